@@ -0,0 +1,200 @@
+/*
+ * ddsbench.cpp
+ *
+ * Copyright (C) 2023 Vega Strike contributors.
+ *
+ * https://github.com/vegastrike/Vega-Strike-Engine-Source
+ *
+ * This file is part of Vega Strike.
+ *
+ * Vega Strike is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Vega Strike is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Vega Strike. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+//Times the software DXT decoder over a set of DDS files, e.g.
+//    find data/textures -name '*.dds' | xargs vs-buildenv-ddsbench -i 5
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+#include "gldrv/dxt_decoder.h"
+
+struct Surface {
+    std::string name;
+    DxtFormat format;
+    int width;
+    int height;
+    int levels;
+    int faces;
+    std::vector<unsigned char> blocks;
+};
+
+static unsigned int readLittle32(const unsigned char *bytes) {
+    return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | ((unsigned int) bytes[3] << 24);
+}
+
+//Reads the header fields VSImage::ReadDDS uses; returns false for anything but DXT1/3/5
+static bool readSurface(const char *filename, Surface &surface) {
+    FILE *fp = fopen(filename, "rb");
+    if (!fp) {
+        fprintf(stderr, "%s: cannot open\n", filename);
+        return false;
+    }
+    std::vector<unsigned char> file;
+    unsigned char chunk[65536];
+    size_t got;
+    while ((got = fread(chunk, 1, sizeof(chunk), fp)) > 0) {
+        file.insert(file.end(), chunk, chunk + got);
+    }
+    fclose(fp);
+    if (file.size() < 128 || memcmp(&file[0], "DDS ", 4) != 0) {
+        fprintf(stderr, "%s: not a DDS file\n", filename);
+        return false;
+    }
+    surface.name = filename;
+    surface.height = readLittle32(&file[12]);
+    surface.width = readLittle32(&file[16]);
+    surface.levels = std::max(1u, readLittle32(&file[28]));
+    surface.faces = (readLittle32(&file[112]) & 0x200) ? 6 : 1;
+    switch (file[87]) {
+        case '1':
+            surface.format = DXT_FORMAT_DXT1;
+            break;
+        case '3':
+            surface.format = DXT_FORMAT_DXT3;
+            break;
+        case '5':
+            surface.format = DXT_FORMAT_DXT5;
+            break;
+        default:
+            fprintf(stderr, "%s: not DXT compressed\n", filename);
+            return false;
+    }
+    size_t bytes = 0;
+    for (int level = 0, w = surface.width, h = surface.height; level < surface.levels; ++level) {
+        bytes += DxtLevelBytes(surface.format, w, h);
+        w = std::max(w >> 1, 1);
+        h = std::max(h >> 1, 1);
+    }
+    bytes *= surface.faces;
+    if (surface.width <= 0 || surface.height <= 0 || file.size() < 128 + bytes) {
+        fprintf(stderr, "%s: truncated\n", filename);
+        return false;
+    }
+    surface.blocks.assign(file.begin() + 128, file.begin() + 128 + bytes);
+    return true;
+}
+
+//Seconds taken by the fastest of a number of passes over every surface
+static double timeDecoding(const std::vector<Surface> &surfaces,
+        int iterations,
+        bool all_levels,
+        const DxtParallelFor &parallel_for) {
+    std::vector<unsigned char> output;
+    double best = 0;
+    for (int pass = 0; pass < iterations; ++pass) {
+        auto start = std::chrono::steady_clock::now();
+        for (const Surface &surface : surfaces) {
+            int levels = all_levels ? surface.levels : 1;
+            size_t face_bytes = surface.blocks.size() / surface.faces;
+            output.resize(DxtDecodedBytes(surface.width, surface.height, 0, levels));
+            for (int face = 0; face < surface.faces; ++face) {
+                DxtDecode(&surface.blocks[face * face_bytes], surface.format, surface.width, surface.height,
+                        0, levels, &output[0], parallel_for);
+            }
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (pass == 0 || seconds < best) {
+            best = seconds;
+        }
+    }
+    return best;
+}
+
+int main(int argc, char **argv) {
+    int iterations = 3;
+    unsigned int threads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<Surface> surfaces;
+    for (int i = 1; i < argc; ++i) {
+        if ((strcmp(argv[i], "-i") == 0) && i + 1 < argc) {
+            iterations = std::max(1, atoi(argv[++i]));
+        } else if ((strcmp(argv[i], "-t") == 0) && i + 1 < argc) {
+            threads = std::max(1, atoi(argv[++i]));
+        } else {
+            Surface surface;
+            if (readSurface(argv[i], surface)) {
+                surfaces.push_back(surface);
+            }
+        }
+    }
+    if (surfaces.empty()) {
+        fprintf(stderr, "Usage: %s [-i iterations] [-t threads] file.dds...\n", argv[0]);
+        return 1;
+    }
+
+    double top_pixels = 0;
+    double all_pixels = 0;
+    for (const Surface &surface : surfaces) {
+        top_pixels += double(surface.width) * surface.height * surface.faces;
+        all_pixels += double(DxtDecodedBytes(surface.width, surface.height, 0, surface.levels)) / 4
+                * surface.faces;
+    }
+
+    DxtParallelFor threaded = [threads](size_t rows, const std::function<void(size_t, size_t)> &body) {
+        size_t chunks = std::min<size_t>(threads, (rows + 63) / 64);
+        if (chunks <= 1) {
+            body(0, rows);
+            return;
+        }
+        std::vector<std::thread> workers;
+        size_t chunk = (rows + chunks - 1) / chunks;
+        for (size_t begin = chunk; begin < rows; begin += chunk) {
+            workers.push_back(std::thread(body, begin, std::min(rows, begin + chunk)));
+        }
+        body(0, chunk);
+        for (std::thread &worker : workers) {
+            worker.join();
+        }
+    };
+
+    printf("%u surfaces, %.1f Mpixels in top levels, %.1f Mpixels in all levels, best of %d\n",
+            (unsigned int) surfaces.size(), top_pixels / 1e6, all_pixels / 1e6, iterations);
+    const char *decoder = DxtDecoderName();
+    struct Run {
+        const char *decoder;
+        bool scalar;
+        bool threaded;
+        bool all_levels;
+    } runs[] = {
+            {"scalar", true, false, false},
+            {decoder, false, false, false},
+            {decoder, false, true, false},
+            {decoder, false, true, true},
+    };
+    for (const Run &run : runs) {
+        DxtForceScalarDecoder(run.scalar);
+        double seconds = timeDecoding(surfaces, iterations, run.all_levels,
+                run.threaded ? threaded : DxtParallelFor());
+        double pixels = run.all_levels ? all_pixels : top_pixels;
+        printf("%-7s %-2u thread(s) %-10s %9.2f ms %9.1f Mpixels/s\n",
+                run.decoder, run.threaded ? threads : 1, run.all_levels ? "all levels" : "top level",
+                seconds * 1e3, pixels / seconds / 1e6);
+    }
+    return 0;
+}
@@ -23,6 +23,7 @@
 #include "PrecompiledHeaders/Converter.h"
 #include "mesh_io.h"
 #include "to_BFXM.h"
+#include "gfx/mesh_optimizer.h"
 #include <cstring>  //We are using C style string functions here
 
 //#define fprintf aprintf
@@ -1063,6 +1064,28 @@ void NormalizeMaterial(GFXMaterial &m) {
     NormalizeProperty(m.er, m.eg, m.eb, m.ea);
 }
 
+//Orders triangles for the vertex cache and overdraw, so the engine can draw them as they are stored
+static void optimizetriangleorder(vector<triangle> &tris, const vector<GFXVertex> &vertices) {
+    if (tris.size() < 2 || vertices.empty()) {
+        return;
+    }
+    vector<unsigned int> indices(tris.size() * 3);
+    for (size_t tri = 0; tri < tris.size(); tri++) {
+        for (int corner = 0; corner < 3; corner++) {
+            indices[tri * 3 + corner] = (unsigned int) tris[tri].indexref[corner];
+        }
+    }
+    vector<unsigned int> order(tris.size());
+    OptimizeTriangleOrder(&indices[0], tris.size(), vertices.size(),
+            &vertices[0].x, sizeof(GFXVertex) / sizeof(float), &order[0]);
+    vector<triangle> ordered;
+    ordered.reserve(tris.size());
+    for (size_t tri = 0; tri < order.size(); tri++) {
+        ordered.push_back(tris[order[tri]]);
+    }
+    tris.swap(ordered);
+}
+
 uint32bit appendmeshfromxml(XML memfile, FILE *Outputfile, bool forcenormals) {
     float transx = float(atof(Converter::getNamedOption("addx").c_str()));
     float transy = float(atof(Converter::getNamedOption("addy").c_str()));
@@ -1360,6 +1383,7 @@ uint32bit appendmeshfromxml(XML memfile, FILE *Outputfile, bool forcenormals) {
     //End Variable sized Attributes
     uint32bit VSAend = ftell(Outputfile);
     //GEOMETRY
+    optimizetriangleorder(memfile.tris, memfile.vertices);
     intbuf = VSSwapHostIntToLittle((uint32bit) memfile.vertices.size());
     runningbytenum += sizeof(uint32bit)
             * (uint32bit) fwrite(&intbuf, sizeof(uint32bit), 1, Outputfile);       //Number of vertices
@@ -28,6 +28,7 @@
 #include "gfx/vec.h"
 #include "al_globals.h"
 #include "hashtable.h"
+std::recursive_mutex audio_mutex;
 #ifdef HAVE_AL
 Hashtable<std::string, ALuint, 127> soundHash;
 unsigned int maxallowedsingle = 10;
@@ -29,6 +29,7 @@
 /* #undef SOUND_DEBUG */
 
 #include "gfx/vec.h"
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -111,6 +112,10 @@ extern bool usepositional;
 
 #endif
 
+//Serializes the AUD entry points; units in different star systems may
+//start and move sounds from simulation worker threads at the same time.
+extern std::recursive_mutex audio_mutex;
+
 float AUDDistanceSquared(const int sound);
 char AUDQueryAudability(const int sound, const Vector &pos, const Vector &vel, const float gain);
 void AUDAddWatchedPlayed(const int sound, const Vector &pos);
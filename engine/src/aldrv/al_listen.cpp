@@ -198,6 +198,7 @@ typedef std::vector<int> vecint;
 vecint soundstodelete;
 
 void AUDRefreshSounds() {
+    std::lock_guard<std::recursive_mutex> lock(audio_mutex);
 #ifdef HAVE_AL
     static unsigned int i = 0;
     if (i >= hashsize) {
@@ -267,6 +268,7 @@ void AUDListenerOrientation(const Vector &p, const Vector &q, const Vector &r) {
 }
 
 void AUDSoundGain(int sound, float gain, bool music) {
+    std::lock_guard<std::recursive_mutex> lock(audio_mutex);
 #ifdef HAVE_AL
     if (sound >= 0 && sound < (int) sounds.size()) {
         sounds[sound].music = music;
@@ -281,6 +283,7 @@ void AUDSoundGain(int sound, float gain, bool music) {
 }
 
 void AUDListenerGain(const float ggain) {
+    std::lock_guard<std::recursive_mutex> lock(audio_mutex);
 #ifdef HAVE_AL
     float gain = ggain;
     if (gain <= 0) {
@@ -537,6 +537,7 @@ unsigned int
         nil_wavebuf = 0;
 
 int AUDCreateSoundWAV(const std::string &s, const bool music, const bool LOOP) {
+    std::lock_guard<std::recursive_mutex> lock(audio_mutex);
 #ifdef HAVE_AL
 #ifdef SOUND_DEBUG
     VS_LOG(trace, "AUDCreateSoundWAV:: ");
@@ -590,6 +591,7 @@ int AUDCreateMusicWAV(const std::string &s, const bool LOOP) {
 }
 
 int AUDCreateSoundMP3(const std::string &s, const bool music, const bool LOOP) {
+    std::lock_guard<std::recursive_mutex> lock(audio_mutex);
 #ifdef HAVE_AL
     assert(0);
     if ((game_options()->Music && !music) || (game_options()->Music && music)) {
@@ -665,6 +667,7 @@ int AUDCreateMusic(const std::string &s, const bool LOOP) {
 
 ///copies other sound loaded through AUDCreateSound
 int AUDCreateSound(int sound, const bool LOOP /*=false*/ ) {
+    std::lock_guard<std::recursive_mutex> lock(audio_mutex);
 #ifdef HAVE_AL
     if (AUDIsPlaying(sound)) {
         AUDStopPlaying(sound);
@@ -679,6 +682,7 @@ int AUDCreateSound(int sound, const bool LOOP /*=false*/ ) {
 extern std::vector<int> soundstodelete;
 
 void AUDDeleteSound(int sound, bool music) {
+    std::lock_guard<std::recursive_mutex> lock(audio_mutex);
 #ifdef HAVE_AL
     if (sound >= 0 && sound < (int) sounds.size()) {
         if (AUDIsPlaying(sound)) {
@@ -723,6 +727,7 @@ void AUDDeleteSound(int sound, bool music) {
 }
 
 void AUDAdjustSound(const int sound, const QVector &pos, const Vector &vel) {
+    std::lock_guard<std::recursive_mutex> lock(audio_mutex);
 
 #ifdef HAVE_AL
     if (sound >= 0 && sound < (int) sounds.size()) {
@@ -753,6 +758,7 @@ void AUDAdjustSound(const int sound, const QVector &pos, const Vector &vel) {
 }
 
 void AUDStreamingSound(const int sound) {
+    std::lock_guard<std::recursive_mutex> lock(audio_mutex);
 #ifdef HAVE_AL
     if (sound >= 0 && sound < (int) sounds.size() && sounds[sound].source) {
         alSource3f(sounds[sound].source, AL_POSITION, 0.0, 0.0, 0.0);
@@ -777,6 +783,7 @@ bool starSystemOK() {
 }
 
 int AUDHighestSoundPlaying() {
+    std::lock_guard<std::recursive_mutex> lock(audio_mutex);
     int retval = -1;
 #ifdef HAVE_AL
     unsigned int s = ::sounds.size();
@@ -790,6 +797,7 @@ int AUDHighestSoundPlaying() {
 }
 
 void AUDStopAllSounds(int except_this_one) {
+    std::lock_guard<std::recursive_mutex> lock(audio_mutex);
 #ifdef HAVE_AL
     unsigned int s = ::sounds.size();
     for (unsigned int i = 0; i < s; ++i) {
@@ -801,6 +809,7 @@ void AUDStopAllSounds(int except_this_one) {
 }
 
 bool AUDIsPlaying(const int sound) {
+    std::lock_guard<std::recursive_mutex> lock(audio_mutex);
 #ifdef HAVE_AL
     if (sound >= 0 && sound < (int) sounds.size()) {
         if (!sounds[sound].source) {
@@ -820,6 +829,7 @@ bool AUDIsPlaying(const int sound) {
 }
 
 void AUDStopPlaying(const int sound) {
+    std::lock_guard<std::recursive_mutex> lock(audio_mutex);
 #ifdef HAVE_AL
     if (sound >= 0 && sound < (int) sounds.size()) {
 #ifdef SOUND_DEBUG
@@ -885,6 +895,7 @@ static bool AUDReclaimSource(const int sound, bool high_priority = false) {
 }
 
 void AUDStartPlaying(const int sound) {
+    std::lock_guard<std::recursive_mutex> lock(audio_mutex);
 #ifdef SOUND_DEBUG
     VS_LOG(trace, (boost::format("AUDStartPlaying(%1$d)") % sound));
 #endif
@@ -907,6 +918,7 @@ void AUDStartPlaying(const int sound) {
 }
 
 void AUDPlay(const int sound, const QVector &pos, const Vector &vel, const float gain) {
+    std::lock_guard<std::recursive_mutex> lock(audio_mutex);
 #ifdef HAVE_AL
     char tmp;
     if (sound < 0) {
@@ -945,6 +957,7 @@ void AUDPlay(const int sound, const QVector &pos, const Vector &vel, const float
 #endif
 
 float AUDGetCurrentPosition(const int sound) {
+    std::lock_guard<std::recursive_mutex> lock(audio_mutex);
 #ifdef HAVE_AL
     ALfloat rv;
     alGetSourcef(sound, AL_SEC_OFFSET, &rv);
@@ -955,6 +968,7 @@ float AUDGetCurrentPosition(const int sound) {
 }
 
 void AUDPausePlaying(const int sound) {
+    std::lock_guard<std::recursive_mutex> lock(audio_mutex);
 #ifdef HAVE_AL
     if (sound >= 0 && sound < (int) sounds.size()) {
         //alSourcePlay( sounds[sound].source() );
@@ -57,7 +57,7 @@
 #include "star_system.h"
 #include "universe.h"
 
-extern double aggfire;
+extern thread_local double aggfire;
 
 using namespace Orders;
 using namespace XMLSupport;
@@ -39,9 +39,12 @@
 #include "lin_time.h" //DEBUG ONLY
 #include "cmd/pilot.h"
 #include "universe.h"
+#include "configuration/config_handle.h"
+#include "cmd/ai/target_acquisition.h"
+#include "star_system.h"
 
-extern int numprocessed;
-extern double targetpick;
+extern thread_local int numprocessed;
+extern thread_local double targetpick;
 
 static bool NoDockWithClear() {
     static bool nodockwithclear =
@@ -49,7 +52,6 @@ static bool NoDockWithClear() {
     return nodockwithclear;
 }
 
-VSRandom targrand(time(NULL));
 
 Unit *getAtmospheric(Unit *targ) {
     if (targ) {
@@ -138,7 +140,7 @@ void FireAt::ReInit(float aggressivitylevel) {
     agg = aggressivitylevel;
     distance = 1;
     //JS --- spreading target switch times
-    lastchangedtarg = 0.0 - targrand.uniformInc(0, 1) * configuration()->ai.targeting_config.min_time_to_switch_targets;
+    lastchangedtarg = 0.0 - vsrandom.uniformInc(0, 1) * configuration()->ai.targeting_config.min_time_to_switch_targets;
     had_target = false;
 }
 
@@ -351,13 +353,11 @@ class ChooseTargetClass {
     Unit *parent{};
     Unit *parentparent{};
     vector<TurretBin> *tbin{};
-    StaticTuple<float, numTuple> maxinnerrangeless;
-    StaticTuple<float, numTuple> maxinnerrangemore;
+    StaticTuple<float, numTuple> innerranges;
+    size_t innerrange{};
     float priority{};
     char rolepriority{};
     char maxrolepriority{};
-    bool reachedMore{};
-    bool reachedLess{};
     FireAt *fireat{};
     float gunrange{};
     int numtargets{};
@@ -380,19 +380,11 @@ public:
         this->parent = un;
         this->parentparent = un->owner ? UniverseUtil::getUnitByPtr(un->owner, un, false) : 0;
         mytarg = NULL;
-        double currad = 0;
-        if (!is_null(un->location[Unit::UNIT_ONLY])) {
-            currad = un->location[Unit::UNIT_ONLY]->getKey();
-        }
         for (size_t i = 0; i < numTuple; ++i) {
-            double tmpless = currad - innermaxrange[i];
-            double tmpmore = currad + innermaxrange[i];
-            this->maxinnerrangeless[i] = tmpless;
-            this->maxinnerrangemore[i] = tmpmore;
+            this->innerranges[i] = innermaxrange[i];
         }
+        innerrange = 0;
         this->maxrolepriority = maxrolepriority; //max priority that will allow gun range to be ok
-        reachedMore = false;
-        reachedLess = false;
         this->priority = -1;
         this->rolepriority = 31;
         this->gunrange = gunrange;
@@ -400,31 +392,13 @@ public:
         this->maxtargets = maxtargets;
     }
 
-    bool acquire(Unit *un, float distance) {
-        double unkey = un->location[Unit::UNIT_ONLY]->getKey();
-        bool lesscheck = unkey < maxinnerrangeless[0];
-        bool morecheck = unkey > maxinnerrangemore[0];
-        if (reachedMore == false || reachedLess == false) {
-            if (lesscheck || morecheck) {
-                if (lesscheck) {
-                    reachedLess = true;
-                }
-                if (morecheck) {
-                    reachedMore = true;
-                }
-                if (mytarg && rolepriority < maxrolepriority) {
-                    return false;
-                } else if (reachedLess == true && reachedMore == true) {
-                    for (size_t i = 1; i < numTuple; ++i) {
-                        if (unkey > maxinnerrangeless[i] && unkey < maxinnerrangemore[i]) {
-                            maxinnerrangeless[0] = maxinnerrangeless[i];
-                            maxinnerrangemore[0] = maxinnerrangemore[i];
-                            reachedLess = false;
-                            reachedMore = false;
-                        }
-                    }
-                }
+    //For units coming nearest first: stops at the end of the inner range reached with a good enough target
+    bool acquireNearest(Unit *un, float distance) {
+        while (innerrange < numTuple && distance > innerranges[innerrange]) {
+            if (mytarg && rolepriority < maxrolepriority) {
+                return false;
             }
+            ++innerrange;
         }
         return ShouldTargetUnit(un, distance);
     }
@@ -471,87 +445,43 @@ public:
     }
 };
 
-int numpolled[2] = {0, 0};   //number of units that searched for a target
-
-int prevpollindex[2] = {10000, 10000};   //previous number of units touched (doesn't need to be precise)
-
-int pollindex[2] = {1,
-        1};   //current count of number of units touched (doesn't need to be precise)  -- used for "fairness" heuristic
-
 void FireAt::ChooseTargets(int numtargs, bool force) {
-    float gunspeed, gunrange, missilerange;
-    parent->getAverageGunSpeed(gunspeed, gunrange, missilerange);
-    static float targettimer = UniverseUtil::GetGameTime();    //timer used to determine passage of physics frames
-    static float mintimetoswitch =
-            XMLSupport::parse_float(vs_config->getVariable("AI", "Targetting", "MinTimeToSwitchTargets", "3"));
-    static float minnulltimetoswitch =
-            XMLSupport::parse_float(vs_config->getVariable("AI", "Targetting", "MinNullTimeToSwitchTargets", "5"));
-    static int minnumpollers =
-            float_to_int(XMLSupport::parse_float(vs_config->getVariable("AI",
-                    "Targetting",
-                    "MinNumberofpollersperframe",
-                    "5")));                    //maximum number of vessels allowed to search for a target in a given physics frame
-    static int maxnumpollers =
-            float_to_int(XMLSupport::parse_float(vs_config->getVariable("AI",
-                    "Targetting",
-                    "MaxNumberofpollersperframe",
-                    "49")));                    //maximum number of vessels allowed to search for a target in a given physics frame
-    static int numpollers[2] = {maxnumpollers, maxnumpollers};
-
-    static int nextframenumpollers[2] = {maxnumpollers, maxnumpollers};
+    static const vega_config::ConfigHandle<float> mintimetoswitch("AI.Targetting.MinTimeToSwitchTargets", 3.0F);
+    static const vega_config::ConfigHandle<float> minnulltimetoswitch("AI.Targetting.MinNullTimeToSwitchTargets", 5.0F);
     if (lastchangedtarg + mintimetoswitch > 0) {
         return;
     }          //don't switch if switching too soon
 
     Unit *curtarg = parent->Target();
-    int hastarg = (curtarg == NULL) ? 0 : 1;
-    //Following code exists to limit the number of craft polling for a target in a given frame - this is an expensive operation, and needs to be spread out, or there will be pauses.
-    if ((UniverseUtil::GetGameTime()) - targettimer >= SIMULATION_ATOM * .99) {
-        //Check if one or more physics frames have passed
-        numpolled[0] = numpolled[1] = 0;         //reset counters
-        prevpollindex[0] = pollindex[0];
-        prevpollindex[1] = pollindex[1];
-        pollindex[hastarg] = 0;
-        targettimer = UniverseUtil::GetGameTime();
-        numpollers[0] = float_to_int(nextframenumpollers[0]);
-        numpollers[1] = float_to_int(nextframenumpollers[1]);
-    }
-    pollindex[hastarg]++;     //count number of craft touched - will use in the next physics frame to spread out the vessels actually chosen to be processed among all of the vessels being touched
-    if (numpolled[hastarg] > numpollers[hastarg]) {      //over quota, wait until next physics frame
-        return;
-    }
-    if (!(pollindex[hastarg] % ((prevpollindex[hastarg] / numpollers[hastarg])
-            + 1))) {      //spread out, in modulo fashion, the possibility of changing one's target. Use previous physics frame count of craft to estimate current number of craft
-        numpolled[hastarg]++;          //if a more likely candidate, we're going to search for a target.
-    } else {
-        return;
-    }          //skipped to achieve better fairness - see comment on modulo distribution above
     if (curtarg) {
         if (isJumpablePlanet(curtarg)) {
             return;
         }
     }
+    //The units around us are gathered for every ship at once at the end of the physics frame, see TargetAcquisition
+    TargetAcquisition &acquisition = _Universe->activeStarSystem()->GetTargetAcquisition();
+    static thread_local vector<TargetAcquisition::Candidate> candidates;
+    bool gathered = acquisition.TakeCandidates(parent, candidates);
     bool wasnull = (curtarg == NULL);
     Flightgroup *fg = parent->getFlightgroup();
-    lastchangedtarg = 0 + targrand.uniformInc(0, 1)
-            * mintimetoswitch;     //spread out next valid time to switch targets - helps to ease per-frame loads.
     if (fg) {
         if (!fg->directive.empty()) {
             if (curtarg != NULL && (*fg->directive.begin()) == toupper(*fg->directive.begin())) {
+                lastchangedtarg = 0 + vsrandom.uniformInc(0, 1) * mintimetoswitch;
                 return;
             }
         }
     }
     //not   allowed to switch targets
-    numprocessed++;
+    float gunspeed, gunrange, missilerange;
+    parent->getAverageGunSpeed(gunspeed, gunrange, missilerange);
     vector<TurretBin> tbin;
     Unit *su = NULL;
     un_iter subun = parent->getSubUnits();
     for (; (su = *subun) != NULL; ++subun) {
         static unsigned int inert = ROLES::getRole("INERT");
         static unsigned int pointdef = ROLES::getRole("POINTDEF");
-        static bool assignpointdef =
-                XMLSupport::parse_bool(vs_config->getVariable("AI", "Targetting", "AssignPointDef", "true"));
+        static const vega_config::ConfigHandle<bool> assignpointdef("AI.Targetting.AssignPointDef", true);
         if ((su->getAttackPreferenceChar() != pointdef) || assignpointdef) {
             if (su->getAttackPreferenceChar() != inert) {
                 AssignTBin(su, tbin);
@@ -566,18 +496,10 @@ void FireAt::ChooseTargets(int numtargs, bool force) {
     std::sort(tbin.begin(), tbin.end());
     float efrel = 0;
     float mytargrange = FLT_MAX;
-    static float unitRad =
-            XMLSupport::parse_float(vs_config->getVariable("AI",
-                    "Targetting",
-                    "search_extra_radius",
-                    "1000"));                 //Maximum target radius that is guaranteed to be detected
-    static char maxrolepriority =
-            XMLSupport::parse_int(vs_config->getVariable("AI", "Targetting", "search_max_role_priority", "16"));
-    static int maxtargets = XMLSupport::parse_int(vs_config->getVariable("AI",
-            "Targetting",
-            "search_max_candidates",
-            "64"));   //Cutoff candidate count (if that many hostiles found, stop search - performance/quality tradeoff, 0=no cutoff)
-    UnitWithinRangeLocator<ChooseTargetClass<2> > unitLocator(parent->GetComputerData().radar.maxrange, unitRad);
+    static const vega_config::ConfigHandle<int> maxrolepriority("AI.Targetting.search_max_role_priority", 16);
+    //Cutoff candidate count (if that many hostiles found, stop search - performance/quality tradeoff, 0=no cutoff)
+    static const vega_config::ConfigHandle<int> maxtargets("AI.Targetting.search_max_candidates", 64);
+    ChooseTargetClass<2> chooser;
     StaticTuple<float, 2> maxranges{};
 
     maxranges[0] = gunrange;
@@ -586,40 +508,51 @@ void FireAt::ChooseTargets(int numtargs, bool force) {
         maxranges[0] = (tbin[0].maxrange > gunrange ? tbin[0].maxrange : gunrange);
     }
     double pretable = queryTime();
-    unitLocator.action.init(this, parent, gunrange, &tbin, maxranges, maxrolepriority, maxtargets);
-    static int gcounter = 0;
-    static int
-            min_rechoose_interval = XMLSupport::parse_int(vs_config->getVariable("AI", "min_rechoose_interval", "128"));
-    if (curtarg) {
-        if (gcounter++ < min_rechoose_interval || rand() / 8 < RAND_MAX / 9) {
-            //in this case only look at potentially *interesting* units rather than huge swaths of nearby units...including target, threat, players, and leader's target
-            unitLocator.action.ShouldTargetUnit(curtarg, UnitUtil::getDistance(parent, curtarg));
-            unsigned int np = _Universe->numPlayers();
-            for (unsigned int i = 0; i < np; ++i) {
-                Unit *playa = _Universe->AccessCockpit(i)->GetParent();
-                if (playa) {
-                    unitLocator.action.ShouldTargetUnit(playa, UnitUtil::getDistance(parent, playa));
-                }
-            }
-            Unit *lead = UnitUtil::getFlightgroupLeader(parent);
-            if (lead != NULL && lead != parent && (lead = lead->Target()) != NULL) {
-                unitLocator.action.ShouldTargetUnit(lead, UnitUtil::getDistance(parent, lead));
+    chooser.init(this, parent, gunrange, &tbin, maxranges, maxrolepriority.Get(), maxtargets.Get());
+    if (gathered) {
+        //They were gathered a little while ago, so measure again
+        for (const TargetAcquisition::Candidate &candidate : candidates) {
+            if (!chooser.acquireNearest(candidate.unit, UnitUtil::getDistance(parent, candidate.unit))) {
+                break;
             }
-            Unit *threat = parent->Threat();
-            if (threat) {
-                unitLocator.action.ShouldTargetUnit(threat, UnitUtil::getDistance(parent, threat));
+        }
+    } else {
+        static thread_local int gcounter = 0;
+        static const vega_config::ConfigHandle<int> min_rechoose_interval("AI.min_rechoose_interval", 128);
+        if (curtarg) {
+            if (gcounter++ < min_rechoose_interval || rand() / 8 < RAND_MAX / 9) {
+                //in this case only look at potentially *interesting* units rather than huge swaths of nearby units...including target, threat, players, and leader's target
+                chooser.ShouldTargetUnit(curtarg, UnitUtil::getDistance(parent, curtarg));
+                unsigned int np = _Universe->numPlayers();
+                for (unsigned int i = 0; i < np; ++i) {
+                    Unit *playa = _Universe->AccessCockpit(i)->GetParent();
+                    if (playa) {
+                        chooser.ShouldTargetUnit(playa, UnitUtil::getDistance(parent, playa));
+                    }
+                }
+                Unit *lead = UnitUtil::getFlightgroupLeader(parent);
+                if (lead != NULL && lead != parent && (lead = lead->Target()) != NULL) {
+                    chooser.ShouldTargetUnit(lead, UnitUtil::getDistance(parent, lead));
+                }
+                Unit *threat = parent->Threat();
+                if (threat) {
+                    chooser.ShouldTargetUnit(threat, UnitUtil::getDistance(parent, threat));
+                }
+            } else {
+                gcounter = 0;
             }
-        } else {
-            gcounter = 0;
+        }
+        if (chooser.mytarg == NULL) {      //decided to rechoose or did not have initial target
+            //Keep the current target until the search comes back
+            acquisition.Request(parent);
+            targetpick += queryTime() - pretable;
+            return;
         }
     }
-    if (unitLocator.action.mytarg == NULL) {      //decided to rechoose or did not have initial target
-        findObjects(
-                _Universe->activeStarSystem()->collide_map[Unit::UNIT_ONLY],
-                parent->location[Unit::UNIT_ONLY],
-                &unitLocator);
-    }
-    Unit *mytarg = unitLocator.action.mytarg;
+    numprocessed++;
+    lastchangedtarg = 0 + vsrandom.uniformInc(0, 1)
+            * mintimetoswitch;     //spread out next valid time to switch targets - helps to ease per-frame loads.
+    Unit *mytarg = chooser.mytarg;
     targetpick += queryTime() - pretable;
     if (mytarg) {
         efrel = parent->getRelation(mytarg);
@@ -630,31 +563,8 @@ void FireAt::ChooseTargets(int numtargs, bool force) {
         k->AssignTargets(my_target, parent->cumulative_transformation_matrix);
     }
     parent->LockTarget(false);
-    if (wasnull) {
-        if (mytarg) {
-            nextframenumpollers[hastarg] += 2;
-            if (nextframenumpollers[hastarg] > maxnumpollers) {
-                nextframenumpollers[hastarg] = maxnumpollers;
-            }
-        } else {
-            lastchangedtarg += targrand.uniformInc(0, 1) * minnulltimetoswitch;
-            nextframenumpollers[hastarg] -= .05;
-            if (nextframenumpollers[hastarg] < minnumpollers) {
-                nextframenumpollers[hastarg] = minnumpollers;
-            }
-        }
-    } else {
-        if (parent->Target() != mytarg) {
-            nextframenumpollers[hastarg] += 2;
-            if (nextframenumpollers[hastarg] > maxnumpollers) {
-                nextframenumpollers[hastarg] = maxnumpollers;
-            }
-        } else {
-            nextframenumpollers[hastarg] -= .01;
-            if (nextframenumpollers[hastarg] < minnumpollers) {
-                nextframenumpollers[hastarg] = minnumpollers;
-            }
-        }
+    if (wasnull && !mytarg) {
+        lastchangedtarg += vsrandom.uniformInc(0, 1) * minnulltimetoswitch;
     }
     parent->Target(mytarg);
     parent->LockTarget(true);
@@ -711,8 +621,8 @@ bool FireAt::ShouldFire(Unit *targ, bool &missilelock) {
                     int curtime =
                             (int) fmod(floor(UniverseUtil::GetGameTime() / attacker_switch_time), (float) (1 << 24));
                     int seed = ((((size_t) parent) & 0xffffffff) ^ curtime);
-                    static VSRandom decide(seed);
-                    decide.init_genrand(seed);
+                    //Reseeded for every decision, so each caller has its own; unit stages run on worker threads
+                    VSRandom decide(seed);
                     if (decide.genrand_int31() % attackers >= max_attackers) {
                         return false;
                     }
@@ -0,0 +1,189 @@
+/*
+ * target_acquisition.cpp
+ *
+ * Copyright (C) 2023 Vega Strike contributors.
+ *
+ * https://github.com/vegastrike/Vega-Strike-Engine-Source
+ *
+ * This file is part of Vega Strike.
+ *
+ * Vega Strike is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Vega Strike is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Vega Strike. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "cmd/ai/target_acquisition.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "cmd/collide_map.h"
+#include "cmd/unit_generic.h"
+#include "configuration/config_handle.h"
+#include "star_system.h"
+
+namespace {
+
+// The stretch of the collide map a request looks at
+struct Window {
+    Unit *parent;
+    std::vector<TargetAcquisition::Candidate> *candidates;
+    QVector position;
+    float radius;
+    float range;
+    double begin;
+    double end;
+
+    bool operator<(const Window &other) const {
+        return begin < other.begin;
+    }
+};
+
+} // namespace
+
+TargetAcquisition::~TargetAcquisition() {
+    Clear();
+}
+
+void TargetAcquisition::Request(Unit *parent) {
+    //Already pending, or served and waiting to be taken
+    if (!results.emplace(parent, Result()).second) {
+        return;
+    }
+    parent->Ref();
+    pending.push_back(parent);
+}
+
+bool TargetAcquisition::TakeCandidates(Unit *parent, std::vector<Candidate> &candidates) {
+    candidates.clear();
+    std::unordered_map<Unit *, Result>::iterator found = results.find(parent);
+    if (found == results.end() || found->second.run == 0) {
+        return false;
+    }
+    for (const Candidate &candidate : found->second.candidates) {
+        if (!candidate.unit->Killed()) {
+            candidates.push_back(candidate);
+        }
+    }
+    Release(found->second);
+    results.erase(found);
+    return true;
+}
+
+void TargetAcquisition::Release(Result &result) {
+    for (Candidate &candidate : result.candidates) {
+        candidate.unit->UnRef();
+    }
+    result.candidates.clear();
+}
+
+void TargetAcquisition::Clear() {
+    for (auto &entry : results) {
+        Release(entry.second);
+        entry.first->UnRef();
+    }
+    results.clear();
+    pending.clear();
+}
+
+void TargetAcquisition::Run(CollideArray &units) {
+    ++runs;
+    if (runs == 0) {
+        ++runs;
+    }
+    //Ships run their AI at least once every SIM_QUEUE_SIZE atoms; anything
+    //older was asked for by an order that is gone
+    for (auto entry = results.begin(); entry != results.end();) {
+        if (entry->second.run != 0 && runs - entry->second.run > SIM_QUEUE_SIZE) {
+            Release(entry->second);
+            entry->first->UnRef();
+            entry = results.erase(entry);
+        } else {
+            ++entry;
+        }
+    }
+    if (pending.empty()) {
+        return;
+    }
+    //Units bigger than this may be missed at the edge of radar range, as by findObjects
+    static const vega_config::ConfigHandle<float> unit_rad("AI.Targetting.search_extra_radius", 1000.0F);
+
+    std::vector<Window> windows;
+    windows.reserve(pending.size());
+    for (Unit *parent : pending) {
+        Result &result = results[parent];
+        result.run = runs;
+        CollideMap::iterator location = parent->location[Unit::UNIT_ONLY];
+        if (parent->Killed() || is_null(location)) {
+            continue;
+        }
+        Window window;
+        window.parent = parent;
+        window.candidates = &result.candidates;
+        window.position = (*location)->GetPosition();
+        window.radius = fabs((*location)->radius);
+        window.range = parent->GetComputerData().radar.maxrange;
+        double reach = window.range + window.radius + unit_rad.Get();
+        window.begin = window.position.i - reach;
+        window.end = window.position.i + reach;
+        windows.push_back(window);
+    }
+    pending.clear();
+    if (windows.empty() || units.begin() == units.end()) {
+        return;
+    }
+    std::sort(windows.begin(), windows.end());
+
+    //One walk along the map, which is sorted by key, with every window that
+    //covers the current key open
+    Collidable dummy;
+    dummy.position.i = windows.front().begin;
+    CollideArray::iterator i = std::lower_bound(units.begin(), units.end(), dummy);
+    size_t next = 0;
+    std::vector<Window *> open;
+    for (; i != units.end() && (next < windows.size() || !open.empty()); ++i) {
+        const double key = i->getKey();
+        while (next < windows.size() && windows[next].begin <= key) {
+            open.push_back(&windows[next++]);
+        }
+        open.erase(std::remove_if(open.begin(), open.end(), [key](const Window *window) {
+            return window->end < key;
+        }), open.end());
+        //Bolts, and units about to be removed
+        if (i->radius <= 0 || open.empty()) {
+            continue;
+        }
+        Unit *unit = i->ref.unit;
+        if (unit->Killed() || !unit->cloak.Visible()) {
+            continue;
+        }
+        const QVector position = i->GetPosition();
+        const float radius = fabs(i->radius);
+        for (Window *window : open) {
+            if (unit == window->parent) {
+                continue;
+            }
+            float distance = (position - window->position).Magnitude() - radius - window->radius;
+            if (distance < window->range) {
+                unit->Ref();
+                window->candidates->push_back(Candidate{unit, distance});
+            }
+        }
+    }
+    for (Window &window : windows) {
+        std::sort(window.candidates->begin(), window.candidates->end(),
+                [](const Candidate &a, const Candidate &b) {
+                    return a.distance < b.distance;
+                });
+    }
+}
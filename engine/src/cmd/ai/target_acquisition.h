@@ -0,0 +1,86 @@
+/*
+ * target_acquisition.h
+ *
+ * Copyright (C) 2023 Vega Strike contributors.
+ *
+ * https://github.com/vegastrike/Vega-Strike-Engine-Source
+ *
+ * This file is part of Vega Strike.
+ *
+ * Vega Strike is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Vega Strike is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Vega Strike. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef VEGA_STRIKE_ENGINE_CMD_AI_TARGET_ACQUISITION_H
+#define VEGA_STRIKE_ENGINE_CMD_AI_TARGET_ACQUISITION_H
+
+#include <unordered_map>
+#include <vector>
+
+class Unit;
+class CollideArray;
+
+/**
+ * @brief Finds the units around every ship of a star system that wants a
+ * new target, all at once.
+ *
+ * Rather than sweeping the collide map on its own, FireAt::ChooseTargets
+ * asks for the units within radar range of its ship and gets them the next
+ * time it runs. Once per simulation atom the star system calls Run(), which
+ * serves every request of that atom with a single walk along the collide
+ * map, so the cost of target searches grows with the number of ships
+ * looking rather than being rationed between them.
+ */
+class TargetAcquisition {
+public:
+    struct Candidate {
+        Unit *unit;
+        // Between the surfaces of the two units, when they were gathered
+        float distance;
+    };
+
+    TargetAcquisition() = default;
+    TargetAcquisition(const TargetAcquisition &) = delete;
+    TargetAcquisition &operator=(const TargetAcquisition &) = delete;
+    ~TargetAcquisition();
+
+    // Asks for the units within the radar range of parent, gathered by the
+    // next Run(). Asking again before they are taken does nothing.
+    void Request(Unit *parent);
+
+    // Hands over the units gathered for parent, nearest first, and forgets
+    // them. Returns false if there are none yet.
+    bool TakeCandidates(Unit *parent, std::vector<Candidate> &candidates);
+
+    // Serves every pending request from units, the UNIT_ONLY collide map,
+    // which must have been flattened
+    void Run(CollideArray &units);
+
+    void Clear();
+
+private:
+    struct Result {
+        // Number of Run() that gathered the candidates, 0 while pending
+        unsigned int run = 0;
+        std::vector<Candidate> candidates;
+    };
+
+    void Release(Result &result);
+
+    // Ships that asked since the last Run()
+    std::vector<Unit *> pending;
+    // Every ship that asked, whether it has been served yet or not
+    std::unordered_map<Unit *, Result> results;
+    unsigned int runs = 0;
+};
+
+#endif //VEGA_STRIKE_ENGINE_CMD_AI_TARGET_ACQUISITION_H
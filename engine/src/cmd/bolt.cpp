@@ -42,6 +42,7 @@
 #include "universe.h"
 #include "damageable.h"
 #include "vs_logging.h"
+#include "vs_profiler.h"
 #include "gfx/texture_manager.h"
 
 using std::vector;
@@ -58,9 +59,11 @@ int Bolt::AddTexture(BoltDrawManager *q, std::string file) {
     int decal = q->boltdecals.AddTexture(file.c_str(), MIPMAP);
     if (decal >= (int) q->bolts.size()) {
         q->bolts.push_back(vector<Bolt>());
+        q->bolt_motion.push_back(BoltMotion());
         int blargh = q->boltdecals.AddTexture(file.c_str(), MIPMAP);
         if (blargh >= (int) q->bolts.size()) {
             q->bolts.push_back(vector<Bolt>());
+            q->bolt_motion.push_back(BoltMotion());
         }
     }
 
@@ -86,6 +89,7 @@ int Bolt::AddAnimation(BoltDrawManager *q, std::string file, QVector cur_positio
                         false));         //balls have their own orientation
         q->animations.back()->SetPosition(cur_position);
         q->balls.push_back(vector<Bolt>());
+        q->ball_motion.push_back(BoltMotion());
     }
     return decal;
 }
@@ -113,15 +117,16 @@ void Bolt::DrawAllBolts() {
 
     qmesh->LoadDrawState();
     qmesh->BeginDrawState();
-    int decal = 0;
 
     // Iterate over specific types of bolts (with same texture)
-    for (auto &&bolt_types : bolt_draw_manager.bolts) {
+    for (size_t decal = 0; decal < bolt_draw_manager.bolts.size(); ++decal) {
+        vector<Bolt> &bolt_types = bolt_draw_manager.bolts[decal];
+        const BoltMotion &motion = bolt_draw_manager.bolt_motion[decal];
         if (bolt_types.size() == 0) {
             continue;
         }
 
-        Bolt bolt = bolt_types[0];
+        const Bolt &bolt = bolt_types[0];
 
         Texture *texture = TextureManager::GetInstance().GetTexture(bolt.bolt_name, MIPMAP);
         if (!texture) {
@@ -134,12 +139,11 @@ void Bolt::DrawAllBolts() {
             if (texture->SetupPass(0, bsrc, bdst)) {
                 texture->MakeActive();
                 GFXToggleTexture(true, 0);
-                for (auto &&bolt : bolt_types) {
-                    bolt.DrawBolt(qmesh);
+                for (size_t i = 0; i < bolt_types.size(); ++i) {
+                    bolt_types[i].DrawBolt(qmesh, motion.Position(i), motion.PreviousPosition(i));
                 }
             }
         }
-        decal++;
     }
 
     qmesh->EndDrawState();
@@ -147,14 +151,14 @@ void Bolt::DrawAllBolts() {
 
 void Bolt::DrawAllBalls() {
     BoltDrawManager &bolt_draw_manager = BoltDrawManager::GetInstance();
-    vector<Animation *>::iterator k = bolt_draw_manager.animations.begin();
-
-    for (auto &&ball_types : bolt_draw_manager.balls) {
+    for (size_t decal = 0; decal < bolt_draw_manager.balls.size(); ++decal) {
+        vector<Bolt> &ball_types = bolt_draw_manager.balls[decal];
+        const BoltMotion &motion = bolt_draw_manager.ball_motion[decal];
         if (ball_types.size() == 0) {
             continue;
         }
 
-        Animation *cur = *k;
+        Animation *cur = bolt_draw_manager.animations[decal];
 
         float bolt_size = 2 * ball_types[0].type->radius * 2;
         bolt_size *= bolt_size;
@@ -162,13 +166,13 @@ void Bolt::DrawAllBalls() {
         //FIXME::MuST USE DRAWNO	TRANSFORMNOW cur->CalculateOrientation (result);
 
         // Iterate over specific balls
-        for (auto &&bolt : ball_types) { // really ball
-            bolt.DrawBall(bolt_size, cur);
+        for (size_t i = 0; i < ball_types.size(); ++i) {
+            ball_types[i].DrawBall(bolt_size, cur, motion.Position(i), motion.PreviousPosition(i));
         }
     }
 }
 
-void Bolt::DrawBolt(GFXVertexList *qmesh) {
+void Bolt::DrawBolt(GFXVertexList *qmesh, const QVector &cur_position, const QVector &prev_position) {
     float distance = (cur_position - BoltDrawManager::camera_position).MagnitudeSquared();
 
     if (distance * BoltDrawManager::pixel_angle >= bolt_size) {
@@ -190,7 +194,7 @@ void Bolt::DrawBolt(GFXVertexList *qmesh) {
     qmesh->Draw();
 }
 
-void Bolt::DrawBall(float &bolt_size, Animation *cur) {
+void Bolt::DrawBall(float &bolt_size, Animation *cur, const QVector &cur_position, const QVector &prev_position) {
     // TODO: move up to DrawBalls
     Vector p, q, r;
     _Universe->AccessCamera()->GetOrientation(p, q, r);
@@ -218,10 +222,13 @@ void Bolt::Destroy(unsigned int index) {
 
     BoltDrawManager &q = BoltDrawManager::GetInstance();
     vector<vector<Bolt> > *target;
+    BoltMotion *motion;
     if (!isBall) {
         target = &q.bolts;
+        motion = &q.bolt_motion[decal];
     } else {
         target = &q.balls;
+        motion = &q.ball_motion[decal];
     }
 
     vector<Bolt> *vec = &(*target)[decal];
@@ -237,6 +244,7 @@ void Bolt::Destroy(unsigned int index) {
         }
 
         vec->pop_back();         //pop that back up
+        motion->remove(index);
     } else {
         VS_LOG_AND_FLUSH(fatal, "Bolt Fault Nouveau! Not found in draw queue! No Chance to recover");
         assert(0);
@@ -248,14 +256,13 @@ Bolt::Bolt(const WeaponInfo *typ,
         const Matrix &orientationpos,
         const Vector &shipspeed,
         void *owner,
-        CollideMap::iterator hint) : cur_position(orientationpos.p), ShipSpeed(shipspeed) {
+        CollideMap::iterator hint) {
     VSCONSTRUCT2('t')
     BoltDrawManager &q = BoltDrawManager::GetInstance();
-    prev_position = cur_position;
+    QVector cur_position = orientationpos.p;
     this->owner = owner;
     this->type = typ;
     bolt_name = typ->file;
-    curdist = 0;
     bolt_size = std::pow(2 * type->radius + type->length, 2);
     ball_size = std::pow(4 * type->radius, 2);
 
@@ -281,6 +288,10 @@ Bolt::Bolt(const WeaponInfo *typ,
                 hint);
 
         q.bolts[decal].push_back(*this);
+        q.bolt_motion[decal].push_back(cur_position,
+                shipspeed + drawmat.getR() * (typ->speed / typ->length),
+                typ->speed,
+                typ->range);
 
         BoltDrawManager &bolt_draw_manager = BoltDrawManager::GetInstance();
         bolt_texture = bolt_draw_manager.boltdecals.GetTexture(decal);
@@ -297,6 +308,10 @@ Bolt::Bolt(const WeaponInfo *typ,
                 cur_position + vel * simulation_atom_var * .5);
         this->location = bolt_collide_map->insert(collidable, hint);
         q.balls[decal].push_back(*this);
+        q.ball_motion[decal].push_back(cur_position,
+                shipspeed + drawmat.getR() * (typ->speed / typ->radius),
+                typ->speed,
+                typ->range);
     }
 }
 
@@ -304,79 +319,130 @@ size_t nondecal_index(Collidable::CollideRef b) {
     return b.bolt_index >> 8;
 }
 
-bool Bolt::Update(Collidable::CollideRef index) {
-    const WeaponInfo *type = this->type;
-    float speed = type->speed;
-    curdist += speed * simulation_atom_var;
-    prev_position = cur_position;
-    cur_position +=
-            ((ShipSpeed + drawmat.getR() * speed
-                    / ((type->type
-                            == WEAPON_TYPE::BALL) * type->radius
-                            + (type->type != WEAPON_TYPE::BALL) * type->length)).Cast() * simulation_atom_var);
-    if (curdist > type->range) {
-        this->Destroy(nondecal_index(index));         //risky
-        return false;
-    }
-    Collidable updated(**location);
-    updated.SetPosition(.5 * (prev_position + cur_position));
-    location = _Universe->activeStarSystem()->collide_map[Unit::UNIT_BOLT]->changeKey(location, updated);
-    return true;
+void BoltMotion::push_back(const QVector &position, const Vector &velocity, float speed, float range) {
+    x.push_back(position.i);
+    y.push_back(position.j);
+    z.push_back(position.k);
+    prev_x.push_back(position.i);
+    prev_y.push_back(position.j);
+    prev_z.push_back(position.k);
+    velocity_x.push_back(velocity.i);
+    velocity_y.push_back(velocity.j);
+    velocity_z.push_back(velocity.k);
+    this->speed.push_back(speed);
+    distance.push_back(0);
+    this->range.push_back(range);
+    expired.push_back(0);
 }
 
-class UpdateBolt {
-    CollideMap *collide_map;
-    StarSystem *starSystem;
-public:
-    UpdateBolt(StarSystem *ss, CollideMap *collide_map) {
-        this->starSystem = ss;
-        this->collide_map = collide_map;
-    }
-
-    void operator()(Collidable &collidable) {
-        if (collidable.radius < 0) {
-            Bolt *thus = Bolt::BoltFromIndex(collidable.ref);
-            if (!collide_map->CheckCollisions(thus, collidable)) {
-                thus->Update(collidable.ref);
-            }
-        }
-    }
-};
+template<class T>
+static inline void RemoveSwapped(std::vector<T> &values, size_t index) {
+    values[index] = values.back();
+    values.pop_back();
+}
 
-namespace vsalg {
-//
+void BoltMotion::remove(size_t index) {
+    RemoveSwapped(x, index);
+    RemoveSwapped(y, index);
+    RemoveSwapped(z, index);
+    RemoveSwapped(prev_x, index);
+    RemoveSwapped(prev_y, index);
+    RemoveSwapped(prev_z, index);
+    RemoveSwapped(velocity_x, index);
+    RemoveSwapped(velocity_y, index);
+    RemoveSwapped(velocity_z, index);
+    RemoveSwapped(speed, index);
+    RemoveSwapped(distance, index);
+    RemoveSwapped(range, index);
+    RemoveSwapped(expired, index);
+}
 
-template<typename IT, typename F>
-void for_each(IT start, IT end, F f) {
-    //This way, deletion of current item is allowed
-    //- drawback: iterator copy each iteration
-    while (start != end) {
-        f(*start++);
+void BoltMotion::Integrate(float atom) {
+    //Plain loops over plain arrays, no calls or branches, so that they vectorize
+    const size_t count = size();
+    double *px = x.data(), *py = y.data(), *pz = z.data();
+    double *ppx = prev_x.data(), *ppy = prev_y.data(), *ppz = prev_z.data();
+    const float *vx = velocity_x.data(), *vy = velocity_y.data(), *vz = velocity_z.data();
+    for (size_t i = 0; i < count; ++i) {
+        ppx[i] = px[i];
+        px[i] += static_cast<double>(vx[i] * atom);
+    }
+    for (size_t i = 0; i < count; ++i) {
+        ppy[i] = py[i];
+        py[i] += static_cast<double>(vy[i] * atom);
+    }
+    for (size_t i = 0; i < count; ++i) {
+        ppz[i] = pz[i];
+        pz[i] += static_cast<double>(vz[i] * atom);
+    }
+    float *travelled = distance.data();
+    const float *bolt_speed = speed.data(), *bolt_range = range.data();
+    uint8_t *out_of_range = expired.data();
+    for (size_t i = 0; i < count; ++i) {
+        travelled[i] += bolt_speed[i] * atom;
+        out_of_range[i] = travelled[i] > bolt_range[i];
     }
 }
 
-//
+const BoltMotion &Bolt::Motion(size_t &index) const {
+    BoltDrawManager &q = BoltDrawManager::GetInstance();
+    if (type->type == WEAPON_TYPE::BOLT) {
+        index = this - q.bolts[decal].data();
+        return q.bolt_motion[decal];
+    } else {
+        index = this - q.balls[decal].data();
+        return q.ball_motion[decal];
+    }
 }
 
-class UpdateBolts {
-    UpdateBolt sub;
-public:
-    UpdateBolts(StarSystem *ss, CollideMap *collide_map) : sub(ss, collide_map) {
+//Reused between groups; each simulation thread updates one system at a time
+static thread_local vector<CollideMap::iterator> bolt_locations;
+static thread_local vector<QVector> bolt_positions;
+
+void Bolt::UpdateGroup(vector<Bolt> &group, BoltMotion &motion, CollideMap *cm) {
+    //Back to front, so that bolts Destroy() moves into the gap are already done
+    for (size_t i = group.size(); i-- > 0;) {
+        group[i].Collide((*group[i].location)->ref);
+    }
+
+    motion.Integrate(simulation_atom_var);
+    for (size_t i = group.size(); i-- > 0;) {
+        if (motion.expired[i]) {
+            group[i].Destroy(i);
+        }
     }
 
-    template<class T>
-    void operator()(T &collidableList) {
-        vsalg::for_each(collidableList.begin(), collidableList.end(), sub);
+    //The collide map sorts the new keys once, when it is flattened
+    vector<CollideMap::iterator> &locations = bolt_locations;
+    vector<QVector> &positions = bolt_positions;
+    locations.resize(group.size());
+    positions.resize(group.size());
+    for (size_t i = 0; i < group.size(); ++i) {
+        locations[i] = group[i].location;
+        positions[i] = QVector(.5 * (motion.prev_x[i] + motion.x[i]),
+                .5 * (motion.prev_y[i] + motion.y[i]),
+                .5 * (motion.prev_z[i] + motion.z[i]));
     }
-};
+    cm->changeKeys(locations, positions);
+}
 
 void Bolt::UpdatePhysics(StarSystem *ss) {
+    VS_PROFILE_ZONE("Bolt::UpdatePhysics");
+    BoltDrawManager &q = BoltDrawManager::GetInstance();
     CollideMap *cm = ss->collide_map[Unit::UNIT_BOLT];
-    vsalg::for_each(cm->sorted.begin(), cm->sorted.end(), UpdateBolt(ss, cm));
-    vsalg::for_each(cm->toflattenhints.begin(), cm->toflattenhints.end(), UpdateBolts(ss, cm));
+    for (size_t decal = 0; decal < q.bolts.size(); ++decal) {
+        UpdateGroup(q.bolts[decal], q.bolt_motion[decal], cm);
+    }
+    for (size_t decal = 0; decal < q.balls.size(); ++decal) {
+        UpdateGroup(q.balls[decal], q.ball_motion[decal], cm);
+    }
 }
 
 bool Bolt::Collide(Unit *target) {
+    size_t index;
+    const BoltMotion &motion = Motion(index);
+    QVector prev_position = motion.PreviousPosition(index);
+    QVector cur_position = motion.Position(index);
     Vector normal;
     float distance;
     Unit *affectedSubUnit;
@@ -400,7 +466,7 @@ bool Bolt::Collide(Unit *target) {
         }
         QVector tmp = (cur_position - prev_position).Normalize();
         tmp = tmp.Scale(distance);
-        distance = curdist / this->type->range;
+        distance = motion.distance[index] / this->type->range;
         GFXColor coltmp(this->type->r, this->type->g, this->type->b, this->type->a);
         Damage damage(this->type->damage * ((1 - distance) + distance * this->type->long_range),
                 this->type->phase_damage * ((1 - distance) + distance * this->type->long_range));
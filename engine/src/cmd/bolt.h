@@ -34,21 +34,57 @@
 #include "collide_map.h"
 #include "gfx/animation.h"
 
+#include <cstdint>
+#include <vector>
+
 class Unit;
 class StarSystem;
 class BoltDrawManager;
 class Animation;
 class Texture;
 
+/**
+ * Where the bolts of one draw group (one texture or animation) are and how
+ * they move, as parallel arrays in the same order as their Bolt objects.
+ * Keeping it apart from the bulky Bolt lets a whole group advance in one
+ * tight loop the compiler can vectorize.
+ */
+class BoltMotion {
+public:
+    std::vector<double> x, y, z;
+    std::vector<double> prev_x, prev_y, prev_z;
+    //Constant for the life of the bolt: bolts fly straight
+    std::vector<float> velocity_x, velocity_y, velocity_z;
+    std::vector<float> speed;
+    std::vector<float> distance;
+    std::vector<float> range;
+    //Set by Integrate for bolts that flew past their range
+    std::vector<uint8_t> expired;
+
+    size_t size() const {
+        return x.size();
+    }
+
+    QVector Position(size_t index) const {
+        return QVector(x[index], y[index], z[index]);
+    }
+
+    QVector PreviousPosition(size_t index) const {
+        return QVector(prev_x[index], prev_y[index], prev_z[index]);
+    }
+
+    void push_back(const QVector &position, const Vector &velocity, float speed, float range);
+    //Moves the last bolt into index, like Destroy does with the Bolt objects
+    void remove(size_t index);
+    //Advances every bolt by one atom and flags the ones out of range
+    void Integrate(float atom);
+};
+
 class Bolt {
 private:
     const WeaponInfo *type;//beam or bolt;
     Matrix drawmat;
-    QVector cur_position;
-    Vector ShipSpeed;
-    QVector prev_position;//beams don't change heading.
     void *owner;
-    float curdist;
     int decal;//which image it uses
     float bolt_size; // actually squared
     std::string bolt_name;
@@ -59,6 +95,11 @@ private:
     Texture *bolt_texture;
     Animation animation;
 
+    //Position and state of this bolt in its draw group
+    const BoltMotion &Motion(size_t &index) const;
+    //Runs one atom of the bolts of a draw group
+    static void UpdateGroup(std::vector<Bolt> &group, BoltMotion &motion, CollideMap *cm);
+
 public:
     CollideMap::iterator location;
     static int AddTexture(BoltDrawManager *q, std::string filename);
@@ -68,14 +109,6 @@ public:
     static Bolt *BoltFromIndex(Collidable::CollideRef bolt_name);
     static Collidable::CollideRef BoltIndex(int index, int decal, bool isBall);
 
-    bool operator==(const Bolt &b) const {
-
-        return owner == b.owner
-                && curdist == b.curdist
-                && cur_position == b.cur_position
-                && prev_position == b.prev_position;
-    }
-
     Bolt(const WeaponInfo *type,
             const Matrix &orientationpos,
             const Vector &ShipSpeed,
@@ -85,9 +118,8 @@ public:
     //static void Draw();
     static void DrawAllBolts();
     static void DrawAllBalls();
-    void DrawBolt(GFXVertexList *qmesh);
-    void DrawBall(float &bolt_size, Animation *cur);
-    bool Update(Collidable::CollideRef index);
+    void DrawBolt(GFXVertexList *qmesh, const QVector &cur_position, const QVector &prev_position);
+    void DrawBall(float &bolt_size, Animation *cur, const QVector &cur_position, const QVector &prev_position);
     bool Collide(Collidable::CollideRef index);
     static void UpdatePhysics(StarSystem *ss);//updates all physics in the starsystem
     void noop() const {
@@ -30,7 +30,7 @@
 #include "oldcollection.cpp"
 #elif defined (USE_STL_COLLECTION)
 
-#include <list>
+#include <iterator>
 #include <vector>
 #ifndef LIST_TESTING
 #include "unit_util.h"
@@ -42,8 +42,10 @@
 
 #include "vs_logging.h"
 
-using std::list;
 using std::vector;
+
+const UnitCollection::Slot UnitCollection::head;
+
 //UnitIterator  BEGIN:
 
 UnitCollection::UnitIterator &UnitCollection::UnitIterator::operator=(const UnitCollection::UnitIterator &orig) {
@@ -57,12 +59,14 @@ UnitCollection::UnitIterator &UnitCollection::UnitIterator::operator=(const Unit
         }
     }
     it = orig.it;
+    generation = orig.generation;
     return *this;
 }
 
 UnitCollection::UnitIterator::UnitIterator(const UnitIterator &orig) {
     col = orig.col;
     it = orig.it;
+    generation = orig.generation;
     if (col) {
         col->reg(this);
     }
@@ -70,14 +74,15 @@ UnitCollection::UnitIterator::UnitIterator(const UnitIterator &orig) {
 
 UnitCollection::UnitIterator::UnitIterator(UnitCollection *orig) {
     col = orig;
-    it = col->u.begin();
+    seek(col->nodes[head].next);
     col->reg(this);
-    while (it != col->u.end()) {
-        if ((*it) == NULL) {
-            ++it;
+    while (it != head) {
+        if (col->nodes[it].unit == NULL) {
+            seek(col->nodes[it].next);
         } else {
-            if ((*it)->Killed()) {
+            if (col->nodes[it].unit->Killed()) {
                 col->erase(it);
+                generation = col->nodes[it].generation;
             } else {
                 break;
             }
@@ -91,44 +96,52 @@ UnitCollection::UnitIterator::~UnitIterator() {
     }
 }
 
+inline void UnitCollection::UnitIterator::seek(Slot slot) {
+    it = slot;
+    generation = col->nodes[slot].generation;
+}
+
 void UnitCollection::UnitIterator::remove() {
-    if (col && it != col->u.end()) {
+    if (col && col->valid(it, generation)) {
         col->erase(it);
+        generation = col->nodes[it].generation;
     }
 }
 
 void UnitCollection::UnitIterator::moveBefore(UnitCollection &otherlist) {
-    if (col && it != col->u.end()) {
-        otherlist.prepend(*it);
+    if (col && col->valid(it, generation)) {
+        otherlist.prepend(col->nodes[it].unit);
         col->erase(it);
+        generation = col->nodes[it].generation;
     }
 }
 
 void UnitCollection::UnitIterator::preinsert(Unit *unit) {
     if (col && unit) {
         col->insert(it, unit);
+        generation = col->nodes[it].generation;
     }
 }
 
 void UnitCollection::UnitIterator::postinsert(Unit *unit) {
-    list<Unit *>::iterator tmp = it;
-    if (col && unit && it != col->u.end()) {
-        ++tmp;
+    if (col && unit && col->valid(it, generation)) {
+        Slot tmp = col->nodes[it].next;
         col->insert(tmp, unit);
     }
 }
 
 void UnitCollection::UnitIterator::advance() {
-    if (!col || it == col->u.end()) {
+    if (!col || !col->valid(it, generation)) {
         return;
     }
-    ++it;
-    while (it != col->u.end()) {
-        if ((*it) == NULL) {
-            ++it;
+    seek(col->nodes[it].next);
+    while (it != head) {
+        if (col->nodes[it].unit == NULL) {
+            seek(col->nodes[it].next);
         } else {
-            if ((*it)->Killed()) {
+            if (col->nodes[it].unit->Killed()) {
                 col->erase(it);
+                generation = col->nodes[it].generation;
             } else {
                 break;
             }
@@ -138,7 +151,7 @@ void UnitCollection::UnitIterator::advance() {
 
 Unit *UnitCollection::UnitIterator::next() {
     advance();
-    return *it;
+    return **this;
 }
 
 //UnitIterator END:
@@ -158,8 +171,9 @@ UnitCollection::ConstIterator::ConstIterator(const ConstIterator &orig) {
 
 UnitCollection::ConstIterator::ConstIterator(const UnitCollection *orig) {
     col = orig;
-    for (it = orig->u.begin(); it != col->u.end(); ++it) {
-        if ((*it) && !(*it)->Killed()) {
+    for (it = orig->nodes[head].next; it != head; it = col->nodes[it].next) {
+        Unit *unit = col->nodes[it].unit;
+        if (unit && !unit->Killed()) {
             break;
         }
     }
@@ -170,27 +184,23 @@ UnitCollection::ConstIterator::~ConstIterator() {
 
 Unit *UnitCollection::ConstIterator::next() {
     advance();
-    if (col && it != col->u.end()) {
-        return *it;
+    if (col && it != head) {
+        return col->nodes[it].unit;
     }
     return NULL;
 }
 
 inline void UnitCollection::ConstIterator::advance() {
-    if (!col || it == col->u.end()) {
+    if (!col || it == head) {
         return;
     }
-    ++it;
-    while (it != col->u.end()) {
-        if ((*it) == NULL) {
-            ++it;
-        } else {
-            if ((*it)->Killed()) {
-                ++it;
-            } else {
-                break;
-            }
+    it = col->nodes[it].next;
+    while (it != head) {
+        Unit *unit = col->nodes[it].unit;
+        if (unit && !unit->Killed()) {
+            break;
         }
+        it = col->nodes[it].next;
     }
 }
 
@@ -209,34 +219,76 @@ const UnitCollection::ConstIterator UnitCollection::ConstIterator::operator++(in
 
 //UnitCollection  BEGIN:
 
-UnitCollection::UnitCollection() {
+UnitCollection::UnitCollection() : num_units(0) {
     activeIters.reserve(20);
-}
-
-UnitCollection::UnitCollection(const UnitCollection &uc) {
-    list<Unit *>::const_iterator in = uc.u.begin();
-    while (in != uc.u.end()) {
-        append(*in);
-        ++in;
+    Node list_head = {NULL, head, head, 0};
+    nodes.push_back(list_head);
+}
+
+UnitCollection::UnitCollection(const UnitCollection &uc) : num_units(0) {
+    Node list_head = {NULL, head, head, 0};
+    nodes.reserve(uc.num_units + 1);
+    nodes.push_back(list_head);
+    for (Slot slot = uc.nodes[head].next; slot != head; slot = uc.nodes[slot].next) {
+        append(uc.nodes[slot].unit);
+    }
+}
+
+UnitCollection::Slot UnitCollection::link_before(Slot position, Unit *unit) {
+    Slot slot;
+    if (free_slots.empty()) {
+        slot = nodes.size();
+        Node node = {unit, head, head, 0};
+        nodes.push_back(node);
+    } else {
+        slot = free_slots.back();
+        free_slots.pop_back();
+        nodes[slot].unit = unit;
+    }
+    Slot prev = nodes[position].prev;
+    nodes[slot].prev = prev;
+    nodes[slot].next = position;
+    nodes[prev].next = slot;
+    nodes[position].prev = slot;
+    index.insert(std::make_pair(unit, slot));
+    ++num_units;
+    return slot;
+}
+
+void UnitCollection::unlink(Slot slot) {
+    Node &node = nodes[slot];
+    nodes[node.prev].next = node.next;
+    nodes[node.next].prev = node.prev;
+    node.unit = NULL;
+    ++node.generation;
+    free_slots.push_back(slot);
+}
+
+void UnitCollection::unindex(const Unit *unit, Slot slot) {
+    auto range = index.equal_range(unit);
+    for (auto entry = range.first; entry != range.second; ++entry) {
+        if (entry->second == slot) {
+            index.erase(entry);
+            break;
+        }
     }
+    --num_units;
 }
 
 void UnitCollection::insert_unique(Unit *unit) {
     if (unit) {
-        for (list<Unit *>::iterator it = u.begin(); it != u.end(); ++it) {
-            if (*it == unit) {
-                return;
-            }
+        if (index.find(unit) != index.end()) {
+            return;
         }
         unit->Ref();
-        u.push_front(unit);
+        link_before(nodes[head].next, unit);
     }
 }
 
 void UnitCollection::prepend(Unit *unit) {
     if (unit) {
         unit->Ref();
-        u.push_front(unit);
+        link_before(nodes[head].next, unit);
     }
 }
 
@@ -245,11 +297,10 @@ void UnitCollection::prepend(UnitIterator *it) {
     if (!it) {
         return;
     }
-    list<Unit *>::iterator tmpI = u.begin();
+    Slot first = nodes[head].next;
     while ((tmp = **it)) {
         tmp->Ref();
-        u.insert(tmpI, tmp);
-        ++tmpI;
+        link_before(first, tmp);
         it->advance();
     }
 }
@@ -257,7 +308,7 @@ void UnitCollection::prepend(UnitIterator *it) {
 void UnitCollection::append(Unit *un) {
     if (un) {
         un->Ref();
-        u.push_back(un);
+        link_before(head, un);
     }
 }
 
@@ -268,17 +319,17 @@ void UnitCollection::append(UnitIterator *it) {
     Unit *tmp = NULL;
     while ((tmp = **it)) {
         tmp->Ref();
-        u.push_back(tmp);
+        link_before(head, tmp);
         it->advance();
     }
 }
 
-void UnitCollection::insert(list<Unit *>::iterator &temp, Unit *unit) {
+void UnitCollection::insert(Slot &temp, Unit *unit) {
     if (unit) {
         unit->Ref();
-        temp = u.insert(temp, unit);
+        link_before(temp, unit);
     }
-    temp = u.end();
+    temp = head;
 }
 
 void UnitCollection::clear() {
@@ -287,91 +338,130 @@ void UnitCollection::clear() {
         return;
     }
 
-    for (list<Unit *>::iterator it = u.begin(); it != u.end(); ++it) {
-        (*it)->UnRef();
-        (*it) = NULL;
+    for (Slot slot = nodes[head].next; slot != head; slot = nodes[slot].next) {
+        if (nodes[slot].unit) {
+            nodes[slot].unit->UnRef();
+        }
     }
-    u.clear();
+    nodes.resize(1);
+    nodes[head].prev = nodes[head].next = head;
+    free_slots.clear();
+    removedIters.clear();
+    index.clear();
+    num_units = 0;
 }
 
 void UnitCollection::destr() {
-    for (list<Unit *>::iterator it = u.begin(); it != u.end(); ++it) {
-        if (*it) {
-            (*it)->UnRef();
-            (*it) = NULL;
+    for (Slot slot = nodes[head].next; slot != head; slot = nodes[slot].next) {
+        if (nodes[slot].unit) {
+            nodes[slot].unit->UnRef();
+            nodes[slot].unit = NULL;
         }
     }
+    index.clear();
+    num_units = 0;
     for (vector<un_iter *>::iterator t = activeIters.begin(); t != activeIters.end(); ++t) {
         (*t)->col = NULL;
     }
 }
 
 bool UnitCollection::contains(const Unit *unit) const {
-    if (u.empty() || !unit) {
+    if (!unit) {
         return false;
     }
-    for (list<Unit *>::const_iterator it = u.begin(); it != u.end(); ++it) {
-        if ((*it) == unit && !(*it)->Killed()) {
-            return true;
-        }
-    }
-    return false;
+    auto entry = index.find(unit);
+    return entry != index.end() && !nodes[entry->second].unit->Killed();
 }
 
-inline void UnitCollection::erase(list<Unit *>::iterator &it2) {
-    if (!(*it2)) {
-        ++it2;
+inline void UnitCollection::erase(Slot &it2) {
+    Unit *unit = nodes[it2].unit;
+    if (!unit) {
+        it2 = nodes[it2].next;
         return;
     }
+    unindex(unit, it2);
     //If we have more than 4 iterators, just push node onto vector.
     if (activeIters.size() > 3) {
         removedIters.push_back(it2);
-        (*it2)->UnRef();
-        (*it2) = NULL;
-        ++it2;
+        nodes[it2].unit = NULL;
+        unit->UnRef();
+        it2 = nodes[it2].next;
         return;
     }
-    //If we have between 2 and 4 iterators, see if any are actually
-    //on the node we want to remove, if so, just push onto vector.
+    //If we have up to 4 iterators, see if any are actually on the node we
+    //want to remove, if so, just push onto vector, so that they move on to
+    //the next node from there. The iterator doing the erasing moves on by itself.
     //Purpose : This special case is to reduce the size of the list in the
     //situation where removedIters isn't being processed.
-    if (activeIters.size() > 1) {
-        for (vector<UnitCollection::UnitIterator *>::size_type i = 0; i < activeIters.size(); ++i) {
-            if (activeIters[i]->it == it2) {
-                removedIters.push_back(it2);
-                (*it2)->UnRef();
-                (*it2) = NULL;
-                ++it2;
-                return;
-            }
+    for (vector<UnitCollection::UnitIterator *>::size_type i = 0; i < activeIters.size(); ++i) {
+        if (activeIters[i]->it == it2 && &activeIters[i]->it != &it2) {
+            removedIters.push_back(it2);
+            nodes[it2].unit = NULL;
+            unit->UnRef();
+            it2 = nodes[it2].next;
+            return;
         }
     }
-    //If we have 1 iterator, or none of the iterators are currently on the
-    //requested node to be removed, then remove it right away.
-    (*it2)->UnRef();
-    (*it2) = NULL;
-    it2 = u.erase(it2);
+    //If none of the other iterators are currently on the requested node
+    //to be removed, then remove it right away.
+    Slot next = nodes[it2].next;
+    unlink(it2);
+    unit->UnRef();
+    it2 = next;
 }
 
 bool UnitCollection::remove(const Unit *unit) {
-    if (u.empty() || !unit) {
+    if (!unit) {
+        return false;
+    }
+    auto range = index.equal_range(unit);
+    if (range.first == range.second) {
         return false;
     }
-    for (list<Unit *>::iterator it = u.begin(); it != u.end(); ++it) {
-        if ((*it) == unit) {
-            erase(it);
-            return (true);
+    Slot slot = range.first->second;
+    if (std::next(range.first) != range.second) {
+        //In the list more than once: take the first one in list order
+        for (slot = nodes[head].next; nodes[slot].unit != unit; slot = nodes[slot].next) {
+        }
+    }
+    erase(slot);
+    return true;
+}
+
+void UnitCollection::compact() {
+    if (!activeIters.empty() || free_slots.empty()) {
+        return;
+    }
+    vector<Node> compacted;
+    compacted.reserve(num_units + 1);
+    Node list_head = {NULL, head, head, 0};
+    compacted.push_back(list_head);
+    index.clear();
+    for (Slot slot = nodes[head].next; slot != head; slot = nodes[slot].next) {
+        if (!nodes[slot].unit) {
+            continue;
         }
+        Slot position = compacted.size();
+        Node node = {nodes[slot].unit, static_cast<Slot>(position - 1), head, 0};
+        compacted[position - 1].next = position;
+        compacted.push_back(node);
+        index.insert(std::make_pair(node.unit, position));
     }
-    return (false);
+    compacted[head].prev = compacted.size() - 1;
+    nodes.swap(compacted);
+    free_slots.clear();
+    removedIters.clear();
 }
 
 const UnitCollection &UnitCollection::operator=(const UnitCollection &uc) {
     destr();
-    list<Unit *>::const_iterator in = uc.u.begin();
-    while (in != uc.u.end()) {
-        append(*in);
-        ++in;
+    activeIters.clear();
+    nodes.resize(1);
+    nodes[head].prev = nodes[head].next = head;
+    free_slots.clear();
+    removedIters.clear();
+    for (Slot slot = uc.nodes[head].next; slot != head; slot = uc.nodes[slot].next) {
+        append(uc.nodes[slot].unit);
     }
     return *this;
 }
@@ -388,9 +478,10 @@ inline void UnitCollection::unreg(un_iter *iter) {
         }
     }
     if (activeIters.empty()
-            || (activeIters.size() == 1 && (activeIters[0]->it == u.end() || (*(activeIters[0]->it))))) {
+            || (activeIters.size() == 1
+                    && (activeIters[0]->it == head || nodes[activeIters[0]->it].unit))) {
         while (!removedIters.empty()) {
-            u.erase(removedIters.back());
+            unlink(removedIters.back());
             removedIters.pop_back();
         }
     }
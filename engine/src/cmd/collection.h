@@ -39,7 +39,9 @@
 #elif defined (USE_STL_COLLECTION)
 
 #include <cstddef>
-#include <list>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
 #include <vector>
 
 class Unit;
@@ -50,9 +52,17 @@ class Unit;
  * Currently, you dont assign one collection to another.
  * You're not supposed to hold references to the list across physics frames
  * UnitCollection is designed to be robust to at least 20,000 units.
+ *
+ * The list is doubly linked through indices into one contiguous array of
+ * nodes (a slot map), so walking it mostly scans memory linearly; compact()
+ * restores list order in memory. An index from unit to node makes
+ * contains() and remove() O(1).
  */
 class UnitCollection {
 public:
+    /* Position of a node in the node array */
+    typedef uint32_t Slot;
+
     /*
      * UnitIterator is the "node" class for UnitCollection.
      * It's meant to mimic std::iterator's for the most part, but
@@ -62,7 +72,7 @@ public:
      */
     class UnitIterator {
     public:
-        UnitIterator() : col(NULL) {
+        UnitIterator() : col(NULL), it(0), generation(0) {
         }
 
         UnitIterator(const UnitIterator &);
@@ -70,7 +80,7 @@ public:
         virtual ~UnitIterator();
 
         inline bool isDone() {
-            if (col && it != col->u.end()) {
+            if (col && col->valid(it, generation)) {
                 return false;
             }
             return true;
@@ -112,8 +122,8 @@ public:
         }
 
         inline Unit *operator*() {
-            if (col && it != col->u.end()) {
-                return *it;
+            if (col && col->valid(it, generation)) {
+                return col->nodes[it].unit;
             }
             return NULL;
         }
@@ -123,8 +133,12 @@ public:
         //Pointer back to the collection we were spawned from
         UnitCollection *col;
 
-        //Current position in the list
-        std::list<class Unit *>::iterator it;
+        //Current position in the list, and the generation of that node
+        //when we got there; a mismatch means the node was recycled under us
+        Slot it;
+        uint32_t generation;
+
+        void seek(Slot slot);
     };
 
     /* This class is to be used when no changes to the list are made
@@ -134,7 +148,7 @@ public:
      */
     class ConstIterator {
     public:
-        ConstIterator() : col(NULL) {
+        ConstIterator() : col(NULL), it(0) {
         }
 
         ConstIterator(const ConstIterator &);
@@ -148,7 +162,7 @@ public:
         }
 
         inline bool isDone() {
-            if (col && it != col->u.end()) {
+            if (col && it != head) {
                 return false;
             }
             return true;
@@ -159,8 +173,8 @@ public:
         const ConstIterator operator++(int);
 
         inline Unit *operator*() const {
-            if (it != col->u.end() && !col->empty()) {
-                return *it;
+            if (col && it != head && !col->empty()) {
+                return col->nodes[it].unit;
             }
             return NULL;
         }
@@ -168,7 +182,7 @@ public:
     protected:
         friend class UnitCollection;
         const UnitCollection *col;
-        std::list<class Unit *>::const_iterator it;
+        Slot it;
     };
 
     /* backwards compatibility only.  Typedefs suck. dont use them. */
@@ -199,18 +213,11 @@ public:
         return ConstFastIterator(this);
     }
 
-    /* Traverses entire list and only inserts if no matches are found
-     * Do not use in any fast-code paths */
+    /* Only inserts if the unit is not in the list yet */
     void insert_unique(Unit *);
 
     inline bool empty() const {
-        if (u.empty()) {
-            return true;
-        } else if (removedIters.empty() || u.size() > removedIters.size()) {
-            return false;
-        } else {
-            return true;
-        }
+        return num_units == 0;
     }
 
     // Add a unit or iterator to the front of the list. */
@@ -222,7 +229,7 @@ public:
     void append(UnitIterator *);
 
     /* This is how iterators insert units. Always inserts before iterator */
-    void insert(std::list<Unit *>::iterator &, Unit *);
+    void insert(Slot &, Unit *);
 
     /* Whipes out entire list only if no iterators are being held.
      * No code uses this function as of 0.5 release */
@@ -234,27 +241,31 @@ public:
      * 1. if we have less than 4 iterators being held
      * 2. if none of those iterators are referencing the requested unit
      * Otherwise the Unit pointer is removed from the list and set to NULL,
-     * and the iterator is referenced on another list to be deleted
+     * and the node is referenced on another list to be deleted
      * the delete list is processed when the number of iterators hits 1 or 0.
      * The reason for this is so we can be scalable to 20,000+ units and
      * modifications to the list by multiple held iterators dont bog us down
      */
-    void erase(std::list<class Unit *>::iterator &);
+    void erase(Slot &);
 
-    /* traverse list and remove first (only) matching Unit.
-     * Do not use in fast-path code */
+    /* Remove first (only) matching Unit */
     bool remove(const class Unit *);
 
+    /* Moves the nodes back into list order in memory, so that iteration is a
+     * linear scan again. Does nothing while iterators are held, so only call
+     * it where no ConstIterator can be alive either. */
+    void compact();
+
     /* Returns number of non-null units in list */
     inline const int size() const {
-        return u.size() - removedIters.size();
+        return num_units;
     }
 
     /* Returns last non-null unit in list. May be Killed() */
     inline Unit *back() {
-        for (std::list<Unit *>::reverse_iterator it = u.rbegin(); it != u.rend(); ++it) {
-            if (*it) {
-                return *it;
+        for (Slot slot = nodes[head].prev; slot != head; slot = nodes[slot].prev) {
+            if (nodes[slot].unit) {
+                return nodes[slot].unit;
             }
         }
         return NULL;
@@ -262,9 +273,9 @@ public:
 
     /* Returns first non-null unit in list. May be Killed() */
     inline Unit *front() {
-        for (std::list<Unit *>::iterator it = u.begin(); it != u.end(); ++it) {
-            if (*it) {
-                return *it;
+        for (Slot slot = nodes[head].next; slot != head; slot = nodes[slot].next) {
+            if (nodes[slot].unit) {
+                return nodes[slot].unit;
             }
         }
         return NULL;
@@ -274,6 +285,28 @@ private:
     friend class UnitIterator;
     friend class ConstIterator;
 
+    struct Node {
+        Unit *unit;
+        Slot prev;
+        Slot next;
+        //Bumped whenever the node is unlinked, so stale positions can be told apart
+        uint32_t generation;
+    };
+
+    /* Node 0 is the list head: its next is the first node and its prev the
+     * last one. Iterators at the head are done. */
+    static const Slot head = 0;
+
+    inline bool valid(Slot slot, uint32_t generation) const {
+        return slot != head && nodes[slot].generation == generation;
+    }
+
+    /* Links a new node for the unit in before the given node */
+    Slot link_before(Slot position, Unit *unit);
+    /* Takes a node out of the list and recycles it */
+    void unlink(Slot slot);
+    void unindex(const Unit *unit, Slot slot);
+
     /* Does not clear list.  It sets all the Unit pointers to null
      * And sets all the current iterator's collection pointers to NULL.
      * Effectively shutting the list down so it can be destroyed safely. */
@@ -299,10 +332,23 @@ private:
     /* This is a list of positions in the collection that are pointing to
      * NULL units, positions that should be removed from the collection
      * but couldn't because another iterator was referencing it. */
-    std::vector<std::list<class Unit *>::iterator> removedIters;
+    std::vector<Slot> removedIters;
+
+    /* Main collection; see Node */
+    std::vector<Node> nodes;
+    /* Unlinked nodes, ready for reuse */
+    std::vector<Slot> free_slots;
+    /* gnuhash.h specializes std::hash for units, which this header can't
+     * see, so hash the address by hand the same way */
+    struct UnitHash {
+        size_t operator()(const Unit *unit) const {
+            return std::hash<uintptr_t>()(reinterpret_cast<uintptr_t>(unit) >> 4);
+        }
+    };
 
-    /* Main collection */
-    std::list<class Unit *> u;
+    /* Where each unit is. A unit may be in the list more than once */
+    std::unordered_multimap<const Unit *, Slot, UnitHash> index;
+    int num_units;
 };
 
 /* Typedefs.   We really should not use them but we're lazy */
@@ -0,0 +1,270 @@
+/*
+ * collide_broadphase.cpp
+ *
+ * Copyright (C) 2023 Vega Strike contributors.
+ *
+ * https://github.com/vegastrike/Vega-Strike-Engine-Source
+ *
+ * This file is part of Vega Strike.
+ *
+ * Vega Strike is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Vega Strike is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Vega Strike. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "collide_broadphase.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "collide_map.h"
+
+namespace {
+
+// Radius an entry collides with, or 0 if it should be skipped
+inline float SearchRadius(const Collidable &collidable) {
+    float radius = std::fabs(collidable.radius);
+    return radius > 0 ? radius : 0;
+}
+
+inline bool WithinReach(const Collidable &collidable, const QVector &center, double reach) {
+    float radius = SearchRadius(collidable);
+    if (radius == 0) {
+        return false;
+    }
+    double limit = reach + radius;
+    return limit >= 0 && (collidable.position - center).MagnitudeSquared() <= limit * limit;
+}
+
+class CollectVisitor : public CollideBroadphase::Visitor {
+public:
+    CollectVisitor(double distance, std::vector<size_t> &result) : distance(distance), result(result) {
+    }
+
+    double Reach() const override {
+        return distance;
+    }
+
+    bool Visit(size_t index) override {
+        result.push_back(index);
+        return true;
+    }
+
+private:
+    double distance;
+    std::vector<size_t> &result;
+};
+
+} // namespace
+
+void CollideBroadphase::Query(const QVector &center, double distance, std::vector<size_t> &result) const {
+    CollectVisitor visitor(distance, result);
+    Search(center, visitor);
+}
+
+std::unique_ptr<CollideBroadphase> CollideBroadphase::Create(const std::string &kind) {
+    if (kind == "sorted_axis") {
+        return std::unique_ptr<CollideBroadphase>(new SortedAxisBroadphase());
+    }
+    if (kind == "loose_octree") {
+        return std::unique_ptr<CollideBroadphase>(new LooseOctreeBroadphase());
+    }
+    return nullptr;
+}
+
+void SortedAxisBroadphase::Build(const Collidable *begin, const Collidable *end) {
+    first = begin;
+    last = end;
+    max_radius = 0;
+    for (const Collidable *collidable = begin; collidable != end; ++collidable) {
+        max_radius = std::max<double>(max_radius, SearchRadius(*collidable));
+    }
+}
+
+void SortedAxisBroadphase::Search(const QVector &center, Visitor &visitor) const {
+    if (first == last) {
+        return;
+    }
+    Collidable key;
+    key.position = center;
+    const Collidable *more = std::lower_bound(first, last, key);
+    const Collidable *less = more;
+    bool work_less = less != first;
+    bool work_more = more != last;
+    //Step whichever side is closer along X, so the visit order is roughly by distance
+    while (work_less || work_more) {
+        double reach = visitor.Reach();
+        if (reach < 0) {
+            return;
+        }
+        double less_gap = work_less ? center.i - (less - 1)->position.i : HUGE_VAL;
+        double more_gap = work_more ? more->position.i - center.i : HUGE_VAL;
+        const Collidable *next;
+        if (less_gap <= more_gap) {
+            if (less_gap > reach + max_radius) {
+                work_less = false;
+                continue;
+            }
+            next = --less;
+            work_less = less != first;
+        } else {
+            if (more_gap > reach + max_radius) {
+                work_more = false;
+                continue;
+            }
+            next = more++;
+            work_more = more != last;
+        }
+        if (WithinReach(*next, center, reach) && !visitor.Visit(next - first)) {
+            return;
+        }
+    }
+}
+
+void LooseOctreeBroadphase::Build(const Collidable *begin, const Collidable *end) {
+    first = begin;
+    nodes.clear();
+    items.clear();
+    QVector low(HUGE_VAL, HUGE_VAL, HUGE_VAL);
+    QVector high(-HUGE_VAL, -HUGE_VAL, -HUGE_VAL);
+    for (const Collidable *collidable = begin; collidable != end; ++collidable) {
+        const QVector &position = collidable->position;
+        if (SearchRadius(*collidable) == 0
+                || !std::isfinite(position.i) || !std::isfinite(position.j) || !std::isfinite(position.k)) {
+            continue;
+        }
+        items.push_back(collidable - begin);
+        low = QVector(std::min(low.i, position.i), std::min(low.j, position.j), std::min(low.k, position.k));
+        high = QVector(std::max(high.i, position.i), std::max(high.j, position.j), std::max(high.k, position.k));
+    }
+    if (items.empty()) {
+        return;
+    }
+    QVector extent = high - low;
+    double half_size = std::max(std::max(extent.i, extent.j), extent.k) * .5 + 1;
+    nodes.push_back(Node());
+    BuildNode(0, (low + high) * .5, half_size, 0, items.size(), 0);
+}
+
+void LooseOctreeBroadphase::BuildNode(uint32_t index,
+        const QVector &center,
+        double half_size,
+        uint32_t begin,
+        uint32_t end,
+        int depth) {
+    float max_radius = 0;
+    for (uint32_t i = begin; i < end; ++i) {
+        max_radius = std::max(max_radius, SearchRadius(first[items[i]]));
+    }
+    Node &node = nodes[index];
+    node.center = center;
+    node.half_size = half_size;
+    node.max_radius = max_radius;
+    node.begin = begin;
+    node.end = end;
+    node.children = 0;
+    if (end - begin <= kLeafSize || depth >= kMaxDepth) {
+        return;
+    }
+
+    //Sort the items of this node by octant: bit 0 is X, 1 is Y and 2 is Z
+    uint32_t octant_end[8] = {};
+    std::vector<uint32_t> octant_of(end - begin);
+    for (uint32_t i = begin; i < end; ++i) {
+        const QVector &position = first[items[i]].position;
+        uint32_t octant = (position.i >= center.i ? 1 : 0)
+                | (position.j >= center.j ? 2 : 0)
+                | (position.k >= center.k ? 4 : 0);
+        octant_of[i - begin] = octant;
+        ++octant_end[octant];
+    }
+    if (std::count(octant_end, octant_end + 8, 0) == 7 && half_size < 1) {
+        //Stacked on top of each other: no split is going to separate them
+        return;
+    }
+    uint32_t octant_begin[8];
+    uint32_t position = begin;
+    for (int octant = 0; octant < 8; ++octant) {
+        octant_begin[octant] = position;
+        position += octant_end[octant];
+        octant_end[octant] = octant_begin[octant];
+    }
+    std::vector<uint32_t> sorted_items(end - begin);
+    for (uint32_t i = begin; i < end; ++i) {
+        sorted_items[octant_end[octant_of[i - begin]]++ - begin] = items[i];
+    }
+    std::copy(sorted_items.begin(), sorted_items.end(), items.begin() + begin);
+
+    //Children are allocated together so that a node only needs to know the first
+    uint32_t children = nodes.size();
+    nodes[index].children = children;
+    nodes.resize(children + 8);
+    double quarter = half_size * .5;
+    for (int octant = 0; octant < 8; ++octant) {
+        QVector child_center(center.i + (octant & 1 ? quarter : -quarter),
+                center.j + (octant & 2 ? quarter : -quarter),
+                center.k + (octant & 4 ? quarter : -quarter));
+        BuildNode(children + octant, child_center, quarter, octant_begin[octant], octant_end[octant], depth + 1);
+    }
+}
+
+void LooseOctreeBroadphase::Search(const QVector &center, Visitor &visitor) const {
+    if (!nodes.empty()) {
+        SearchNode(0, center, visitor);
+    }
+}
+
+bool LooseOctreeBroadphase::SearchNode(uint32_t index, const QVector &center, Visitor &visitor) const {
+    const Node &node = nodes[index];
+    if (node.children == 0) {
+        for (uint32_t i = node.begin; i < node.end; ++i) {
+            double reach = visitor.Reach();
+            if (reach < 0) {
+                return false;
+            }
+            if (WithinReach(first[items[i]], center, reach) && !visitor.Visit(items[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    //Visit the children nearest first, so that narrowing searches can skip the rest
+    std::pair<double, uint32_t> order[8];
+    int count = 0;
+    for (uint32_t child = node.children; child < node.children + 8; ++child) {
+        const Node &child_node = nodes[child];
+        if (child_node.begin == child_node.end) {
+            continue;
+        }
+        QVector offset = center - child_node.center;
+        double dx = std::max(0.0, std::fabs(offset.i) - child_node.half_size);
+        double dy = std::max(0.0, std::fabs(offset.j) - child_node.half_size);
+        double dz = std::max(0.0, std::fabs(offset.k) - child_node.half_size);
+        order[count++] = std::make_pair(std::sqrt(dx * dx + dy * dy + dz * dz) - child_node.max_radius, child);
+    }
+    std::sort(order, order + count);
+    for (int i = 0; i < count; ++i) {
+        double reach = visitor.Reach();
+        if (reach < 0) {
+            return false;
+        }
+        if (order[i].first > reach) {
+            break;
+        }
+        if (!SearchNode(order[i].second, center, visitor)) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,126 @@
+/*
+ * collide_broadphase.h
+ *
+ * Copyright (C) 2023 Vega Strike contributors.
+ *
+ * https://github.com/vegastrike/Vega-Strike-Engine-Source
+ *
+ * This file is part of Vega Strike.
+ *
+ * Vega Strike is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Vega Strike is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Vega Strike. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef VEGA_STRIKE_ENGINE_CMD_COLLIDE_BROADPHASE_H
+#define VEGA_STRIKE_ENGINE_CMD_COLLIDE_BROADPHASE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gfx/vec.h"
+
+class Collidable;
+
+/**
+ * @brief A spatial index over the sorted array of a CollideArray.
+ *
+ * It is rebuilt every time the array is flattened and answers "what is near
+ * this point" with indices into that array. Collidables are spheres of
+ * radius fabs(radius) (bolts store a negative radius); entries whose radius
+ * is 0 or NaN are skipped, so entries erased after the build simply drop out.
+ */
+class CollideBroadphase {
+public:
+    class Visitor {
+    public:
+        virtual ~Visitor() = default;
+
+        // How far past the surface of a collidable the query centre may be
+        // for it to be visited. Checked again after every visit, so a
+        // search can narrow as it goes; negative ends the search.
+        virtual double Reach() const = 0;
+
+        // Returns false to end the search
+        virtual bool Visit(size_t index) = 0;
+    };
+
+    virtual ~CollideBroadphase() = default;
+
+    // Indexes [begin, end). The array must stay where it is until the next build.
+    virtual void Build(const Collidable *begin, const Collidable *end) = 0;
+
+    // Visits collidables within visitor.Reach() of center, roughly nearest first
+    virtual void Search(const QVector &center, Visitor &visitor) const = 0;
+
+    // Appends the index of every collidable within distance of center
+    void Query(const QVector &center, double distance, std::vector<size_t> &result) const;
+
+    // "sorted_axis" or "loose_octree". Anything else, including "builtin",
+    // returns nullptr: the CollideArray then uses its own sweep along X.
+    static std::unique_ptr<CollideBroadphase> Create(const std::string &kind);
+};
+
+/**
+ * The classic sweep: the array is sorted along X, so walk out from the query
+ * point in both directions until the X distance alone rules the rest out.
+ * Cheap to build, but degrades to a full scan when units share an X plane.
+ */
+class SortedAxisBroadphase : public CollideBroadphase {
+public:
+    void Build(const Collidable *begin, const Collidable *end) override;
+    void Search(const QVector &center, Visitor &visitor) const override;
+
+private:
+    const Collidable *first{nullptr};
+    const Collidable *last{nullptr};
+    double max_radius{0};
+};
+
+/**
+ * An octree over the centres of the collidables. Each node keeps the largest
+ * radius below it and is tested with its box grown by that radius, which
+ * makes it "loose": nothing straddles a split, so building is a plain
+ * recursive partition.
+ */
+class LooseOctreeBroadphase : public CollideBroadphase {
+public:
+    void Build(const Collidable *begin, const Collidable *end) override;
+    void Search(const QVector &center, Visitor &visitor) const override;
+
+private:
+    static const size_t kLeafSize = 8;
+    static const int kMaxDepth = 20;
+
+    struct Node {
+        QVector center;
+        double half_size;
+        float max_radius;
+        // Range of items in this subtree
+        uint32_t begin;
+        uint32_t end;
+        // Index of the first of 8 children, 0 for leaves
+        uint32_t children;
+    };
+
+    void BuildNode(uint32_t index, const QVector &center, double half_size, uint32_t begin, uint32_t end, int depth);
+    bool SearchNode(uint32_t node, const QVector &center, Visitor &visitor) const;
+
+    const Collidable *first{nullptr};
+    std::vector<Node> nodes;
+    // Indices into the array, grouped by node
+    std::vector<uint32_t> items;
+};
+
+#endif //VEGA_STRIKE_ENGINE_CMD_COLLIDE_BROADPHASE_H
@@ -32,9 +32,50 @@
 #include "star_system.h"
 #include "universe.h"
 #include "vs_logging.h"
+#include "configuration/configuration.h"
 
 volatile bool apart_return = true;
 
+CollideArray::CollideArray(unsigned int location_index) : toflattenhints(1), count(0) {
+    this->location_index = location_index;
+    broadphase = CollideBroadphase::Create(configuration()->physics_config.collision_broadphase);
+}
+
+void CollideArray::IndexSorted() {
+    if (broadphase) {
+        broadphase->Build(this->begin(), this->end());
+    } else {
+        sweep.Build(this->begin(), this->end());
+    }
+}
+
+void CollideArray::QueryUnits(const QVector &center, double distance, std::vector<Unit *> &result) const {
+    std::vector<size_t> nearby;
+    if (broadphase) {
+        broadphase->Query(center, distance, nearby);
+    } else {
+        sweep.Query(center, distance, nearby);
+    }
+    for (size_t index : nearby) {
+        const Collidable &collidable = sorted[index];
+        if (collidable.radius > 0) {
+            result.push_back(collidable.ref.unit);
+        }
+    }
+    if (num_hinted == 0) {
+        return;
+    }
+    //Not indexed until the next flatten
+    for (const std::list<CollidableBackref> &hinted : toflattenhints) {
+        for (const CollidableBackref &collidable : hinted) {
+            const double limit = distance + collidable.radius;
+            if (collidable.radius > 0 && (collidable.position - center).MagnitudeSquared() <= limit * limit) {
+                result.push_back(collidable.ref.unit);
+            }
+        }
+    }
+}
+
 void CollideArray::erase(iterator target) {
     count -= 1;
     if (target >= this->begin() && target < this->end()) {
@@ -78,6 +119,20 @@ CollideArray::iterator CollideArray::changeKey(CollideArray::iterator iter, cons
     return iter;
 }
 
+void CollideArray::changeKeys(const std::vector<iterator> &iters, const std::vector<QVector> &positions) {
+    iterator first = this->begin();
+    iterator last = this->end();
+    Collidable *first_unsorted = unsorted.empty() ? nullptr : &unsorted[0];
+    for (size_t i = 0; i < iters.size(); ++i) {
+        iterator iter = iters[i];
+        if (iter >= first && iter < last) {
+            first_unsorted[iter - first].SetPosition(positions[i]);
+        } else {
+            iter->SetPosition(positions[i]);
+        }
+    }
+}
+
 float CollideArray::max_bolt_radius = 0;
 
 CollideArray::iterator CollideArray::changeKey(CollideArray::iterator iter,
@@ -170,9 +225,11 @@ void CollideArray::flatten() {
         }
         toflattenhints[i].resize(0);
     }
+    num_hinted = 0;
 
     std::sort(sorted.begin(), sorted.end());
     unsorted = sorted;
+    IndexSorted();
 
     toflattenhints.resize(count + 1);
     if (location_index == Unit::UNIT_BOLT) {
@@ -227,8 +284,10 @@ void CollideArray::flatten(CollideArray &hint) {
         sorted.resize(count);
         for_each(toflattenhints.begin(), toflattenhints.end(), resizezero());
         toflattenhints.resize(count + 1);
+        num_hinted = 0;
 
         for_each(sorted.begin(), sorted.end(), CopyExample(hint.sorted.begin(), hint.sorted.end()));
+        IndexSorted();
     } else {
         VS_LOG(info, "Trying to use flatten hint on a array with both bolts and units");
         flatten();
@@ -244,11 +303,13 @@ CollideArray::iterator CollideArray::insert(const Collidable &newKey, iterator h
         this->unsorted.push_back(newKey);
         this->toflattenhints.resize(2);
         this->sorted.push_back(newKey);
+        IndexSorted();
         return &sorted.back();
     } else if (hint >= this->begin() && hint <= this->end()) {
         count += 1;
         size_t len = hint - this->begin();
         std::list<CollidableBackref> *hintlist = &toflattenhints[len];
+        ++num_hinted;
         return &*hintlist->insert(hintlist->end(), CollidableBackref(newKey, len));
     } else {
         return this->insert(newKey);         //don't use hint;
@@ -464,6 +525,41 @@ public:
         return false;
     }
 
+    //Same checks as CheckCollisionsInner, on whatever the broadphase finds
+    //within reach of the collider rather than on a window along X
+    static bool CheckCollisionsNearby(CollideMap *cm, T *un, const Collidable &collider, unsigned int location_index) {
+        if (canbebolt && BoltType(un)) {
+            //Bolts don't hit bolts, so go straight to the units
+            CollideMap *unit_map = _Universe->activeStarSystem()->collide_map[Unit::UNIT_ONLY];
+            if (unit_map->begin() == unit_map->end()) {
+                return false;
+            }
+            return CollideChecker<T, false>::CheckCollisionsNearby(unit_map, un, collider, Unit::UNIT_ONLY);
+        }
+        std::vector<size_t> nearby;
+        cm->broadphase->Query(collider.GetPosition(), std::fabs(collider.radius), nearby);
+        CollideMap::iterator self = CheckBackref<T>()(un, location_index);
+        CollideMap::iterator cmbegin = cm->begin();
+        for (size_t index : nearby) {
+            CollideMap::iterator other = cmbegin + index;
+            if (other == self) {
+                continue;
+            }
+            //Read again: an earlier collision may have erased it
+            float rad = other->radius;
+            if (canbebolt && rad < 0) {
+                if (CheckCollision(un, collider, other->ref, *other) && endAfterCollide(un, location_index)) {
+                    return true;
+                }
+            } else if (rad != 0) {
+                if (CheckCollision(un, collider, other->ref.unit, *other) && endAfterCollide(un, location_index)) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
     static bool CheckCollisions(CollideMap *cm, T *un, const Collidable &collider, unsigned int location_index) {
         CollideMap::iterator tless, tmore;
         double sortedloc = collider.getKey();
@@ -473,6 +569,9 @@ public:
         if (cmbegin == cmend) {
             return false;
         }
+        if (cm->broadphase) {
+            return CheckCollisionsNearby(cm, un, collider, location_index);
+        }
         double minlook, maxlook;
         CollideMap::iterator startIter = CheckBackref<T>()(un, location_index);
         if (ComputeMaxLookMinLook(un, cm, startIter, cmbegin, cmend, sortedloc, rad, minlook, maxlook)) {
@@ -27,9 +27,11 @@
 #include "key_mutable_set.h"
 #include "vegastrike.h"
 #include "gfx/vec.h"
+#include "collide_broadphase.h"
 #if defined (_WIN32) || __GNUC__ != 2
 #include <limits>
 #endif
+#include <memory>
 #include <vector>
 /* Arbitrarily use Set for ALL PLATFORMS -hellcatv */
 class Unit;
@@ -149,7 +151,17 @@ public:
     ResizableArray sorted;
     ResizableArray unsorted;
     std::vector<std::list<CollidableBackref> > toflattenhints;
+    //Insertions into toflattenhints since the last flatten
+    size_t num_hinted{0};
     unsigned int count;
+    //Index over sorted, rebuilt on flatten. Null: sweep sorted along X instead
+    std::unique_ptr<CollideBroadphase> broadphase;
+    //What QueryUnits sweeps when there is no broadphase
+    SortedAxisBroadphase sweep;
+    void IndexSorted();
+    //Appends every unit whose bounding sphere comes within distance of center: where they were at the last
+    //flatten, or where they were inserted since
+    void QueryUnits(const QVector &center, double distance, std::vector<Unit *> &result) const;
     void UpdateBoltInfo(iterator iter, Collidable::CollideRef ref);
     void flatten();
     void flatten(CollideArray &example); //maybe it has some xtra bolts
@@ -157,6 +169,8 @@ public:
     iterator insert(const Collidable &newKey);
     iterator changeKey(iterator iter, const Collidable &newKey);
     iterator changeKey(iterator iter, const Collidable &newKey, iterator tless, iterator tmore);
+    //Moves each key to the matching position, as changeKey() would, in one pass
+    void changeKeys(const std::vector<iterator> &iters, const std::vector<QVector> &positions);
 
     iterator begin() {
         return !sorted.empty() ? &*sorted.begin() : nullptr;
@@ -170,9 +184,7 @@ public:
     void erase(iterator iter);
     void checkSet();
 
-    explicit CollideArray(unsigned int location_index) : toflattenhints(1), count(0) {
-        this->location_index = location_index;
-    }
+    explicit CollideArray(unsigned int location_index);
 
     // TODO: Add virtual destructor?
 };
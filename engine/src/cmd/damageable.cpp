@@ -463,9 +463,7 @@ void Damageable::Destroy() {
             DestroyMount(&unit->mounts[beamcount]);
         }
 
-        if (!unit->Explode(false, simulation_atom_var)) {
-            unit->Kill();
-        }
+        unit->ExplodeInSimulation(simulation_atom_var, true);
     }
 }
 
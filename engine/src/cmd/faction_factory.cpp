@@ -73,6 +73,9 @@ void FactionFactory::parse(ptree tree) {
         // TODO: make factioname an std::string
         faction->factionname = new char[tmp_name.size() + 1];
         strcpy(faction->factionname, tmp_name.c_str());
+        if (tmp_name.find("pirates") != string::npos) {
+            faction->traits |= Faction::TRAIT_PIRATE;
+        }
 
         faction->citizen = inner.get("<xmlattr>.citizen", false);
         string logo_rgb = inner.get("<xmlattr>.logoRGB", "");
@@ -43,6 +43,7 @@
 #include "ai/turretai.h"
 #include "collide2/CSopcodecollider.h"
 #include "vega_cast_utils.h"
+#include "vs_profiler.h"
 
 #include <string>
 
@@ -183,6 +184,7 @@ void Intelligent::EnqueueAIFirst(Order *newAI) {
 }
 
 void Intelligent::ExecuteAI() {
+    VS_PROFILE_ZONE("ExecuteAI");
     Unit *unit = static_cast<Unit *>(this);
     Flightgroup *flightgroup = unit->flightgroup;
     if (flightgroup) {
@@ -33,6 +33,7 @@
 #include "vsfilesystem.h"
 #include "vs_exit.h"
 #include "vega_cast_utils.h"
+#include "star_system_loader.h"
 
 // TODO: once implementation is refactored, deal with this too
 extern QVector RealPosition(const Unit *un);
@@ -106,6 +107,13 @@ void JumpCapable::ActivateJumpDrive(int destination) {
     Unit *unit = static_cast<Unit *>(this);
     if (((unit->docked & (unit->DOCKED | unit->DOCKED_INSIDE)) == 0) && unit->jump_drive.Installed()) {
         unit->jump_drive.SetDestination(destination);
+        //The player likely jumps through what they target; get its systems parsed by the time they arrive
+        const Unit *jumppoint = unit->Target();
+        if (jumppoint && _Universe->isPlayerStarship(unit)) {
+            for (const std::string &system : jumppoint->GetDestinations()) {
+                GetStarSystemLoader().Prefetch(system);
+            }
+        }
     }
 }
 
@@ -550,15 +558,21 @@ Vector JumpCapable::GetWarpRefVelocity() const {
 
 Vector JumpCapable::GetWarpVelocity() const {
     const Unit *unit = vega_dynamic_cast_ptr<const Unit>(this);
+    return GetWarpVelocity(unit->graphicOptions.WarpFieldStrength);
+}
+
+Vector JumpCapable::GetWarpVelocity(float warp_field_strength) const {
+    const Unit *unit = vega_dynamic_cast_ptr<const Unit>(this);
 
-    if (unit->graphicOptions.WarpFieldStrength == 1.0) {
+    if (warp_field_strength == 1.0) {
         // Short circuit, most ships won't be at warp, so it simplifies math a lot
         return unit->cumulative_velocity;
     } else {
         Vector VelocityRef(0, 0, 0);
         {
-            Unit *vr = const_cast< UnitContainer * > (&unit->computer.velocity_ref)->GetUnit();
-            if (vr) {
+            //Read only, as units get their motion computed concurrently
+            const Unit *vr = unit->computer.velocity_ref.GetConstUnit();
+            if (vr && !vr->Killed()) {
                 VelocityRef = vr->cumulative_velocity;
             }
         }
@@ -571,7 +585,7 @@ Vector JumpCapable::GetWarpVelocity() const {
             Vector veldir = vel * (1. / speed);
             Vector facing = unit->cumulative_transformation_matrix.getR();
             float ang = facing.Dot(veldir);
-            float warpfield = unit->graphicOptions.WarpFieldStrength;
+            float warpfield = warp_field_strength;
             if (ang < 0) {
                 warpfield = 1. / warpfield;
             }
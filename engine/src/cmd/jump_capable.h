@@ -51,6 +51,7 @@ public:
     const StarSystem *getStarSystem() const;
     Vector GetWarpRefVelocity() const;
     Vector GetWarpVelocity() const;
+    Vector GetWarpVelocity(float warp_field_strength) const;
     bool InCorrectStarSystem(StarSystem *);
     virtual bool TransferUnitToSystem(StarSystem *NewSystem);
     virtual bool TransferUnitToSystem(unsigned int whichJumpQueue,
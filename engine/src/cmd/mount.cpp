@@ -230,6 +230,129 @@ double Mount::Percentage(const Mount *newammo) const {
 
 extern void GetMadAt(Unit *un, Unit *parent, int numhits = 0);
 
+//Launches a missile or spawns a fighter. Creating units isn't safe off the main thread,
+//and weapons fire during the unit stage, which may run on a worker, so it is queued from there.
+static void SpawnProjectile(StarSystem *system,
+        const WeaponInfo *type,
+        Unit *caller,
+        void *owner,
+        Unit *target,
+        const Transformation &tmp,
+        const Matrix &mat,
+        const Matrix &m,
+        const Vector &velocity) {
+    using namespace VSFileSystem;
+    Unit *temp;
+    static bool match_speed_with_target =
+            XMLSupport::parse_float(vs_config->getVariable("physics", "match_speed_with_target", "true"));
+    string skript = /*string("ai/script/")+*/ type->file + string(".xai");
+    VSError err = LookForFile(skript, AiFile);
+    if (err <= Ok) {
+        temp = new Missile(
+                type->file.c_str(),
+                caller->faction,
+                "",
+                type->damage,
+                type->phase_damage,
+                type->range / type->speed,
+                type->radius,
+                type->radial_speed,
+                type->pulse_speed /*detonation_radius*/);
+        if (!match_speed_with_target) {
+            temp->GetComputerData().max_combat_speed = type->speed + velocity.Magnitude();
+            temp->GetComputerData().max_combat_ab_speed = type->speed + velocity.Magnitude();
+        }
+    } else {
+        Flightgroup *testfg = caller->getFlightgroup();
+        if (testfg == NULL) {
+            static Flightgroup bas;
+            bas.name = "Base";
+            testfg = &bas;
+        }
+        if (testfg->name == "Base") {
+            int fgsnumber = 0;
+            Flightgroup *fg = Flightgroup::newFlightgroup("Base_Patrol",
+                    type->file,
+                    FactionUtil::GetFactionName(caller->faction),
+                    "deafult",
+                    1,
+                    1,
+                    "",
+                    "",
+                    mission);
+            if (fg != NULL) {
+                fg->target.SetUnit(caller->Target());
+                fg->directive = "a";
+                fg->name =
+                        "Base_Patrol";                               //this fixes base-spawned fighters becoming navpoints, which happens sometimes
+
+                fgsnumber = fg->nr_ships;
+                fg->nr_ships = 1;
+                fg->nr_ships_left = 1;
+            }
+            temp = new Unit(type->file.c_str(), false, caller->faction, "", fg, fgsnumber);
+        } else {
+            Flightgroup *fg = caller->getFlightgroup();
+            int fgsnumber = 0;
+            if (fg != NULL) {
+                fgsnumber = fg->nr_ships;
+                fg->nr_ships++;
+                fg->nr_ships_left++;
+            }
+            temp = new Unit(type->file.c_str(), false, caller->faction, "", fg, fgsnumber);
+        }
+    }
+    Vector adder = Vector(mat.r[6], mat.r[7], mat.r[8]) * type->speed;
+    temp->SetVelocity(caller->GetVelocity() + adder);
+
+    if (target && target != owner) {
+        temp->Target(target);
+        temp->TargetTurret(target);
+        if (err <= Ok) {
+            temp->EnqueueAI(new AIScript((type->file + ".xai").c_str()));
+            temp->EnqueueAI(new Orders::FireAllYouGot);
+            if (match_speed_with_target) {
+                temp->GetComputerData().velocity_ref.SetUnit(target);
+            }
+        } else {
+            temp->EnqueueAI(new Orders::AggressiveAI("default.agg.xml"));
+            temp->SetTurretAI();
+            temp->TurretFAW();                         //turrets are for DEFENSE damnit!
+            temp->owner =
+                    caller;                         //spawned wingmen act as cargo (owned) wingmen, not as hired wingmen
+            float relat;
+            relat = caller->getRelation(target);
+            if (caller->isSubUnit() && relat >= 0) {
+                relat = -1;
+                temp->owner = caller->owner;
+            }
+            if (relat < 0) {
+                int i = 0;
+                while (relat < temp->getRelation(target) && i++ < 100) {
+                    GetMadAt(target, temp, 2);
+                }
+            }
+            //pissed off					getMadAt(target, 10); // how do I cause an attack here?
+        }
+    } else {
+        temp->EnqueueAI(new Orders::MatchLinearVelocity(Vector(0, 0, 100000), true, false));
+        temp->EnqueueAI(new Orders::FireAllYouGot);
+    }
+    temp->SetOwner((Unit *) owner);
+    temp->Velocity = velocity + adder;
+    temp->curr_physical_state = temp->prev_physical_state = temp->cumulative_transformation = tmp;
+    CopyMatrix(temp->cumulative_transformation_matrix, m);
+    //Next to the one firing, as Unit::Fire() would hint
+    Unit *anchor = static_cast<Unit *>(owner);
+    CollideMap::iterator hint[Unit::NUM_COLLIDE_MAPS];
+    for (unsigned int locind = 0; locind < Unit::NUM_COLLIDE_MAPS; ++locind) {
+        hint[locind] = (anchor && !is_null(anchor->location[locind])) ? anchor->location[locind]
+                : system->collide_map[locind]->begin();
+    }
+    system->AddUnit(temp);
+    temp->UpdateCollideQueue(system, hint);
+}
+
 //bool returns whether to refund the cost of firing
 bool Mount::PhysicsAlignedFire(Unit *caller,
         const Transformation &Cumulative,
@@ -258,7 +381,6 @@ bool Mount::PhysicsAlignedFire(Unit *caller,
             return true;
         }              //Not ready to refire yet.  But don't stop firing.
 
-        Unit *temp;
         Transformation tmp(orient, pos.Cast());
         tmp.Compose(Cumulative, m);
         Matrix mat;
@@ -313,115 +435,24 @@ bool Mount::PhysicsAlignedFire(Unit *caller,
                         BoltDrawManager::GetInstance().AddBall(type, mat, velocity, owner, hint[Unit::UNIT_BOLT]);
                 break;
             }
-            case WEAPON_TYPE::PROJECTILE:
-                static bool match_speed_with_target =
-                        XMLSupport::parse_float(vs_config->getVariable("physics", "match_speed_with_target", "true"));
-                string skript = /*string("ai/script/")+*/ type->file + string(".xai");
-                VSError err = LookForFile(skript, AiFile);
-                if (err <= Ok) {
-                    temp = new Missile(
-                            type->file.c_str(),
-                            caller->faction,
-                            "",
-                            type->damage,
-                            type->phase_damage,
-                            type->range / type->speed,
-                            type->radius,
-                            type->radial_speed,
-                            type->pulse_speed /*detonation_radius*/);
-                    if (!match_speed_with_target) {
-                        temp->GetComputerData().max_combat_speed = type->speed + velocity.Magnitude();
-                        temp->GetComputerData().max_combat_ab_speed = type->speed + velocity.Magnitude();
-                    }
-                } else {
-                    Flightgroup *testfg = caller->getFlightgroup();
-                    if (testfg == NULL) {
-                        static Flightgroup bas;
-                        bas.name = "Base";
-                        testfg = &bas;
-                    }
-                    if (testfg->name == "Base") {
-                        int fgsnumber = 0;
-                        Flightgroup *fg = Flightgroup::newFlightgroup("Base_Patrol",
-                                type->file,
-                                FactionUtil::GetFactionName(caller->faction),
-                                "deafult",
-                                1,
-                                1,
-                                "",
-                                "",
-                                mission);
-                        if (fg != NULL) {
-                            fg->target.SetUnit(caller->Target());
-                            fg->directive = "a";
-                            fg->name =
-                                    "Base_Patrol";                               //this fixes base-spawned fighters becoming navpoints, which happens sometimes
-
-                            fgsnumber = fg->nr_ships;
-                            fg->nr_ships = 1;
-                            fg->nr_ships_left = 1;
-                        }
-                        temp = new Unit(type->file.c_str(), false, caller->faction, "", fg, fgsnumber);
-                    } else {
-                        Flightgroup *fg = caller->getFlightgroup();
-                        int fgsnumber = 0;
-                        if (fg != NULL) {
-                            fgsnumber = fg->nr_ships;
-                            fg->nr_ships++;
-                            fg->nr_ships_left++;
-                        }
-                        temp = new Unit(type->file.c_str(), false, caller->faction, "", fg, fgsnumber);
-                    }
-                }
-                Vector adder = Vector(mat.r[6], mat.r[7], mat.r[8]) * type->speed;
-                temp->SetVelocity(caller->GetVelocity() + adder);
-
-                if (target && target != owner) {
-                    temp->Target(target);
-                    temp->TargetTurret(target);
-                    if (err <= Ok) {
-                        temp->EnqueueAI(new AIScript((type->file + ".xai").c_str()));
-                        temp->EnqueueAI(new Orders::FireAllYouGot);
-                        if (match_speed_with_target) {
-                            temp->GetComputerData().velocity_ref.SetUnit(target);
-                        }
-                    } else {
-                        temp->EnqueueAI(new Orders::AggressiveAI("default.agg.xml"));
-                        temp->SetTurretAI();
-                        temp->TurretFAW();                         //turrets are for DEFENSE damnit!
-                        temp->owner =
-                                caller;                         //spawned wingmen act as cargo (owned) wingmen, not as hired wingmen
-                        float relat;
-                        relat = caller->getRelation(target);
-                        if (caller->isSubUnit() && relat >= 0) {
-                            relat = -1;
-                            temp->owner = caller->owner;
-                        }
-                        if (relat < 0) {
-                            int i = 0;
-                            while (relat < temp->getRelation(target) && i++ < 100) {
-                                GetMadAt(target, temp, 2);
-                            }
-                        }
-                        //pissed off					getMadAt(target, 10); // how do I cause an attack here?
+            case WEAPON_TYPE::PROJECTILE: {
+                const WeaponInfo *projectile = type;
+                StarSystem *system = _Universe->activeStarSystem();
+                //Kept alive until the queue runs; a unit killed meanwhile is let go of
+                UnitContainer caller_ref(caller);
+                UnitContainer owner_ref(static_cast<Unit *>(owner));
+                UnitContainer target_ref(target);
+                system->QueueForMainThread([system, projectile, caller_ref, owner_ref, target_ref, tmp, mat, m,
+                        velocity]() mutable {
+                    //Nothing is launched by a unit that got killed in the same atom
+                    Unit *spawner = caller_ref.GetUnit();
+                    if (spawner) {
+                        SpawnProjectile(system, projectile, spawner, owner_ref.GetUnit(), target_ref.GetUnit(), tmp,
+                                mat, m, velocity);
                     }
-                } else {
-                    temp->EnqueueAI(new Orders::MatchLinearVelocity(Vector(0, 0, 100000), true, false));
-                    temp->EnqueueAI(new Orders::FireAllYouGot);
-                }
-                temp->SetOwner((Unit *) owner);
-                temp->Velocity = velocity + adder;
-                temp->curr_physical_state = temp->prev_physical_state = temp->cumulative_transformation = tmp;
-                CopyMatrix(temp->cumulative_transformation_matrix, m);
-                _Universe->activeStarSystem()->AddUnit(temp);
-                temp->UpdateCollideQueue(_Universe->activeStarSystem(), hint);
-                for (unsigned int locind = 0; locind < Unit::NUM_COLLIDE_MAPS; ++locind) {
-                    if (!is_null(temp->location[locind])) {
-                        hint[locind] = temp->location[locind];
-                    }
-                }
-
+                });
                 break;
+            }
         }
         static bool use_separate_sound =
                 XMLSupport::parse_bool(vs_config->getVariable("audio", "high_quality_weapon", "true"));
@@ -143,6 +143,18 @@ void Movable::UpdatePhysics(const Transformation &trans,
         bool lastframe,
         UnitCollection *uc,
         Unit *superunit) {
+    Transformation old_physical_state = PrepareUpdatePhysics(trans, transmat, lastframe, uc, superunit);
+    MotionStep step;
+    FindNearestWarpMultiplier(step);
+    ComputeMotion(trans, transmat, cum_vel, simulation_atom_var, step);
+    FinishUpdatePhysics(trans, transmat, cum_vel, lastframe, uc, old_physical_state, step);
+}
+
+Transformation Movable::PrepareUpdatePhysics(const Transformation &trans,
+        const Matrix &transmat,
+        bool lastframe,
+        UnitCollection *uc,
+        Unit *superunit) {
     //Save information about when this happened
     unsigned int cur_sim_frame = _Universe->activeStarSystem()->getCurrentSimFrame();
     //Well, wasn't skipped actually, but...
@@ -151,93 +163,186 @@ void Movable::UpdatePhysics(const Transformation &trans,
     Transformation old_physical_state = curr_physical_state;
 
     UpdatePhysics3(trans, transmat, lastframe, uc, superunit);
+    //ComputeMotion only reads the velocity reference, so a killed one is let go of here
+    Unit *unit = vega_dynamic_cast_ptr<Unit>(this);
+    unit->computer.velocity_ref.GetUnit();
 
     if (resolveforces) {
+        // stephengtuggy 2020-10-17: These need to be initialized here, because they depend on having an active mission.
+        air_res_coef = XMLSupport::parse_floatf(active_missions[0]->getVariable("air_resistance", "0"));
+        lateral_air_res_coef = XMLSupport::parse_floatf(active_missions[0]->getVariable("lateral_air_resistance", "0"));
+    }
+    return old_physical_state;
+}
+
+void Movable::FinishUpdatePhysics(const Transformation &trans,
+        const Matrix &transmat,
+        const Vector &cum_vel,
+        bool lastframe,
+        UnitCollection *uc,
+        const Transformation &old_physical_state,
+        const MotionStep &step) {
+    ApplyMotion(step);
+    // The 1.0 difficulty is a hack based on the hack in GetVelocityDifficultyMult
+    this->UpdatePhysics2(trans, old_physical_state, Vector(), 1.0, transmat, cum_vel, lastframe, uc);
+}
+
+void Movable::FindNearestWarpMultiplier(MotionStep &step) const {
+    //ComputeVelocity() only asks for the warp field strength in these cases
+    if (graphicOptions.InWarp == 1 || graphicOptions.RampCounter != 0 || graphicOptions.WarpRamping) {
+        const Unit *unit = vega_dynamic_const_cast_ptr<const Unit>(this);
+        Unit *nearest_unit = nullptr;
+        step.nearest_warp_multiplier = unit->CalculateNearestWarpUnit(
+                configuration()->warp_config.warp_multiplier_max * graphicOptions.MaxWarpMultiplier,
+                &nearest_unit,
+                true);
+    }
+}
+
+void Movable::ComputeMotion(const Transformation &trans,
+        const Matrix &transmat,
+        const Vector &cum_vel,
+        float atom,
+        MotionStep &step) const {
+    step.velocity = Velocity;
+    step.angular_velocity = AngularVelocity;
+    step.saved_accel = SavedAccel;
+    step.saved_ang_accel = SavedAngAccel;
+    step.physical_state = curr_physical_state;
+    step.warp_field_strength = graphicOptions.WarpFieldStrength;
+    step.ramp_counter = graphicOptions.RampCounter;
+    step.warp_ramping = graphicOptions.WarpRamping;
+    step.resolved_forces = resolveforces;
+    step.warp_stretch = false;
+
+    if (resolveforces) {
+        ComputeForces(transmat, atom, step);
         //clamp velocity
-        ResolveForces(trans, transmat);
         float velocity_max = configuration()->physics_config.velocity_max;
-        if (Velocity.i > velocity_max) {
-            Velocity.i = velocity_max;
-        } else if (Velocity.i < -velocity_max) {
-            Velocity.i = -velocity_max;
+        if (step.velocity.i > velocity_max) {
+            step.velocity.i = velocity_max;
+        } else if (step.velocity.i < -velocity_max) {
+            step.velocity.i = -velocity_max;
         }
-        if (Velocity.j > velocity_max) {
-            Velocity.j = velocity_max;
-        } else if (Velocity.j < -velocity_max) {
-            Velocity.j = -velocity_max;
+        if (step.velocity.j > velocity_max) {
+            step.velocity.j = velocity_max;
+        } else if (step.velocity.j < -velocity_max) {
+            step.velocity.j = -velocity_max;
         }
-        if (Velocity.k > velocity_max) {
-            Velocity.k = velocity_max;
-        } else if (Velocity.k < -velocity_max) {
-            Velocity.k = -velocity_max;
+        if (step.velocity.k > velocity_max) {
+            step.velocity.k = velocity_max;
+        } else if (step.velocity.k < -velocity_max) {
+            step.velocity.k = -velocity_max;
         }
     }
 
+    if (step.angular_velocity.i || step.angular_velocity.j || step.angular_velocity.k) {
+        step.physical_state.orientation =
+                RotatedOrientation(step.physical_state.orientation, atom * step.angular_velocity);
+    }
+
     // The 1.0 difficulty is a hack based on the hack in GetVelocityDifficultyMult
-    this->UpdatePhysics2(trans, old_physical_state, Vector(), 1.0, transmat, cum_vel, lastframe, uc);
+    ComputeVelocity(1.0, atom, step);
 
+    step.cumulative_transformation = step.physical_state;
+    step.cumulative_transformation.Compose(trans, transmat);
+    step.cumulative_transformation.to_matrix(step.cumulative_transformation_matrix);
+    step.cumulative_velocity = TransformNormal(transmat, step.velocity) + cum_vel;
 }
 
-void Movable::AddVelocity(float difficulty) {
+void Movable::ApplyMotion(const MotionStep &step) {
+    if (step.warp_stretch) {
+        static bool docache = true;
+        if (docache && !configuration()->graphics_config.in_system_jump_animation.empty()) {
+            UniverseUtil::cacheAnimation(configuration()->graphics_config.in_system_jump_animation);
+            docache = false;
+        }
+        Vector v(GetVelocity());
+        v.Normalize();
+
+        float tmpsec = step.warp_stretch_decel ? configuration()->warp_config.warp_stretch_decel_cutoff : configuration()->warp_config.warp_stretch_cutoff;
+        UniverseUtil::playAnimationGrow(configuration()->graphics_config.in_system_jump_animation,
+                realPosition().Cast() + step.warp_stretch_velocity * tmpsec + v * radial_size,
+                radial_size * 8,
+                1);
+    }
+
+    Velocity = step.velocity;
+    AngularVelocity = step.angular_velocity;
+    SavedAccel = step.saved_accel;
+    SavedAngAccel = step.saved_ang_accel;
+    if (step.resolved_forces) {
+        NetForce = NetLocalForce = NetTorque = NetLocalTorque = Vector(0, 0, 0);
+    }
+    curr_physical_state = step.physical_state;
+    graphicOptions.WarpFieldStrength = step.warp_field_strength;
+    graphicOptions.RampCounter = step.ramp_counter;
+    graphicOptions.WarpRamping = step.warp_ramping ? 1 : 0;
+    cumulative_transformation = step.cumulative_transformation;
+    cumulative_transformation_matrix = step.cumulative_transformation_matrix;
+    cumulative_velocity = step.cumulative_velocity;
+}
+
+void Movable::ComputeVelocity(float difficulty, float atom, MotionStep &step) const {
     const Unit *unit = vega_dynamic_const_cast_ptr<const Unit>(this);
-    float lastWarpField = graphicOptions.WarpFieldStrength;
+    float lastWarpField = step.warp_field_strength;
 
     bool playa = isPlayerShip();
 
     float warprampuptime = playa ? configuration()->warp_config.warp_ramp_up_time : configuration()->warp_config.computer_warp_ramp_up_time;
     //Warp Turning on/off
-    if (graphicOptions.WarpRamping) {
-        float oldrampcounter = graphicOptions.RampCounter;
+    if (step.warp_ramping) {
+        float oldrampcounter = step.ramp_counter;
         if (graphicOptions.InWarp == 1) {             //Warp Turning on
-            graphicOptions.RampCounter = warprampuptime;
+            step.ramp_counter = warprampuptime;
         } else {                                        //Warp Turning off
-            graphicOptions.RampCounter = configuration()->warp_config.warp_ramp_down_time;
+            step.ramp_counter = configuration()->warp_config.warp_ramp_down_time;
         }
         //switched mid - ramp time; we also know old mode's ramptime != 0, or there won't be ramping
-        if (oldrampcounter != 0 && graphicOptions.RampCounter != 0) {
+        if (oldrampcounter != 0 && step.ramp_counter != 0) {
             if (graphicOptions.InWarp == 1) {             //Warp is turning on before it turned off
-                graphicOptions.RampCounter *= (1 - oldrampcounter / configuration()->warp_config.warp_ramp_down_time);
+                step.ramp_counter *= (1 - oldrampcounter / configuration()->warp_config.warp_ramp_down_time);
             } else {                                        //Warp is turning off before it turned on
-                graphicOptions.RampCounter *= (1 - oldrampcounter / warprampuptime);
+                step.ramp_counter *= (1 - oldrampcounter / warprampuptime);
             }
         }
-        graphicOptions.WarpRamping = 0;
+        step.warp_ramping = false;
     }
-    if (graphicOptions.InWarp == 1 || graphicOptions.RampCounter != 0) {
+    if (graphicOptions.InWarp == 1 || step.ramp_counter != 0) {
         float rampmult = 1.f;
-        if (graphicOptions.RampCounter != 0) {
-            graphicOptions.RampCounter -= simulation_atom_var;
-            if (graphicOptions.RampCounter <= 0) {
-                graphicOptions.RampCounter = 0;
+        if (step.ramp_counter != 0) {
+            step.ramp_counter -= atom;
+            if (step.ramp_counter <= 0) {
+                step.ramp_counter = 0;
             }
-            if (graphicOptions.InWarp == 0 && graphicOptions.RampCounter > configuration()->warp_config.warp_ramp_down_time) {
-                graphicOptions.RampCounter = (1 - graphicOptions.RampCounter / warprampuptime) * configuration()->warp_config.warp_ramp_down_time;
+            if (graphicOptions.InWarp == 0 && step.ramp_counter > configuration()->warp_config.warp_ramp_down_time) {
+                step.ramp_counter = (1 - step.ramp_counter / warprampuptime) * configuration()->warp_config.warp_ramp_down_time;
             }
-            if (graphicOptions.InWarp == 1 && graphicOptions.RampCounter > warprampuptime) {
-                graphicOptions.RampCounter = warprampuptime;
+            if (graphicOptions.InWarp == 1 && step.ramp_counter > warprampuptime) {
+                step.ramp_counter = warprampuptime;
             }
             rampmult = (graphicOptions.InWarp) ? 1.0F
-                    - ((graphicOptions.RampCounter
+                    - ((step.ramp_counter
                             / warprampuptime)
-                            * (graphicOptions.RampCounter
-                                    / warprampuptime)) : (graphicOptions.RampCounter
-                    / configuration()->warp_config.warp_ramp_down_time) * (graphicOptions.RampCounter / configuration()->warp_config.warp_ramp_down_time);
+                            * (step.ramp_counter
+                                    / warprampuptime)) : (step.ramp_counter
+                    / configuration()->warp_config.warp_ramp_down_time) * (step.ramp_counter / configuration()->warp_config.warp_ramp_down_time);
         }
-        graphicOptions.WarpFieldStrength = GetMaxWarpFieldStrength(rampmult);
+        step.warp_field_strength = GetMaxWarpFieldStrength(step.nearest_warp_multiplier, rampmult);
     } else {
-        graphicOptions.WarpFieldStrength = 1;
+        step.warp_field_strength = 1;
     }
     //not any more? lastWarpField=1;
     Vector v;
-    if (graphicOptions.WarpFieldStrength != 1.0) {
-        v = unit->GetWarpVelocity();
+    if (step.warp_field_strength != 1.0) {
+        v = unit->GetWarpVelocity(step.warp_field_strength);
     } else {
-        v = Velocity;
+        v = step.velocity;
     }
 
-    graphicOptions.WarpFieldStrength =
-            lastWarpField * configuration()->warp_config.warp_memory_effect + (1.0 - configuration()->warp_config.warp_memory_effect) * graphicOptions.WarpFieldStrength;
-    curr_physical_state.position = curr_physical_state.position + (v * simulation_atom_var * difficulty).Cast();
+    step.warp_field_strength =
+            lastWarpField * configuration()->warp_config.warp_memory_effect + (1.0 - configuration()->warp_config.warp_memory_effect) * step.warp_field_strength;
+    step.physical_state.position = step.physical_state.position + (v * atom * difficulty).Cast();
     //now we do this later in update physics
     //I guess you have to, to be robust}
 }
@@ -250,18 +355,19 @@ void Movable::UpdatePhysics2(const Transformation &trans,
         const Vector &cum_vel,
         bool lastframe,
         UnitCollection *uc) {
-    //Only in non-networking OR networking && is a player OR SERVER && not a player
-    if (AngularVelocity.i || AngularVelocity.j || AngularVelocity.k) {
-        Rotate(simulation_atom_var * (AngularVelocity));
-    }
-
+    //Rotation and translation are integrated by ComputeMotion and stored by
+    //ApplyMotion before this runs; subclasses add their own per-atom updates
 }
 
 void Movable::Rotate(const Vector &axis) {
+    curr_physical_state.orientation = RotatedOrientation(curr_physical_state.orientation, axis);
+}
+
+Quaternion Movable::RotatedOrientation(const Quaternion &orientation, const Vector &axis) const {
     double theta = axis.Magnitude();
     double ootheta = 0;
     if (theta == 0) {
-        return;
+        return orientation;
     }
     ootheta = 1 / theta;
     float s = cos(theta * .5);
@@ -269,20 +375,21 @@ void Movable::Rotate(const Vector &axis) {
     if (theta < 0.0001) {
         rot = identity_quaternion;
     }
-    curr_physical_state.orientation *= rot;
+    Quaternion rotated = orientation * rot;
     if (limits.limitmin > -1) {
         Matrix mat;
-        curr_physical_state.orientation.to_matrix(mat);
+        rotated.to_matrix(mat);
         if (limits.structurelimits.Dot(mat.getR()) < limits.limitmin) {
-            curr_physical_state.orientation = prev_physical_state.orientation;
+            return prev_physical_state.orientation;
         }
     }
+    return rotated;
 }
 
-Vector Movable::ResolveForces(const Transformation &trans, const Matrix &transmat) {
+void Movable::ComputeForces(const Matrix &transmat, float atom, MotionStep &step) const {
     //First, save theoretical instantaneous acceleration (not time-quantized) for GetAcceleration()
-    SavedAccel = GetNetAcceleration();
-    SavedAngAccel = GetNetAngularAcceleration();
+    step.saved_accel = GetNetAcceleration();
+    step.saved_ang_accel = GetNetAngularAcceleration();
 
     Vector p, q, r;
     GetOrientation(p, q, r);
@@ -297,8 +404,8 @@ Vector Movable::ResolveForces(const Transformation &trans, const Matrix &transma
     // TODO: restore this with the unit name
     //    else
     //        VSFileSystem::vs_fprintf( stderr, "zero moment of inertia %s\n", name.get().c_str() );
-    Vector temp(temp1 * simulation_atom_var);
-    AngularVelocity += temp;
+    Vector temp(temp1 * atom);
+    step.angular_velocity += temp;
 
     float caprate;
     if (isPlayerShip()) {         //clamp to avoid vomit-comet effects
@@ -306,8 +413,8 @@ Vector Movable::ResolveForces(const Transformation &trans, const Matrix &transma
     } else {
         caprate = configuration()->physics_config.max_non_player_rotation_rate;
     }
-    if (AngularVelocity.MagnitudeSquared() > caprate * caprate) {
-        AngularVelocity = AngularVelocity.Normalize() * caprate;
+    if (step.angular_velocity.MagnitudeSquared() > caprate * caprate) {
+        step.angular_velocity = step.angular_velocity.Normalize() * caprate;
     }
     //acceleration
     Vector temp2 = (NetLocalForce.i * p + NetLocalForce.j * q + NetLocalForce.k * r);
@@ -318,68 +425,46 @@ Vector Movable::ResolveForces(const Transformation &trans, const Matrix &transma
         temp2 += InvTransformNormal(transmat, NetForce);
     }
     temp2 = temp2 / Mass;
-    temp = temp2 * simulation_atom_var;
+    temp = temp2 * atom;
     if (!(FINITE(temp2.i) && FINITE(temp2.j) && FINITE(temp2.k))) {
         VS_LOG(info, "NetForce transform skrewed");
     }
-    float oldmagsquared = Velocity.MagnitudeSquared();
-    Velocity += temp;
-    //}
+    float oldmagsquared = step.velocity.MagnitudeSquared();
+    step.velocity += temp;
 
-    float newmagsquared = Velocity.MagnitudeSquared();
+    float newmagsquared = step.velocity.MagnitudeSquared();
 
     bool oldbig = oldmagsquared > cutsqr;
     bool newbig = newmagsquared > cutsqr;
     bool oldoutbig = oldmagsquared > outcutsqr;
     bool newoutbig = newmagsquared > outcutsqr;
     if ((newbig && !oldbig) || (oldoutbig && !newoutbig)) {
-        static bool docache = true;
-        if (docache && !configuration()->graphics_config.in_system_jump_animation.empty()) {
-            UniverseUtil::cacheAnimation(configuration()->graphics_config.in_system_jump_animation);
-            docache = false;
-        }
-        Vector v(GetVelocity());
-        v.Normalize();
-        Vector p, q, r;
-        GetOrientation(p, q, r);
-
-        float tmpsec = oldbig ? configuration()->warp_config.warp_stretch_decel_cutoff : configuration()->warp_config.warp_stretch_cutoff;
-        UniverseUtil::playAnimationGrow(configuration()->graphics_config.in_system_jump_animation,
-                realPosition().Cast() + Velocity * tmpsec + v * radial_size,
-                radial_size * 8,
-                1);
+        step.warp_stretch = true;
+        step.warp_stretch_decel = oldbig;
+        step.warp_stretch_velocity = step.velocity;
     }
 
-    // stephengtuggy 2020-10-17: These need to be initialized here, because they depend on having an active mission.
-    air_res_coef = XMLSupport::parse_floatf(active_missions[0]->getVariable("air_resistance", "0"));
-    lateral_air_res_coef = XMLSupport::parse_floatf(active_missions[0]->getVariable("lateral_air_resistance", "0"));
-
     if (air_res_coef != 0.0F || lateral_air_res_coef != 0.0F) {
-        float velmag = Velocity.Magnitude();
-        Vector AirResistance = Velocity
+        float velmag = step.velocity.Magnitude();
+        Vector AirResistance = step.velocity
                 * (air_res_coef * velmag / Mass) * (corner_max.i - corner_min.i) * (corner_max.j - corner_min.j);
         if (AirResistance.Magnitude() > velmag) {
-            Velocity.Set(0, 0, 0);
+            step.velocity.Set(0, 0, 0);
         } else {
-            Velocity = Velocity - AirResistance;
+            step.velocity = step.velocity - AirResistance;
             if (lateral_air_res_coef != 0.0F) {
-                Vector p, q, r;
-                GetOrientation(p, q, r);
-                Vector lateralVel = p * Velocity.Dot(p) + q * Velocity.Dot(q);
+                Vector lateralVel = p * step.velocity.Dot(p) + q * step.velocity.Dot(q);
                 AirResistance = lateralVel
                         * (lateral_air_res_coef * velmag
                                 / Mass) * (corner_max.i - corner_min.i) * (corner_max.j - corner_min.j);
                 if (AirResistance.Magnitude() > lateralVel.Magnitude()) {
-                    Velocity = r * Velocity.Dot(r);
+                    step.velocity = r * step.velocity.Dot(r);
                 } else {
-                    Velocity = Velocity - AirResistance;
+                    step.velocity = step.velocity - AirResistance;
                 }
             }
         }
     }
-    NetForce = NetLocalForce = NetTorque = NetLocalTorque = Vector(0, 0, 0);
-
-    return temp2;
 }
 
 void Movable::SetOrientation(QVector q, QVector r) {
@@ -438,14 +523,22 @@ Vector Movable::ToWorldCoordinates(const Vector &v) const {
 
 // TODO: move this to JumpCapable
 double Movable::GetMaxWarpFieldStrength(float rampmult) const {
+    const Unit *unit = vega_dynamic_const_cast_ptr<const Unit>(this);
+    //inverse fractional effect of ship vs real big object
+    Unit *nearest_unit = nullptr;
+    float minimum_multiplier = unit->CalculateNearestWarpUnit(
+            configuration()->warp_config.warp_multiplier_max * graphicOptions.MaxWarpMultiplier,
+            &nearest_unit,
+            true);
+    return GetMaxWarpFieldStrength(minimum_multiplier, rampmult);
+}
+
+double Movable::GetMaxWarpFieldStrength(float nearest_warp_multiplier, float rampmult) const {
     const Unit *unit = vega_dynamic_const_cast_ptr<const Unit>(this);
     Vector v = unit->GetWarpRefVelocity();
 //    QVector qv = v.Cast();
 
-    //inverse fractional effect of ship vs real big object
-    float minimum_multiplier = configuration()->warp_config.warp_multiplier_max * graphicOptions.MaxWarpMultiplier;
-    Unit *nearest_unit = nullptr;
-    minimum_multiplier = unit->CalculateNearestWarpUnit(minimum_multiplier, &nearest_unit, true);
+    float minimum_multiplier = nearest_warp_multiplier;
     float minWarp = configuration()->warp_config.warp_multiplier_min * graphicOptions.MinWarpMultiplier;
     float maxWarp = configuration()->warp_config.warp_multiplier_max * graphicOptions.MaxWarpMultiplier;
     if (minimum_multiplier < minWarp) {
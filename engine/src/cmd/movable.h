@@ -153,9 +153,49 @@ protected:
     virtual ~Movable() = default;
 
 public:
-    void AddVelocity(float difficulty);
-//Resolves forces of given unit on a physics frame
-    virtual Vector ResolveForces(const Transformation &, const Matrix &);
+    /**
+     * The outcome of integrating a unit's motion over one sim atom:
+     * resolved forces, rotation, velocity (incl. warp ramping) and the
+     * resulting cumulative transformation. It is computed without touching
+     * the unit, so that many units can be integrated at once from the same
+     * snapshot, and stored afterwards by ApplyMotion() in a fixed order.
+     */
+    struct MotionStep {
+        Vector velocity;
+        Vector angular_velocity;
+        Vector saved_accel;
+        Vector saved_ang_accel;
+        Transformation physical_state;
+        Transformation cumulative_transformation;
+        Matrix cumulative_transformation_matrix;
+        Vector cumulative_velocity;
+        float warp_field_strength{1.0F};
+        float ramp_counter{0.0F};
+        bool warp_ramping{false};
+        bool resolved_forces{false};
+        //The in-system jump animation is due, at this velocity
+        bool warp_stretch{false};
+        bool warp_stretch_decel{false};
+        Vector warp_stretch_velocity;
+        //Warp multiplier allowed by the nearest warp-limiting unit, as found
+        //by FindNearestWarpMultiplier(); left at 0 when the unit isn't warping
+        float nearest_warp_multiplier{0.0F};
+    };
+
+    //Fills in step.nearest_warp_multiplier if the unit is or may be about to
+    //be warping. It walks the star system's unit lists, so it must be called
+    //from the thread that owns the system, before ComputeMotion().
+    void FindNearestWarpMultiplier(MotionStep &step) const;
+    //Integrates this unit's motion over atom seconds from a step prepared by
+    //FindNearestWarpMultiplier(). Only reads the unit and the units it refers
+    //to, never the star system's lists, so units may be integrated concurrently.
+    void ComputeMotion(const Transformation &trans,
+            const Matrix &transmat,
+            const Vector &cum_vel,
+            float atom,
+            MotionStep &step) const;
+    //Stores a step computed by ComputeMotion and starts its effects
+    virtual void ApplyMotion(const MotionStep &step);
 
     //Sets the unit-space position
     void SetPosition(const QVector &pos);
@@ -188,7 +228,7 @@ public:
 //Transforms a orientation vector to world space. Does not take position into account
     Vector ToWorldCoordinates(const Vector &v) const;
 
-    virtual bool isPlayerShip() {
+    virtual bool isPlayerShip() const {
         return false;
     };
 
@@ -200,6 +240,20 @@ public:
             bool ResolveLast,
             UnitCollection *uc,
             Unit *superunit);
+    //UpdatePhysics, split around ComputeMotion() for callers that integrate
+    //many units at once. Prepare returns the state to pass on to Finish.
+    Transformation PrepareUpdatePhysics(const Transformation &trans,
+            const Matrix &transmat,
+            bool ResolveLast,
+            UnitCollection *uc,
+            Unit *superunit);
+    void FinishUpdatePhysics(const Transformation &trans,
+            const Matrix &transmat,
+            const Vector &CumulativeVelocity,
+            bool ResolveLast,
+            UnitCollection *uc,
+            const Transformation &old_physical_state,
+            const MotionStep &step);
     virtual void UpdatePhysics2(const Transformation &trans,
             const Transformation &old_physical_state,
             const Vector &accel,
@@ -234,11 +288,23 @@ public:
     void SetResolveForces(bool);
 
     double GetMaxWarpFieldStrength(float rampmult = 1.f) const;
+    //GetMaxWarpFieldStrength() from an already found nearest warp multiplier
+    double GetMaxWarpFieldStrength(float nearest_warp_multiplier, float rampmult) const;
     void DecreaseWarpEnergy(bool insystem, float time = 1.0f);
     void IncreaseWarpEnergy(bool insystem, float time = 1.0f);
     //Rotates about the axis
     void Rotate(const Vector &axis);
 
+protected:
+    //The orientation after rotating about the axis, within the structure limits
+    Quaternion RotatedOrientation(const Quaternion &orientation, const Vector &axis) const;
+    //Resolves the forces accrued over the atom into step
+    void ComputeForces(const Matrix &transmat, float atom, MotionStep &step) const;
+    //Advances position and warp ramping over the atom
+    void ComputeVelocity(float difficulty, float atom, MotionStep &step) const;
+
+public:
+
     virtual QVector realPosition() = 0;
     virtual void UpdatePhysics3(const Transformation &trans,
             const Matrix &transmat,
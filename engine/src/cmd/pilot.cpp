@@ -115,8 +115,10 @@ float Pilot::getAnger(const Unit *parent, const Unit *target) const {
     if (iter != effective_relationship.end()) {
         rel = iter->second;
     }
-    if (_Universe->isPlayerStarship(target)) {
-        if (FactionUtil::GetFactionName(faction).find("pirates") != std::string::npos) {
+    int parent_cp = _Universe->whichPlayerStarship(parent);
+    int target_cp = _Universe->whichPlayerStarship(target);
+    if (target_cp != -1) {
+        if (FactionUtil::HasTrait(faction, Faction::TRAIT_PIRATE)) {
             static unsigned int cachedCargoNum = 0;
             static bool good = true;
             if (cachedCargoNum != target->numCargo()) {
@@ -138,15 +140,15 @@ float Pilot::getAnger(const Unit *parent, const Unit *target) const {
         }
     }
     {
-        int fac = faction;
-        MapStringFloat::iterator mapiter = factions[fac]->ship_relation_modifier.find(target->name);
-        if (mapiter != factions[fac]->ship_relation_modifier.end()) {
-            rel += (*mapiter).second;
+        const MapStringFloat &modifiers = factions[faction]->ship_relation_modifier;
+        if (!modifiers.empty()) {
+            MapStringFloat::const_iterator mapiter = modifiers.find(target->name);
+            if (mapiter != modifiers.end()) {
+                rel += (*mapiter).second;
+            }
         }
     }
     {
-        int parent_cp = _Universe->whichPlayerStarship(parent);
-        int target_cp = _Universe->whichPlayerStarship(target);
         if (parent_cp != -1) {
             Flightgroup *fg = target->getFlightgroup();
             if (fg) {
@@ -110,7 +110,7 @@ float Pilot::getAnger(const Unit *parent, const Unit *target) const {
         rel = iter->second;
     }
     if (_Universe->isPlayerStarship(target)) {
-        if (FactionUtil::GetFactionName(faction).find("pirates") != std::string::npos) {
+        if (FactionUtil::HasTrait(faction, Faction::TRAIT_PIRATE)) {
             static unsigned int cachedCargoNum = 0;
             static bool good = true;
             if (cachedCargoNum != target->numCargo()) {
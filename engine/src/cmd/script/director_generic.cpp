@@ -33,6 +33,7 @@
 #include "cmd/ai/order.h"
 
 #include "configxml.h"
+#include "configuration/config_handle.h"
 #include "gfx/cockpit_generic.h"
 
 #include "python/python_class.h"
@@ -43,6 +44,7 @@
 #include "gnuhash.h"
 #include "universe.h"
 #include "vs_logging.h"
+#include "vs_profiler.h"
 
 PYTHON_INIT_INHERIT_GLOBALS(Director, PythonMissionBaseClass);
 
@@ -411,6 +413,7 @@ bool Mission::runScript(missionNode *module_node, const string &scriptname, unsi
     if (script_node == NULL) {
         return false;
     }
+    VS_PROFILE_ZONE("MissionScript");
     runtime.cur_thread->module_stack.push_back(module_node);
     runtime.cur_thread->classid_stack.push_back(classid);
 
@@ -455,13 +458,16 @@ void Mission::UnPickle(string pickled) {
 void Mission::DirectorStart(missionNode *node) {
     VS_LOG(trace, "DIRECTOR START");
 
-    static int st_debuglevel = atoi(vs_config->getVariable("interpreter", "debuglevel", "0").c_str());
-    static bool st_start_game = XMLSupport::parse_bool(vs_config->getVariable("interpreter", "startgame", "true"));
-    static bool st_do_trace = XMLSupport::parse_bool(vs_config->getVariable("interpreter", "trace", "false"));
+    //handles, so that each mission picks up the settings of the time it starts
+    static const vega_config::ConfigHandle<int> st_debuglevel("interpreter.debuglevel", 0);
+    static const vega_config::ConfigHandle<bool> st_start_game("interpreter.startgame", true);
+    static const vega_config::ConfigHandle<bool> st_do_trace("interpreter.trace", false);
+    static const vega_config::ConfigHandle<bool> st_compile_scripts("interpreter.compile", true);
 
     debuglevel = st_debuglevel;
     start_game = st_start_game;
     do_trace = st_do_trace;
+    compile_scripts = st_compile_scripts;
 
     vi_counter = 0;
     old_vi_counter = 0;
@@ -506,6 +512,11 @@ void Mission::DirectorStart(missionNode *node) {
             doModule(mnode, SCRIPT_PARSE);
         }
     }
+    if (compile_scripts) {
+        for (iter = runtime.modules.begin(); iter != runtime.modules.end(); iter++) {
+            compileModule((*iter).second);
+        }
+    }
 }
 
 void Mission::DirectorInitgame() {
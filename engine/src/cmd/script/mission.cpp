@@ -71,7 +71,24 @@ Mission::Mission(const char *filename, bool loadscripts) {
     ConstructMission(filename, string(""), loadscripts);
 }
 
+Mission::Mission(missionNode *parsed, bool loadscripts) {
+    ConstructMission(parsed, string(""), loadscripts);
+}
+
 void Mission::ConstructMission(const char *configfile, const std::string &script, bool loadscripts) {
+    easyDomFactory<missionNode> domf;
+    missionNode *parsed = domf.LoadXML(configfile);
+    static bool dontpanic = false;
+    if (parsed == NULL && !dontpanic) {
+        VS_LOG_AND_FLUSH(fatal, (boost::format("Panic exit - mission file %1% not found") % configfile));
+        VSExit(0);
+    } else {
+        dontpanic = true;
+    }
+    ConstructMission(parsed, script, loadscripts);
+}
+
+void Mission::ConstructMission(missionNode *parsed, const std::string &script, bool loadscripts) {
     player_autopilot = global_autopilot = AUTO_NORMAL;
     player_num = 0;
     briefing = NULL;
@@ -84,15 +101,7 @@ void Mission::ConstructMission(const char *configfile, const std::string &script
         nextpythonmission[script.length()] = 0;
         strcpy(nextpythonmission, script.c_str());
     }
-    easyDomFactory<missionNode> domf;
-    top = domf.LoadXML(configfile);
-    static bool dontpanic = false;
-    if (top == NULL && !dontpanic) {
-        VS_LOG_AND_FLUSH(fatal, (boost::format("Panic exit - mission file %1% not found") % configfile));
-        VSExit(0);
-    } else {
-        dontpanic = true;
-    }
+    top = parsed;
     if (top == NULL) {
         return;
     }
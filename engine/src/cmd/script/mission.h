@@ -37,6 +37,7 @@
 #include <expat.h>
 #include <string>
 #include <fstream>
+#include <memory>
 
 //#include "xml_support.h"
 #include "easydom.h"
@@ -383,6 +384,23 @@ public:
 
 /* *********************************************************** */
 
+class scriptCode;
+struct scriptValue;
+
+///Where a variable reference finds its variable, worked out when its module is compiled
+struct scriptVarRef {
+    enum kind_type { UNRESOLVED, LOCAL, CLASS, MODULE, GLOBAL };
+    kind_type kind = UNRESOLVED;
+    ///LOCAL: context in the running script, 0 being the script itself
+    unsigned int context = 0;
+    ///LOCAL, CLASS: index in the varVec of the context or the class instance
+    unsigned int slot = 0;
+    ///MODULE, GLOBAL: the node holding the varinst
+    missionNode *node = nullptr;
+};
+
+/* *********************************************************** */
+
 class missionNode : public tagDomNode {
 public:
     struct script_t {
@@ -407,6 +425,8 @@ public:
         int varId;
         callback_module_type callback_module_id;
         int method_id;
+        scriptVarRef varref; //var,setvar
+        std::shared_ptr<scriptCode> code; //fmath,test,and,or,not: compiled, if it could be
     }
             script;
 };
@@ -457,6 +477,8 @@ public:
 
     Mission(const char *configfile, bool loadscripts = true);
     Mission(const char *filename, const std::string &pythonscript, bool loadscripts = true);
+    //takes a mission file parsed already, by easyDomFactory<missionNode>
+    Mission(missionNode *parsed, bool loadscripts = true);
     std::string Pickle(); //returns filename\npickleddata
     void UnPickle(std::string pickled); //takes in pickeddata
     void AddFlightgroup(Flightgroup *fg);
@@ -525,6 +547,7 @@ public:
 private:
 //std::string getVariable(easyDomNode *section, std::string name, std::string defaultval);
     void ConstructMission(const char *configfile, const std::string &pythonscript, bool loadscripts = true);
+    void ConstructMission(missionNode *parsed, const std::string &pythonscript, bool loadscripts = true);
     missionNode *top;
 
     easyDomNode *variables;
@@ -537,6 +560,7 @@ private:
     int debuglevel;
     bool start_game;
     bool do_trace;
+    bool compile_scripts;
     int tracelevel; //unusued
 
     static int total_nr_frames;
@@ -615,6 +639,10 @@ private:
     varInst *lookupModuleVariable(missionNode *asknode);
     varInst *lookupClassVariable(missionNode *asknode);
     varInst *lookupGlobalVariable(missionNode *asknode);
+    varInst *lookupResolvedVariable(missionNode *asknode);
+    friend class scriptCompiler;
+    void compileModule(missionNode *node);
+    void runCode(missionNode *node, scriptValue &result);
     varInst *doVariable(missionNode *node, int mode);
     void checkStatement(missionNode *node, int mode);
     void doIf(missionNode *node, int mode);
@@ -590,6 +590,11 @@ unsigned int Mission::createClassInstance(string modulename) {
         assignVariable(vi, vi0);
 
         (*cvmap)[vi0_name] = vi;
+        //same slot as in the class template, for resolved references
+        if (cvmap->varVec.size() <= (unsigned int) vi0->varId) {
+            cvmap->varVec.resize(vi0->varId + 1, NULL);
+        }
+        cvmap->varVec[vi0->varId] = vi;
     }
     return module_node->script.classinst_counter;
 }
@@ -0,0 +1,74 @@
+/*
+ * script_code.h
+ *
+ * Copyright (C) 2023 Vega Strike contributors.
+ *
+ * https://github.com/vegastrike/Vega-Strike-Engine-Source
+ *
+ * This file is part of Vega Strike.
+ *
+ * Vega Strike is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Vega Strike is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Vega Strike. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef VEGA_STRIKE_ENGINE_CMD_SCRIPT_SCRIPT_CODE_H
+#define VEGA_STRIKE_ENGINE_CMD_SCRIPT_SCRIPT_CODE_H
+
+#include <vector>
+
+#include "mission.h"
+
+/**
+ * Bytecode of a mission script expression: the math, tests and boolean
+ * operators of one expression tree, run on a small value stack. Variables,
+ * calls and execs are left to the interpreter, one instruction each, so
+ * the compiled form behaves like checkExpression() on the same tree.
+ */
+enum scriptOpcode {
+    SOP_CONST,  ///< push constants[arg]
+    SOP_VAR,    ///< push the variable node refers to
+    SOP_EVAL,   ///< push what checkExpression() makes of node, a call or an exec
+    SOP_NUMBER, ///< the first operand of a math must be int or float
+    SOP_ADD,
+    SOP_SUB,
+    SOP_MUL,
+    SOP_DIV,
+    SOP_TEST,   ///< compare the two topmost; arg is the tester_type
+    SOP_AND,    ///< of the arg topmost
+    SOP_OR,     ///< of the arg topmost
+    SOP_NOT,
+    SOP_EXPECT, ///< the top must be of var_type arg
+};
+
+struct scriptInstruction {
+    scriptOpcode op;
+    unsigned int arg;
+    ///Where errors are reported, and what SOP_VAR and SOP_EVAL work on
+    missionNode *node;
+};
+
+struct scriptValue {
+    var_type type;
+    int int_val;
+    double float_val;
+    bool bool_val;
+};
+
+class scriptCode {
+public:
+    std::vector<scriptInstruction> instructions;
+    std::vector<scriptValue> constants;
+    ///Most values on the stack at once
+    unsigned int max_depth{0};
+};
+
+#endif //VEGA_STRIKE_ENGINE_CMD_SCRIPT_SCRIPT_CODE_H
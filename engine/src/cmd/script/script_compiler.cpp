@@ -0,0 +1,543 @@
+/*
+ * script_compiler.cpp
+ *
+ * Copyright (C) 2023 Vega Strike contributors.
+ *
+ * https://github.com/vegastrike/Vega-Strike-Engine-Source
+ *
+ * This file is part of Vega Strike.
+ *
+ * Vega Strike is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Vega Strike is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Vega Strike. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ *  xml Mission Scripting written by Alexander Rawass <alexannika@users.sourceforge.net>
+ *
+ *  Once a module is parsed, its expressions are compiled to bytecode and its
+ *  variable references resolved to slots, so that running a script no longer
+ *  walks expression trees nor searches variables by name. Whatever can't be
+ *  compiled is left to the interpreter, which still has the last word on
+ *  every variable it can't find in its slot.
+ */
+
+#include <assert.h>
+#include <algorithm>
+#include <unordered_set>
+
+#include "cmd/unit_generic.h"
+#include "mission.h"
+#include "script_code.h"
+
+class scriptCompiler {
+public:
+    scriptCompiler(Mission &mission, missionNode *module) : mission(mission), module(module) {
+    }
+
+    void compileScript(missionNode *script);
+
+private:
+    void compileStatement(missionNode *node);
+    void compileExpression(missionNode *node);
+    void compileArguments(missionNode *node);
+    //appends node to code, or returns false if the interpreter has to do it
+    bool emit(scriptCode &code, missionNode *node, var_type expect);
+    void resolve(missionNode *node);
+
+    Mission &mission;
+    missionNode *module;
+    //the script and the blocks the compiler is in, as the contexts of the running script will be
+    std::vector<missionNode *> scopes;
+    //the local variables defined so far, as when the script was parsed
+    std::unordered_set<missionNode *> seen_defvars;
+};
+
+/* *********************************************************** */
+
+void Mission::compileModule(missionNode *node) {
+    scriptCompiler compiler(*this, node);
+    vector<easyDomNode *>::const_iterator siter;
+    for (siter = node->subnodes.begin(); siter != node->subnodes.end(); siter++) {
+        missionNode *snode = (missionNode *) *siter;
+        if (snode->tag == DTAG_SCRIPT) {
+            compiler.compileScript(snode);
+        }
+    }
+}
+
+void scriptCompiler::compileScript(missionNode *script) {
+    scopes.assign(1, script);
+    seen_defvars.clear();
+    vector<easyDomNode *>::const_iterator siter;
+    for (siter = script->subnodes.begin(); siter != script->subnodes.end(); siter++) {
+        missionNode *snode = (missionNode *) *siter;
+        if (snode->tag == DTAG_ARGUMENTS) {
+            vector<easyDomNode *>::const_iterator argiter;
+            for (argiter = snode->subnodes.begin(); argiter != snode->subnodes.end(); argiter++) {
+                seen_defvars.insert((missionNode *) *argiter);
+            }
+        } else {
+            compileStatement(snode);
+        }
+    }
+}
+
+void scriptCompiler::compileStatement(missionNode *node) {
+    switch (node->tag) {
+        case DTAG_IF:
+            if (node->subnodes.size() == 3) {
+                compileExpression((missionNode *) node->subnodes[0]);
+                compileStatement((missionNode *) node->subnodes[1]);
+                compileStatement((missionNode *) node->subnodes[2]);
+            }
+            break;
+        case DTAG_BLOCK: {
+            scopes.push_back(node);
+            vector<easyDomNode *>::const_iterator siter;
+            for (siter = node->subnodes.begin(); siter != node->subnodes.end(); siter++) {
+                compileStatement((missionNode *) *siter);
+            }
+            scopes.pop_back();
+            break;
+        }
+        case DTAG_SETVAR:
+            resolve(node);
+            if (node->subnodes.size() == 1) {
+                compileExpression((missionNode *) node->subnodes[0]);
+            }
+            break;
+        case DTAG_DEFVAR:
+            seen_defvars.insert(node);
+            break;
+        case DTAG_EXEC:
+        case DTAG_CALL:
+            compileArguments(node);
+            break;
+        case DTAG_RETURN:
+            if (node->subnodes.size() == 1) {
+                compileExpression((missionNode *) node->subnodes[0]);
+            }
+            break;
+        default:
+            //while isn't parsed, so neither is what is below it
+            break;
+    }
+}
+
+void scriptCompiler::compileExpression(missionNode *node) {
+    switch (node->tag) {
+        case DTAG_VAR_EXPR:
+            resolve(node);
+            break;
+        case DTAG_AND_EXPR:
+        case DTAG_OR_EXPR:
+        case DTAG_NOT_EXPR:
+        case DTAG_TEST_EXPR:
+        case DTAG_FMATH: {
+            std::shared_ptr<scriptCode> code(new scriptCode);
+            if (emit(*code, node, VAR_ANY)) {
+                int depth = 0;
+                for (const scriptInstruction &instruction : code->instructions) {
+                    switch (instruction.op) {
+                        case SOP_CONST:
+                        case SOP_VAR:
+                        case SOP_EVAL:
+                            depth++;
+                            break;
+                        case SOP_ADD:
+                        case SOP_SUB:
+                        case SOP_MUL:
+                        case SOP_DIV:
+                        case SOP_TEST:
+                            depth--;
+                            break;
+                        case SOP_AND:
+                        case SOP_OR:
+                            depth += 1 - (int) instruction.arg;
+                            break;
+                        default:
+                            break;
+                    }
+                    code->max_depth = std::max(code->max_depth, (unsigned int) depth);
+                }
+                node->script.code = code;
+            } else {
+                vector<easyDomNode *>::const_iterator siter;
+                for (siter = node->subnodes.begin(); siter != node->subnodes.end(); siter++) {
+                    compileExpression((missionNode *) *siter);
+                }
+            }
+            break;
+        }
+        case DTAG_EXEC:
+        case DTAG_CALL:
+            compileArguments(node);
+            break;
+        default:
+            break;
+    }
+}
+
+void scriptCompiler::compileArguments(missionNode *node) {
+    vector<easyDomNode *>::const_iterator siter;
+    for (siter = node->subnodes.begin(); siter != node->subnodes.end(); siter++) {
+        compileExpression((missionNode *) *siter);
+    }
+}
+
+/* *********************************************************** */
+
+bool scriptCompiler::emit(scriptCode &code, missionNode *node, var_type expect) {
+    scriptInstruction instruction = {SOP_EVAL, 0, node};
+    switch (node->tag) {
+        case DTAG_CONST: {
+            varInst *vi = node->script.varinst;
+            if (vi == NULL) {
+                //never parsed
+                return false;
+            }
+            if (vi->type == VAR_FLOAT || vi->type == VAR_INT || vi->type == VAR_BOOL) {
+                scriptValue value = {vi->type, vi->int_val, vi->float_val, vi->bool_val};
+                instruction.op = SOP_CONST;
+                instruction.arg = code.constants.size();
+                code.constants.push_back(value);
+            }
+            code.instructions.push_back(instruction);
+            break;
+        }
+        case DTAG_VAR_EXPR:
+            if (node->script.name.empty()) {
+                return false;
+            }
+            resolve(node);
+            instruction.op = SOP_VAR;
+            code.instructions.push_back(instruction);
+            break;
+        case DTAG_CALL:
+        case DTAG_EXEC:
+            compileArguments(node);
+            code.instructions.push_back(instruction);
+            break;
+        case DTAG_FMATH: {
+            if (expect != VAR_ANY || node->subnodes.size() < 2) {
+                return false;
+            }
+            string mathname = node->attr_value("math");
+            if (mathname == "+") {
+                instruction.op = SOP_ADD;
+            } else if (mathname == "-") {
+                instruction.op = SOP_SUB;
+            } else if (mathname == "*") {
+                instruction.op = SOP_MUL;
+            } else if (mathname == "/") {
+                instruction.op = SOP_DIV;
+            } else {
+                return false;
+            }
+            if (!emit(code, (missionNode *) node->subnodes[0], VAR_ANY)) {
+                return false;
+            }
+            scriptInstruction number = {SOP_NUMBER, 0, node};
+            code.instructions.push_back(number);
+            for (unsigned int i = 1; i < node->subnodes.size(); i++) {
+                if (!emit(code, (missionNode *) node->subnodes[i], VAR_ANY)) {
+                    return false;
+                }
+                code.instructions.push_back(instruction);
+            }
+            //already a number
+            return true;
+        }
+        case DTAG_TEST_EXPR:
+            if (node->subnodes.size() != 2 || node->script.test_arg[0] == NULL) {
+                return false;
+            }
+            if (!emit(code, node->script.test_arg[0], VAR_ANY) || !emit(code, node->script.test_arg[1], VAR_ANY)) {
+                return false;
+            }
+            instruction.op = SOP_TEST;
+            instruction.arg = node->script.tester;
+            code.instructions.push_back(instruction);
+            return true;
+        case DTAG_AND_EXPR:
+        case DTAG_OR_EXPR: {
+            vector<easyDomNode *>::const_iterator siter;
+            for (siter = node->subnodes.begin(); siter != node->subnodes.end(); siter++) {
+                if (!emit(code, (missionNode *) *siter, VAR_BOOL)) {
+                    return false;
+                }
+            }
+            instruction.op = node->tag == DTAG_AND_EXPR ? SOP_AND : SOP_OR;
+            instruction.arg = node->subnodes.size();
+            code.instructions.push_back(instruction);
+            return true;
+        }
+        case DTAG_NOT_EXPR:
+            if (node->subnodes.empty() || !emit(code, (missionNode *) node->subnodes[0], VAR_BOOL)) {
+                return false;
+            }
+            instruction.op = SOP_NOT;
+            code.instructions.push_back(instruction);
+            return true;
+        default:
+            return false;
+    }
+    //a constant, a variable or a call: may be of any type
+    if (expect != VAR_ANY) {
+        scriptInstruction check = {SOP_EXPECT, (unsigned int) expect, node};
+        code.instructions.push_back(check);
+    }
+    return true;
+}
+
+/* *********************************************************** */
+
+/*
+ * Works out where doVariable() will find the variable, by the same rules:
+ * the contexts of the script, then the class instance, the module and the
+ * globals. A local variable gets a slot only when a single scope on the way
+ * defines it, once, before the reference; anything less certain is left to
+ * the search by name.
+ */
+void scriptCompiler::resolve(missionNode *node) {
+    scriptVarRef &ref = node->script.varref;
+    ref = scriptVarRef();
+    const string &name = node->script.name;
+    if (name.empty()) {
+        return;
+    }
+    int defining = -1;
+    varInst *local = NULL;
+    for (unsigned int depth = 0; depth < scopes.size(); depth++) {
+        varInstMap &vars = scopes[depth]->script.variables;
+        varInstMap::const_iterator found = vars.find(name);
+        if (found != vars.end() && found->second != NULL) {
+            if (defining >= 0) {
+                return;
+            }
+            defining = depth;
+            local = found->second;
+        }
+    }
+    if (defining >= 0) {
+        const varInstVec &slots = scopes[defining]->script.variables.varVec;
+        int definitions = 0;
+        for (unsigned int i = 0; i < slots.size(); i++) {
+            if (slots[i] != NULL && slots[i]->name == name) {
+                definitions++;
+            }
+        }
+        if (definitions == 1 && seen_defvars.count(local->defvar_node)) {
+            ref.kind = scriptVarRef::LOCAL;
+            ref.context = defining;
+            ref.slot = local->varId;
+        }
+        return;
+    }
+    if (!module->script.classvars.empty() && module->script.classvars[0] != NULL) {
+        varInstMap *classvars = module->script.classvars[0];
+        varInstMap::const_iterator found = classvars->find(name);
+        if (found != classvars->end() && found->second != NULL) {
+            ref.kind = scriptVarRef::CLASS;
+            ref.slot = found->second->varId;
+            return;
+        }
+    }
+    vector<easyDomNode *>::const_iterator siter;
+    for (siter = module->subnodes.begin(); siter != module->subnodes.end(); siter++) {
+        missionNode *varnode = (missionNode *) *siter;
+        if (varnode->script.name == name) {
+            ref.kind = scriptVarRef::MODULE;
+            ref.node = varnode;
+            return;
+        }
+    }
+    vsUMap<string, missionNode *>::const_iterator global = mission.runtime.global_variables.find(name);
+    if (global != mission.runtime.global_variables.end() && global->second != NULL) {
+        ref.kind = scriptVarRef::GLOBAL;
+        ref.node = global->second;
+    }
+}
+
+/* *********************************************************** */
+
+static double floatOp(scriptOpcode op, double res1, double res2) {
+    switch (op) {
+        case SOP_ADD:
+            return res1 + res2;
+        case SOP_SUB:
+            return res1 - res2;
+        case SOP_MUL:
+            return res1 * res2;
+        default:
+            return res1 / res2;
+    }
+}
+
+static int intOp(scriptOpcode op, int res1, int res2) {
+    switch (op) {
+        case SOP_ADD:
+            return res1 + res2;
+        case SOP_SUB:
+            return res1 - res2;
+        case SOP_MUL:
+            return res1 * res2;
+        default:
+            return res1 / res2;
+    }
+}
+
+template<typename T>
+static bool test(unsigned int tester, T arg1, T arg2) {
+    switch (tester) {
+        case TEST_GT:
+            return arg1 > arg2;
+        case TEST_LT:
+            return arg1 < arg2;
+        case TEST_EQ:
+            return arg1 == arg2;
+        case TEST_NE:
+            return arg1 != arg2;
+        case TEST_GE:
+            return arg1 >= arg2;
+        case TEST_LE:
+            return arg1 <= arg2;
+        default:
+            return false;
+    }
+}
+
+static void pushVariable(scriptValue &value, const varInst *vi) {
+    value.type = vi->type;
+    value.int_val = vi->int_val;
+    value.float_val = vi->float_val;
+    value.bool_val = vi->bool_val;
+}
+
+//runs the code compiled for node; results are as doMath() and checkBoolExpr() have them, floats included
+void Mission::runCode(missionNode *node, scriptValue &result) {
+    const scriptCode &code = *node->script.code;
+    scriptValue local_stack[16];
+    std::vector<scriptValue> big_stack;
+    scriptValue *stack = local_stack;
+    if (code.max_depth > 16) {
+        big_stack.resize(code.max_depth);
+        stack = &big_stack[0];
+    }
+    unsigned int top = 0;
+    for (const scriptInstruction &instruction : code.instructions) {
+        switch (instruction.op) {
+            case SOP_CONST:
+                stack[top++] = code.constants[instruction.arg];
+                break;
+            case SOP_VAR: {
+                varInst *vi = doVariable(instruction.node, SCRIPT_RUN);
+                scriptValue &value = stack[top++];
+                if (vi == NULL) {
+                    value.type = VAR_FAILURE;
+                } else {
+                    pushVariable(value, vi);
+                    deleteVarInst(vi);
+                }
+                break;
+            }
+            case SOP_EVAL: {
+                varInst *vi = checkExpression(instruction.node, SCRIPT_RUN);
+                scriptValue &value = stack[top++];
+                if (vi == NULL) {
+                    fatalError(instruction.node, SCRIPT_RUN, "doExec returned NULL");
+                    value.type = VAR_VOID;
+                } else {
+                    pushVariable(value, vi);
+                    deleteVarInst(vi);
+                }
+                break;
+            }
+            case SOP_NUMBER: {
+                scriptValue &value = stack[top - 1];
+                if (value.type == VAR_ANY) {
+                    value.type = VAR_FLOAT;
+                } else if (value.type != VAR_INT && value.type != VAR_FLOAT) {
+                    fatalError(instruction.node, SCRIPT_RUN, "only int or float expr allowed for math");
+                    assert(0);
+                }
+                break;
+            }
+            case SOP_ADD:
+            case SOP_SUB:
+            case SOP_MUL:
+            case SOP_DIV: {
+                const scriptValue &res2 = stack[--top];
+                scriptValue &res = stack[top - 1];
+                //the sums are in doubles, the results in floats, as in doMath()
+                if (res2.type == VAR_INT && res.type == VAR_FLOAT) {
+                    res.float_val = (float) floatOp(instruction.op, res.float_val, (float) res2.int_val);
+                } else if (res2.type == VAR_FLOAT && res.type == VAR_INT) {
+                    res.type = VAR_FLOAT;
+                    res.float_val = (float) res.int_val;
+                    res.float_val = (float) floatOp(instruction.op, res.float_val, (float) res2.float_val);
+                } else if (res.type != res2.type) {
+                    fatalError(instruction.node, SCRIPT_RUN, "can't do math on such types");
+                    assert(0);
+                } else if (res.type == VAR_INT) {
+                    res.int_val = intOp(instruction.op, res.int_val, res2.int_val);
+                } else if (res.type == VAR_FLOAT) {
+                    res.float_val = (float) floatOp(instruction.op, res.float_val, res2.float_val);
+                }
+                break;
+            }
+            case SOP_TEST: {
+                const scriptValue &arg2 = stack[--top];
+                scriptValue &arg1 = stack[top - 1];
+                bool res = false;
+                if (arg1.type != arg2.type) {
+                    fatalError(instruction.node, SCRIPT_RUN, "test is getting not the same types");
+                    assert(0);
+                } else if (arg1.type == VAR_FLOAT) {
+                    res = test(instruction.arg, arg1.float_val, arg2.float_val);
+                } else if (arg1.type == VAR_INT) {
+                    res = test(instruction.arg, arg1.int_val, arg2.int_val);
+                } else {
+                    fatalError(instruction.node, SCRIPT_RUN, "no such type allowed for test");
+                    assert(0);
+                }
+                arg1.type = VAR_BOOL;
+                arg1.bool_val = res;
+                break;
+            }
+            case SOP_AND:
+            case SOP_OR: {
+                bool ok = instruction.op == SOP_AND;
+                for (unsigned int i = top - instruction.arg; i < top; i++) {
+                    ok = instruction.op == SOP_AND ? ok && stack[i].bool_val : ok || stack[i].bool_val;
+                }
+                top -= instruction.arg;
+                stack[top].type = VAR_BOOL;
+                stack[top].bool_val = ok;
+                top++;
+                break;
+            }
+            case SOP_NOT:
+                stack[top - 1].type = VAR_BOOL;
+                stack[top - 1].bool_val = !stack[top - 1].bool_val;
+                break;
+            case SOP_EXPECT:
+                if (stack[top - 1].type != (var_type) instruction.arg) {
+                    fatalError(instruction.node, SCRIPT_RUN, "expected a bool expression, got a different one");
+                    assert(0);
+                }
+                break;
+        }
+    }
+    result = stack[0];
+}
@@ -42,6 +42,7 @@
 
 #include "cmd/unit_generic.h"
 #include "mission.h"
+#include "script_code.h"
 #include "easydom.h"
 
 /* *********************************************************** */
@@ -289,6 +290,15 @@ int Mission::doIMath(missionNode *node, int mode) {
 
 double Mission::checkFloatExpr(missionNode *node, int mode) {
     double res = 0.0;
+    if (mode == SCRIPT_RUN && node->tag == DTAG_FMATH && node->script.code) {
+        scriptValue value;
+        runCode(node, value);
+        if (value.type != VAR_FLOAT) {
+            fatalError(node, mode, "fmath expected float");
+            assert(0);
+        }
+        return value.float_val;
+    }
     if (node->tag == DTAG_VAR_EXPR) {
         res = doFloatVar(node, mode);
     } else if (node->tag == DTAG_FMATH) {
@@ -336,6 +346,15 @@ double Mission::checkFloatExpr(missionNode *node, int mode) {
 
 int Mission::checkIntExpr(missionNode *node, int mode) {
     int res = 0;
+    if (mode == SCRIPT_RUN && node->tag == DTAG_FMATH && node->script.code) {
+        scriptValue value;
+        runCode(node, value);
+        if (value.type != VAR_INT) {
+            fatalError(node, mode, "fmath expected int");
+            assert(0);
+        }
+        return value.int_val;
+    }
     if (node->tag == DTAG_VAR_EXPR) {
         res = doIntVar(node, mode);
     } else if (node->tag == DTAG_FMATH) {
@@ -383,6 +402,11 @@ int Mission::checkIntExpr(missionNode *node, int mode) {
 
 bool Mission::checkBoolExpr(missionNode *node, int mode) {
     bool ok = false;
+    if (mode == SCRIPT_RUN && node->tag != DTAG_FMATH && node->script.code) {
+        scriptValue value;
+        runCode(node, value);
+        return value.bool_val;
+    }
     //no difference between parse/run
     if (node->tag == DTAG_AND_EXPR) {
         ok = doAndOr(node, mode);
@@ -615,6 +639,16 @@ bool Mission::doTest(missionNode *node, int mode) {
 
 varInst *Mission::checkExpression(missionNode *node, int mode) {
     varInst *ret = NULL;
+    if (mode == SCRIPT_RUN && node->script.code) {
+        scriptValue value;
+        runCode(node, value);
+        ret = newVarInst(VI_TEMP);
+        ret->type = value.type;
+        ret->float_val = value.float_val;
+        ret->int_val = value.int_val;
+        ret->bool_val = value.bool_val;
+        return ret;
+    }
     debug(3, node, mode, "checking expression");
     switch (node->tag) {
         case DTAG_AND_EXPR:
@@ -156,6 +156,38 @@ varInst *Mission::lookupLocalVariable(missionNode *asknode) {
 
 /* *********************************************************** */
 
+//the variable the reference was resolved to when its module was compiled, NULL to search by name
+varInst *Mission::lookupResolvedVariable(missionNode *asknode) {
+    const scriptVarRef &ref = asknode->script.varref;
+    switch (ref.kind) {
+        case scriptVarRef::LOCAL: {
+            contextStack *cstack = runtime.cur_thread->exec_stack.back();
+            if (ref.context >= cstack->contexts.size()) {
+                return NULL;
+            }
+            const varInstVec &slots = cstack->contexts[ref.context]->varinsts->varVec;
+            return ref.slot < slots.size() ? slots[ref.slot] : NULL;
+        }
+        case scriptVarRef::CLASS: {
+            missionNode *module = runtime.cur_thread->module_stack.back();
+            unsigned int classid = runtime.cur_thread->classid_stack.back();
+            if (classid == 0 || classid >= module->script.classvars.size()
+                    || module->script.classvars[classid] == NULL) {
+                return NULL;
+            }
+            const varInstVec &slots = module->script.classvars[classid]->varVec;
+            return ref.slot < slots.size() ? slots[ref.slot] : NULL;
+        }
+        case scriptVarRef::MODULE:
+        case scriptVarRef::GLOBAL:
+            return ref.node->script.varinst;
+        default:
+            return NULL;
+    }
+}
+
+/* *********************************************************** */
+
 varInst *Mission::lookupModuleVariable(string mname, missionNode *asknode) {
     //only when runtime
     missionNode *module_node = runtime.modules[mname];
@@ -263,7 +295,11 @@ void Mission::doGlobals(missionNode *node, int mode) {
 
 varInst *Mission::doVariable(missionNode *node, int mode) {
     if (mode == SCRIPT_RUN) {
-        varInst *var = lookupLocalVariable(node);
+        varInst *var = lookupResolvedVariable(node);
+        if (var != NULL) {
+            return var;
+        }
+        var = lookupLocalVariable(node);
         if (var == NULL) {
             var = lookupClassVariable(node);
             if (var != NULL) {
@@ -326,7 +362,13 @@ void Mission::doDefVar(missionNode *node, int mode, bool global_var) {
         vi->name = node->script.name;
 
         (*vmap)[node->script.name] = vi;
-
+        //where resolved references look for it
+        if (node->script.varId >= 0) {
+            if (vmap->varVec.size() <= (unsigned int) node->script.varId) {
+                vmap->varVec.resize(node->script.varId + 1, NULL);
+            }
+            vmap->varVec[node->script.varId] = vi;
+        }
         printRuntime();
 
         return;
@@ -457,7 +499,7 @@ void Mission::doSetVar(missionNode *node, int mode) {
             }
             vi = global_var->script.varinst;
         }
-        if (vi->type != VAR_BOOL || vi->type != VAR_FLOAT || vi->type != VAR_INT || vi->type != VAR_OBJECT) {
+        if (vi->type != VAR_BOOL && vi->type != VAR_FLOAT && vi->type != VAR_INT && vi->type != VAR_OBJECT) {
             fatalError(node, mode, "unsupported type in setvar");
             assert(0);
         }
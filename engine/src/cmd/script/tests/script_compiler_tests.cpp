@@ -0,0 +1,311 @@
+/*
+ * script_compiler_tests.cpp
+ *
+ * Copyright (C) 2023 Vega Strike contributors.
+ *
+ * https://github.com/vegastrike/Vega-Strike-Engine-Source
+ *
+ * This file is part of Vega Strike.
+ *
+ * Vega Strike is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Vega Strike is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Vega Strike. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Each mission is run twice, with its scripts compiled and interpreted, and
+// both runs have to leave the variables of its module alike
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "configuration/game_config.h"
+#include "easydom.h"
+#include "cmd/script/mission.h"
+
+namespace {
+
+class ScriptRun {
+public:
+    // Runs the script "run" of the module, a <module name="director"> element
+    ScriptRun(const std::string &module, bool compile) {
+        vega_config::GetGameConfig().SetVariable("interpreter.compile", compile ? "true" : "false");
+        easyDomFactory<missionNode> factory;
+        missionNode *top = factory.ParseXML(
+                "<mission><variables><var name=\"mission_name\" value=\"script compiler test\"/></variables>"
+                        + module + "</mission>");
+        mission.reset(new Mission(top));
+        mission->initMission();
+        ran = mission->runScript("director", "run");
+    }
+
+    ~ScriptRun() {
+        vega_config::GetGameConfig().SetVariable("interpreter.compile", "true");
+    }
+
+    const varInst *Variable(const std::string &name) {
+        missionNode *module = mission->runtime.modules["director"];
+        for (easyDomNode *node : module->subnodes) {
+            missionNode *defvar = (missionNode *) node;
+            if (defvar->tag == DTAG_DEFVAR && defvar->script.name == name) {
+                return defvar->script.varinst;
+            }
+        }
+        return nullptr;
+    }
+
+    // The expressions of the module that were compiled to code
+    int CompiledExpressions() {
+        return CompiledExpressions(mission->runtime.modules["director"]);
+    }
+
+    bool ran{false};
+
+private:
+    static int CompiledExpressions(missionNode *node) {
+        int count = node->script.code ? 1 : 0;
+        for (easyDomNode *subnode : node->subnodes) {
+            count += CompiledExpressions((missionNode *) subnode);
+        }
+        return count;
+    }
+
+    std::unique_ptr<Mission> mission;
+};
+
+// Runs the module both ways and compares the named module variables, to the bit
+void ExpectSameResults(const std::string &module, const std::vector<std::string> &names) {
+    ScriptRun interpreted(module, false);
+    ScriptRun compiled(module, true);
+    ASSERT_TRUE(interpreted.ran);
+    ASSERT_TRUE(compiled.ran);
+    EXPECT_EQ(interpreted.CompiledExpressions(), 0);
+    EXPECT_GT(compiled.CompiledExpressions(), 0);
+
+    for (const std::string &name : names) {
+        const varInst *expected = interpreted.Variable(name);
+        const varInst *actual = compiled.Variable(name);
+        ASSERT_NE(expected, nullptr) << name;
+        ASSERT_NE(actual, nullptr) << name;
+        ASSERT_EQ(actual->type, expected->type) << name;
+        switch (expected->type) {
+            case VAR_FLOAT:
+                EXPECT_EQ(actual->float_val, expected->float_val) << name;
+                break;
+            case VAR_INT:
+                EXPECT_EQ(actual->int_val, expected->int_val) << name;
+                break;
+            case VAR_BOOL:
+                EXPECT_EQ(actual->bool_val, expected->bool_val) << name;
+                break;
+            default:
+                ADD_FAILURE() << name << " is of a type the test can't compare";
+                break;
+        }
+    }
+}
+
+double FloatResult(const std::string &module, bool compile, const std::string &name) {
+    ScriptRun run(module, compile);
+    const varInst *vi = run.Variable(name);
+    return vi ? vi->float_val : -1.0;
+}
+
+int IntResult(const std::string &module, bool compile, const std::string &name) {
+    ScriptRun run(module, compile);
+    const varInst *vi = run.Variable(name);
+    return vi ? vi->int_val : -1;
+}
+
+} // namespace
+
+TEST(ScriptCompiler, FloatMathIsTruncatedToFloat) {
+    // Constants keep their double value, while every partial result is cut to a float
+    const std::string module =
+            "<module name=\"director\">"
+            "  <defvar name=\"sum\" type=\"float\" initvalue=\"0\"/>"
+            "  <defvar name=\"quotient\" type=\"float\" initvalue=\"0\"/>"
+            "  <script name=\"run\">"
+            "    <setvar name=\"sum\"><fmath math=\"+\">"
+            "      <const type=\"float\" value=\"0.1\"/><const type=\"float\" value=\"0.2\"/>"
+            "      <const type=\"float\" value=\"0.3\"/>"
+            "    </fmath></setvar>"
+            "    <setvar name=\"quotient\"><fmath math=\"/\">"
+            "      <const type=\"float\" value=\"1\"/><const type=\"float\" value=\"3\"/>"
+            "    </fmath></setvar>"
+            "  </script>"
+            "</module>";
+    ExpectSameResults(module, {"sum", "quotient"});
+
+    const float partial = (float) (0.1 + 0.2);
+    const double sum = (float) (partial + 0.3);
+    const double quotient = (float) (1.0 / 3.0);
+    for (bool compile : {false, true}) {
+        EXPECT_EQ(FloatResult(module, compile, "sum"), sum) << "compiled: " << compile;
+        EXPECT_EQ(FloatResult(module, compile, "quotient"), quotient) << "compiled: " << compile;
+    }
+}
+
+TEST(ScriptCompiler, IntsArePromotedToFloat) {
+    const std::string module =
+            "<module name=\"director\">"
+            "  <defvar name=\"int_first\" type=\"float\" initvalue=\"0\"/>"
+            "  <defvar name=\"float_first\" type=\"float\" initvalue=\"0\"/>"
+            "  <defvar name=\"int_quotient\" type=\"int\" initvalue=\"0\"/>"
+            "  <defvar name=\"promoted_later\" type=\"float\" initvalue=\"0\"/>"
+            "  <script name=\"run\">"
+            "    <setvar name=\"int_first\"><fmath math=\"+\">"
+            "      <const type=\"int\" value=\"7\"/><const type=\"float\" value=\"0.1\"/>"
+            "    </fmath></setvar>"
+            "    <setvar name=\"float_first\"><fmath math=\"+\">"
+            "      <const type=\"float\" value=\"0.1\"/><const type=\"int\" value=\"7\"/>"
+            "    </fmath></setvar>"
+            "    <setvar name=\"int_quotient\"><fmath math=\"/\">"
+            "      <const type=\"int\" value=\"7\"/><const type=\"int\" value=\"2\"/>"
+            "    </fmath></setvar>"
+            "    <setvar name=\"promoted_later\"><fmath math=\"*\">"
+            "      <fmath math=\"/\"><const type=\"int\" value=\"7\"/><const type=\"int\" value=\"2\"/></fmath>"
+            "      <const type=\"float\" value=\"0.5\"/>"
+            "    </fmath></setvar>"
+            "  </script>"
+            "</module>";
+    ExpectSameResults(module, {"int_first", "float_first", "int_quotient", "promoted_later"});
+
+    for (bool compile : {false, true}) {
+        // The float taken in by an int is cut first, the one it is added to isn't
+        EXPECT_EQ(FloatResult(module, compile, "int_first"), (float) (7.0 + (float) 0.1)) << "compiled: " << compile;
+        EXPECT_EQ(FloatResult(module, compile, "float_first"), (float) (0.1 + 7.0)) << "compiled: " << compile;
+        EXPECT_EQ(IntResult(module, compile, "int_quotient"), 3) << "compiled: " << compile;
+        EXPECT_EQ(FloatResult(module, compile, "promoted_later"), 1.5) << "compiled: " << compile;
+    }
+}
+
+TEST(ScriptCompiler, AndOrEvaluateEveryOperand) {
+    const std::string module =
+            "<module name=\"director\">"
+            "  <defvar name=\"calls\" type=\"int\" initvalue=\"0\"/>"
+            "  <defvar name=\"all\" type=\"bool\" initvalue=\"true\"/>"
+            "  <defvar name=\"any\" type=\"bool\" initvalue=\"false\"/>"
+            "  <script name=\"no\" type=\"bool\">"
+            "    <setvar name=\"calls\"><fmath math=\"+\"><var name=\"calls\"/><const type=\"int\" value=\"1\"/></fmath></setvar>"
+            "    <return><const type=\"bool\" value=\"false\"/></return>"
+            "  </script>"
+            "  <script name=\"yes\" type=\"bool\">"
+            "    <setvar name=\"calls\"><fmath math=\"+\"><var name=\"calls\"/><const type=\"int\" value=\"1\"/></fmath></setvar>"
+            "    <return><const type=\"bool\" value=\"true\"/></return>"
+            "  </script>"
+            "  <script name=\"run\">"
+            "    <setvar name=\"all\"><and><exec name=\"no\"/><exec name=\"yes\"/></and></setvar>"
+            "    <setvar name=\"any\"><or><exec name=\"yes\"/><exec name=\"no\"/></or></setvar>"
+            "  </script>"
+            "</module>";
+    ExpectSameResults(module, {"calls", "all", "any"});
+
+    for (bool compile : {false, true}) {
+        ScriptRun run(module, compile);
+        ASSERT_NE(run.Variable("calls"), nullptr);
+        // No short-circuit: the operands after the one deciding still run
+        EXPECT_EQ(run.Variable("calls")->int_val, 4) << "compiled: " << compile;
+        EXPECT_FALSE(run.Variable("all")->bool_val) << "compiled: " << compile;
+        EXPECT_TRUE(run.Variable("any")->bool_val) << "compiled: " << compile;
+    }
+}
+
+TEST(ScriptCompiler, LocalShadowsModuleVariable) {
+    const std::string module =
+            "<module name=\"director\">"
+            "  <defvar name=\"x\" type=\"float\" initvalue=\"1\"/>"
+            "  <defvar name=\"seen\" type=\"float\" initvalue=\"0\"/>"
+            "  <script name=\"run\">"
+            "    <defvar name=\"x\" type=\"float\"/>"
+            "    <setvar name=\"x\"><const type=\"float\" value=\"2\"/></setvar>"
+            "    <setvar name=\"seen\"><fmath math=\"+\"><var name=\"x\"/><const type=\"float\" value=\"0\"/></fmath></setvar>"
+            "  </script>"
+            "</module>";
+    ExpectSameResults(module, {"x", "seen"});
+
+    for (bool compile : {false, true}) {
+        EXPECT_EQ(FloatResult(module, compile, "x"), 1.0) << "compiled: " << compile;
+        EXPECT_EQ(FloatResult(module, compile, "seen"), 2.0) << "compiled: " << compile;
+    }
+}
+
+TEST(ScriptCompiler, NameDefinedTwiceInAScopeIsLookedUpByName) {
+    // The second defvar replaces the first, which no slot can tell
+    const std::string module =
+            "<module name=\"director\">"
+            "  <defvar name=\"twice\" type=\"int\" initvalue=\"0\"/>"
+            "  <script name=\"run\">"
+            "    <defvar name=\"z\" type=\"int\"/>"
+            "    <setvar name=\"z\"><const type=\"int\" value=\"1\"/></setvar>"
+            "    <defvar name=\"z\" type=\"int\"/>"
+            "    <setvar name=\"z\"><const type=\"int\" value=\"2\"/></setvar>"
+            "    <setvar name=\"twice\"><fmath math=\"+\"><var name=\"z\"/><const type=\"int\" value=\"0\"/></fmath></setvar>"
+            "  </script>"
+            "</module>";
+    ExpectSameResults(module, {"twice"});
+
+    for (bool compile : {false, true}) {
+        EXPECT_EQ(IntResult(module, compile, "twice"), 2) << "compiled: " << compile;
+    }
+}
+
+TEST(ScriptCompiler, NameShadowedInABlockIsLookedUpByName) {
+    // The interpreter finds the outermost definition first, so the block
+    // writes the variable of the script rather than its own
+    const std::string module =
+            "<module name=\"director\">"
+            "  <defvar name=\"inner\" type=\"float\" initvalue=\"0\"/>"
+            "  <defvar name=\"outer\" type=\"float\" initvalue=\"0\"/>"
+            "  <script name=\"run\">"
+            "    <defvar name=\"y\" type=\"float\"/>"
+            "    <setvar name=\"y\"><const type=\"float\" value=\"1\"/></setvar>"
+            "    <block>"
+            "      <defvar name=\"y\" type=\"float\"/>"
+            "      <setvar name=\"y\"><const type=\"float\" value=\"2\"/></setvar>"
+            "      <setvar name=\"inner\"><fmath math=\"+\"><var name=\"y\"/><const type=\"float\" value=\"0\"/></fmath></setvar>"
+            "    </block>"
+            "    <setvar name=\"outer\"><fmath math=\"+\"><var name=\"y\"/><const type=\"float\" value=\"0\"/></fmath></setvar>"
+            "  </script>"
+            "</module>";
+    ExpectSameResults(module, {"inner", "outer"});
+
+    for (bool compile : {false, true}) {
+        EXPECT_EQ(FloatResult(module, compile, "outer"), 2.0) << "compiled: " << compile;
+    }
+}
+
+TEST(ScriptCompiler, ReferenceBeforeDefvarFindsTheModuleVariable) {
+    const std::string module =
+            "<module name=\"director\">"
+            "  <defvar name=\"w\" type=\"int\" initvalue=\"5\"/>"
+            "  <defvar name=\"before\" type=\"int\" initvalue=\"0\"/>"
+            "  <defvar name=\"after\" type=\"int\" initvalue=\"0\"/>"
+            "  <script name=\"run\">"
+            "    <setvar name=\"before\"><fmath math=\"+\"><var name=\"w\"/><const type=\"int\" value=\"1\"/></fmath></setvar>"
+            "    <defvar name=\"w\" type=\"int\"/>"
+            "    <setvar name=\"w\"><const type=\"int\" value=\"10\"/></setvar>"
+            "    <setvar name=\"after\"><fmath math=\"+\"><var name=\"w\"/><const type=\"int\" value=\"1\"/></fmath></setvar>"
+            "  </script>"
+            "</module>";
+    ExpectSameResults(module, {"w", "before", "after"});
+
+    for (bool compile : {false, true}) {
+        ScriptRun run(module, compile);
+        ASSERT_NE(run.Variable("w"), nullptr);
+        EXPECT_EQ(run.Variable("before")->int_val, 6) << "compiled: " << compile;
+        EXPECT_EQ(run.Variable("after")->int_val, 11) << "compiled: " << compile;
+        EXPECT_EQ(run.Variable("w")->int_val, 5) << "compiled: " << compile;
+    }
+}
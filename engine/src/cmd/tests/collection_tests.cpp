@@ -0,0 +1,273 @@
+/*
+ * collection_tests.cpp
+ *
+ * Copyright (C) 2023 Vega Strike contributors.
+ *
+ * https://github.com/vegastrike/Vega-Strike-Engine-Source
+ *
+ * This file is part of Vega Strike.
+ *
+ * Vega Strike is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Vega Strike is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Vega Strike. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Built with LIST_TESTING, against the stand-in Unit of testcollection/unit.h
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "collection.h"
+#include "testcollection/unit.h"
+
+namespace {
+
+std::vector<Unit *> Contents(const UnitCollection &collection) {
+    std::vector<Unit *> contents;
+    for (un_kiter iter = collection.constIterator(); !iter.isDone(); ++iter) {
+        contents.push_back(*iter);
+    }
+    return contents;
+}
+
+} // namespace
+
+TEST(UnitCollection, AppendPrependOrder) {
+    Unit a(false), b(false), c(false);
+    UnitCollection collection;
+    collection.append(&b);
+    collection.append(&c);
+    collection.prepend(&a);
+
+    EXPECT_EQ(Contents(collection), (std::vector<Unit *>{&a, &b, &c}));
+    EXPECT_EQ(collection.size(), 3);
+    EXPECT_EQ(collection.front(), &a);
+    EXPECT_EQ(collection.back(), &c);
+    EXPECT_EQ(b.ucref, 1);
+}
+
+TEST(UnitCollection, StaleIteratorAfterRemoval) {
+    Unit a(false), b(false), c(false), d(false);
+    UnitCollection collection;
+    collection.append(&a);
+    collection.append(&b);
+    collection.append(&c);
+
+    un_iter iter = collection.createIterator();
+    ++iter;
+    ASSERT_EQ(*iter, &b);
+
+    // Even with a single iterator held, the node stays in the list, empty,
+    // while the iterator is on it, so that the iteration can go on
+    EXPECT_TRUE(collection.remove(&b));
+    EXPECT_EQ(*iter, nullptr);
+    EXPECT_FALSE(iter.isDone());
+    EXPECT_EQ(b.ucref, 0);
+    EXPECT_EQ(collection.size(), 2);
+
+    // d goes to the back of the list, after where the iterator is headed
+    collection.append(&d);
+    EXPECT_EQ(iter.next(), &c);
+    EXPECT_EQ(iter.next(), &d);
+    EXPECT_TRUE(iter.next() == nullptr);
+    EXPECT_TRUE(iter.isDone());
+    EXPECT_EQ(Contents(collection), (std::vector<Unit *>{&a, &c, &d}));
+}
+
+TEST(UnitCollection, FreeNodesAreReusedInListOrder) {
+    Unit a(false), b(false), c(false), d(false), e(false);
+    UnitCollection collection;
+    collection.append(&a);
+    collection.append(&b);
+    collection.append(&c);
+
+    EXPECT_TRUE(collection.remove(&b));
+    EXPECT_FALSE(collection.remove(&b));
+    // d takes the node b had in the middle of the array but goes to the back of the list
+    collection.append(&d);
+    collection.prepend(&e);
+
+    EXPECT_EQ(Contents(collection), (std::vector<Unit *>{&e, &a, &c, &d}));
+    EXPECT_EQ(collection.size(), 4);
+    EXPECT_TRUE(collection.contains(&d));
+    EXPECT_FALSE(collection.contains(&b));
+}
+
+TEST(UnitCollection, RemovalIsDeferredWhileIteratorsAreOnTheNode) {
+    Unit a(false), b(false), c(false);
+    UnitCollection collection;
+    collection.append(&a);
+    collection.append(&b);
+    collection.append(&c);
+
+    {
+        un_iter first = collection.createIterator();
+        un_iter second = collection.createIterator();
+        ++first;
+        ++second;
+        ASSERT_EQ(*first, &b);
+
+        EXPECT_TRUE(collection.remove(&b));
+        // The node stays in the list, empty, until the iterators let go of it
+        EXPECT_EQ(*first, nullptr);
+        EXPECT_FALSE(first.isDone());
+        EXPECT_EQ(b.ucref, 0);
+        EXPECT_EQ(collection.size(), 2);
+        EXPECT_FALSE(collection.contains(&b));
+        EXPECT_EQ(Contents(collection), (std::vector<Unit *>{&a, &c}));
+
+        // Both iterators can still move on from it
+        EXPECT_EQ(first.next(), &c);
+        ++second;
+        EXPECT_EQ(*second, &c);
+    }
+
+    // Emptied nodes are unlinked once the iterators are gone
+    Unit d(false);
+    collection.append(&d);
+    EXPECT_EQ(Contents(collection), (std::vector<Unit *>{&a, &c, &d}));
+}
+
+TEST(UnitCollection, IteratorRemoveMovesOn) {
+    Unit a(false), b(false), c(false);
+    UnitCollection collection;
+    collection.append(&a);
+    collection.append(&b);
+    collection.append(&c);
+
+    un_iter iter = collection.createIterator();
+    iter.remove();
+    EXPECT_EQ(*iter, &b);
+    EXPECT_EQ(a.ucref, 0);
+    EXPECT_EQ(Contents(collection), (std::vector<Unit *>{&b, &c}));
+}
+
+TEST(UnitCollection, KilledUnitsAreSkippedAndErased) {
+    Unit a(false), b(false), c(false);
+    UnitCollection collection;
+    collection.append(&a);
+    collection.append(&b);
+    collection.append(&c);
+    b.Kill();
+
+    // Const iteration skips it without changing the list
+    EXPECT_EQ(Contents(collection), (std::vector<Unit *>{&a, &c}));
+    EXPECT_EQ(collection.size(), 3);
+    EXPECT_FALSE(collection.contains(&b));
+
+    un_iter iter = collection.createIterator();
+    EXPECT_EQ(iter.next(), &c);
+    EXPECT_EQ(collection.size(), 2);
+    EXPECT_TRUE(b.zapped);
+}
+
+TEST(UnitCollection, MoveBefore) {
+    Unit a(false), b(false), c(false), d(false);
+    UnitCollection from;
+    UnitCollection to;
+    from.append(&a);
+    from.append(&b);
+    from.append(&c);
+    to.append(&d);
+
+    un_iter iter = from.createIterator();
+    ++iter;
+    iter.moveBefore(to);
+
+    EXPECT_EQ(*iter, &c);
+    EXPECT_EQ(Contents(from), (std::vector<Unit *>{&a, &c}));
+    EXPECT_EQ(Contents(to), (std::vector<Unit *>{&b, &d}));
+    EXPECT_FALSE(from.contains(&b));
+    EXPECT_TRUE(to.contains(&b));
+    EXPECT_EQ(b.ucref, 1);
+}
+
+TEST(UnitCollection, InsertUnique) {
+    Unit a(false), b(false);
+    UnitCollection collection;
+    collection.insert_unique(&a);
+    collection.insert_unique(&b);
+    collection.insert_unique(&a);
+    collection.insert_unique(nullptr);
+
+    EXPECT_EQ(Contents(collection), (std::vector<Unit *>{&b, &a}));
+    EXPECT_EQ(collection.size(), 2);
+    EXPECT_EQ(a.ucref, 1);
+
+    // Once removed it may go in again
+    EXPECT_TRUE(collection.remove(&a));
+    collection.insert_unique(&a);
+    EXPECT_EQ(Contents(collection), (std::vector<Unit *>{&a, &b}));
+    EXPECT_EQ(a.ucref, 1);
+}
+
+TEST(UnitCollection, RemoveTakesTheFirstOfDuplicates) {
+    Unit a(false), b(false);
+    UnitCollection collection;
+    collection.append(&a);
+    collection.append(&b);
+    collection.append(&a);
+
+    EXPECT_TRUE(collection.remove(&a));
+    EXPECT_EQ(Contents(collection), (std::vector<Unit *>{&b, &a}));
+    EXPECT_TRUE(collection.contains(&a));
+    EXPECT_EQ(a.ucref, 1);
+}
+
+TEST(UnitCollection, Compact) {
+    Unit a(false), b(false), c(false), d(false), e(false);
+    UnitCollection collection;
+    collection.append(&a);
+    collection.append(&b);
+    collection.append(&c);
+    collection.append(&d);
+    collection.remove(&b);
+    collection.remove(&d);
+    collection.prepend(&e);
+
+    {
+        // Does nothing while iterators are held
+        un_iter iter = collection.createIterator();
+        ++iter;
+        collection.compact();
+        EXPECT_EQ(*iter, &a);
+    }
+
+    collection.compact();
+    EXPECT_EQ(Contents(collection), (std::vector<Unit *>{&e, &a, &c}));
+    EXPECT_EQ(collection.size(), 3);
+    EXPECT_EQ(collection.front(), &e);
+    EXPECT_EQ(collection.back(), &c);
+
+    // The index is rebuilt along with the nodes
+    EXPECT_TRUE(collection.contains(&c));
+    EXPECT_TRUE(collection.remove(&a));
+    collection.append(&b);
+    EXPECT_EQ(Contents(collection), (std::vector<Unit *>{&e, &c, &b}));
+    EXPECT_EQ(a.ucref, 0);
+    EXPECT_EQ(c.ucref, 1);
+}
+
+TEST(UnitCollection, ClearRefusesWhileIterating) {
+    Unit a(false);
+    UnitCollection collection;
+    collection.append(&a);
+    {
+        un_iter iter = collection.createIterator();
+        collection.clear();
+        EXPECT_EQ(*iter, &a);
+    }
+    collection.clear();
+    EXPECT_TRUE(collection.empty());
+    EXPECT_EQ(a.ucref, 0);
+}
@@ -0,0 +1,217 @@
+/*
+ * collide_broadphase_tests.cpp
+ *
+ * Copyright (C) 2023 Vega Strike contributors.
+ *
+ * https://github.com/vegastrike/Vega-Strike-Engine-Source
+ *
+ * This file is part of Vega Strike.
+ *
+ * Vega Strike is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Vega Strike is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Vega Strike. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "collide_map.h"
+#include "collide_broadphase.h"
+#include "unit_generic.h"
+
+namespace {
+
+Collidable MakeCollidable(double x, double y, double z, float radius) {
+    Collidable collidable;
+    collidable.position = QVector(x, y, z);
+    collidable.radius = radius;
+    return collidable;
+}
+
+// Units spread over a ring in the YZ plane, the worst case for a sweep along X
+std::vector<Collidable> MakeStationRing(size_t count, std::mt19937 &random) {
+    std::uniform_real_distribution<double> angle(0, 2 * M_PI);
+    std::uniform_real_distribution<double> jitter(-50, 50);
+    std::uniform_real_distribution<float> radius(5, 40);
+    std::vector<Collidable> ring;
+    for (size_t i = 0; i < count; ++i) {
+        double a = angle(random);
+        ring.push_back(MakeCollidable(jitter(random) * .1, 20000 * cos(a) + jitter(random),
+                20000 * sin(a) + jitter(random), radius(random)));
+    }
+    std::sort(ring.begin(), ring.end());
+    return ring;
+}
+
+std::vector<Collidable> MakeFleetCloud(size_t count, std::mt19937 &random) {
+    std::uniform_real_distribution<double> coordinate(-20000, 20000);
+    std::uniform_real_distribution<float> radius(5, 40);
+    std::vector<Collidable> cloud;
+    for (size_t i = 0; i < count; ++i) {
+        cloud.push_back(MakeCollidable(coordinate(random), coordinate(random), coordinate(random), radius(random)));
+    }
+    std::sort(cloud.begin(), cloud.end());
+    return cloud;
+}
+
+std::vector<size_t> BruteForce(const std::vector<Collidable> &collidables, const QVector &center, double distance) {
+    std::vector<size_t> result;
+    for (size_t i = 0; i < collidables.size(); ++i) {
+        double limit = distance + std::fabs(collidables[i].radius);
+        if (collidables[i].radius != 0 && (collidables[i].position - center).MagnitudeSquared() <= limit * limit) {
+            result.push_back(i);
+        }
+    }
+    return result;
+}
+
+// Stands for a unit without making one; QueryUnits() never looks at it
+Collidable MakeUnitCollidable(double x, double y, double z, float radius, uintptr_t unit) {
+    Collidable collidable = MakeCollidable(x, y, z, radius);
+    collidable.ref.unit = reinterpret_cast<Unit *>(unit);
+    return collidable;
+}
+
+std::vector<Unit *> QueryUnits(const CollideArray &units, const QVector &center, double distance) {
+    std::vector<Unit *> found;
+    units.QueryUnits(center, distance, found);
+    std::sort(found.begin(), found.end());
+    return found;
+}
+
+std::vector<size_t> Sorted(std::vector<size_t> indices) {
+    std::sort(indices.begin(), indices.end());
+    return indices;
+}
+
+// Visits everything but keeps only the closest, like NearestUnitLocator
+class NearestVisitor : public CollideBroadphase::Visitor {
+public:
+    NearestVisitor(const std::vector<Collidable> &collidables, const QVector &center) :
+            collidables(collidables), center(center) {
+    }
+
+    double Reach() const override {
+        return distance;
+    }
+
+    bool Visit(size_t index) override {
+        double surface = (collidables[index].position - center).Magnitude() - std::fabs(collidables[index].radius);
+        if (surface < distance) {
+            distance = surface;
+            nearest = index;
+        }
+        return true;
+    }
+
+    const std::vector<Collidable> &collidables;
+    QVector center;
+    double distance{HUGE_VAL};
+    size_t nearest{0};
+};
+
+void ExpectMatchesBruteForce(CollideBroadphase &broadphase, const std::vector<Collidable> &collidables) {
+    broadphase.Build(collidables.data(), collidables.data() + collidables.size());
+    std::mt19937 random(7);
+    std::uniform_int_distribution<size_t> pick(0, collidables.size() - 1);
+    for (int query = 0; query < 200; ++query) {
+        const Collidable &around = collidables[pick(random)];
+        double distance = 500.0 * (query % 5);
+        std::vector<size_t> found;
+        broadphase.Query(around.position, distance, found);
+        EXPECT_EQ(Sorted(found), BruteForce(collidables, around.position, distance));
+    }
+}
+
+} // namespace
+
+TEST(CollideBroadphase, Create) {
+    EXPECT_EQ(CollideBroadphase::Create("builtin"), nullptr);
+    EXPECT_NE(CollideBroadphase::Create("sorted_axis"), nullptr);
+    EXPECT_NE(CollideBroadphase::Create("loose_octree"), nullptr);
+}
+
+TEST(CollideBroadphase, SortedAxisMatchesBruteForce) {
+    std::mt19937 random(1);
+    SortedAxisBroadphase broadphase;
+    ExpectMatchesBruteForce(broadphase, MakeStationRing(2000, random));
+    ExpectMatchesBruteForce(broadphase, MakeFleetCloud(2000, random));
+}
+
+TEST(CollideBroadphase, LooseOctreeMatchesBruteForce) {
+    std::mt19937 random(1);
+    LooseOctreeBroadphase broadphase;
+    ExpectMatchesBruteForce(broadphase, MakeStationRing(2000, random));
+    ExpectMatchesBruteForce(broadphase, MakeFleetCloud(2000, random));
+}
+
+TEST(CollideBroadphase, SkipsErasedEntries) {
+    std::vector<Collidable> collidables;
+    collidables.push_back(MakeCollidable(0, 0, 0, 10));
+    collidables.push_back(MakeCollidable(1, 0, 0, 10));
+    collidables.push_back(MakeCollidable(2, 0, 0, -10));
+    LooseOctreeBroadphase broadphase;
+    broadphase.Build(collidables.data(), collidables.data() + collidables.size());
+    collidables[1].radius = 0;
+    std::vector<size_t> found;
+    broadphase.Query(QVector(0, 0, 0), 1, found);
+    EXPECT_EQ(Sorted(found), std::vector<size_t>({0, 2}));
+}
+
+TEST(CollideBroadphase, QueryUnitsReachesBoundingSpheres) {
+    Unit *const big = reinterpret_cast<Unit *>(0x10);
+    Unit *const small = reinterpret_cast<Unit *>(0x20);
+    Unit *const hinted = reinterpret_cast<Unit *>(0x30);
+    CollideArray units(Unit::UNIT_ONLY);
+    // The first one goes straight into the sorted array, the rest wait for the next flatten
+    units.insert(MakeUnitCollidable(100, 0, 0, 50, 0x10));
+    units.insert(MakeUnitCollidable(0, 80, 0, 5, 0x20));
+    EXPECT_EQ(units.sorted.size(), 1U);
+
+    // 60 short of the centre of the big one, but within reach of its surface
+    EXPECT_EQ(QueryUnits(units, QVector(0, 0, 0), 60), std::vector<Unit *>({big}));
+    EXPECT_EQ(QueryUnits(units, QVector(0, 0, 0), 49), std::vector<Unit *>());
+    // Units inserted since the last flatten are found too
+    EXPECT_EQ(QueryUnits(units, QVector(0, 0, 0), 76), std::vector<Unit *>({big, small}));
+
+    units.insert(MakeUnitCollidable(-70, 0, 0, 15, 0x30));
+    // Bolts never are
+    units.insert(MakeCollidable(-5, 0, 0, -3));
+    EXPECT_EQ(QueryUnits(units, QVector(0, 0, 0), 55), std::vector<Unit *>({big, hinted}));
+    EXPECT_EQ(QueryUnits(units, QVector(-70, 0, 0), 1), std::vector<Unit *>({hinted}));
+}
+
+TEST(CollideBroadphase, NarrowingSearchFindsNearest) {
+    std::mt19937 random(3);
+    std::vector<Collidable> cloud = MakeFleetCloud(3000, random);
+    SortedAxisBroadphase sorted_axis;
+    LooseOctreeBroadphase loose_octree;
+    sorted_axis.Build(cloud.data(), cloud.data() + cloud.size());
+    loose_octree.Build(cloud.data(), cloud.data() + cloud.size());
+    for (int i = 0; i < 50; ++i) {
+        QVector center(i * 700.0 - 17000, i * -500.0 + 12000, i * 300.0 - 5000);
+        NearestVisitor expected(cloud, center);
+        for (size_t j = 0; j < cloud.size(); ++j) {
+            expected.Visit(j);
+        }
+        NearestVisitor by_axis(cloud, center);
+        sorted_axis.Search(center, by_axis);
+        NearestVisitor by_octree(cloud, center);
+        loose_octree.Search(center, by_octree);
+        EXPECT_EQ(by_axis.nearest, expected.nearest);
+        EXPECT_EQ(by_octree.nearest, expected.nearest);
+    }
+}
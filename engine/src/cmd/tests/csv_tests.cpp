@@ -57,3 +57,39 @@ TEST(CSV, Sanity) {
         }
     }*/
 }
+
+TEST(CSV, TypedLookups) {
+    std::string csv = "Key,Name,Textual_Description,Mass,Hull,Can_Cloak\n"
+                      "test_llama,Llama,\"A ship, with a comma\",\"1,5\",250.5,TRUE\n"
+                      "test_empty,,,,,\n";
+    UnitCSVFactory::ParseCSV(csv, "/root", false);
+
+    EXPECT_TRUE(UnitCSVFactory::HasUnit("test_llama"));
+    EXPECT_FALSE(UnitCSVFactory::HasUnit("test_missing"));
+    EXPECT_TRUE(UnitCSVFactory::HasVariable("test_llama", "Hull"));
+    EXPECT_FALSE(UnitCSVFactory::HasVariable("test_llama", "Armor"));
+
+    EXPECT_EQ(UnitCSVFactory::GetVariable("test_llama", "Name", std::string()), "Llama");
+    EXPECT_EQ(UnitCSVFactory::GetVariable("test_llama", "Textual_Description", std::string()), "A ship, with a comma");
+    EXPECT_EQ(UnitCSVFactory::GetVariable("test_llama", "root", std::string()), "/root");
+    EXPECT_FLOAT_EQ(UnitCSVFactory::GetVariable("test_llama", "Hull", 0.0f), 250.5f);
+    EXPECT_DOUBLE_EQ(UnitCSVFactory::GetVariable("test_llama", "Hull", 0.0), 250.5);
+    EXPECT_EQ(UnitCSVFactory::GetVariable("test_llama", "Hull", 0), 250);
+    // Like std::stoi, only the leading number counts
+    EXPECT_EQ(UnitCSVFactory::GetVariable("test_llama", "Mass", 0), 1);
+    EXPECT_TRUE(UnitCSVFactory::GetVariable("test_llama", "Can_Cloak", false));
+
+    // Empty cells are present, but don't parse as numbers
+    EXPECT_TRUE(UnitCSVFactory::HasVariable("test_empty", "Hull"));
+    EXPECT_FLOAT_EQ(UnitCSVFactory::GetVariable("test_empty", "Hull", 7.0f), 7.0f);
+    EXPECT_EQ(UnitCSVFactory::GetVariable("test_empty", "Name", std::string("default")), "");
+    EXPECT_FALSE(UnitCSVFactory::GetVariable("test_empty", "Can_Cloak", true));
+    EXPECT_EQ(UnitCSVFactory::GetVariable("test_missing", "Hull", 3), 3);
+
+    // Loading a unit again replaces all of its attributes
+    std::map<std::string, std::string> replacement = {{"Hull", "10"}};
+    UnitCSVFactory::LoadUnit("test_llama", replacement);
+    EXPECT_EQ(UnitCSVFactory::GetVariable("test_llama", "Hull", 0), 10);
+    EXPECT_FALSE(UnitCSVFactory::HasVariable("test_llama", "Name"));
+    EXPECT_EQ(UnitCSVFactory::GetUnit("test_llama"), replacement);
+}
@@ -0,0 +1,177 @@
+/*
+ * target_acquisition_tests.cpp
+ *
+ * Copyright (C) 2023 Vega Strike contributors.
+ *
+ * https://github.com/vegastrike/Vega-Strike-Engine-Source
+ *
+ * This file is part of Vega Strike.
+ *
+ * Vega Strike is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Vega Strike is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Vega Strike. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Searches for targets run against real units, without a star system
+
+#include "cmd/ai/target_acquisition.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "cmd/collide_map.h"
+#include "cmd/unit_generic.h"
+#include "universe.h"
+#include "vs_globals.h"
+#include "vsfilesystem.h"
+
+namespace {
+
+class TargetAcquisitionTest : public ::testing::Test {
+protected:
+    static void SetUpTestCase() {
+        if (vs_config == nullptr) {
+            vs_config = createVegaConfig("test_assets/vegastrike.config");
+        }
+        if (_Universe == nullptr) {
+            _Universe = new Universe();
+        }
+    }
+
+    void TearDown() override {
+        acquisition.Clear();
+    }
+
+    Unit *MakeUnit(int faction, double x, double radius) {
+        Unit *unit = new Unit(0);
+        unit->faction = faction;
+        unit->SetPosition(QVector(x, 0, 0));
+        unit->GetComputerData().radar.maxrange = 1000;
+        Collidable collidable;
+        collidable.SetPosition(unit->Position());
+        collidable.radius = radius;
+        collidable.ref.unit = unit;
+        unit_map.insert(collidable);
+        return unit;
+    }
+
+    // As the star system does once per atom: the map is flattened, which
+    // also points every unit at its place in it, then searched
+    void RunAtom() {
+        unit_map.flatten();
+        acquisition.Run(unit_map);
+    }
+
+    std::vector<TargetAcquisition::Candidate> Take(Unit *parent) {
+        std::vector<TargetAcquisition::Candidate> candidates;
+        EXPECT_TRUE(acquisition.TakeCandidates(parent, candidates));
+        return candidates;
+    }
+
+    CollideArray unit_map{Unit::UNIT_ONLY};
+    TargetAcquisition acquisition;
+};
+
+} // namespace
+
+TEST_F(TargetAcquisitionTest, CandidatesArriveWithTheNextAtom) {
+    Unit *hunter = MakeUnit(1, 0, 10);
+    Unit *enemy = MakeUnit(2, 300, 10);
+    unit_map.flatten();
+
+    // Nothing is searched when asked: the ship keeps its current target
+    // until the star system has run the search
+    acquisition.Request(hunter);
+    std::vector<TargetAcquisition::Candidate> candidates;
+    EXPECT_FALSE(acquisition.TakeCandidates(hunter, candidates));
+    EXPECT_TRUE(candidates.empty());
+
+    RunAtom();
+    candidates = Take(hunter);
+    ASSERT_EQ(candidates.size(), 1U);
+    EXPECT_EQ(candidates[0].unit, enemy);
+
+    // Taken once; another search needs another request
+    EXPECT_FALSE(acquisition.TakeCandidates(hunter, candidates));
+}
+
+TEST_F(TargetAcquisitionTest, NearestFirstWithinRadarRange) {
+    Unit *hunter = MakeUnit(1, 0, 10);
+    Unit *near_enemy = MakeUnit(2, 300, 10);
+    Unit *behind = MakeUnit(2, -600, 10);
+    // Its centre is out of radar range, but not its surface
+    Unit *big = MakeUnit(2, 1100, 200);
+    // Out of radar range
+    MakeUnit(2, 5000, 10);
+    // Its surface is just out of radar range
+    MakeUnit(2, 1030, 10);
+
+    acquisition.Request(hunter);
+    RunAtom();
+    std::vector<TargetAcquisition::Candidate> candidates = Take(hunter);
+    ASSERT_EQ(candidates.size(), 3U);
+    EXPECT_EQ(candidates[0].unit, near_enemy);
+    EXPECT_FLOAT_EQ(candidates[0].distance, 280);
+    EXPECT_EQ(candidates[1].unit, behind);
+    EXPECT_EQ(candidates[2].unit, big);
+    EXPECT_FLOAT_EQ(candidates[2].distance, 890);
+}
+
+TEST_F(TargetAcquisitionTest, LeavesTheFactionToTheChooser) {
+    Unit *hunter = MakeUnit(1, 0, 10);
+    Unit *wingman = MakeUnit(1, 50, 10);
+    Unit *far_enemy = MakeUnit(3, -700, 10);
+    Unit *near_enemy = MakeUnit(2, 400, 10);
+
+    // Every faction is gathered, since whether a unit is hostile depends on
+    // the ship and its orders; FireAt weighs their relation in the order
+    // given, so the first hostile it meets is the nearest one
+    acquisition.Request(hunter);
+    acquisition.Request(far_enemy);
+    RunAtom();
+
+    std::vector<TargetAcquisition::Candidate> candidates = Take(hunter);
+    ASSERT_EQ(candidates.size(), 3U);
+    EXPECT_EQ(candidates[0].unit, wingman);
+    EXPECT_EQ(candidates[1].unit, near_enemy);
+    EXPECT_EQ(candidates[2].unit, far_enemy);
+    auto hostile = std::find_if(candidates.begin(), candidates.end(),
+            [hunter](const TargetAcquisition::Candidate &candidate) {
+                return candidate.unit->faction != hunter->faction;
+            });
+    ASSERT_NE(hostile, candidates.end());
+    EXPECT_EQ(hostile->unit, near_enemy);
+
+    // Served by the same walk, from its own position
+    candidates = Take(far_enemy);
+    ASSERT_EQ(candidates.size(), 2U);
+    EXPECT_EQ(candidates[0].unit, hunter);
+    EXPECT_EQ(candidates[1].unit, wingman);
+}
+
+TEST_F(TargetAcquisitionTest, SkipsKilledUnits) {
+    Unit *hunter = MakeUnit(1, 0, 10);
+    Unit *dead = MakeUnit(2, 100, 10);
+    Unit *dying = MakeUnit(2, 200, 10);
+    Unit *enemy = MakeUnit(2, 300, 10);
+    dead->killed = true;
+
+    acquisition.Request(hunter);
+    RunAtom();
+    // Killed between the search and the taking
+    dying->killed = true;
+    std::vector<TargetAcquisition::Candidate> candidates = Take(hunter);
+    ASSERT_EQ(candidates.size(), 1U);
+    EXPECT_EQ(candidates[0].unit, enemy);
+}
@@ -0,0 +1,126 @@
+/*
+ * unit_database_tests.cpp
+ *
+ * Copyright (C) 2023 Vega Strike contributors.
+ *
+ * https://github.com/vegastrike/Vega-Strike-Engine-Source
+ *
+ * This file is part of Vega Strike.
+ *
+ * Vega Strike is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Vega Strike is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Vega Strike. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <string>
+
+#include <boost/filesystem.hpp>
+
+#include "unit_csv_factory.h"
+#include "unit_database.h"
+
+namespace {
+
+// A table shaped like units.csv: every unit has every column, many of them empty
+std::string MakeUnitTable(int num_units) {
+    const size_t num_columns = sizeof(keys) / sizeof(keys[0]);
+    std::string csv;
+    for (size_t column = 0; column < num_columns; ++column) {
+        csv += (column ? "," : "") + keys[column];
+    }
+    csv += "\n";
+    for (int unit = 0; unit < num_units; ++unit) {
+        csv += "db_test_unit_" + std::to_string(unit);
+        for (size_t column = 1; column < num_columns; ++column) {
+            csv += ",";
+            switch ((unit + column) % 4) {
+                case 0:
+                    break;
+                case 1:
+                    csv += std::to_string(unit * 0.5 + column);
+                    break;
+                case 2:
+                    csv += column % 2 ? "TRUE" : "{llama.bfxm;;}";
+                    break;
+                default:
+                    csv += std::to_string(unit + column);
+                    break;
+            }
+        }
+        csv += "\n";
+    }
+    return csv;
+}
+
+std::string TemporaryPath(const std::string &name) {
+    return (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path(name + "-%%%%-%%%%.db")).string();
+}
+
+} // namespace
+
+TEST(UnitDatabase, RoundTrip) {
+    UnitCSVFactory::ParseCSV(MakeUnitTable(50), "/data", false);
+    std::map<std::string, std::string> expected = UnitCSVFactory::GetUnit("db_test_unit_7");
+    ASSERT_FALSE(expected.empty());
+
+    UnitDatabase::SourceStamp source;
+    source.size = 1234;
+    source.modified = 42;
+    source.hash = 99;
+    const std::string path = TemporaryPath("round-trip");
+    ASSERT_TRUE(UnitDatabase::Save(path, source));
+
+    UnitCSVFactory::LoadUnit("db_test_unit_7", {{"Hull", "1"}});
+    ASSERT_TRUE(UnitDatabase::Load(path, source));
+    EXPECT_EQ(UnitCSVFactory::GetUnit("db_test_unit_7"), expected);
+    EXPECT_EQ(UnitCSVFactory::GetVariable("db_test_unit_7", "root", std::string()), "/data");
+    EXPECT_FLOAT_EQ(UnitCSVFactory::GetVariable("db_test_unit_7", "Hull", 0.0f),
+            std::stof(expected["Hull"]));
+
+    boost::filesystem::remove(path);
+}
+
+TEST(UnitDatabase, RejectsOtherSources) {
+    UnitCSVFactory::ParseCSV(MakeUnitTable(5), "/data", false);
+    UnitDatabase::SourceStamp source;
+    source.size = 1000;
+    source.modified = 42;
+    source.hash = 99;
+    const std::string path = TemporaryPath("stale");
+    ASSERT_TRUE(UnitDatabase::Save(path, source));
+
+    UnitDatabase::SourceStamp touched = source;
+    touched.modified = 43;
+    touched.hash = 0;
+    EXPECT_FALSE(UnitDatabase::Load(path, touched));
+    // A new timestamp on the same contents is still a match once hashed
+    touched.hash = 99;
+    EXPECT_TRUE(UnitDatabase::Load(path, touched));
+
+    UnitDatabase::SourceStamp edited = source;
+    edited.size = 1001;
+    EXPECT_FALSE(UnitDatabase::Load(path, edited));
+    edited = source;
+    edited.modified = 0;
+    edited.hash = 100;
+    EXPECT_FALSE(UnitDatabase::Load(path, edited));
+
+    // A truncated file is refused rather than read past its end
+    boost::filesystem::resize_file(path, boost::filesystem::file_size(path) / 2);
+    EXPECT_FALSE(UnitDatabase::Load(path, source));
+    EXPECT_FALSE(UnitDatabase::Load(path + ".missing", source));
+
+    boost::filesystem::remove(path);
+}
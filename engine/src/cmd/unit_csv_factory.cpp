@@ -25,15 +25,68 @@
 
 #include "unit_csv_factory.h"
 
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
 #include <iostream>
 #include <vector>
 #include <string>
 
-// Required definition of static variable
-std::map<std::string, std::map<std::string, std::string>> UnitCSVFactory::units;
+// Required definition of static variables
+std::unordered_map<std::string, size_t> UnitCSVFactory::unit_rows;
+std::unordered_map<std::string, size_t> UnitCSVFactory::attribute_columns;
+std::vector<std::vector<UnitCSVFactory::Attribute>> UnitCSVFactory::rows;
+
+// Same results as std::stof, std::stod and std::stoi, which would throw
+// for every one of the many empty cells
+void UnitCSVFactory::Attribute::Set(const std::string &value) {
+    text = value;
+    present = true;
+
+    const char *start = text.c_str();
+    char *end;
+    errno = 0;
+    real_f = std::strtof(start, &end);
+    has_float = end != start && errno != ERANGE;
+    errno = 0;
+    real = std::strtod(start, &end);
+    has_double = end != start && errno != ERANGE;
+    errno = 0;
+    long whole = std::strtol(start, &end, 10);
+    has_int = end != start && errno != ERANGE && whole >= INT_MIN && whole <= INT_MAX;
+    integer = has_int ? static_cast<int>(whole) : 0;
+
+    std::string lower = boost::algorithm::to_lower_copy(text);
+    boolean = lower == "true" || lower == "1";
+}
+
+std::vector<UnitCSVFactory::Attribute> &UnitCSVFactory::NewRow(const std::string &unit_key) {
+    auto row = unit_rows.find(unit_key);
+    if (row != unit_rows.end()) {
+        rows[row->second].clear();
+        return rows[row->second];
+    }
+    unit_rows[unit_key] = rows.size();
+    rows.emplace_back();
+    return rows.back();
+}
+
+size_t UnitCSVFactory::Column(const std::string &attribute_key) {
+    auto column = attribute_columns.find(attribute_key);
+    if (column != attribute_columns.end()) {
+        return column->second;
+    }
+    size_t index = attribute_columns.size();
+    attribute_columns[attribute_key] = index;
+    return index;
+}
 
-// This is probably unique enough to ensure no collision
-std::string UnitCSVFactory::DEFAULT_ERROR_VALUE = "UnitCSVFactory::_GetVariable DEFAULT_ERROR_VALUE";
+static inline void SetCell(std::vector<UnitCSVFactory::Attribute> &row, size_t column, const std::string &value) {
+    if (column >= row.size()) {
+        row.resize(column + 1);
+    }
+    row[column].Set(value);
+}
 
 void ExtractColumns(std::string &line) {
     std::string data(line);
@@ -107,28 +160,31 @@ void UnitCSVFactory::ParseCSV(std::string data, std::string root, bool saved_gam
         data.append("\n");
     }
 
+    std::vector<size_t> column_ids;
+    size_t root_column = Column("root");
     while ((pos = data.find(delimiter)) != std::string::npos) {
         token = data.substr(0, pos);
         if (first_line) {
             columns = ProcessLine(token);
+            for (const std::string &column : columns) {
+                column_ids.push_back(Column(column));
+            }
 
             first_line = false;
         } else {
 
             std::vector<std::string> line = ProcessLine(token);
-            std::map<std::string, std::string> unit_attributes;
-
-            for (unsigned int i = 1; i < columns.size(); i++) {
-                unit_attributes[columns[i]] = line[i];
-            }
-
-            // Add root
-            unit_attributes["root"] = root;
 
             std::string key = (saved_game ? "player_ship" : line[0]);
 
             if(!key.empty()) {
-                UnitCSVFactory::units[key] = unit_attributes;
+                std::vector<Attribute> &row = NewRow(key);
+                for (unsigned int i = 1; i < columns.size(); i++) {
+                    SetCell(row, column_ids[i], line[i]);
+                }
+
+                // Add root
+                SetCell(row, root_column, root);
             }
         }
         data.erase(0, pos + delimiter.length());
@@ -151,7 +207,24 @@ std::string GetUnitKeyFromNameAndFaction(const std::string unit_name, const std:
     return std::string();
 }
 
-void UnitCSVFactory::LoadUnit(std::string key, 
-                              std::map<std::string,std::string> unit_map) {
-    UnitCSVFactory::units[key] = unit_map;
+std::map<std::string, std::string> UnitCSVFactory::GetUnit(std::string const &key) {
+    std::map<std::string, std::string> unit;
+    const std::vector<Attribute> *row = FindRow(key);
+    if (!row) {
+        return unit;
+    }
+    for (const auto &column : attribute_columns) {
+        if (column.second < row->size() && (*row)[column.second].present) {
+            unit[column.first] = (*row)[column.second].text;
+        }
+    }
+    return unit;
+}
+
+void UnitCSVFactory::LoadUnit(std::string const &key,
+                              std::map<std::string,std::string> const &unit_map) {
+    std::vector<Attribute> &row = NewRow(key);
+    for (const auto &attribute : unit_map) {
+        SetCell(row, Column(attribute.first), attribute.second);
+    }
 }
\ No newline at end of file
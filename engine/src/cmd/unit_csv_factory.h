@@ -24,9 +24,12 @@
 #ifndef VEGA_STRIKE_ENGINE_CMD_UNIT_CSV_FACTORY_H
 #define VEGA_STRIKE_ENGINE_CMD_UNIT_CSV_FACTORY_H
 
+#include <cstdint>
 #include <map>
 #include <string>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 #include <boost/algorithm/string.hpp>
 #include <iostream>
 
@@ -72,146 +75,134 @@ const std::string keys[] = {"Key", "Directory",	"Name",	"Object_Type",
 
 
 class UnitCSVFactory {
-    static std::string DEFAULT_ERROR_VALUE;
-    static std::map<std::string, std::map<std::string, std::string>> units;
-
-    static inline std::string _GetVariable(std::string unit_key, std::string const &attribute_key) {
-        if (units.count(unit_key) == 0) {
-            return DEFAULT_ERROR_VALUE;
-        }
-
-        std::map<std::string, std::string> unit_attributes = UnitCSVFactory::units[unit_key];
-
-        // TODO: Use this code to find more missing key as shown above.
-        // Note: The following code can probably be cleaner with find...
-        /*bool attribute_found = false;
-
-        for(const std::string& key : keys) {
-            if(key == attribute_key) {
-                attribute_found = true;
-                break;
+public:
+    /* One cell of the unit table. Numbers are parsed once, when the unit is
+     * loaded, rather than on every lookup. */
+    struct Attribute {
+        std::string text;
+        float real_f{0};
+        double real{0};
+        int integer{0};
+        bool has_float{false};
+        bool has_double{false};
+        bool has_int{false};
+        bool boolean{false};
+        bool present{false};
+
+        void Set(const std::string &value);
+    };
+
+private:
+    // Unit key to row of the table
+    static std::unordered_map<std::string, size_t> unit_rows;
+    // Attribute name to column of the table
+    static std::unordered_map<std::string, size_t> attribute_columns;
+    // rows[row][column]. A row stops after the last column it has a value for.
+    static std::vector<std::vector<Attribute>> rows;
+
+    // The row of the unit, emptied, or a new one
+    static std::vector<Attribute> &NewRow(const std::string &unit_key);
+    // The column of the attribute, added if it is new
+    static size_t Column(const std::string &attribute_key);
+
+    static inline const std::vector<Attribute> *FindRow(const std::string &unit_key) {
+        // Loading a unit looks up hundreds of attributes of the same unit in a row
+        static thread_local std::string last_unit_key;
+        static thread_local size_t last_row = SIZE_MAX;
+        if (last_row == SIZE_MAX || unit_key != last_unit_key) {
+            auto row = unit_rows.find(unit_key);
+            if (row == unit_rows.end()) {
+                return nullptr;
             }
+            last_unit_key = unit_key;
+            last_row = row->second;
         }
+        return &rows[last_row];
+    }
 
-        if (!attribute_found)
-        {
-            std::cout << attribute_key << " attribute not found.\n";
-            assert(0);
-        }*/
-
-        if (unit_attributes.count(attribute_key) == 0) {
-            return DEFAULT_ERROR_VALUE;
+    static inline const Attribute *Find(const std::string &unit_key, std::string const &attribute_key) {
+        const std::vector<Attribute> *row = FindRow(unit_key);
+        if (!row) {
+            return nullptr;
         }
-
-        return unit_attributes[attribute_key];
+        auto column = attribute_columns.find(attribute_key);
+        if (column == attribute_columns.end() || column->second >= row->size() || !(*row)[column->second].present) {
+            return nullptr;
+        }
+        return &(*row)[column->second];
     }
 
-    friend class UnitJSONFactory;
-    friend class UnitOptimizeFactory;
+    friend class UnitDatabase;
+
 public:
     static void ParseCSV(std::string data, std::string root, bool saved_game);
 
     template<class T>
-    static inline T GetVariable(std::string unit_key, std::string const &attribute_key, T default_value) = delete;
-    static bool HasVariable(std::string unit_key, std::string const &attribute_key) {
-        if (units.count(unit_key) == 0) {
-            return false;
-        }
-
-        std::map<std::string, std::string> unit_attributes = UnitCSVFactory::units[unit_key];
+    static inline T GetVariable(std::string const &unit_key, std::string const &attribute_key, T default_value) = delete;
 
-        return (unit_attributes.count(attribute_key) > 0);
+    static bool HasVariable(std::string const &unit_key, std::string const &attribute_key) {
+        return Find(unit_key, attribute_key) != nullptr;
     }
 
-    static bool HasUnit(std::string unit_key) {
-        return (units.count(unit_key) > 0);
+    static bool HasUnit(std::string const &unit_key) {
+        return unit_rows.count(unit_key) > 0;
     }
 
+    static std::map<std::string, std::string> GetUnit(std::string const &key);
 
-    static std::map<std::string, std::string> GetUnit(std::string key) {
-        return UnitCSVFactory::units[key];
-    }
-
-    static void LoadUnit(std::string key, 
-                         std::map<std::string,std::string> unit_map);
+    static void LoadUnit(std::string const &key,
+                         std::map<std::string,std::string> const &unit_map);
 };
 
 // Template Specialization
 template<>
-inline std::string UnitCSVFactory::GetVariable(std::string unit_key,
+inline std::string UnitCSVFactory::GetVariable(std::string const &unit_key,
         std::string const &attribute_key,
         std::string default_value) {
-    std::string result = _GetVariable(unit_key, attribute_key);
-    if (result == DEFAULT_ERROR_VALUE) {
+    const Attribute *result = Find(unit_key, attribute_key);
+    if (!result) {
         return default_value;
     }
 
-    return result;
+    return result->text;
 }
 
-// Need this in because "abcd" is const char* and not std::string
-/*template <>
-inline const char* UnitCSVFactory::GetVariable(std::string unit_key, std::string const &attribute_key, const char* default_value)
-{
-    std::string result = _GetVariable(unit_key, attribute_key);
-    if(result == DEFAULT_ERROR_VALUE) {
-        return default_value;
-    }
-
-    return result.c_str();
-}*/
-
 template<>
-inline bool UnitCSVFactory::GetVariable(std::string unit_key, std::string const &attribute_key, bool default_value) {
-    std::string result = _GetVariable(unit_key, attribute_key);
-    if (result == DEFAULT_ERROR_VALUE) {
+inline bool UnitCSVFactory::GetVariable(std::string const &unit_key, std::string const &attribute_key, bool default_value) {
+    const Attribute *result = Find(unit_key, attribute_key);
+    if (!result) {
         return default_value;
     }
-    boost::algorithm::to_lower(result);
-    return (result == "true" || result == "1");
+    return result->boolean;
 }
 
 template<>
-inline float UnitCSVFactory::GetVariable(std::string unit_key, std::string const &attribute_key, float default_value) {
-    std::string result = _GetVariable(unit_key, attribute_key);
-
-    if (result == DEFAULT_ERROR_VALUE) {
-        return default_value;
-    }
-
-    try {
-        return std::stof(result);
-    } catch (std::invalid_argument &) {
+inline float UnitCSVFactory::GetVariable(std::string const &unit_key, std::string const &attribute_key, float default_value) {
+    const Attribute *result = Find(unit_key, attribute_key);
+    if (!result || !result->has_float) {
         return default_value;
     }
+    return result->real_f;
 }
 
 template<>
-inline double UnitCSVFactory::GetVariable(std::string unit_key,
+inline double UnitCSVFactory::GetVariable(std::string const &unit_key,
         std::string const &attribute_key,
         double default_value) {
-    std::string result = _GetVariable(unit_key, attribute_key);
-    if (result == DEFAULT_ERROR_VALUE) {
-        return default_value;
-    }
-    try {
-        return std::stod(result);
-    } catch (std::invalid_argument &) {
+    const Attribute *result = Find(unit_key, attribute_key);
+    if (!result || !result->has_double) {
         return default_value;
     }
+    return result->real;
 }
 
 template<>
-inline int UnitCSVFactory::GetVariable(std::string unit_key, std::string const &attribute_key, int default_value) {
-    std::string result = _GetVariable(unit_key, attribute_key);
-    if (result == DEFAULT_ERROR_VALUE) {
-        return default_value;
-    }
-    try {
-        return std::stoi(result);
-    } catch (std::invalid_argument &) {
+inline int UnitCSVFactory::GetVariable(std::string const &unit_key, std::string const &attribute_key, int default_value) {
+    const Attribute *result = Find(unit_key, attribute_key);
+    if (!result || !result->has_int) {
         return default_value;
     }
+    return result->integer;
 }
 
 std::string GetUnitKeyFromNameAndFaction(const std::string unit_name, const std::string unit_faction);
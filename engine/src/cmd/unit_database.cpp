@@ -0,0 +1,345 @@
+/*
+ * unit_database.cpp
+ *
+ * Copyright (C) 2023 Vega Strike contributors.
+ *
+ * https://github.com/vegastrike/Vega-Strike-Engine-Source
+ *
+ * This file is part of Vega Strike.
+ *
+ * Vega Strike is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Vega Strike is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Vega Strike. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "unit_database.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include "unit_csv_factory.h"
+#include "vs_logging.h"
+
+namespace {
+
+const char kMagic[8] = {'V', 'S', 'U', 'N', 'I', 'T', 'D', 'B'};
+// Written as is, so a file from a machine of the other endianness reads differently
+const uint32_t kByteOrder = 0x01020304;
+
+enum CellFlags : uint8_t {
+    kPresent = 1,
+    kHasFloat = 2,
+    kHasDouble = 4,
+    kHasInt = 8,
+    kBoolean = 16,
+};
+
+// All offsets are from the start of the file, and sections are 8 byte aligned
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t source_size;
+    int64_t source_modified;
+    uint64_t source_hash;
+    uint64_t file_size;
+
+    uint32_t num_strings;
+    uint32_t num_columns;
+    uint32_t num_rows;
+    uint32_t reserved;
+
+    // uint32_t[num_strings + 1]: string i is [offsets[i], offsets[i + 1]) of string_data
+    uint64_t string_offsets;
+    uint64_t string_data;
+    // uint32_t[num_columns] and uint32_t[num_rows], ids of strings
+    uint64_t column_names;
+    uint64_t row_keys;
+    // One array per type with num_columns * num_rows cells, column by column
+    uint64_t cell_text;
+    uint64_t cell_float;
+    uint64_t cell_double;
+    uint64_t cell_int;
+    uint64_t cell_flags;
+};
+
+// Assembles the file in memory, section by section
+class Writer {
+public:
+    Writer() : buffer(sizeof(Header), '\0') {
+    }
+
+    template<class T>
+    uint64_t Append(const std::vector<T> &values) {
+        return Append(values.data(), values.size() * sizeof(T));
+    }
+
+    uint64_t Append(const void *data, size_t size) {
+        buffer.resize((buffer.size() + 7) & ~size_t(7), '\0');
+        uint64_t offset = buffer.size();
+        buffer.append(static_cast<const char *>(data), size);
+        return offset;
+    }
+
+    Header &header() {
+        return *reinterpret_cast<Header *>(&buffer[0]);
+    }
+
+    std::string buffer;
+};
+
+// Checks that a section of count values of type T lies within the file
+template<class T>
+bool SectionFits(uint64_t offset, uint64_t count, uint64_t file_size) {
+    return offset % 8 == 0 && offset <= file_size && count <= (file_size - offset) / sizeof(T);
+}
+
+template<class T>
+const T *Section(const char *file, uint64_t offset) {
+    return reinterpret_cast<const T *>(file + offset);
+}
+
+bool Matches(const Header &header, const UnitDatabase::SourceStamp &source) {
+    if (header.source_size != source.size) {
+        return false;
+    }
+    return (source.modified != 0 && header.source_modified == source.modified)
+            || (source.hash != 0 && header.source_hash == source.hash);
+}
+
+} // namespace
+
+uint64_t UnitDatabase::Hash(const std::string &data) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : data) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+bool UnitDatabase::Load(const std::string &path, const SourceStamp &source) {
+    boost::system::error_code error;
+    if (!boost::filesystem::exists(path, error)) {
+        return false;
+    }
+
+    boost::interprocess::mapped_region region;
+    try {
+        boost::interprocess::file_mapping mapping(path.c_str(), boost::interprocess::read_only);
+        boost::interprocess::mapped_region(mapping, boost::interprocess::read_only).swap(region);
+    } catch (const boost::interprocess::interprocess_exception &exception) {
+        VS_LOG(warning, (boost::format("Unable to map unit database %1%: %2%") % path % exception.what()));
+        return false;
+    }
+    const char *file = static_cast<const char *>(region.get_address());
+    const uint64_t file_size = region.get_size();
+
+    if (file_size < sizeof(Header)) {
+        return false;
+    }
+    const Header &header = *Section<Header>(file, 0);
+    if (memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion
+            || header.byte_order != kByteOrder) {
+        VS_LOG(info, (boost::format("Unit database %1% is from another version") % path));
+        return false;
+    }
+    if (header.file_size != file_size) {
+        VS_LOG(warning, (boost::format("Unit database %1% is damaged") % path));
+        return false;
+    }
+    if (!Matches(header, source)) {
+        return false;
+    }
+
+    // Validate everything before UnitCSVFactory is touched
+    const uint64_t num_cells = uint64_t(header.num_columns) * header.num_rows;
+    if (!SectionFits<uint32_t>(header.string_offsets, uint64_t(header.num_strings) + 1, file_size)
+            || !SectionFits<uint32_t>(header.column_names, header.num_columns, file_size)
+            || !SectionFits<uint32_t>(header.row_keys, header.num_rows, file_size)
+            || !SectionFits<uint32_t>(header.cell_text, num_cells, file_size)
+            || !SectionFits<float>(header.cell_float, num_cells, file_size)
+            || !SectionFits<double>(header.cell_double, num_cells, file_size)
+            || !SectionFits<int32_t>(header.cell_int, num_cells, file_size)
+            || !SectionFits<uint8_t>(header.cell_flags, num_cells, file_size)) {
+        VS_LOG(warning, (boost::format("Unit database %1% is damaged") % path));
+        return false;
+    }
+    const uint32_t *string_offsets = Section<uint32_t>(file, header.string_offsets);
+    const char *string_data = Section<char>(file, header.string_data);
+    for (uint32_t i = 0; i < header.num_strings; ++i) {
+        if (string_offsets[i] > string_offsets[i + 1]) {
+            return false;
+        }
+    }
+    if (header.string_data > file_size || string_offsets[header.num_strings] > file_size - header.string_data) {
+        return false;
+    }
+    const uint32_t *column_names = Section<uint32_t>(file, header.column_names);
+    const uint32_t *row_keys = Section<uint32_t>(file, header.row_keys);
+    const uint32_t *cell_text = Section<uint32_t>(file, header.cell_text);
+    auto valid_string = [&header](uint32_t id) {
+        return id < header.num_strings;
+    };
+    if (!std::all_of(column_names, column_names + header.num_columns, valid_string)
+            || !std::all_of(row_keys, row_keys + header.num_rows, valid_string)
+            || !std::all_of(cell_text, cell_text + num_cells, valid_string)) {
+        VS_LOG(warning, (boost::format("Unit database %1% is damaged") % path));
+        return false;
+    }
+
+    const float *cell_float = Section<float>(file, header.cell_float);
+    const double *cell_double = Section<double>(file, header.cell_double);
+    const int32_t *cell_int = Section<int32_t>(file, header.cell_int);
+    const uint8_t *cell_flags = Section<uint8_t>(file, header.cell_flags);
+    auto string_at = [string_offsets, string_data](uint32_t id) {
+        return std::string(string_data + string_offsets[id], string_offsets[id + 1] - string_offsets[id]);
+    };
+
+    std::vector<size_t> columns(header.num_columns);
+    for (uint32_t column = 0; column < header.num_columns; ++column) {
+        columns[column] = UnitCSVFactory::Column(string_at(column_names[column]));
+    }
+    for (uint32_t row = 0; row < header.num_rows; ++row) {
+        std::vector<UnitCSVFactory::Attribute> &attributes = UnitCSVFactory::NewRow(string_at(row_keys[row]));
+        for (uint32_t column = 0; column < header.num_columns; ++column) {
+            size_t cell = size_t(column) * header.num_rows + row;
+            uint8_t flags = cell_flags[cell];
+            if (!(flags & kPresent)) {
+                continue;
+            }
+            if (columns[column] >= attributes.size()) {
+                attributes.resize(columns[column] + 1);
+            }
+            UnitCSVFactory::Attribute &attribute = attributes[columns[column]];
+            attribute.text = string_at(cell_text[cell]);
+            attribute.real_f = cell_float[cell];
+            attribute.real = cell_double[cell];
+            attribute.integer = cell_int[cell];
+            attribute.has_float = flags & kHasFloat;
+            attribute.has_double = flags & kHasDouble;
+            attribute.has_int = flags & kHasInt;
+            attribute.boolean = flags & kBoolean;
+            attribute.present = true;
+        }
+    }
+    VS_LOG(info, (boost::format("Loaded %1% units from unit database %2%") % header.num_rows % path));
+    return true;
+}
+
+bool UnitDatabase::Save(const std::string &path, const SourceStamp &source) {
+    std::vector<uint32_t> string_offsets(1, 0);
+    std::string string_data;
+    std::unordered_map<std::string, uint32_t> string_ids;
+    auto intern = [&](const std::string &text) {
+        auto found = string_ids.find(text);
+        if (found != string_ids.end()) {
+            return found->second;
+        }
+        uint32_t id = string_ids.size();
+        string_ids.emplace(text, id);
+        string_data += text;
+        string_offsets.push_back(string_data.size());
+        return id;
+    };
+
+    const uint32_t num_columns = UnitCSVFactory::attribute_columns.size();
+    const uint32_t num_rows = UnitCSVFactory::unit_rows.size();
+    std::vector<uint32_t> column_names(num_columns);
+    for (const auto &column : UnitCSVFactory::attribute_columns) {
+        column_names[column.second] = intern(column.first);
+    }
+    std::vector<uint32_t> row_keys;
+    row_keys.reserve(num_rows);
+    const size_t num_cells = size_t(num_columns) * num_rows;
+    std::vector<uint32_t> cell_text(num_cells, 0);
+    std::vector<float> cell_float(num_cells, 0);
+    std::vector<double> cell_double(num_cells, 0);
+    std::vector<int32_t> cell_int(num_cells, 0);
+    std::vector<uint8_t> cell_flags(num_cells, 0);
+    for (const auto &unit : UnitCSVFactory::unit_rows) {
+        const uint32_t row = row_keys.size();
+        row_keys.push_back(intern(unit.first));
+        const std::vector<UnitCSVFactory::Attribute> &attributes = UnitCSVFactory::rows[unit.second];
+        for (size_t column = 0; column < attributes.size(); ++column) {
+            const UnitCSVFactory::Attribute &attribute = attributes[column];
+            if (!attribute.present) {
+                continue;
+            }
+            size_t cell = column * num_rows + row;
+            cell_text[cell] = intern(attribute.text);
+            cell_float[cell] = attribute.real_f;
+            cell_double[cell] = attribute.real;
+            cell_int[cell] = attribute.integer;
+            cell_flags[cell] = kPresent
+                    | (attribute.has_float ? kHasFloat : 0)
+                    | (attribute.has_double ? kHasDouble : 0)
+                    | (attribute.has_int ? kHasInt : 0)
+                    | (attribute.boolean ? kBoolean : 0);
+        }
+    }
+
+    Writer writer;
+    Header header{};
+    memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.byte_order = kByteOrder;
+    header.source_size = source.size;
+    header.source_modified = source.modified;
+    header.source_hash = source.hash;
+    header.num_strings = string_ids.size();
+    header.num_columns = num_columns;
+    header.num_rows = num_rows;
+    header.string_offsets = writer.Append(string_offsets);
+    header.string_data = writer.Append(string_data.data(), string_data.size());
+    header.column_names = writer.Append(column_names);
+    header.row_keys = writer.Append(row_keys);
+    header.cell_text = writer.Append(cell_text);
+    header.cell_float = writer.Append(cell_float);
+    header.cell_double = writer.Append(cell_double);
+    header.cell_int = writer.Append(cell_int);
+    header.cell_flags = writer.Append(cell_flags);
+    header.file_size = writer.buffer.size();
+    writer.header() = header;
+
+    // Write to the side and move into place, so a crash never leaves half a file behind
+    boost::system::error_code error;
+    boost::filesystem::path target(path);
+    if (target.has_parent_path()) {
+        boost::filesystem::create_directories(target.parent_path(), error);
+    }
+    const std::string temporary = path + ".tmp";
+    {
+        std::ofstream out(temporary.c_str(), std::ios::binary | std::ios::trunc);
+        out.write(writer.buffer.data(), writer.buffer.size());
+        if (!out) {
+            VS_LOG(warning, (boost::format("Unable to write unit database %1%") % temporary));
+            return false;
+        }
+    }
+    boost::filesystem::rename(temporary, target, error);
+    if (error) {
+        VS_LOG(warning, (boost::format("Unable to write unit database %1%: %2%") % path % error.message()));
+        boost::filesystem::remove(temporary, error);
+        return false;
+    }
+    VS_LOG(info, (boost::format("Wrote %1% units to unit database %2%") % num_rows % path));
+    return true;
+}
@@ -0,0 +1,66 @@
+/*
+ * unit_database.h
+ *
+ * Copyright (C) 2023 Vega Strike contributors.
+ *
+ * https://github.com/vegastrike/Vega-Strike-Engine-Source
+ *
+ * This file is part of Vega Strike.
+ *
+ * Vega Strike is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Vega Strike is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Vega Strike. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef VEGA_STRIKE_ENGINE_CMD_UNIT_DATABASE_H
+#define VEGA_STRIKE_ENGINE_CMD_UNIT_DATABASE_H
+
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief A compiled copy of the unit table, so that startup does not have to
+ * parse units.json or units.csv again.
+ *
+ * The file holds the table of UnitCSVFactory as it was after parsing: every
+ * string once, then one array per column and type (text, float, double, int
+ * and flags) indexed by row. It is memory mapped and copied straight into
+ * UnitCSVFactory. The header records which source table it was compiled from,
+ * and a file that does not match is simply not loaded.
+ */
+class UnitDatabase {
+public:
+    // Identifies the contents of a unit table
+    struct SourceStamp {
+        uint64_t size{0};
+        // Modification time of the table, 0 if unknown (e.g. inside a PK3)
+        int64_t modified{0};
+        // Hash() of the table, 0 if it has not been read
+        uint64_t hash{0};
+    };
+
+    // Bump whenever the layout of the file changes
+    static const uint32_t kVersion = 1;
+
+    // FNV-1a over the contents of a table
+    static uint64_t Hash(const std::string &data);
+
+    // Loads the units in the file at path into UnitCSVFactory, provided it
+    // was compiled from a table of the same size and with either the same
+    // (known) modification time or the same (known) hash. Returns false,
+    // without touching UnitCSVFactory, if it was not or the file is unusable.
+    static bool Load(const std::string &path, const SourceStamp &source);
+
+    // Writes every unit of UnitCSVFactory to path, replacing any previous file
+    static bool Save(const std::string &path, const SourceStamp &source);
+};
+
+#endif //VEGA_STRIKE_ENGINE_CMD_UNIT_DATABASE_H
@@ -28,6 +28,43 @@
 
 #include "unit_util.h"
 
+//Feeds what a CollideBroadphase finds to a locator. Locators report how far
+//they still look with Reach(), measured between surfaces like their distances.
+template<class Locator>
+class LocatorBroadphaseVisitor : public CollideBroadphase::Visitor {
+    CollideMap::iterator cmbegin;
+    CollideMap::iterator self;
+    Locator *check;
+    QVector thispos;
+    float thisrad;
+public:
+    LocatorBroadphaseVisitor(CollideMap *cm,
+            CollideMap::iterator self,
+            Locator *check,
+            const QVector &thispos,
+            float thisrad) :
+            cmbegin(cm->begin()), self(self), check(check), thispos(thispos), thisrad(thisrad) {
+    }
+
+    double Reach() const override {
+        double reach = check->Reach();
+        return reach < 0 ? reach : reach + thisrad;
+    }
+
+    bool Visit(size_t index) override {
+        CollideMap::iterator i = cmbegin + index;
+        if (i == self) {
+            return true;
+        }
+        float rad = (*i)->radius;
+        if (!check->BoltsOrUnits() && check->UnitsOnly() != (rad > 0)) {
+            return true;
+        }
+        float trad = check->NeedDistance() ? ((*i)->GetPosition() - thispos).Magnitude() - fabs(rad) - thisrad : 0;
+        return check->acquire(trad, i);
+    }
+};
+
 template<class Locator>
 void findObjectsFromPosition(CollideMap *cm,
         CollideMap::iterator location,
@@ -37,6 +74,21 @@ void findObjectsFromPosition(CollideMap *cm,
         bool acquire_on_location) {
     CollideMap::iterator cmend = cm->end();
     CollideMap::iterator cmbegin = cm->begin();
+    if (cm->broadphase && cmend != cmbegin && !is_null(location)) {
+        CollideMap::iterator self = !acquire_on_location && cm->Iterable(location) ? location : nullptr;
+        if (location == cmend) {
+            --location;
+        } else if (!cm->Iterable(location)) {
+            location = cmbegin + static_cast< CollideArray::CollidableBackref * > (location)->toflattenhints_offset;
+            if (location == cmend) {
+                --location;
+            }
+        }
+        check->init(cm, location);
+        LocatorBroadphaseVisitor<Locator> visitor(cm, self, check, thispos, thisrad);
+        cm->broadphase->Search(thispos, visitor);
+        return;
+    }
     if (cmend != cmbegin && !is_null(location)) {
         CollideMap::iterator tless = location;
         CollideMap::iterator tmore = location;
@@ -156,6 +208,10 @@ public:
         return rad != FLT_MAX && (startkey + rad) < (*tmore)->getKey();
     }
 
+    double Reach() const {
+        return rad;
+    }
+
     bool acquire(float distance, CollideMap::iterator i) {
         if (distance < rad) {
             rad = distance;
@@ -262,6 +318,10 @@ public:
         return startkey + radius + maxUnitRadius < (*tmore)->getKey();
     }
 
+    double Reach() const {
+        return radius;
+    }
+
     bool acquire(float dist, CollideMap::iterator i) {
         if (dist < radius) {
             //Inside radius...
@@ -311,6 +371,10 @@ public:
         return retval;
     }
 
+    double Reach() const {
+        return retval ? -1 : FLT_MAX;
+    }
+
     bool acquire(float distance, CollideMap::iterator i) {
         return retval = (((const void *) ((*i)->ref.unit)) == unit);
     }
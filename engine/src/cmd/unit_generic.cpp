@@ -68,12 +68,14 @@
 #include "gfx/camera.h"
 #include "options.h"
 #include "star_system.h"
+#include "worker_pool.h"
 #include "universe.h"
 #include "weapon_info.h"
 #include "mount_size.h"
 #include "turret.h"
 #include "energetic.h"
 #include "configuration/game_config.h"
+#include "configuration/config_handle.h"
 #include "resource/resource.h"
 #include "base_util.h"
 #include "unit_csv_factory.h"
@@ -85,6 +87,7 @@
 #include <cstdint>
 #include <boost/format.hpp>
 #include <random>
+#include <mutex>
 
 #ifdef _WIN32
 #define strcasecmp stricmp
@@ -235,6 +238,8 @@ unsigned int apply_float_to_unsigned_int(float tmp) {
 }
 
 static list<Unit *> Unitdeletequeue;
+//Units in different star systems may die on different simulation threads
+static std::mutex unit_delete_queue_mutex;
 static Hashtable<uintmax_t, Unit, 2095> deletedUn;
 int deathofvs = 1;
 
@@ -1429,7 +1434,10 @@ void Unit::Kill(bool erasefromsave, bool quitting) {
     if (ucref == 0) {
         VS_LOG(trace, (boost::format("UNIT DELETION QUEUED: %1$s %2$s (file %3$s, addr 0x%4$08x)")
                 % name.get().c_str() % fullname.c_str() % filename.get().c_str() % this));
-        Unitdeletequeue.push_back(this);
+        {
+            std::lock_guard<std::mutex> lock(unit_delete_queue_mutex);
+            Unitdeletequeue.push_back(this);
+        }
         if (flightgroup) {
             if (flightgroup->leader.GetUnit() == this) {
                 flightgroup->leader.SetUnit(NULL);
@@ -1452,6 +1460,7 @@ void Unit::UnRef() {
         deletedUn.Put( (uintmax_t) this, this );
 #endif
         //delete
+        std::lock_guard<std::mutex> lock(unit_delete_queue_mutex);
         Unitdeletequeue.push_back(this);
 #ifdef DESTRUCTDEBUG
         VS_LOG(trace, (boost::format("%1$s %2$x - %3$d") % name.get().c_str() % this % Unitdeletequeue.size()));
@@ -1465,7 +1474,11 @@ float Unit::ExplosionRadius() {
 }
 
 void Unit::ProcessDeleteQueue() {
-    while (!Unitdeletequeue.empty()) {
+    while (true) {
+        std::unique_lock<std::mutex> lock(unit_delete_queue_mutex);
+        if (Unitdeletequeue.empty()) {
+            break;
+        }
 #ifdef DESTRUCTDEBUG
                                                                                                                                 VS_LOG_AND_FLUSH(trace, (boost::format("Eliminatin' %1$x - %2$d") % Unitdeletequeue.back() % Unitdeletequeue.size()));
         VS_LOG_AND_FLUSH(trace, (boost::format("Eliminatin' %1$s") % Unitdeletequeue.back()->name.get().c_str()));
@@ -1477,6 +1490,7 @@ void Unit::ProcessDeleteQueue() {
 #endif
         Unit *mydeleter = Unitdeletequeue.back();
         Unitdeletequeue.pop_back();
+        lock.unlock();
         delete mydeleter;                        ///might modify unitdeletequeue
 
 #ifdef DESTRUCTDEBUG
@@ -1831,6 +1845,20 @@ bool Unit::Explode(bool drawit, float timeit) {
     return alldone || (!timealldone);
 }
 
+void Unit::ExplodeInSimulation(float timeit, bool kill_when_done) {
+    if (WorkerPool::InTask()) {
+        Ref();
+        _Universe->activeStarSystem()->QueueForMainThread([this, timeit, kill_when_done]() {
+            if (!killed && !Explode(false, timeit) && kill_when_done) {
+                Kill();
+            }
+            UnRef();
+        });
+    } else if (!Explode(false, timeit) && kill_when_done) {
+        Kill();
+    }
+}
+
 float Unit::ExplodingProgress() const {
     static float debrisTime = XMLSupport::parse_float(vs_config->getVariable("physics", "debris_time", "500"));
     return std::min(pImage->timeexplode / debrisTime, 1.0f);
@@ -4099,7 +4127,7 @@ enum Unit::tractorHow Unit::getTractorability() const {
 void Unit::RequestPhysics() {
     //Request ASAP physics
     if (getStarSystem()) {
-        getStarSystem()->RequestPhysics(this, cur_sim_queue_slot);
+        getStarSystem()->RequestPhysics(this);
     }
 }
 
@@ -4200,8 +4228,6 @@ void Unit::UpdatePhysics2(const Transformation &trans,
         UnitCollection *uc) {
     Movable::UpdatePhysics2(trans, old_physical_state, accel, difficulty, transmat, cum_vel, lastframe, uc);
 
-    this->AddVelocity(difficulty);
-
 #ifdef DEPRECATEDPLANETSTUFF
                                                                                                                             if (planet) {
         Matrix basis;
@@ -4212,10 +4238,6 @@ void Unit::UpdatePhysics2(const Transformation &trans,
         planet->cps = Transformation::from_matrix( this->cumulative_transformation_matrix );
     }
 #endif
-    this->cumulative_transformation = this->curr_physical_state;
-    this->cumulative_transformation.Compose(trans, transmat);
-    this->cumulative_transformation.to_matrix(this->cumulative_transformation_matrix);
-    this->cumulative_velocity = TransformNormal(transmat, this->Velocity) + cum_vel;
     unsigned int i, n;
     if (lastframe) {
         char tmp = 0;
@@ -4233,7 +4255,7 @@ void Unit::UpdatePhysics2(const Transformation &trans,
         }
         //double blah1 = queryTime();
         if (!tmp && this->Destroyed()) {
-            Explode(false, simulation_atom_var /*SIMULATION_ATOM?*/ );
+            ExplodeInSimulation(simulation_atom_var /*SIMULATION_ATOM?*/, false);
         }
         //double blah2 = queryTime();
     }
@@ -4244,12 +4266,14 @@ void Unit::UpdatePhysics2(const Transformation &trans,
 
 
 
-Vector Unit::ResolveForces(const Transformation &trans, const Matrix &transmat) {
+void Unit::ApplyMotion(const MotionStep &step) {
 #ifndef PERFRAMESOUND
-    //AUDAdjustSound( this->sound->engine, this->cumulative_transformation.position, this->cumulative_velocity );
-    adjustSound(SoundType::engine);
+    if (step.resolved_forces) {
+        //AUDAdjustSound( this->sound->engine, this->cumulative_transformation.position, this->cumulative_velocity );
+        adjustSound(SoundType::engine);
+    }
 #endif
-    return Movable::ResolveForces(trans, transmat);
+    Movable::ApplyMotion(step);
 }
 
 void Unit::UpdatePhysics3(const Transformation &trans,
@@ -4310,12 +4334,12 @@ void Unit::UpdatePhysics3(const Transformation &trans,
 
     float difficulty;
     Cockpit *player_cockpit = GetVelocityDifficultyMult(difficulty);
-    static float EXTRA_CARGO_SPACE_DRAG =
-            XMLSupport::parse_float(vs_config->getVariable("physics", "extra_space_drag_for_cargo", "0.005"));
-    if (EXTRA_CARGO_SPACE_DRAG > 0) {
+    static const vega_config::ConfigHandle<float> EXTRA_CARGO_SPACE_DRAG("physics.extra_space_drag_for_cargo", 0.005F);
+    const float extra_cargo_space_drag = EXTRA_CARGO_SPACE_DRAG.Get();
+    if (extra_cargo_space_drag > 0) {
         int upgfac = FactionUtil::GetUpgradeFaction();
         if ((this->faction == upgfac) || (this->name == "eject") || (this->name == "Pilot")) {
-            Velocity = Velocity * (1 - EXTRA_CARGO_SPACE_DRAG);
+            Velocity = Velocity * (1 - extra_cargo_space_drag);
         }
     }
 
@@ -4347,10 +4371,10 @@ void Unit::UpdatePhysics3(const Transformation &trans,
             }
         }
     }
-    static float SPACE_DRAG = XMLSupport::parse_float(vs_config->getVariable("physics", "unit_space_drag", "0.000000"));
-
-    if (SPACE_DRAG > 0) {
-        Velocity = Velocity * (1 - SPACE_DRAG);
+    static const vega_config::ConfigHandle<float> SPACE_DRAG("physics.unit_space_drag", 0.0F);
+    const float space_drag = SPACE_DRAG.Get();
+    if (space_drag > 0) {
+        Velocity = Velocity * (1 - space_drag);
     }
 
     static string LockingSoundName = vs_config->getVariable("unitaudio", "locking", "locking.wav");
@@ -4372,8 +4396,7 @@ void Unit::UpdatePhysics3(const Transformation &trans,
             }
             if (increase_locking && (dist_sqr_to_target < mounts[i].type->range * mounts[i].type->range)) {
                 mounts[i].time_to_lock -= simulation_atom_var;
-                static bool ai_lock_cheat =
-                        XMLSupport::parse_bool(vs_config->getVariable("physics", "ai_lock_cheat", "true"));
+                static const vega_config::ConfigHandle<bool> ai_lock_cheat("physics.ai_lock_cheat", true);
                 if (!player_cockpit) {
                     if (ai_lock_cheat) {
                         mounts[i].time_to_lock = -1;
@@ -4382,15 +4405,9 @@ void Unit::UpdatePhysics3(const Transformation &trans,
                     int LockingPlay = LockingSound;
 
                     //enables spiffy wc2 torpedo music, default to normal though
-                    static bool LockTrumpsMusic =
-                            XMLSupport::parse_bool(vs_config->getVariable("unitaudio",
-                                    "locking_trumps_music",
-                                    "false"));
+                    static const vega_config::ConfigHandle<bool> LockTrumpsMusic("unitaudio.locking_trumps_music", false);
                     //enables spiffy wc2 torpedo music, default to normal though
-                    static bool TorpLockTrumpsMusic =
-                            XMLSupport::parse_bool(vs_config->getVariable("unitaudio",
-                                    "locking_torp_trumps_music",
-                                    "false"));
+                    static const vega_config::ConfigHandle<bool> TorpLockTrumpsMusic("unitaudio.locking_torp_trumps_music", false);
                     if (mounts[i].type->lock_time > 0) {
                         static string LockedSoundName = vs_config->getVariable("unitaudio", "locked", "locked.wav");
                         static int LockedSound = AUDCreateSoundWAV(LockedSoundName, false);
@@ -4512,12 +4529,10 @@ void Unit::UpdatePhysics3(const Transformation &trans,
             uc,
             superunit);
     //can a unit get to another system without jumping?.
-    static bool warp_is_interstellar =
-            XMLSupport::parse_bool(vs_config->getVariable("physics", "warp_is_interstellar", "false"));
+    static const vega_config::ConfigHandle<bool> warp_is_interstellar("physics.warp_is_interstellar", false);
     if (warp_is_interstellar
             && (curr_physical_state.position.MagnitudeSquared() > howFarToJump() * howFarToJump() && !isSubUnit())) {
-        static bool direct =
-                XMLSupport::parse_bool(vs_config->getVariable("physics", "direct_interstellar_journey", "true"));
+        static const vega_config::ConfigHandle<bool> direct("physics.direct_interstellar_journey", true);
         bool jumpDirect = false;
         if (direct) {
             Cockpit *cp = _Universe->isPlayerStarship(this);
@@ -4565,7 +4580,7 @@ void Unit::UpdatePhysics3(const Transformation &trans,
 }
 
 
-bool Unit::isPlayerShip() {
+bool Unit::isPlayerShip() const {
     return _Universe->isPlayerStarship(this) ? true : false;
 }
 
@@ -479,6 +479,10 @@ public:
  *  Uses GFX so only in Unit class
  *  But should always return true on server side = assuming explosion time=0 here */
     bool Explode(bool draw, float timeit);
+/* Explode(false, timeit) from the simulation, killing the unit once the explosion is over if
+ *  kill_when_done. Explosions reach the director, the animations and the music, so on a worker
+ *  thread this waits for the main thread queue of the star system */
+    void ExplodeInSimulation(float timeit, bool kill_when_done);
 
 //Uses GFX so only in Unit class
     //virtual void DrawNow( const Matrix &m = identity_matrix, float lod = 1000000000 ) override {}
@@ -591,7 +595,7 @@ public:
             bool lastframe,
             UnitCollection *uc,
             Unit *superunit) override;
-    bool isPlayerShip() override;
+    bool isPlayerShip() const override;
 
 //The owner of this unit. This may not collide with owner or units owned by owner. Do not dereference (may be dead pointer)
     void *owner = nullptr;   //void ensures that it won't be referenced by accident
@@ -657,7 +661,7 @@ public:
     float ExplodingProgress() const;
 
     ///Resolves forces of given unit on a physics frame
-    Vector ResolveForces(const Transformation &, const Matrix &) override;
+    void ApplyMotion(const MotionStep &step) override;
 
 //What's the size of this unit
     float rSize() const {
@@ -36,8 +36,10 @@
 
 
 void UnitJSONFactory::ParseJSON(VSFileSystem::VSFile &file) {
-    const std::string json_text = file.ReadFull();
+    ParseJSON(file.ReadFull(), file.GetRoot());
+}
 
+void UnitJSONFactory::ParseJSON(const std::string &json_text, const std::string &root) {
     std::vector<std::string> units = json::parsing::parse_array(json_text.c_str());
     // Iterate over root
     for (const std::string &unit_text : units) {
@@ -56,11 +58,11 @@ void UnitJSONFactory::ParseJSON(VSFileSystem::VSFile &file) {
         }
 
         // Add root
-        unit_attributes["root"] = file.GetRoot();
+        unit_attributes["root"] = root;
 
         std::string unit_key = unit.get("Key");
         std::string stripped_unit_key = unit_key.substr(1, unit_key.size() - 2);
 
-        UnitCSVFactory::units[stripped_unit_key] = unit_attributes;
+        UnitCSVFactory::LoadUnit(stripped_unit_key, unit_attributes);
     }
 }
@@ -33,5 +33,6 @@ class UnitJSONFactory {
 
 public:
     static void ParseJSON(VSFileSystem::VSFile &file);
+    static void ParseJSON(const std::string &json_text, const std::string &root);
 };
 #endif //VEGA_STRIKE_ENGINE_CMD_UNIT_JSON_FACTORY_H
@@ -47,7 +47,7 @@ void UnitOptimizeFactory::RecursiveParse(std::map<std::string, std::string> unit
 
     if(unit_attributes.count("Key")) {
         std::string unit_key = unit_attributes["Key"];
-        UnitCSVFactory::units[unit_key] = unit_attributes;
+        UnitCSVFactory::LoadUnit(unit_key, unit_attributes);
     }
     
 
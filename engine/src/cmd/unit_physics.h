@@ -52,8 +52,6 @@ void Unit::UpdatePhysics2(const Transformation &trans,
         UnitCollection *uc) {
     Movable::UpdatePhysics2(trans, old_physical_state, accel, difficulty, transmat, cum_vel, lastframe, uc);
 
-    this->AddVelocity(difficulty);
-
 #ifdef DEPRECATEDPLANETSTUFF
     if (planet) {
         Matrix basis;
@@ -149,12 +147,4 @@ void GameUnit::Thrust(const Vector &amt1, bool afterburn) {
     }
 }
 
-Vector Unit::ResolveForces(const Transformation &trans, const Matrix &transmat) {
-#ifndef PERFRAMESOUND
-    //AUDAdjustSound( this->sound->engine, this->cumulative_transformation.position, this->cumulative_velocity );
-    adjustSound(SoundType::engine);
-#endif
-    return Movable::ResolveForces(trans, transmat);
-}
-
 #endif //VEGA_STRIKE_ENGINE_CMD_UNIT_PHYSICS_H
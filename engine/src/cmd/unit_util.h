@@ -42,6 +42,10 @@ void setFactionName(Unit *my_unit, string factionname);
 float getFactionRelation(const Unit *my_unit, const Unit *their_unit);
 float getRelationToFaction(const Unit *my_unit, int other_faction);
 float getRelationFromFaction(const Unit *their_unit, int my_faction);
+//Brings the faction relations cache up to date, then keeps it as it is until
+//ThawRelationCache(), so unit stages running concurrently only ever read it
+void FreezeRelationCache();
+void ThawRelationCache();
 string getName(const Unit *my_unit);
 void setName(Unit *my_unit, string name);
 void SetHull(Unit *my_unit, float hull);
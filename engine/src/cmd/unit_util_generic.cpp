@@ -23,7 +23,9 @@
 
 #define PY_SSIZE_T_CLEAN
 #include <boost/python.hpp>
+#include <algorithm>
 #include <string>
+#include <vector>
 #include "cmd/unit_generic.h"
 #include "cmd/unit_util.h"
 #include "configxml.h"
@@ -401,36 +403,117 @@ void setFactionName(Unit *my_unit, string factionname) {
     my_unit->SetFaction(FactionUtil::GetFactionIndex(factionname));
 }
 
+//The relations between every pair of factions and the modifiers of every player to every faction, copied into
+//flat arrays once a frame (and whenever they are changed) so that AI ships picking targets don't go through the
+//faction objects and the save game for each pair of units they look at
+struct RelationCache {
+    double frame = -1;
+    unsigned int version = 0;
+    size_t num_factions = 0;
+    size_t num_players = 0;
+    std::vector<float> relations;           //[myfaction * num_factions + theirfaction]
+    std::vector<float> player_modifiers;    //[cockpit * num_factions + faction]
+
+    float Relation(int myfaction, int theirfaction) const {
+        if ((size_t) myfaction < num_factions && (size_t) theirfaction < num_factions) {
+            return relations[myfaction * num_factions + theirfaction];
+        }
+        return FactionUtil::GetIntRelation(myfaction, theirfaction);
+    }
+
+    float PlayerModifier(int cp, int faction) const {
+        if ((size_t) cp < num_players && (size_t) faction < num_factions) {
+            return player_modifiers[cp * num_factions + faction];
+        }
+        return UniverseUtil::getRelationModifierInt(cp, faction);
+    }
+};
+
+static RelationCache relation_cache;
+//Only changed by the main loop around the batches it hands to the worker pool,
+//which orders it with the reads of the workers
+static bool relation_cache_frozen = false;
+
+static void RefreshRelationCache() {
+    RelationCache &cache = relation_cache;
+    const double frame = getNewTime();
+    if (cache.frame == frame && cache.version == FactionUtil::relations_version
+            && cache.num_factions == factions.size() && cache.num_players == _Universe->numPlayers()) {
+        return;
+    }
+    cache.frame = frame;
+    cache.version = FactionUtil::relations_version;
+    cache.num_factions = factions.size();
+    cache.num_players = _Universe->numPlayers();
+    const size_t num_factions = cache.num_factions;
+    cache.relations.assign(num_factions * num_factions, 0.0f);
+    for (size_t i = 0; i < num_factions; ++i) {
+        //Factions whose allies haven't been parsed yet don't know of all the others
+        const size_t known = std::min(num_factions, factions[i]->faction.size());
+        for (size_t j = 0; j < known; ++j) {
+            cache.relations[i * num_factions + j] = factions[i]->faction[j].relationship;
+        }
+    }
+    cache.player_modifiers.resize(cache.num_players * num_factions);
+    for (size_t cp = 0; cp < cache.num_players; ++cp) {
+        for (size_t j = 0; j < num_factions; ++j) {
+            cache.player_modifiers[cp * num_factions + j] = UniverseUtil::getRelationModifierInt(cp, j);
+        }
+    }
+}
+
+void FreezeRelationCache() {
+    RefreshRelationCache();
+    relation_cache_frozen = true;
+}
+
+void ThawRelationCache() {
+    relation_cache_frozen = false;
+}
+
+static const RelationCache &GetRelationCache() {
+    //Relations changed during a stage show from the next serial update on
+    if (!relation_cache_frozen) {
+        RefreshRelationCache();
+    }
+    return relation_cache;
+}
+
 float getFactionRelation(const Unit *my_unit, const Unit *their_unit) {
     if ((my_unit == nullptr) || (their_unit == nullptr)) {
         VS_LOG(warning, "getFactionRelation: null unit encountered!");
         return 0.0f;
     }
-    float relation = FactionUtil::GetIntRelation(my_unit->faction, their_unit->faction);
+    const RelationCache &cache = GetRelationCache();
+    float relation = cache.Relation(my_unit->faction, their_unit->faction);
     int my_cp = _Universe->whichPlayerStarship(my_unit);
-    int their_cp = _Universe->whichPlayerStarship(their_unit);
     if (my_cp != -1) {
-        relation += UniverseUtil::getRelationModifierInt(my_cp, their_unit->faction);
-    } else if (their_cp != -1) {             /* The question is: use an else? */
-        relation += UniverseUtil::getRelationModifierInt(their_cp, my_unit->faction);
+        relation += cache.PlayerModifier(my_cp, their_unit->faction);
+    } else {
+        int their_cp = _Universe->whichPlayerStarship(their_unit);
+        if (their_cp != -1) {             /* The question is: use an else? */
+            relation += cache.PlayerModifier(their_cp, my_unit->faction);
+        }
     }
     return relation;
 }
 
 float getRelationToFaction(const Unit *my_unit, int other_faction) {
-    float relation = FactionUtil::GetIntRelation(my_unit->faction, other_faction);
+    const RelationCache &cache = GetRelationCache();
+    float relation = cache.Relation(my_unit->faction, other_faction);
     int my_cp = _Universe->whichPlayerStarship(my_unit);
     if (my_cp != -1) {
-        relation += UniverseUtil::getRelationModifierInt(my_cp, other_faction);
+        relation += cache.PlayerModifier(my_cp, other_faction);
     }
     return relation;
 }
 
 float getRelationFromFaction(const Unit *their_unit, int my_faction) {
-    float relation = FactionUtil::GetIntRelation(my_faction, their_unit->faction);
+    const RelationCache &cache = GetRelationCache();
+    float relation = cache.Relation(my_faction, their_unit->faction);
     int their_cp = _Universe->whichPlayerStarship(their_unit);
     if (their_cp != -1) {
-        relation += UniverseUtil::getRelationModifierInt(their_cp, my_faction);
+        relation += cache.PlayerModifier(their_cp, my_faction);
     }
     return relation;
 }
@@ -0,0 +1,112 @@
+/*
+ * config_handle.cpp
+ *
+ * Copyright (C) 2023 Vega Strike contributors.
+ *
+ * https://github.com/vegastrike/Vega-Strike-Engine-Source
+ *
+ * This file is part of Vega Strike.
+ *
+ * Vega Strike is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Vega Strike is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Vega Strike. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "configuration/config_handle.h"
+
+#include <algorithm>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+#include "configuration/game_config.h"
+
+namespace vega_config {
+
+namespace {
+
+struct Registry {
+    // Held while handles are added, removed or refreshed, so a refresh
+    // never sees a handle that is being destroyed
+    std::recursive_mutex mutex;
+    std::vector<ConfigHandleBase *> handles;
+};
+
+// Constructed before the first handle, so destroyed after the last one
+Registry &GetRegistry() {
+    static Registry registry;
+    return registry;
+}
+
+} // namespace
+
+void ConfigHandleBase::Register() {
+    Registry &registry = GetRegistry();
+    std::lock_guard<std::recursive_mutex> lock(registry.mutex);
+    Refresh();
+    registry.handles.push_back(this);
+}
+
+void ConfigHandleBase::Unregister() {
+    Registry &registry = GetRegistry();
+    std::lock_guard<std::recursive_mutex> lock(registry.mutex);
+    registry.handles.erase(std::remove(registry.handles.begin(), registry.handles.end(), this),
+            registry.handles.end());
+}
+
+std::string ConfigHandleBase::ReadText() const {
+    return GetGameConfig().GetString(path_, std::string());
+}
+
+void RefreshConfigHandles() {
+    Registry &registry = GetRegistry();
+    std::lock_guard<std::recursive_mutex> lock(registry.mutex);
+    for (ConfigHandleBase *handle : registry.handles) {
+        handle->Refresh();
+    }
+}
+
+bool ParseConfigValue(const std::string &text, bool &value) {
+    if (text.empty()) {
+        return false;
+    }
+    value = text[0] == 't' || text[0] == 'T' || text[0] == 'y' || text[0] == 'Y' || text[0] == '1';
+    return true;
+}
+
+bool ParseConfigValue(const std::string &text, double &value) {
+    if (text.empty()) {
+        return false;
+    }
+    std::istringstream stream(text);
+    value = 0.0;
+    stream >> value;
+    return true;
+}
+
+ConfigHandle<std::string>::ConfigHandle(std::string path, std::string default_value) :
+        ConfigHandleBase(std::move(path)), default_value_(std::move(default_value)) {
+    Register();
+}
+
+ConfigHandle<std::string>::~ConfigHandle() {
+    Unregister();
+}
+
+void ConfigHandle<std::string>::Refresh() {
+    std::string text = ReadText();
+    std::atomic_store(&value_,
+            std::shared_ptr<const std::string>(std::make_shared<std::string>(text.empty() ? default_value_ : text)));
+}
+
+} // namespace vega_config
@@ -0,0 +1,146 @@
+/*
+ * config_handle.h
+ *
+ * Copyright (C) 2023 Vega Strike contributors.
+ *
+ * https://github.com/vegastrike/Vega-Strike-Engine-Source
+ *
+ * This file is part of Vega Strike.
+ *
+ * Vega Strike is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Vega Strike is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Vega Strike. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef VEGA_STRIKE_ENGINE_CONFIG_CONFIG_HANDLE_H
+#define VEGA_STRIKE_ENGINE_CONFIG_CONFIG_HANDLE_H
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <type_traits>
+
+namespace vega_config {
+
+/**
+ * @brief A configuration variable, looked up once rather than on every use.
+ *
+ * Every handle is kept in a registry and re-read whenever the configuration
+ * is loaded or changed, so handles can live in function-local statics
+ * without freezing the value they had at first use:
+ *
+ *     static const vega_config::ConfigHandle<float> space_drag("physics.unit_space_drag", 0.0F);
+ *     Velocity = Velocity * (1 - space_drag.Get());
+ *
+ * Paths are those of GameConfig ("section.name" or
+ * "section.subsection.name"). Values are parsed like vs_config variables
+ * (XMLSupport::parse_float and parse_bool); a missing or empty variable
+ * gives the default.
+ */
+class ConfigHandleBase {
+public:
+    ConfigHandleBase(const ConfigHandleBase &) = delete;
+    ConfigHandleBase &operator=(const ConfigHandleBase &) = delete;
+    virtual ~ConfigHandleBase() = default;
+
+    const std::string &Path() const {
+        return path_;
+    }
+
+protected:
+    explicit ConfigHandleBase(std::string path) : path_(std::move(path)) {
+    }
+
+    // Reads the value and adds the handle to the registry. Called by the
+    // derived constructor, so Refresh() is never called on a partial object.
+    void Register();
+    // Called by the derived destructor, for the same reason
+    void Unregister();
+
+    // The text of the variable, empty if it is not set
+    std::string ReadText() const;
+
+private:
+    friend void RefreshConfigHandles();
+
+    virtual void Refresh() = 0;
+
+    const std::string path_;
+};
+
+// Re-reads every handle from GetGameConfig(). Called by GameConfig whenever
+// the configuration changes.
+void RefreshConfigHandles();
+
+// Parses like XMLSupport: numbers by stream extraction, booleans by their
+// first letter (t, y or 1). Returns false if text holds no value.
+bool ParseConfigValue(const std::string &text, bool &value);
+bool ParseConfigValue(const std::string &text, double &value);
+
+template<typename T>
+class ConfigHandle : public ConfigHandleBase {
+    static_assert(std::is_arithmetic<T>::value, "ConfigHandle holds numbers, booleans and strings");
+
+public:
+    ConfigHandle(std::string path, T default_value) :
+            ConfigHandleBase(std::move(path)), default_value_(default_value), value_(default_value) {
+        Register();
+    }
+
+    ~ConfigHandle() override {
+        Unregister();
+    }
+
+    inline T Get() const {
+        return value_.load(std::memory_order_relaxed);
+    }
+
+    inline operator T() const {
+        return Get();
+    }
+
+private:
+    typedef typename std::conditional<std::is_same<T, bool>::value, bool, double>::type Parsed;
+
+    void Refresh() override {
+        Parsed parsed;
+        value_.store(ParseConfigValue(ReadText(), parsed) ? static_cast<T>(parsed) : default_value_,
+                std::memory_order_relaxed);
+    }
+
+    const T default_value_;
+    std::atomic<T> value_;
+};
+
+template<>
+class ConfigHandle<std::string> : public ConfigHandleBase {
+public:
+    ConfigHandle(std::string path, std::string default_value);
+    ~ConfigHandle() override;
+
+    std::string Get() const {
+        return *std::atomic_load(&value_);
+    }
+
+    operator std::string() const {
+        return Get();
+    }
+
+private:
+    void Refresh() override;
+
+    const std::string default_value_;
+    std::shared_ptr<const std::string> value_;
+};
+
+} // namespace vega_config
+
+#endif //VEGA_STRIKE_ENGINE_CONFIG_CONFIG_HANDLE_H
@@ -72,9 +72,12 @@ void Configuration::OverrideDefaultsWithUserConfiguration() {
     general_config.delete_old_systems = GetGameConfig().GetBool("general.deleteoldsystems", general_config.delete_old_systems);
     // vsdebug moved to logging section -- stephengtuggy 2022-05-28
     general_config.while_loading_star_system = GetGameConfig().GetBool("general.while_loading_starsystem", general_config.while_loading_star_system);
+    general_config.prefetched_star_systems = GetGameConfig().GetUInt32("general.prefetched_star_systems", general_config.prefetched_star_systems);
+    general_config.prefetched_image_megabytes = GetGameConfig().GetUInt32("general.prefetched_image_megabytes", general_config.prefetched_image_megabytes);
 
     data_config.master_part_list = GetGameConfig().GetString("data.master_part_list", data_config.master_part_list);
     data_config.using_templates = GetGameConfig().GetBool("data.usingtemplates", data_config.using_templates);
+    data_config.unit_database_cache = GetGameConfig().GetBool("data.unit_database_cache", data_config.unit_database_cache);
 
     ai.always_obedient                                  = GetGameConfig().GetBool("AI.always_obedient", ai.always_obedient);
     ai.assist_friend_in_need                            = GetGameConfig().GetBool("AI.assist_friend_in_need", ai.assist_friend_in_need);
@@ -300,6 +303,10 @@ void Configuration::OverrideDefaultsWithUserConfiguration() {
     // logging substruct
     logging.vsdebug = GetGameConfig().GetInt8("general.verbose_output", logging.vsdebug);
     logging.verbose_debug = GetGameConfig().GetBool("data.verbose_debug", logging.verbose_debug);
+    logging.async_logging = GetGameConfig().GetBool("general.async_logging", logging.async_logging);
+    logging.profiler = GetGameConfig().GetBool("general.profiler", logging.profiler);
+    logging.profiler_report_frames = GetGameConfig().GetUInt32("general.profiler_report_frames", logging.profiler_report_frames);
+    logging.profiler_trace_file = GetGameConfig().GetString("general.profiler_trace_file", logging.profiler_trace_file);
 
     // physics substruct
     physics_config.collision_scale_factor =
@@ -366,6 +373,10 @@ void Configuration::OverrideDefaultsWithUserConfiguration() {
     physics_config.speeding_discharge = GetGameConfig().GetFloat("physics.speeding_discharge", physics_config.speeding_discharge);
     physics_config.min_shield_speeding_discharge = GetGameConfig().GetFloat("physics.min_shield_speeding_discharge", physics_config.min_shield_speeding_discharge);
     physics_config.nebula_shield_recharge = GetGameConfig().GetFloat("physics.nebula_shield_recharge", physics_config.nebula_shield_recharge);
+    physics_config.parallel_star_systems = GetGameConfig().GetBool("physics.parallel_star_systems", physics_config.parallel_star_systems);
+    physics_config.simulation_worker_threads = GetGameConfig().GetUInt32("physics.simulation_worker_threads", physics_config.simulation_worker_threads);
+    physics_config.parallel_unit_physics = GetGameConfig().GetBool("physics.parallel_unit_physics", physics_config.parallel_unit_physics);
+    physics_config.collision_broadphase = GetGameConfig().GetString("physics.collision_broadphase", physics_config.collision_broadphase);
 
     // These calculations depend on the physics.game_speed and physics.game_accel values to be set already;
     // that's why they're down here instead of with the other graphics settings
@@ -59,6 +59,8 @@ struct GeneralConfig {
     uint32_t num_old_systems{6U};
     bool delete_old_systems{true};
     bool while_loading_star_system{false};
+    uint32_t prefetched_star_systems{8U};
+    uint32_t prefetched_image_megabytes{256U};
 };
 
 struct AIFiringConfig {
@@ -142,6 +144,8 @@ struct ComputerConfig {
 struct DataConfig {
     std::string master_part_list{"master_part_list"};
     bool using_templates{true};
+    // Keep a compiled copy of units.json/units.csv in the home directory
+    bool unit_database_cache{true};
 
     DataConfig() = default;
 };
@@ -358,6 +362,10 @@ struct Logging {
 
     int8_t vsdebug{0};
     bool verbose_debug{false};
+    bool async_logging{false};
+    bool profiler{false};
+    uint32_t profiler_report_frames{600};
+    std::string profiler_trace_file{};
 };
 
 struct PhysicsConfig {
@@ -421,6 +429,18 @@ struct PhysicsConfig {
     float min_shield_speeding_discharge{0.1F};
     float nebula_shield_recharge{0.5F};
 
+    // Simulate the sim atoms of every loaded star system as tasks on a worker pool.
+    // Experimental: cross-system work (director, jumps, cockpits) still runs serially.
+    bool parallel_star_systems{false};
+    // Size of the simulation worker pool, including the main thread. 0 means one per core.
+    uint32_t simulation_worker_threads{0U};
+    // Integrate the motion of the units in a physics batch on the worker pool
+    bool parallel_unit_physics{false};
+    // Spatial index behind collision checks and unit searches. "builtin" sweeps
+    // the X-sorted collide array; "sorted_axis" and "loose_octree" select a
+    // CollideBroadphase, see cmd/collide_broadphase.h
+    std::string collision_broadphase{"builtin"};
+
     PhysicsConfig();
 };
 
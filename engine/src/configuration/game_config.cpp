@@ -24,6 +24,7 @@
 
 
 #include "configuration/game_config.h"
+#include "configuration/config_handle.h"
 
 std::string vega_config::GameConfig::EscapedString(const std::string &input) {
     std::string rv;
@@ -117,6 +118,12 @@ void vega_config::GameConfig::LoadGameConfig(const std::string &filename) {
         }
     }
 //    pt::write_xml(filename + ".variables_.out.xml", variables_()->);
+    RefreshConfigHandles();
+}
+
+void vega_config::GameConfig::SetVariable(std::string const &path, std::string const &value) {
+    variables_()->put(path, value);
+    RefreshConfigHandles();
 }
 
 vega_config::GameConfig &vega_config::GetGameConfig() {
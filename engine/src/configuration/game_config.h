@@ -55,6 +55,9 @@ public:
 
     void LoadGameConfig(const std::string &filename);
 
+    // Changes one variable; ConfigHandles of it pick up the new value
+    void SetVariable(std::string const & path, std::string const & value);
+
     template<typename T>
     T GetVariable(std::string const & path, T default_value) {
         return variables_()->get(path, default_value);
@@ -25,6 +25,7 @@
 
 #include <gtest/gtest.h>
 #include "configuration/game_config.h"
+#include "configuration/config_handle.h"
 #include "vs_logging.h"
 
 #include <string>
@@ -90,3 +91,36 @@ TEST(LoadConfig, Sanity) {
 //    VS_LOG_AND_FLUSH(fatal, "Finished GetFloat performance test");
 
 }
+
+TEST(ConfigHandle, FollowsConfiguration) {
+    const vega_config::ConfigHandle<float> float_handle("test.subsection.subsection_float_variable", 8.9F);
+    const vega_config::ConfigHandle<int> int_handle("test2.int_variable2", 3);
+    const vega_config::ConfigHandle<bool> bool_handle("test.boolean_variable", false);
+    const vega_config::ConfigHandle<std::string> string_handle("test.string_variable", "World");
+    const vega_config::ConfigHandle<int> missing_handle("test.no_such_variable", 11);
+
+    vega_config::GetGameConfig().LoadGameConfig("test_assets/vegastrike.config");
+    EXPECT_FLOAT_EQ(float_handle.Get(), 4.2F);
+    EXPECT_EQ(int_handle.Get(), 15);
+    EXPECT_TRUE(bool_handle);
+    EXPECT_EQ(string_handle.Get(), "hello");
+    EXPECT_EQ(missing_handle.Get(), 11);
+
+    // Handles made after loading see the loaded value straight away
+    const vega_config::ConfigHandle<float> late_handle("test2.float_variable2", 10.0F);
+    EXPECT_FLOAT_EQ(late_handle.Get(), 4.2F);
+
+    // and every handle follows later changes
+    vega_config::GetGameConfig().SetVariable("test.subsection.subsection_float_variable", "0.5");
+    vega_config::GetGameConfig().SetVariable("test.boolean_variable", "no");
+    vega_config::GetGameConfig().SetVariable("test.string_variable", "changed");
+    vega_config::GetGameConfig().SetVariable("test.no_such_variable", "12");
+    EXPECT_FLOAT_EQ(float_handle.Get(), 0.5F);
+    EXPECT_FALSE(bool_handle);
+    EXPECT_EQ(string_handle.Get(), "changed");
+    EXPECT_EQ(missing_handle.Get(), 12);
+
+    // An empty value falls back to the default
+    vega_config::GetGameConfig().SetVariable("test.no_such_variable", "");
+    EXPECT_EQ(missing_handle.Get(), 11);
+}
@@ -32,6 +32,7 @@
 #include "easydom.h"
 #include "vs_logging.h"
 #include "vs_exit.h"
+#include "configuration/game_config.h"
 
 /* *********************************************************** */
 
@@ -362,6 +363,7 @@ bool VegaConfig::setVariable(string section, string name, string value) {
     }
     string hashname = section + "/" + name;
     map_variables[hashname] = value;
+    vega_config::GetGameConfig().SetVariable(section + "." + name, value);
     return true;
 }
 
@@ -379,6 +381,7 @@ bool VegaConfig::setVariable(string section, string subsection, string name, str
     }
     string hashname = section + "/" + subsection + "/" + name;
     map_variables[hashname] = value;
+    vega_config::GetGameConfig().SetVariable(section + "." + subsection + "." + name, value);
     return true;
 }
 
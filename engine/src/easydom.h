@@ -145,6 +145,14 @@ public:
         if (err > VSFileSystem::VSError::Ok) {
             return nullptr;
         }
+        const std::string contents = f.ReadFull();
+        f.Close();
+        return ParseXML(contents);
+    }
+
+    //parses a document already in memory, as LoadXML() does the file it reads
+    domNodeType *ParseXML(const std::string &contents) {
+        topnode = nullptr;
         xml = new easyDomFactoryXML;
 
         XML_Parser parser = XML_ParserCreate(nullptr);
@@ -152,7 +160,7 @@ public:
         XML_SetElementHandler(parser, &easyDomFactory::beginElement, &easyDomFactory::endElement);
         XML_SetCharacterDataHandler(parser, &easyDomFactory::charHandler);
 
-        XML_Parse(parser, (f.ReadFull()).c_str(), f.Size(), 1);
+        XML_Parse(parser, contents.c_str(), contents.size(), 1);
         /*
          *  do {
          * #ifdef BIDBG
@@ -171,7 +179,6 @@ public:
          * #endif
          *  } while(!feof(inFile));
          */
-        f.Close();
         XML_ParserFree(parser);
         delete xml;
         return (domNodeType *) topnode;
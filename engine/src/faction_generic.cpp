@@ -39,6 +39,7 @@ void Faction::ParseAllAllies() {
     for (i = 0; i < factions.size(); i++) {
         factions[i]->faction[i].relationship = 1;
     }
+    ++FactionUtil::relations_version;
 }
 
 void Faction::ParseAllies(unsigned int thisfaction) {
@@ -78,6 +78,9 @@ public:
     Texture *secondaryLogo;
 ///char * of the name
     char *factionname;
+///Kinds of faction, worked out from the name when it is loaded
+    enum TRAIT { TRAIT_PIRATE = 1 };
+    unsigned int traits;
     struct comm_face_t {
         std::vector<class Animation *> animations;
         enum CHOICE { CNO, CYES, CEITHER };
@@ -106,6 +109,7 @@ public:
         citizen = false;
         logo = secondaryLogo = NULL;
         factionname = NULL;
+        traits = 0;
         sparkcolor[0] = .5;
         sparkcolor[1] = .5;
         sparkcolor[2] = 1;
@@ -157,6 +161,13 @@ inline float GetIntRelation(const int myfaction, const int theirfaction) {
     return factions[myfaction]->faction[theirfaction].relationship;
 }
 
+///Incremented whenever relations between factions are changed or loaded, so copies of them know to refresh
+extern unsigned int relations_version;
+
+inline bool HasTrait(const int faction, const unsigned int trait) {
+    return (factions[faction]->traits & trait) != 0;
+}
+
 //float GetRelation (std::string myfaction, std::string theirfaction);
 std::string GetFactionName(int index);
 bool isCitizenInt(int index);
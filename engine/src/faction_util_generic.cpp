@@ -34,6 +34,7 @@
 
 using namespace FactionUtil;
 int FactionUtil::upgradefac = 0;
+unsigned int FactionUtil::relations_version = 0;
 int FactionUtil::planetfac = 0;
 int FactionUtil::neutralfac = 0;
 
@@ -121,6 +122,7 @@ void FactionUtil::AdjustIntRelation(const int Myfaction, const int TheirFaction,
                 if (strcmp(factions[TheirFaction]->factionname, "upgrades") != 0) {
                     if (isPlayerFaction(TheirFaction) || game_options()->AllowNonplayerFactionChange) {
                         if (game_options()->AllowCivilWar || Myfaction != TheirFaction) {
+                            ++relations_version;
                             factions[Myfaction]->faction[TheirFaction].relationship += factor * rank;
                             if (factions[Myfaction]->faction[TheirFaction].relationship > 1
                                     && game_options()->CappedFactionRating) {
@@ -186,6 +188,7 @@ int FactionUtil::numnums(const char *str) {
 }
 
 void FactionUtil::LoadSerializedFaction(FILE *fp) {
+    ++relations_version;
     for (unsigned int i = 0; i < factions.size(); i++) {
         char *tmp = new char[24 * factions[i]->faction.size()];
         fgets(tmp, 24 * factions[i]->faction.size() - 1, fp);
@@ -244,6 +247,7 @@ void FactionUtil::LoadSerializedFaction(char *&buf) {
         savedFactions = buf;
         return;
     }
+    ++relations_version;
     for (unsigned int i = 0; i < factions.size(); i++) {
         if (numnums(buf) == 0) {
             return;
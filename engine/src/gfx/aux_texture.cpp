@@ -38,6 +38,7 @@
 #include "main_loop.h"
 #include "aux_texture.h"
 #include "configxml.h"
+#include "star_system_loader.h"
 
 using std::string;
 using namespace VSFileSystem;
@@ -372,10 +373,14 @@ void Texture::Load(const char *FileName,
         bootstrap_draw("Loading " + string(FileName));
     }
     //strcpy(filename, FileName);
-    if (err2 > Ok) {
-        data = this->ReadImage(&f, NULL, true, NULL);
-    } else {
-        data = this->ReadImage(&f, NULL, true, &f2);
+    //Decoded in the background if the star system being built was prefetched
+    data = StarSystemLoader::TakeImage(f.GetFullPath(), err2 > Ok ? string() : f2.GetFullPath(), *this);
+    if (data == NULL) {
+        if (err2 > Ok) {
+            data = this->ReadImage(&f, NULL, true, NULL);
+        } else {
+            data = this->ReadImage(&f, NULL, true, &f2);
+        }
     }
     if (data) {
         if (mode >= _DXT1 && mode <= _DXT5) {
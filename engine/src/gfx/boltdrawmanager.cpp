@@ -80,7 +80,13 @@ BoltDrawManager::~BoltDrawManager() {
     }
 }
 
+// Each star system keeps its own bolts, so that systems simulated on
+// different threads never share them
 BoltDrawManager &BoltDrawManager::GetInstance() {
+    StarSystem *star_system = _Universe ? _Universe->activeStarSystem() : nullptr;
+    if (star_system) {
+        return star_system->GetBoltDrawManager();
+    }
     static BoltDrawManager instance;    // Guaranteed to be destroyed.
     return instance;                    // Instantiated on first use.
 }
@@ -123,7 +129,6 @@ CollideMap::iterator BoltDrawManager::AddBall(const WeaponInfo *typ,
         const Vector &shipspeed,
         void *owner,
         CollideMap::iterator hint) {
-    Bolt ball = Bolt(typ, orientationpos, shipspeed, owner, hint);             //FIXME turrets won't work! Velocity
-    _balls.push_back(ball);
-    return _balls[_balls.size() - 1].location;
+    //The constructor files the ball with the others of its animation
+    return Bolt(typ, orientationpos, shipspeed, owner, hint).location;             //FIXME turrets won't work! Velocity
 }
@@ -46,8 +46,9 @@ public:
     vector<Animation *> animations; // Balls are animated
     vector<vector<Bolt> > bolts; // The inner vector is all of the same type.
     vector<vector<Bolt> > balls;
-
-    vector<Bolt> _balls;
+    // Motion of the bolts and balls above, group for group and bolt for bolt
+    vector<BoltMotion> bolt_motion;
+    vector<BoltMotion> ball_motion;
 
     BoltDrawManager();
     ~BoltDrawManager();
@@ -34,6 +34,8 @@
 #include "faction_generic.h"
 #endif
 #include <assert.h>
+#include <algorithm>
+#include <cstdint>
 
 #include "vegastrike.h"
 #include "vs_logging.h"
@@ -211,10 +213,9 @@ struct OrigMeshLoader {
 
 #define READSTRING(inmemfile, word32index, stringlen, stringvar)                                 \
     do {     /* By Klauss - Much more efficient than the preceding code, and yet still portable */ \
-        uchar8bit *inmemstring = (uchar8bit*) (inmemfile+word32index);                               \
-        uchar8bit  oc = inmemstring[stringlen]; inmemstring[stringlen] = 0;                         \
-        stringvar    = (const char*) inmemstring;                                                  \
-        inmemstring[stringlen] = oc;                                                               \
+        /* inmemfile may be a read only mapping, so the string can't be terminated in place */      \
+        const char *inmemstring = (const char*) (inmemfile+word32index);                          \
+        stringvar.assign( inmemstring, std::find( inmemstring, inmemstring+stringlen, '\0' ) );      \
         word32index += (stringlen+3)/4;                                                            \
     }                                                                                              \
     while (0)
@@ -317,18 +318,27 @@ vector<Mesh *> Mesh::LoadMeshes(VSFileSystem::VSFile &Inputfile,
     fread( inmemfile, 1, Inputlength, Inputfile );
     fcloseInput( Inputfile );
 #else
-    uint32bit Inputlength = Inputfile.Size();
-    if (Inputlength < sizeof(uint32bit) * 13 || Inputlength > (1 << 30)) {
+    //Parse the file in place (mapped, or in the volume's mapping) rather than reading a copy of it
+    size_t mappedlength = 0;
+    const char *mappedfile = Inputfile.MapFull(mappedlength);
+    uint32bit Inputlength = mappedlength;
+    if (!mappedfile || Inputlength < sizeof(uint32bit) * 13 || mappedlength > (1 << 30)) {
         VS_LOG_AND_FLUSH(fatal, (boost::format("Corrupt file %1%, aborting") % Inputfile.GetFilename()));
         abort();
     }
-    inmemfile = (chunk32 *) malloc(Inputlength);
-    if (!inmemfile) {
-        VS_LOG_AND_FLUSH(fatal, "Buffer allocation failed, Aborting");
-        exit(-2);
+    //Files stored in a volume needn't be aligned
+    chunk32 *alignedcopy = NULL;
+    if (reinterpret_cast<uintptr_t>(mappedfile) % alignof(chunk32) == 0) {
+        inmemfile = (chunk32 *) mappedfile;
+    } else {
+        alignedcopy = (chunk32 *) malloc(Inputlength);
+        if (!alignedcopy) {
+            VS_LOG_AND_FLUSH(fatal, "Buffer allocation failed, Aborting");
+            exit(-2);
+        }
+        memcpy(alignedcopy, mappedfile, Inputlength);
+        inmemfile = alignedcopy;
     }
-    Inputfile.Read(inmemfile, Inputlength);
-    Inputfile.Close();
 #endif
     //Extract superheader fields
     word32index += 3;
@@ -1073,7 +1083,12 @@ vector<Mesh *> Mesh::LoadMeshes(VSFileSystem::VSFile &Inputfile,
         }
         output.back()->numlods = output.back()->orig->numlods = meshes.back().num;
     }
+#ifdef STANDALONE
     free(inmemfile);
+#else
+    free(alignedcopy);
+    Inputfile.Close();
+#endif
     inmemfile = NULL;
 #ifndef STANDALONE
     return output;
@@ -66,6 +66,7 @@ extern vector<Logo *> undrawn_logos;
 #endif
 
 #include "vs_logging.h"
+#include "vs_profiler.h"
 
 class Exception : public std::exception {
 private:
@@ -624,6 +625,7 @@ void Mesh::DrawNow(float lod, bool centered, const Matrix &m, int cloak, float n
 }
 
 void Mesh::ProcessZFarMeshes(bool nocamerasetup) {
+    VS_PROFILE_ZONE("Mesh::ProcessZFarMeshes");
     int a = NUM_ZBUF_SEQ;
 
     if (!undrawn_meshes[a].empty()) {
@@ -667,6 +669,7 @@ inline bool rangesOverlap(T min1, T max1, T min2, T max2) {
 }
 
 void Mesh::ProcessUndrawnMeshes(bool pushSpecialEffects, bool nocamerasetup) {
+    VS_PROFILE_ZONE("Mesh::ProcessUndrawnMeshes");
     bool zcleared = false;
 
     for (int a = 0; a < NUM_ZBUF_SEQ; a++) {
@@ -1093,6 +1096,7 @@ void RestoreSpecMapState(bool envMap, bool detailMap, bool write_to_depthmap, fl
 }
 
 void Mesh::ProcessDrawQueue(size_t whichpass, int whichdrawqueue, bool zsort, const QVector &sortctr) {
+    VS_PROFILE_ZONE("Mesh::ProcessDrawQueue");
     //Process the pass for all queued instances
     const Pass &pass = technique->getPass(whichpass);
     if (pass.type == Pass::ShaderPass) {
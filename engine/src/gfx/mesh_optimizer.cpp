@@ -0,0 +1,415 @@
+/*
+ * mesh_optimizer.cpp
+ *
+ * Copyright (C) 2023 Vega Strike contributors.
+ *
+ * https://github.com/vegastrike/Vega-Strike-Engine-Source
+ *
+ * This file is part of Vega Strike.
+ *
+ * Vega Strike is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Vega Strike is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Vega Strike. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "gfx/mesh_optimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+const unsigned int kUnset = ~0u;
+
+//Welding
+
+//The value a float is compared by: its multiple of epsilon, or its bits
+//when there is no epsilon or the multiple would not fit. The low bit
+//tells the two apart.
+inline uint64_t WeldKey(float value, float epsilon) {
+    if (epsilon > 0.0F && std::isfinite(value)) {
+        const double multiple = std::floor(static_cast<double>(value) / epsilon + 0.5);
+        if (std::fabs(multiple) < 1.0e18) {
+            return static_cast<uint64_t>(static_cast<int64_t>(multiple)) << 1;
+        }
+    }
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return (static_cast<uint64_t>(bits) << 1) | 1;
+}
+
+uint64_t WeldHash(const float *vertex, size_t stride, float epsilon) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t k = 0; k < stride; ++k) {
+        hash ^= WeldKey(vertex[k], epsilon);
+        hash *= 1099511628211ULL;
+        hash ^= hash >> 29;
+    }
+    return hash;
+}
+
+bool WeldEqual(const float *a, const float *b, size_t stride, float epsilon) {
+    if (epsilon <= 0.0F) {
+        return memcmp(a, b, stride * sizeof(float)) == 0;
+    }
+    for (size_t k = 0; k < stride; ++k) {
+        if (WeldKey(a[k], epsilon) != WeldKey(b[k], epsilon)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+//Forsyth's scoring, with the constants of his paper
+
+const float kCacheDecayPower = 1.5F;
+const float kLastTriangleScore = 0.75F;
+const float kValenceBoostScale = 2.0F;
+const float kValenceBoostPower = 0.5F;
+const size_t kMaxScoredValence = 32;
+
+struct VertexScores {
+    float cache[kMeshOptimizerCacheSize];
+    float valence[kMaxScoredValence];
+
+    VertexScores() {
+        for (size_t position = 0; position < kMeshOptimizerCacheSize; ++position) {
+            if (position < 3) {
+                //The last triangle's vertices get a fixed score, so that
+                //the same triangle is not favoured whichever way round
+                cache[position] = kLastTriangleScore;
+            } else {
+                const float scaler = 1.0F / (kMeshOptimizerCacheSize - 3);
+                cache[position] = std::pow(1.0F - (position - 3) * scaler, kCacheDecayPower);
+            }
+        }
+        valence[0] = 0.0F;
+        for (size_t count = 1; count < kMaxScoredValence; ++count) {
+            valence[count] = kValenceBoostScale * std::pow(static_cast<float>(count), -kValenceBoostPower);
+        }
+    }
+
+    float Score(int cache_position, unsigned int remaining) const {
+        if (remaining == 0) {
+            //Nothing left to draw with it
+            return -1.0F;
+        }
+        float score = 0.0F;
+        if (cache_position >= 0) {
+            score = cache[cache_position];
+        }
+        //Vertices with few triangles left are worth finishing off
+        if (remaining < kMaxScoredValence) {
+            score += valence[remaining];
+        } else {
+            score += kValenceBoostScale * std::pow(static_cast<float>(remaining), -kValenceBoostPower);
+        }
+        return score;
+    }
+};
+
+void CacheOrder(const unsigned int *indices, size_t triangle_count, size_t vertex_count, unsigned int *order) {
+    static const VertexScores scores;
+
+    //Triangles of each vertex, those still to draw at the front of its range
+    std::vector<unsigned int> remaining(vertex_count, 0);
+    for (size_t corner = 0; corner < triangle_count * 3; ++corner) {
+        ++remaining[indices[corner]];
+    }
+    std::vector<unsigned int> first_triangle(vertex_count + 1, 0);
+    for (size_t vertex = 0; vertex < vertex_count; ++vertex) {
+        first_triangle[vertex + 1] = first_triangle[vertex] + remaining[vertex];
+    }
+    std::vector<unsigned int> triangles(triangle_count * 3);
+    {
+        std::vector<unsigned int> filled(first_triangle.begin(), first_triangle.end() - 1);
+        for (size_t corner = 0; corner < triangle_count * 3; ++corner) {
+            triangles[filled[indices[corner]]++] = static_cast<unsigned int>(corner / 3);
+        }
+    }
+
+    std::vector<int> cache_position(vertex_count, -1);
+    std::vector<float> vertex_score(vertex_count);
+    for (size_t vertex = 0; vertex < vertex_count; ++vertex) {
+        vertex_score[vertex] = scores.Score(-1, remaining[vertex]);
+    }
+    std::vector<float> triangle_score(triangle_count);
+    std::vector<bool> drawn(triangle_count, false);
+    size_t best = 0;
+    for (size_t triangle = 0; triangle < triangle_count; ++triangle) {
+        const unsigned int *corners = indices + triangle * 3;
+        triangle_score[triangle] =
+                vertex_score[corners[0]] + vertex_score[corners[1]] + vertex_score[corners[2]];
+        if (triangle_score[triangle] > triangle_score[best]) {
+            best = triangle;
+        }
+    }
+
+    //Room for the cache plus the three vertices pushed in front of it
+    std::vector<unsigned int> cache;
+    std::vector<unsigned int> next_cache;
+    cache.reserve(kMeshOptimizerCacheSize + 3);
+    next_cache.reserve(kMeshOptimizerCacheSize + 3);
+    size_t first_undrawn = 0;
+    for (size_t drawn_count = 0; drawn_count < triangle_count; ++drawn_count) {
+        if (best == kUnset) {
+            //Nothing in the cache leads anywhere: start afresh
+            while (drawn[first_undrawn]) {
+                ++first_undrawn;
+            }
+            best = first_undrawn;
+        }
+        order[drawn_count] = static_cast<unsigned int>(best);
+        drawn[best] = true;
+
+        const unsigned int *corners = indices + best * 3;
+        next_cache.clear();
+        for (int corner = 0; corner < 3; ++corner) {
+            const unsigned int vertex = corners[corner];
+            unsigned int *begin = &triangles[first_triangle[vertex]];
+            unsigned int *end = begin + remaining[vertex];
+            unsigned int *found = std::find(begin, end, static_cast<unsigned int>(best));
+            std::swap(*found, *(end - 1));
+            --remaining[vertex];
+            if (std::find(next_cache.begin(), next_cache.end(), vertex) == next_cache.end()) {
+                next_cache.push_back(vertex);
+            }
+        }
+        const size_t pushed = next_cache.size();
+        for (unsigned int vertex : cache) {
+            if (std::find(next_cache.begin(), next_cache.begin() + pushed, vertex) == next_cache.begin() + pushed) {
+                next_cache.push_back(vertex);
+            }
+        }
+
+        for (size_t position = 0; position < next_cache.size(); ++position) {
+            const unsigned int vertex = next_cache[position];
+            cache_position[vertex] = position < kMeshOptimizerCacheSize ? static_cast<int>(position) : -1;
+            vertex_score[vertex] = scores.Score(cache_position[vertex], remaining[vertex]);
+        }
+        best = kUnset;
+        float best_score = -1.0F;
+        for (unsigned int vertex : next_cache) {
+            const unsigned int *begin = &triangles[first_triangle[vertex]];
+            for (const unsigned int *triangle = begin; triangle != begin + remaining[vertex]; ++triangle) {
+                const unsigned int *others = indices + *triangle * 3;
+                const float score = vertex_score[others[0]] + vertex_score[others[1]] + vertex_score[others[2]];
+                triangle_score[*triangle] = score;
+                if (score > best_score) {
+                    best_score = score;
+                    best = *triangle;
+                }
+            }
+        }
+        if (next_cache.size() > kMeshOptimizerCacheSize) {
+            next_cache.resize(kMeshOptimizerCacheSize);
+        }
+        cache.swap(next_cache);
+    }
+}
+
+//Overdraw
+
+struct Cluster {
+    size_t begin;
+    size_t end;
+    float sort_key;
+};
+
+void Cross(const float *a, const float *b, const float *c, double *normal) {
+    const double u[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+    const double v[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+    normal[0] = u[1] * v[2] - u[2] * v[1];
+    normal[1] = u[2] * v[0] - u[0] * v[2];
+    normal[2] = u[0] * v[1] - u[1] * v[0];
+}
+
+void OverdrawOrder(const unsigned int *indices,
+        size_t triangle_count,
+        size_t vertex_count,
+        const float *positions,
+        size_t stride,
+        unsigned int *order) {
+    //Cut the cache order where it jumps, i.e. at triangles whose vertices
+    //have all left the cache; moving whole runs keeps the cache order
+    //within them
+    std::vector<Cluster> clusters;
+    std::vector<unsigned int> inserted(vertex_count, kUnset);
+    unsigned int insertions = 0;
+    for (size_t k = 0; k < triangle_count; ++k) {
+        int misses = 0;
+        const unsigned int *corners = indices + order[k] * 3;
+        for (int corner = 0; corner < 3; ++corner) {
+            const unsigned int vertex = corners[corner];
+            if (inserted[vertex] == kUnset || insertions - inserted[vertex] >= kMeshOptimizerCacheSize) {
+                inserted[vertex] = insertions++;
+                ++misses;
+            }
+        }
+        if (k == 0 || misses == 3) {
+            if (!clusters.empty()) {
+                clusters.back().end = k;
+            }
+            clusters.push_back(Cluster{k, triangle_count, 0.0F});
+        }
+    }
+    if (clusters.size() < 2) {
+        return;
+    }
+
+    //Area weighted centres and normals
+    std::vector<double> centres(clusters.size() * 3, 0.0);
+    std::vector<double> normals(clusters.size() * 3, 0.0);
+    double mesh_centre[3] = {0.0, 0.0, 0.0};
+    double mesh_area = 0.0;
+    for (size_t c = 0; c < clusters.size(); ++c) {
+        double area = 0.0;
+        for (size_t k = clusters[c].begin; k < clusters[c].end; ++k) {
+            const unsigned int *corners = indices + order[k] * 3;
+            const float *a = positions + corners[0] * stride;
+            const float *b = positions + corners[1] * stride;
+            const float *p = positions + corners[2] * stride;
+            double normal[3];
+            Cross(a, b, p, normal);
+            const double weight = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+            for (int axis = 0; axis < 3; ++axis) {
+                normals[c * 3 + axis] += normal[axis];
+                centres[c * 3 + axis] += weight * (a[axis] + b[axis] + p[axis]) / 3.0;
+            }
+            area += weight;
+        }
+        for (int axis = 0; axis < 3; ++axis) {
+            mesh_centre[axis] += centres[c * 3 + axis];
+            if (area > 0.0) {
+                centres[c * 3 + axis] /= area;
+            }
+        }
+        mesh_area += area;
+    }
+    if (mesh_area <= 0.0) {
+        return;
+    }
+    for (int axis = 0; axis < 3; ++axis) {
+        mesh_centre[axis] /= mesh_area;
+    }
+    for (size_t c = 0; c < clusters.size(); ++c) {
+        const double *normal = &normals[c * 3];
+        const double length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        if (length <= 0.0) {
+            continue;
+        }
+        double key = 0.0;
+        for (int axis = 0; axis < 3; ++axis) {
+            key += (centres[c * 3 + axis] - mesh_centre[axis]) * normal[axis];
+        }
+        clusters[c].sort_key = static_cast<float>(key / length);
+    }
+
+    //Those facing furthest outward are the likeliest to hide others
+    std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster &a, const Cluster &b) {
+        return a.sort_key > b.sort_key;
+    });
+    std::vector<unsigned int> sorted;
+    sorted.reserve(triangle_count);
+    for (const Cluster &cluster : clusters) {
+        sorted.insert(sorted.end(), order + cluster.begin, order + cluster.end);
+    }
+    std::copy(sorted.begin(), sorted.end(), order);
+}
+
+} // namespace
+
+size_t WeldVertices(const float *vertices, size_t vertex_count, size_t stride, float epsilon, unsigned int *remap) {
+    //Open addressing, at most half full
+    size_t capacity = 16;
+    while (capacity < vertex_count * 2) {
+        capacity *= 2;
+    }
+    std::vector<unsigned int> slots(capacity, kUnset);
+    std::vector<uint64_t> hashes(capacity);
+    unsigned int welded = 0;
+    for (size_t vertex = 0; vertex < vertex_count; ++vertex) {
+        const float *values = vertices + vertex * stride;
+        const uint64_t hash = WeldHash(values, stride, epsilon);
+        size_t slot = static_cast<size_t>(hash) & (capacity - 1);
+        while (true) {
+            const unsigned int first = slots[slot];
+            if (first == kUnset) {
+                slots[slot] = static_cast<unsigned int>(vertex);
+                hashes[slot] = hash;
+                remap[vertex] = welded++;
+                break;
+            }
+            if (hashes[slot] == hash && WeldEqual(values, vertices + first * stride, stride, epsilon)) {
+                remap[vertex] = remap[first];
+                break;
+            }
+            slot = (slot + 1) & (capacity - 1);
+        }
+    }
+    return welded;
+}
+
+void OptimizeTriangleOrder(const unsigned int *indices,
+        size_t triangle_count,
+        size_t vertex_count,
+        const float *positions,
+        size_t position_stride,
+        unsigned int *order) {
+    for (size_t triangle = 0; triangle < triangle_count; ++triangle) {
+        order[triangle] = static_cast<unsigned int>(triangle);
+    }
+    for (size_t corner = 0; corner < triangle_count * 3; ++corner) {
+        if (indices[corner] >= vertex_count) {
+            return;
+        }
+    }
+    if (triangle_count < 2) {
+        return;
+    }
+    CacheOrder(indices, triangle_count, vertex_count, order);
+    if (positions) {
+        OverdrawOrder(indices, triangle_count, vertex_count, positions, position_stride, order);
+    }
+}
+
+size_t OptimizeVertexFetch(unsigned int *indices, size_t index_count, size_t vertex_count, unsigned int *remap) {
+    std::fill(remap, remap + vertex_count, kUnset);
+    unsigned int used = 0;
+    for (size_t index = 0; index < index_count; ++index) {
+        unsigned int &vertex = remap[indices[index]];
+        if (vertex == kUnset) {
+            vertex = used++;
+        }
+        indices[index] = vertex;
+    }
+    return used;
+}
+
+float AverageCacheMissRatio(const unsigned int *indices, size_t index_count, size_t vertex_count, size_t cache_size) {
+    if (index_count < 3) {
+        return 0.0F;
+    }
+    std::vector<size_t> inserted(vertex_count, static_cast<size_t>(-1));
+    size_t insertions = 0;
+    for (size_t index = 0; index < index_count; ++index) {
+        const unsigned int vertex = indices[index];
+        if (inserted[vertex] == static_cast<size_t>(-1) || insertions - inserted[vertex] >= cache_size) {
+            inserted[vertex] = insertions++;
+        }
+    }
+    return static_cast<float>(insertions) / static_cast<float>(index_count / 3);
+}
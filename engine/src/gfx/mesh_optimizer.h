@@ -0,0 +1,83 @@
+/*
+ * mesh_optimizer.h
+ *
+ * Copyright (C) 2023 Vega Strike contributors.
+ *
+ * https://github.com/vegastrike/Vega-Strike-Engine-Source
+ *
+ * This file is part of Vega Strike.
+ *
+ * Vega Strike is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Vega Strike is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Vega Strike. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef VEGA_STRIKE_ENGINE_GFX_MESH_OPTIMIZER_H
+#define VEGA_STRIKE_ENGINE_GFX_MESH_OPTIMIZER_H
+
+#include <cstddef>
+
+/*
+ * Vertex welding and triangle ordering for indexed meshes.
+ *
+ * These work on plain arrays of floats, so that both the engine (through
+ * GFXOptimizeList) and the mesher tool, which have different vertex
+ * structures, can use them. Strides are counted in floats.
+ */
+
+// Number of entries of the post-transform vertex cache the orders are made for
+const size_t kMeshOptimizerCacheSize = 32;
+
+// Gives equal vertices the same index. Vertices are equal when all their
+// stride floats are, bit for bit if epsilon is 0, or once rounded to a
+// multiple of epsilon otherwise. remap[i] receives the new index of vertex
+// i; new indices are handed out in order of first appearance, so the
+// first vertex of every group can be copied to its new place as the
+// remap is walked. Returns the number of distinct vertices.
+size_t WeldVertices(const float *vertices,
+        size_t vertex_count,
+        size_t stride,
+        float epsilon,
+        unsigned int *remap);
+
+// Orders the triangles of an indexed triangle list so that vertices are
+// used again while they are still in the vertex cache (after Forsyth,
+// "Linear-Speed Vertex Cache Optimisation"). When positions are given, the
+// runs of triangles the cache order breaks into are then sorted to draw
+// those that face outward from the middle of the mesh first, which cuts
+// overdraw (after Sander, Nehab and Barczak, "Fast Triangle Reordering for
+// Vertex Locality and Reduced Overdraw").
+// order[k] receives the triangle to draw k-th. Indices out of range leave
+// the triangles in their original order.
+void OptimizeTriangleOrder(const unsigned int *indices,
+        size_t triangle_count,
+        size_t vertex_count,
+        const float *positions,
+        size_t position_stride,
+        unsigned int *order);
+
+// Renumbers vertices in the order indices first use them, so that they
+// are fetched from memory in sequence. indices are rewritten; remap[v]
+// receives the new index of vertex v, or ~0u if no index uses it.
+// Returns the number of vertices used.
+size_t OptimizeVertexFetch(unsigned int *indices,
+        size_t index_count,
+        size_t vertex_count,
+        unsigned int *remap);
+
+// Post-transform cache misses per triangle of an indexed triangle list,
+// for a FIFO cache of cache_size entries
+float AverageCacheMissRatio(const unsigned int *indices,
+        size_t index_count,
+        size_t vertex_count,
+        size_t cache_size = kMeshOptimizerCacheSize);
+
+#endif //VEGA_STRIKE_ENGINE_GFX_MESH_OPTIMIZER_H
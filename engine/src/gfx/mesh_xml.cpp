@@ -31,6 +31,7 @@
 #include <expat.h>
 #include <cfloat>
 #include <cassert>
+#include <memory>
 //#include "ani_texture.h"
 #ifndef _WIN32
 #include <unistd.h>
@@ -52,6 +53,7 @@
 #include "hashtable.h"
 #include "vs_logging.h"
 #include "vs_exit.h"
+#include "star_system_loader.h"
 
 #ifdef max
 #undef max
@@ -1332,12 +1334,15 @@ vector<Mesh *> Mesh::LoadMeshes(const char *filename,
         }
         return ret;
     }
-    VSFile f;
-    VSError err = f.OpenReadOnly(filename, MeshFile);
+    VSFile opened;
+    VSError err = opened.OpenReadOnly(filename, MeshFile);
     if (err > Ok) {
         VS_LOG(error, (boost::format("Cannot Open Mesh File %1%") % filename));
         return vector<Mesh *>();
     }
+    //Read in the background if the star system being built was prefetched
+    std::unique_ptr<VSFile> prefetched = StarSystemLoader::TakeMesh(opened.GetFullPath());
+    VSFile &f = prefetched ? *prefetched : opened;
     char bfxm[4];
     f.Read(&bfxm[0], sizeof(bfxm[0]) * 4);
     bool isbfxm = (bfxm[0] == 'B' && bfxm[1] == 'F' && bfxm[2] == 'X' && bfxm[3] == 'M');
@@ -2064,12 +2069,16 @@ void Mesh::PostProcessLoading(MeshXML *xml, const vector<string> &textureOverrid
                 (XMLSupport::parse_bool(vs_config->getVariable("graphics", "OptimizeVertexArrays", "false")));
         static float optvertexlimit =
                 (XMLSupport::parse_float(vs_config->getVariable("graphics", "OptimizeVertexCondition", "1.0")));
+        static float optvertexepsilon =
+                (XMLSupport::parse_float(vs_config->getVariable("graphics", "OptimizeVertexEpsilon", "0")));
         bool cachunk = false;
         if (usopttmp && (vertexlist.size() > 0)) {
             int numopt = totalvertexsize;
             GFXVertex *newv;
             unsigned int *ind;
-            GFXOptimizeList(&vertexlist[0], totalvertexsize, &newv, &numopt, &ind);
+            GFXOptimizeList(&vertexlist[0], totalvertexsize, &newv, &numopt, &ind, optvertexepsilon,
+                    (polytypes.size() ? &polytypes[0] : 0),
+                    (poly_offsets.size() ? &poly_offsets[0] : 0), o_index);
             if (numopt < totalvertexsize * optvertexlimit) {
                 vlist = new GFXVertexList(
                         (polytypes.size() ? &polytypes[0] : 0),
@@ -0,0 +1,148 @@
+/*
+ * mesh_optimizer_tests.cpp
+ *
+ * Copyright (C) 2023 Vega Strike contributors.
+ *
+ * https://github.com/vegastrike/Vega-Strike-Engine-Source
+ *
+ * This file is part of Vega Strike.
+ *
+ * Vega Strike is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Vega Strike is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Vega Strike. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "gfx/mesh_optimizer.h"
+
+namespace {
+
+// A grid of size x size quads on the z = 0 plane, two triangles each,
+// with positions only
+void MakeGrid(int size, std::vector<float> &positions, std::vector<unsigned int> &indices) {
+    for (int y = 0; y <= size; ++y) {
+        for (int x = 0; x <= size; ++x) {
+            positions.push_back(static_cast<float>(x));
+            positions.push_back(static_cast<float>(y));
+            positions.push_back(0.0F);
+        }
+    }
+    for (int y = 0; y < size; ++y) {
+        for (int x = 0; x < size; ++x) {
+            const unsigned int corner = y * (size + 1) + x;
+            const unsigned int quad[6] = {corner, corner + 1, corner + size + 2,
+                    corner, corner + size + 2, corner + size + 1};
+            indices.insert(indices.end(), quad, quad + 6);
+        }
+    }
+}
+
+std::vector<unsigned int> Reorder(const std::vector<unsigned int> &indices, const std::vector<unsigned int> &order) {
+    std::vector<unsigned int> reordered;
+    for (unsigned int triangle : order) {
+        reordered.insert(reordered.end(), indices.begin() + triangle * 3, indices.begin() + triangle * 3 + 3);
+    }
+    return reordered;
+}
+
+} // namespace
+
+TEST(MeshOptimizer, WeldsIdenticalVertices) {
+    const float vertices[] = {
+            0.0F, 0.0F, 0.0F,
+            1.0F, 0.0F, 0.0F,
+            0.0F, 0.0F, 0.0F,
+            1.0F, 0.0F, 0.0F,
+            2.0F, 0.0F, 0.0F,
+    };
+    unsigned int remap[5];
+    EXPECT_EQ(3, WeldVertices(vertices, 5, 3, 0.0F, remap));
+    const unsigned int expected[5] = {0, 1, 0, 1, 2};
+    for (int i = 0; i < 5; ++i) {
+        EXPECT_EQ(expected[i], remap[i]);
+    }
+}
+
+TEST(MeshOptimizer, WeldsWithinEpsilon) {
+    const float vertices[] = {
+            0.0F, 0.0F,
+            0.00001F, 0.0F,
+            0.5F, 0.0F,
+    };
+    unsigned int remap[3];
+    EXPECT_EQ(3, WeldVertices(vertices, 3, 2, 0.0F, remap));
+    EXPECT_EQ(2, WeldVertices(vertices, 3, 2, 0.001F, remap));
+    EXPECT_EQ(remap[0], remap[1]);
+    EXPECT_NE(remap[0], remap[2]);
+}
+
+TEST(MeshOptimizer, TriangleOrderIsAPermutation) {
+    std::vector<float> positions;
+    std::vector<unsigned int> indices;
+    MakeGrid(20, positions, indices);
+    const size_t triangles = indices.size() / 3;
+    std::vector<unsigned int> order(triangles);
+    OptimizeTriangleOrder(&indices[0], triangles, positions.size() / 3, &positions[0], 3, &order[0]);
+    std::sort(order.begin(), order.end());
+    for (size_t triangle = 0; triangle < triangles; ++triangle) {
+        EXPECT_EQ(triangle, order[triangle]);
+    }
+}
+
+TEST(MeshOptimizer, TriangleOrderReducesCacheMisses) {
+    std::vector<float> positions;
+    std::vector<unsigned int> indices;
+    MakeGrid(40, positions, indices);
+    const size_t triangles = indices.size() / 3;
+    const size_t vertices = positions.size() / 3;
+
+    std::vector<unsigned int> shuffle(triangles);
+    for (size_t triangle = 0; triangle < triangles; ++triangle) {
+        shuffle[triangle] = static_cast<unsigned int>(triangle);
+    }
+    std::shuffle(shuffle.begin(), shuffle.end(), std::mt19937(5));
+    const std::vector<unsigned int> shuffled = Reorder(indices, shuffle);
+    const float before = AverageCacheMissRatio(&shuffled[0], shuffled.size(), vertices);
+
+    std::vector<unsigned int> order(triangles);
+    OptimizeTriangleOrder(&shuffled[0], triangles, vertices, nullptr, 3, &order[0]);
+    const std::vector<unsigned int> optimized = Reorder(shuffled, order);
+    const float after = AverageCacheMissRatio(&optimized[0], optimized.size(), vertices);
+
+    // A regular grid can get close to 0.5 misses per triangle
+    EXPECT_GT(before, 2.0F);
+    EXPECT_LT(after, 0.8F);
+}
+
+TEST(MeshOptimizer, OutOfRangeIndicesKeepTheOrder) {
+    const unsigned int indices[] = {0, 1, 2, 2, 1, 7};
+    unsigned int order[2];
+    OptimizeTriangleOrder(indices, 2, 3, nullptr, 3, order);
+    EXPECT_EQ(0, order[0]);
+    EXPECT_EQ(1, order[1]);
+}
+
+TEST(MeshOptimizer, VertexFetchFollowsFirstUse) {
+    unsigned int indices[] = {4, 2, 0, 2, 4, 1};
+    unsigned int remap[5];
+    EXPECT_EQ(4, OptimizeVertexFetch(indices, 6, 5, remap));
+    const unsigned int expected[6] = {0, 1, 2, 1, 0, 3};
+    for (int i = 0; i < 6; ++i) {
+        EXPECT_EQ(expected[i], indices[i]);
+    }
+    EXPECT_EQ(~0u, remap[3]);
+}
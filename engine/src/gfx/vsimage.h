@@ -297,6 +297,12 @@ public:
     bool isCube() const {
         return this->img_sides != SIDE_SINGLE;
     }
+
+//Forgets the files the image was read from, for when they are closed before the image goes
+    void ForgetFiles() {
+        this->img_file = NULL;
+        this->img_file2 = NULL;
+    }
 };
 
 #endif //VEGA_STRIKE_ENGINE_GFX_VSIMAGE_H
@@ -467,7 +467,10 @@ void GFXDrawElements(POLYTYPE type,
 void GFXBindBuffer(unsigned int vbo_data);
 void GFXBindElementBuffer(unsigned int element_data);
 ///Optimizes a list to reuse repeated vertices!
-void GFXOptimizeList(GFXVertex *old, int numV, GFXVertex **newlist, int *numnewVertices, unsigned int **indices);
+///Vertices within epsilon of each other are welded. If the lists of old are given,
+///the triangles of its GFXTRI lists are reordered for the vertex cache and overdraw
+void GFXOptimizeList(GFXVertex *old, int numV, GFXVertex **newlist, int *numnewVertices, unsigned int **indices,
+        float epsilon = 0.0F, const enum POLYTYPE *poly = nullptr, const int *offsets = nullptr, int numlists = 0);
 
 void GFXFogMode(const FOGMODE fog);
 void GFXFogDensity(const float fogdensity);
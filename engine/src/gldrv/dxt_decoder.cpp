@@ -0,0 +1,322 @@
+/*
+ * dxt_decoder.cpp
+ *
+ * Copyright (C) 2023 Vega Strike contributors.
+ *
+ * https://github.com/vegastrike/Vega-Strike-Engine-Source
+ *
+ * This file is part of Vega Strike.
+ *
+ * Vega Strike is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Vega Strike is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Vega Strike. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "gldrv/dxt_decoder.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define DXT_DECODER_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+//A decoded block: 4 rows of 4 pixels, RGBA
+typedef void (*DecodeBlockFunction)(const unsigned char *block, DxtFormat format, unsigned char *rgba);
+
+inline uint32_t ReadLittle16(const unsigned char *bytes) {
+    return bytes[0] | (bytes[1] << 8);
+}
+
+inline uint32_t ReadLittle32(const unsigned char *bytes) {
+    return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (static_cast<uint32_t>(bytes[3]) << 24);
+}
+
+//Colours are kept as R | G << 8 | B << 16 | A << 24, the order of the bytes of RGBA pixels
+inline uint32_t Pack(uint32_t r, uint32_t g, uint32_t b, uint32_t a) {
+    return r | (g << 8) | (b << 16) | (a << 24);
+}
+
+inline void Expand565(uint32_t color, uint32_t *rgb) {
+    const uint32_t r = (color >> 11) & 0x1f;
+    const uint32_t g = (color >> 5) & 0x3f;
+    const uint32_t b = color & 0x1f;
+    //Replicate the high bits into the low ones, as the hardware does, so that full intensity is 255
+    rgb[0] = (r << 3) | (r >> 2);
+    rgb[1] = (g << 2) | (g >> 4);
+    rgb[2] = (b << 3) | (b >> 2);
+}
+
+//DXT3 and DXT5 colour blocks always use four colours; in DXT1 blocks
+//c0 <= c1 selects three colours and transparent black
+void ColorPalette(const unsigned char *block, bool four_colors, uint32_t *palette) {
+    const uint32_t c0 = ReadLittle16(block);
+    const uint32_t c1 = ReadLittle16(block + 2);
+    uint32_t rgb0[3];
+    uint32_t rgb1[3];
+    Expand565(c0, rgb0);
+    Expand565(c1, rgb1);
+    palette[0] = Pack(rgb0[0], rgb0[1], rgb0[2], 255);
+    palette[1] = Pack(rgb1[0], rgb1[1], rgb1[2], 255);
+    if (c0 > c1 || four_colors) {
+        palette[2] = Pack((2 * rgb0[0] + rgb1[0] + 1) / 3,
+                (2 * rgb0[1] + rgb1[1] + 1) / 3,
+                (2 * rgb0[2] + rgb1[2] + 1) / 3,
+                255);
+        palette[3] = Pack((rgb0[0] + 2 * rgb1[0] + 1) / 3,
+                (rgb0[1] + 2 * rgb1[1] + 1) / 3,
+                (rgb0[2] + 2 * rgb1[2] + 1) / 3,
+                255);
+    } else {
+        palette[2] = Pack((rgb0[0] + rgb1[0] + 1) >> 1,
+                (rgb0[1] + rgb1[1] + 1) >> 1,
+                (rgb0[2] + rgb1[2] + 1) >> 1,
+                255);
+        palette[3] = 0;
+    }
+}
+
+void AlphaPalette(const unsigned char *block, uint32_t *palette) {
+    const uint32_t a0 = block[0];
+    const uint32_t a1 = block[1];
+    palette[0] = a0;
+    palette[1] = a1;
+    if (a0 > a1) {
+        for (uint32_t code = 2; code < 8; ++code) {
+            palette[code] = ((8 - code) * a0 + (code - 1) * a1) / 7;
+        }
+    } else {
+        for (uint32_t code = 2; code < 6; ++code) {
+            palette[code] = ((6 - code) * a0 + (code - 1) * a1) / 5;
+        }
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+}
+
+void DecodeBlockScalar(const unsigned char *block, DxtFormat format, unsigned char *rgba) {
+    const unsigned char *color = (format == DXT_FORMAT_DXT1) ? block : block + 8;
+    uint32_t palette[4];
+    ColorPalette(color, format != DXT_FORMAT_DXT1, palette);
+    const uint32_t indices = ReadLittle32(color + 4);
+    uint32_t pixels[16];
+    for (int pixel = 0; pixel < 16; ++pixel) {
+        pixels[pixel] = palette[(indices >> (2 * pixel)) & 3];
+    }
+    if (format == DXT_FORMAT_DXT3) {
+        const uint64_t bits = ReadLittle32(block) | (static_cast<uint64_t>(ReadLittle32(block + 4)) << 32);
+        for (int pixel = 0; pixel < 16; ++pixel) {
+            const uint32_t alpha = ((bits >> (4 * pixel)) & 0x0f) * 17;
+            pixels[pixel] = (pixels[pixel] & 0x00ffffff) | (alpha << 24);
+        }
+    } else if (format == DXT_FORMAT_DXT5) {
+        uint32_t alphas[8];
+        AlphaPalette(block, alphas);
+        const uint64_t bits = ReadLittle16(block + 2) | (static_cast<uint64_t>(ReadLittle32(block + 4)) << 16);
+        for (int pixel = 0; pixel < 16; ++pixel) {
+            pixels[pixel] = (pixels[pixel] & 0x00ffffff) | (alphas[(bits >> (3 * pixel)) & 7] << 24);
+        }
+    }
+    for (int pixel = 0; pixel < 16; ++pixel) {
+        rgba[pixel * 4] = pixels[pixel] & 0xff;
+        rgba[pixel * 4 + 1] = (pixels[pixel] >> 8) & 0xff;
+        rgba[pixel * 4 + 2] = (pixels[pixel] >> 16) & 0xff;
+        rgba[pixel * 4 + 3] = pixels[pixel] >> 24;
+    }
+}
+
+#ifdef DXT_DECODER_AVX2
+
+//Same values as AlphaPalette, computed in registers: going through memory
+//would stall on loading eight values just stored one at a time.
+//Divisions are multiplications by 65536 / 7 and 65536 / 5, rounded up,
+//which are exact for the sums of weighted 8-bit alphas.
+__attribute__((target("avx2")))
+inline __m256i AlphaPaletteAvx2(uint32_t a0, uint32_t a1) {
+    const __m256i first = _mm256_set1_epi32(a0);
+    const __m256i second = _mm256_set1_epi32(a1);
+    const __m256i eight = _mm256_mulhi_epu16(
+            _mm256_add_epi32(_mm256_mullo_epi16(first, _mm256_setr_epi32(7, 0, 6, 5, 4, 3, 2, 1)),
+                    _mm256_mullo_epi16(second, _mm256_setr_epi32(0, 7, 1, 2, 3, 4, 5, 6))),
+            _mm256_set1_epi32(9363));
+    __m256i six = _mm256_mulhi_epu16(
+            _mm256_add_epi32(_mm256_mullo_epi16(first, _mm256_setr_epi32(5, 0, 4, 3, 2, 1, 0, 0)),
+                    _mm256_mullo_epi16(second, _mm256_setr_epi32(0, 5, 1, 2, 3, 4, 0, 0))),
+            _mm256_set1_epi32(13108));
+    //Codes 6 and 7 are fully transparent and fully opaque
+    six = _mm256_blend_epi32(six, _mm256_setr_epi32(0, 0, 0, 0, 0, 0, 0, 255), 0xc0);
+    return _mm256_blendv_epi8(six, eight, _mm256_set1_epi32(a0 > a1 ? -1 : 0));
+}
+
+//Eight pixels at a time: their indices are shifted out of one broadcast
+//word and looked up in the palette with a cross-lane permute. The
+//permute only reads the low 3 bits of each index, so the four colour
+//palette is repeated in the upper lanes rather than masking the indices.
+__attribute__((target("avx2")))
+void DecodeBlockAvx2(const unsigned char *block, DxtFormat format, unsigned char *rgba) {
+    const unsigned char *color = (format == DXT_FORMAT_DXT1) ? block : block + 8;
+    uint32_t palette[4];
+    ColorPalette(color, format != DXT_FORMAT_DXT1, palette);
+    const __m256i colors = _mm256_setr_epi32(palette[0], palette[1], palette[2], palette[3],
+            palette[0], palette[1], palette[2], palette[3]);
+    const __m256i indices = _mm256_set1_epi32(ReadLittle32(color + 4));
+    __m256i first = _mm256_permutevar8x32_epi32(colors,
+            _mm256_srlv_epi32(indices, _mm256_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14)));
+    __m256i second = _mm256_permutevar8x32_epi32(colors,
+            _mm256_srlv_epi32(indices, _mm256_setr_epi32(16, 18, 20, 22, 24, 26, 28, 30)));
+
+    if (format != DXT_FORMAT_DXT1) {
+        const __m256i rgb = _mm256_set1_epi32(0x00ffffff);
+        __m256i first_alpha;
+        __m256i second_alpha;
+        if (format == DXT_FORMAT_DXT3) {
+            const __m256i shifts = _mm256_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28);
+            const __m256i nibble = _mm256_set1_epi32(0x0f);
+            const __m256i seventeen = _mm256_set1_epi32(17);
+            first_alpha = _mm256_mullo_epi32(
+                    _mm256_and_si256(_mm256_srlv_epi32(_mm256_set1_epi32(ReadLittle32(block)), shifts), nibble),
+                    seventeen);
+            second_alpha = _mm256_mullo_epi32(
+                    _mm256_and_si256(_mm256_srlv_epi32(_mm256_set1_epi32(ReadLittle32(block + 4)), shifts), nibble),
+                    seventeen);
+        } else {
+            const __m256i alpha_palette = AlphaPaletteAvx2(block[0], block[1]);
+            const __m256i shifts = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+            const uint32_t low = ReadLittle16(block + 2) | (block[4] << 16);
+            const uint32_t high = ReadLittle16(block + 5) | (block[7] << 16);
+            first_alpha = _mm256_permutevar8x32_epi32(alpha_palette,
+                    _mm256_srlv_epi32(_mm256_set1_epi32(low), shifts));
+            second_alpha = _mm256_permutevar8x32_epi32(alpha_palette,
+                    _mm256_srlv_epi32(_mm256_set1_epi32(high), shifts));
+        }
+        first = _mm256_or_si256(_mm256_and_si256(first, rgb), _mm256_slli_epi32(first_alpha, 24));
+        second = _mm256_or_si256(_mm256_and_si256(second, rgb), _mm256_slli_epi32(second_alpha, 24));
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(rgba), first);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(rgba + 32), second);
+}
+
+bool CpuHasAvx2() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+
+#endif
+
+std::atomic<bool> force_scalar(false);
+
+DecodeBlockFunction GetDecodeBlock() {
+#ifdef DXT_DECODER_AVX2
+    static const bool has_avx2 = CpuHasAvx2();
+    if (has_avx2 && !force_scalar.load(std::memory_order_relaxed)) {
+        return DecodeBlockAvx2;
+    }
+#endif
+    return DecodeBlockScalar;
+}
+
+void DecodeRows(const unsigned char *input,
+        DxtFormat format,
+        int width,
+        int height,
+        size_t first_row,
+        size_t end_row,
+        unsigned char *output,
+        DecodeBlockFunction decode_block) {
+    const size_t block_bytes = DxtBlockBytes(format);
+    const size_t blocks_per_row = (width + 3) / 4;
+    const size_t row_bytes = static_cast<size_t>(width) * 4;
+    unsigned char block_rgba[64];
+    for (size_t row = first_row; row < end_row; ++row) {
+        const unsigned char *block = input + row * blocks_per_row * block_bytes;
+        const int rows = std::min(4, height - static_cast<int>(row) * 4);
+        unsigned char *out = output + row * 4 * row_bytes;
+        for (size_t column = 0; column < blocks_per_row; ++column, block += block_bytes) {
+            decode_block(block, format, block_rgba);
+            //Surfaces narrower or shorter than 4 pixels, or that are not a
+            //multiple of 4, only keep part of their last blocks
+            const size_t columns = std::min<size_t>(4, width - column * 4);
+            for (int y = 0; y < rows; ++y) {
+                memcpy(out + y * row_bytes + column * 16, block_rgba + y * 16, columns * 4);
+            }
+        }
+    }
+}
+
+} // namespace
+
+size_t DxtBlockBytes(DxtFormat format) {
+    return format == DXT_FORMAT_DXT1 ? 8 : 16;
+}
+
+size_t DxtLevelBytes(DxtFormat format, int width, int height) {
+    return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * DxtBlockBytes(format);
+}
+
+size_t DxtDecodedBytes(int width, int height, int first_level, int levels) {
+    size_t bytes = 0;
+    for (int level = 0; level < first_level + levels; ++level) {
+        if (level >= first_level) {
+            bytes += static_cast<size_t>(width) * height * 4;
+        }
+        width = std::max(width >> 1, 1);
+        height = std::max(height >> 1, 1);
+    }
+    return bytes;
+}
+
+void DxtDecode(const unsigned char *input,
+        DxtFormat format,
+        int width,
+        int height,
+        int first_level,
+        int levels,
+        unsigned char *output,
+        const DxtParallelFor &parallel_for) {
+    const DecodeBlockFunction decode_block = GetDecodeBlock();
+    for (int level = 0; level < first_level + levels; ++level) {
+        if (level >= first_level) {
+            const size_t rows = (height + 3) / 4;
+            auto body = [=](size_t first_row, size_t end_row) {
+                DecodeRows(input, format, width, height, first_row, end_row, output, decode_block);
+            };
+            if (parallel_for && rows > 1) {
+                parallel_for(rows, body);
+            } else {
+                body(0, rows);
+            }
+            output += static_cast<size_t>(width) * height * 4;
+        }
+        input += DxtLevelBytes(format, width, height);
+        width = std::max(width >> 1, 1);
+        height = std::max(height >> 1, 1);
+    }
+}
+
+const char *DxtDecoderName() {
+#ifdef DXT_DECODER_AVX2
+    if (GetDecodeBlock() == DecodeBlockAvx2) {
+        return "avx2";
+    }
+#endif
+    return "scalar";
+}
+
+void DxtForceScalarDecoder(bool force) {
+    force_scalar.store(force, std::memory_order_relaxed);
+}
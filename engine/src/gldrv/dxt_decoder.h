@@ -0,0 +1,78 @@
+/*
+ * dxt_decoder.h
+ *
+ * Copyright (C) 2023 Vega Strike contributors.
+ *
+ * https://github.com/vegastrike/Vega-Strike-Engine-Source
+ *
+ * This file is part of Vega Strike.
+ *
+ * Vega Strike is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Vega Strike is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Vega Strike. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef VEGA_STRIKE_ENGINE_GLDRV_DXT_DECODER_H
+#define VEGA_STRIKE_ENGINE_GLDRV_DXT_DECODER_H
+
+#include <cstddef>
+#include <functional>
+
+/*
+ * Software decoding of S3TC (DXT1, DXT3 and DXT5) surfaces to RGBA, 8 bits
+ * per channel, for drivers without S3TC and for CPU-side image work.
+ *
+ * Blocks are decoded with AVX2 where the CPU has it, and with plain 32-bit
+ * palette lookups otherwise. Only depends on the standard library, so that
+ * tools can link it on its own.
+ */
+
+enum DxtFormat {
+    DXT_FORMAT_DXT1,        // Opaque, or with 1-bit alpha
+    DXT_FORMAT_DXT3,        // Explicit 4-bit alpha
+    DXT_FORMAT_DXT5,        // Interpolated alpha
+};
+
+// Runs body(begin, end) over [0, count), possibly split across threads
+typedef std::function<void(size_t count, const std::function<void(size_t, size_t)> &body)> DxtParallelFor;
+
+// Bytes of one 4x4 block
+size_t DxtBlockBytes(DxtFormat format);
+
+// Bytes of one compressed level of width x height
+size_t DxtLevelBytes(DxtFormat format, int width, int height);
+
+// Bytes of decoded levels [first_level, first_level + levels) of a surface
+// whose top level is width x height
+size_t DxtDecodedBytes(int width, int height, int first_level, int levels);
+
+// Decodes levels [first_level, first_level + levels) of a mip chain whose
+// top level is width x height and whose levels follow each other in input,
+// as DDS files store them. Levels before first_level are skipped without
+// being read. The decoded levels are written one after another to output,
+// which must hold DxtDecodedBytes(). Rows of blocks are handed to
+// parallel_for when one is given.
+void DxtDecode(const unsigned char *input,
+        DxtFormat format,
+        int width,
+        int height,
+        int first_level,
+        int levels,
+        unsigned char *output,
+        const DxtParallelFor &parallel_for = DxtParallelFor());
+
+// Name of the block decoder in use, for logs and benchmarks
+const char *DxtDecoderName();
+
+// Forces the plain decoder even if the CPU has AVX2; for benchmarks and tests
+void DxtForceScalarDecoder(bool force);
+
+#endif //VEGA_STRIKE_ENGINE_GLDRV_DXT_DECODER_H
@@ -182,12 +182,19 @@ struct LineCollideStar {
         return *((int *) (&lc->object.i));
     }
 };
+
+///Hashes a LineCollideStar by the light index its operator== compares
+struct LineCollideStarHash {
+    size_t operator()(const LineCollideStar &a) const {
+        return std::hash<int>()(a.lc->object.i);
+    }
+};
 ///Finds the local lights that are clobberable for new lights (permanent perhaps)
 int findLocalClobberable();
 
 #define CTACC 40000
 ///table to store local lights, numerical pointers to _llights (eg indices)
-extern Hashtable3d<LineCollideStar, 20, CTACC, lighthuge> lighttable;
+extern Hashtable3d<LineCollideStar, CTACC, lighthuge, LineCollideStarHash> lighttable;
 
 ///something that would normally round down
 extern float intensity_cutoff;
@@ -203,10 +203,10 @@ void GFXPickLights(const Vector &center,
         GFXGlobalLights(lights, center, radius);
     }
 
-    veclinecol *tmppickt[2];
-    lighttable.Get(center.Cast(), tmppickt);
+    veclinecol *tmppickt[lighttable.POINT_LISTS];
+    const int numpickt = lighttable.Get(center.Cast(), tmppickt);
 
-    for (int j = 0; j < 2; j++) {
+    for (int j = 0; j < numpickt; j++) {
         veclinecol::iterator i;
         float attenuated = 0, occlusion = 0;
 
@@ -182,7 +182,7 @@ const float atten0scale = 1;
 const float atten1scale = 1. / GFX_SCALE;
 const float atten2scale = 1. / (GFX_SCALE * GFX_SCALE);
 int _GLLightsEnabled = 0;
-Hashtable3d<LineCollideStar, 20, CTACC, lighthuge> lighttable;
+Hashtable3d<LineCollideStar, CTACC, lighthuge, LineCollideStarHash> lighttable;
 
 GFXLight gfx_light::operator=(const GFXLight &tmp) {   // Let's see if I can write a better copy operator
 //    memcpy( this, &tmp, sizeof (GFXLight) );
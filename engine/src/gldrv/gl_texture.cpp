@@ -920,9 +920,22 @@ GFXBOOL /*GFXDRVAPI*/ GFXTransferTexture(unsigned char *buffer,
     int height = textures[handle].height;
     int width = textures[handle].width;
     //If s3tc compression is disabled, our DDS files must be software decompressed
+    int decoded_mips = 0;
     if (internformat >= DXT1 && internformat <= DXT5 && !gl_options.s3tc) {
         unsigned char *tmpbuffer = buffer + offset1;
-        ddsDecompress(tmpbuffer, data, internformat, textures[handle].height, textures[handle].width);
+        //Decode the mipmaps stored in the file rather than rebuild them, if there are all of them
+        if ((((textures[handle].mipmapped & (TRILINEAR | MIPMAP)) && gl_options.mipmap >= 2) || detail_texture)
+                && mips > 1) {
+            int levels = 1;
+            for (int w = width, h = height; w > 1 || h > 1; w >>= 1, h >>= 1) {
+                ++levels;
+            }
+            if (mips >= levels) {
+                decoded_mips = levels;
+            }
+        }
+        ddsDecompress(tmpbuffer, data, internformat, textures[handle].height, textures[handle].width,
+                0, decoded_mips > 0 ? decoded_mips : 1);
         buffer = data;
         internformat = RGBA32;
         textures[handle].textureformat = GL_RGBA;
@@ -983,6 +996,29 @@ GFXBOOL /*GFXDRVAPI*/ GFXTransferTexture(unsigned char *buffer,
                     glCompressedTexImage2D_p(image2D, 0, internalformat, width, height, 0, size, buffer + offset1);
                 }
                 /* END HACK */
+            } else if (decoded_mips > 0) {
+                //Software decompressed DDS, with its own mipmaps
+                size_t offset = 0;
+                int w = textures[handle].width;
+                int h = textures[handle].height;
+                for (int i = 0; i < decoded_mips; ++i) {
+                    glTexImage2D(image2D,
+                            i,
+                            internalformat,
+                            w,
+                            h,
+                            0,
+                            textures[handle].textureformat,
+                            GL_UNSIGNED_BYTE,
+                            buffer + offset);
+                    offset += size_t(w) * size_t(h) * 4;
+                    if (w > 1) {
+                        w >>= 1;
+                    }
+                    if (h > 1) {
+                        h >>= 1;
+                    }
+                }
             } else {
                 //We want mipmaps but we have uncompressed data
                 gluBuild2DMipmaps(image2D,
@@ -39,60 +39,57 @@
 #define GFX_SCALE 1./1024.
 #endif
 
-#include "gnuhash.h"
+#include "gfx/mesh_optimizer.h"
+#include <vector>
 
 GFXVertexList *next;
 
-struct VertexCompare {
-    bool operator()(const GFXVertex *a, const GFXVertex *b) const {
-        if ((sizeof(GFXVertex) % sizeof(unsigned int)) != 0) {
-            return memcmp(a, b, sizeof(GFXVertex)) < 0;
-        } else {
-            // faster memcmp, since it gets unrolled by the compiler
-            const unsigned int *ia = reinterpret_cast<const unsigned int *>(a);
-            const unsigned int *ib = reinterpret_cast<const unsigned int *>(b);
-
-            for (size_t i = 0; i < (sizeof(*a) / sizeof(*ia)); ++i) {
-                if (ia[i] < ib[i]) {
-                    return true;
-                } else if (ia[i] > ib[i]) {
-                    return false;
-                }
-            }
-
-            return false;
-        }
-    }
-};
+static_assert(sizeof(GFXVertex) % sizeof(float) == 0, "GFXOptimizeList welds GFXVertex as an array of floats");
 
-#include <map>
-
-void GFXOptimizeList(GFXVertex *old, int numV, GFXVertex **nw, int *nnewV, unsigned int **ind) {
-    std::map<GFXVertex *, int, VertexCompare> vtxcache;
+void GFXOptimizeList(GFXVertex *old,
+        int numV,
+        GFXVertex **nw,
+        int *nnewV,
+        unsigned int **ind,
+        float epsilon,
+        const enum POLYTYPE *poly,
+        const int *offsets,
+        int numlists) {
+    const size_t stride = sizeof(GFXVertex) / sizeof(float);
 
     *ind = (unsigned int *) malloc(sizeof(unsigned int) * numV);
     *nw = (GFXVertex *) malloc(numV * sizeof(GFXVertex));
-    int _nnewV = *nnewV = 0;
-    int i;
-    bool quickpath = true;
-    for (i = 0; i < numV; i++) {
-        std::map<GFXVertex *, int, VertexCompare>::const_iterator it = vtxcache.find(old + i);
-        if (it != vtxcache.end()) {
-            if (quickpath && i > 0) {
-                quickpath = false;
-                memcpy(*nw, old, sizeof(GFXVertex) * size_t(i));
+    int _nnewV = WeldVertices(&old->s, numV, stride, epsilon, *ind);
+    //New indices are handed out in order, so each new one is a first occurrence
+    for (int i = 0, copied = 0; i < numV; i++) {
+        if ((*ind)[i] == (unsigned int) copied) {
+            (*nw)[copied++] = old[i];
+        }
+    }
+    if (poly && offsets) {
+        std::vector<unsigned int> order;
+        std::vector<unsigned int> reordered;
+        for (int list = 0, first = 0; list < numlists; first += offsets[list++]) {
+            if (poly[list] != GFXTRI || offsets[list] < 6) {
+                continue;
             }
-            (*ind)[i] = it->second;
-        } else {
-            if (!quickpath) {
-                memcpy((*nw) + _nnewV, old + i, sizeof(GFXVertex));
+            const size_t numtris = offsets[list] / 3;
+            unsigned int *tris = (*ind) + first;
+            order.resize(numtris);
+            OptimizeTriangleOrder(tris, numtris, _nnewV, &(*nw)->x, stride, &order[0]);
+            reordered.resize(numtris * 3);
+            for (size_t t = 0; t < numtris; t++) {
+                memcpy(&reordered[t * 3], tris + order[t] * 3, 3 * sizeof(unsigned int));
             }
-            vtxcache[old + i] = ((*ind)[i]) = _nnewV;
-            ++_nnewV;
+            memcpy(tris, &reordered[0], numtris * 3 * sizeof(unsigned int));
+        }
+        //Store the vertices in the order the reordered triangles fetch them
+        std::vector<unsigned int> remap(_nnewV);
+        OptimizeVertexFetch(*ind, numV, _nnewV, &remap[0]);
+        std::vector<GFXVertex> welded(*nw, (*nw) + _nnewV);
+        for (int v = 0; v < _nnewV; v++) {
+            (*nw)[remap[v]] = welded[v];
         }
-    }
-    if (quickpath && i > 0) {
-        memcpy(*nw, old, sizeof(GFXVertex) * size_t(i));
     }
     *nnewV = _nnewV;
 
@@ -23,231 +23,352 @@
 #define VEGA_STRIKE_ENGINE_GLDRV_HASHTABLE_3D_H
 
 #include "gfx/vec.h"
-#include <algorithm>
+#include <math.h>
+#include <stdint.h>
+#include <functional>
+#include <unordered_map>
 #include <vector>
-#include <stdio.h>
-#include <assert.h>
 #include "linecollide.h"
 #include "vs_logging.h"
 
-//#define COLLIDETABLESIZE sizeof(CTSIZ)
-//#define COLLIDETABLEACCURACY sizeof (CTACCURACY)
-///objects that go over 16 sectors are considered huge and better to check against everything.
-//#define HUGEOBJECT sizeof (CTHUGE)
-
 /**
  * Hashtable3d is a 3d datastructure that holds various starships that are
  * near enough to crash into each other (or also lights that are big enough
  * to shine on nearby units.
+ *
+ * The grid is sparse: only occupied cells exist, keyed on their 64-bit
+ * integer coordinates, so it covers a whole star system without wrapping
+ * distant objects onto each other. Each object goes into the finest of
+ * LEVELS grids (cell size COLLIDETABLEACCURACY << level) on which it spans
+ * at most two cells per axis, so big objects fill at most 8 cells. Only
+ * objects too big for the coarsest grid end up in the huge list.
+ *
+ * Every object keeps back-indices to its slots, and every slot to its
+ * object, so Remove and Eradicate swap-remove in constant time instead of
+ * searching cells. T needs operator== and a HASH consistent with it; an
+ * object Put twice is moved rather than stored twice.
  */
-template<class T, int COLLIDETABLESIZE, int COLLIDETABLEACCURACY, int HUGEOBJECT>
+template<class T, int COLLIDETABLEACCURACY, int HUGEOBJECT, class HASH = std::hash<T> >
 class Hashtable3d {
+public:
+///Number of grids; objects wider than COLLIDETABLEACCURACY << (LEVELS - 1) are huge
+    static const int LEVELS = 16;
+///Number of lists Get(const QVector &) may return
+    static const int POINT_LISTS = LEVELS + 1;
+
+private:
+    struct CellKey {
+        int64_t i, j, k;
+        int level;
+
+        bool operator==(const CellKey &b) const {
+            return i == b.i && j == b.j && k == b.k && level == b.level;
+        }
+    };
+
+    struct CellKeyHash {
+        size_t operator()(const CellKey &key) const {
+            uint64_t h = (uint64_t) key.i * 0x9E3779B97F4A7C15ULL;
+            h ^= (uint64_t) key.j * 0xC2B2AE3D27D4EB4FULL + (h << 6) + (h >> 2);
+            h ^= (uint64_t) key.k * 0x165667B19E3779F9ULL + (h << 6) + (h >> 2);
+            h ^= (uint64_t) key.level + (h << 6) + (h >> 2);
+            return (size_t) (h ^ (h >> 32));
+        }
+    };
+
+    struct Record;
+    struct Cell;
+
+///Where one copy of an object sits
+    struct Slot {
+        Cell *cell;
+        unsigned int index;
+    };
+
+///Which object, and which of its slots, a cell entry belongs to
+    struct Owner {
+        Record *record;
+        unsigned int slot;
+    };
+
+    struct Cell {
+        CellKey key;
+        std::vector<T> objects;
+        std::vector<Owner> owners;
+    };
+
+    struct Record {
+        int level;          //-1 when huge
+        std::vector<Slot> slots;
+    };
+
+    typedef std::unordered_map<CellKey, Cell, CellKeyHash> CellMap;
+    typedef std::unordered_map<T, Record, HASH> RecordMap;
+
+///Occupied cells of every level. Node based, so Cell pointers stay valid
+    CellMap cells;
+///Every object in the table, with the slots it occupies
+    RecordMap records;
 ///All objects that are too large to fit (fastly) in the collide table
-    std::vector<T> hugeobjects;
-///The hash table itself. Holds most units to be collided with
-    std::vector<T> table[COLLIDETABLESIZE][COLLIDETABLESIZE][COLLIDETABLESIZE];
+    Cell hugeobjects;
+///Objects per level, so queries skip empty levels
+    unsigned int level_count[LEVELS];
+///Occupied cells per level, so queries spanning more cells than that walk the cells instead
+    unsigned int cell_count[LEVELS];
+///Handed out for empty cells
+    std::vector<T> empty;
+
+    static double cell_size(int level) {
+        return ldexp((double) COLLIDETABLEACCURACY, level);
+    }
+
+///Cell coordinate of aye on a grid of the given cell size, clamped far beyond any star system
+    static int64_t cell_of(double aye, double size) {
+        const double limit = 4611686018427387904.0;       //2^62
+        double cell = floor(aye / size);
+        if (!(cell > -limit)) {
+            cell = -limit;
+        } else if (cell > limit) {
+            cell = limit;
+        }
+        return (int64_t) cell;
+    }
+
+    static CellKey cell_key(const QVector &t, int level) {
+        const double size = cell_size(level);
+        CellKey key = {cell_of(t.i, size), cell_of(t.j, size), cell_of(t.k, size), level};
+        return key;
+    }
+
+///Finest level on which target spans at most 2 cells per axis, or -1 if none does
+    static int pick_level(const LineCollide *target) {
+        for (int level = 0; level < LEVELS; ++level) {
+            const CellKey lo = cell_key(target->Mini, level);
+            const CellKey hi = cell_key(target->Maxi, level);
+            if (hi.i - lo.i <= 1 && hi.j - lo.j <= 1 && hi.k - lo.k <= 1) {
+                return level;
+            }
+        }
+        return -1;
+    }
+
+    Cell *find_cell(const CellKey &key) {
+        typename CellMap::iterator found = cells.find(key);
+        return found == cells.end() ? nullptr : &found->second;
+    }
 
-///hashes 3 values into the appropriate spot in the hash table
-    static void hash_vec(double i, double j, double k, int &x, int &y, int &z) {
-        x = hash_int(i);
-        y = hash_int(j);
-        z = hash_int(k);
+    void add_to_cell(Cell &cell, const T &objectToPut, Record &record) {
+        Slot slot = {&cell, (unsigned int) cell.objects.size()};
+        Owner owner = {&record, (unsigned int) record.slots.size()};
+        cell.objects.push_back(objectToPut);
+        cell.owners.push_back(owner);
+        record.slots.push_back(slot);
     }
 
-///hashes 3 vals into the appropriate place in hash table
-    static void hash_vec(const QVector &t, int &x, int &y, int &z) {
-        hash_vec(t.i, t.j, t.k, x, y, z);
+///Swap-removes a slot, fixing the back-index of the entry moved into its place
+    void remove_from_cell(const Slot &slot) {
+        Cell &cell = *slot.cell;
+        const unsigned int last = (unsigned int) cell.objects.size() - 1;
+        if (slot.index != last) {
+            cell.objects[slot.index] = cell.objects[last];
+            cell.owners[slot.index] = cell.owners[last];
+            const Owner &moved = cell.owners[slot.index];
+            moved.record->slots[moved.slot].index = slot.index;
+        }
+        cell.objects.pop_back();
+        cell.owners.pop_back();
+        if (cell.objects.empty() && &cell != &hugeobjects) {
+            --cell_count[cell.key.level];
+            cells.erase(cell.key);
+        }
+    }
+
+    void remove_record(typename RecordMap::iterator found) {
+        Record &record = found->second;
+        for (size_t i = 0; i < record.slots.size(); ++i) {
+            remove_from_cell(record.slots[i]);
+        }
+        if (record.level >= 0) {
+            --level_count[record.level];
+        }
+        records.erase(found);
+    }
+
+///Hands out the list of a cell, unless retval already holds HUGEOBJECT + 1 lists
+    bool add_list(Cell &cell, std::vector<T> *retval[], unsigned int &sizer) const {
+        if (sizer >= HUGEOBJECT + 1) {
+            VS_LOG(warning,
+                    (boost::format("Hashtable3d: more than %1% occupied cells overlap a box, leaving the others out")
+                            % HUGEOBJECT));
+            return false;
+        }
+        retval[sizer++] = &cell.objects;
+        return true;
     }
 
 public:
-///Hashes a single value to a value on the collide table truncated to all 3d constraints.  Consider using a swizzle
-    static int hash_int(const double aye) {
-        return ((int) (((aye < 0) ? (aye
-                - COLLIDETABLEACCURACY) : aye)
-                / COLLIDETABLEACCURACY)) % (COLLIDETABLESIZE / 2) + (COLLIDETABLESIZE / 2);
+    Hashtable3d() {
+        hugeobjects.key.i = hugeobjects.key.j = hugeobjects.key.k = 0;
+        hugeobjects.key.level = -1;
+        for (int level = 0; level < LEVELS; ++level) {
+            level_count[level] = 0;
+            cell_count[level] = 0;
+        }
+    }
+
+///Cell coordinate of a single value on the finest grid; equal values mean the same cell
+    static int64_t hash_int(const double aye) {
+        return cell_of(aye, (double) COLLIDETABLEACCURACY);
     }
 
 ///clears entire table
     void Clear() {
-        hugeobjects.clear();
-        for (int i = 0; i <= COLLIDETABLESIZE - 1; i++) {
-            for (int j = 0; j <= COLLIDETABLESIZE - 1; j++) {
-                for (int k = 0; k <= COLLIDETABLESIZE - 1; k++) {
-                    if (table[i][j][k].size()) {
-                        table[i][j][k].clear();
-                    }
-                }
-            }
+        cells.clear();
+        records.clear();
+        hugeobjects.objects.clear();
+        hugeobjects.owners.clear();
+        for (int level = 0; level < LEVELS; ++level) {
+            level_count[level] = 0;
+            cell_count[level] = 0;
         }
     }
 
-///returns any objects residing in the sector occupied by Exact
+///Whether objectToFind is in the table
+    bool Contains(const T &objectToFind) const {
+        return records.find(objectToFind) != records.end();
+    }
+
+///Calls fn on every object in the table once
+    template<class FN>
+    void ForEach(FN fn) const {
+        for (typename RecordMap::const_iterator i = records.begin(); i != records.end(); ++i) {
+            fn(i->first);
+        }
+    }
+
+///returns any objects residing in the sector occupied by Exact; retval needs POINT_LISTS entries
     int Get(const QVector &Exact, std::vector<T> *retval[]) {
-        retval[1] = &table[hash_int(Exact.i)][hash_int(Exact.j)][hash_int(Exact.k)];
-        //retval+=hugeobjects;
-        //blah = blooh;
-        retval[0] = &hugeobjects;
-        return 2;
+        int sizer = 1;
+        retval[0] = &hugeobjects.objects;
+        for (int level = 0; level < LEVELS; ++level) {
+            if (level_count[level]) {
+                Cell *cell = find_cell(cell_key(Exact, level));
+                retval[sizer++] = cell ? &cell->objects : &empty;
+            }
+        }
+        return sizer;
     }
 
 ///Returns all objects too big to be conveniently fit in the array
     std::vector<T> &GetHuge() {
-        return hugeobjects;
+        return hugeobjects.objects;
     }
 
-///Returns all objects within sector(s) occupied by target
+///Returns all objects within sector(s) occupied by target; retval needs HUGEOBJECT + 1 entries.
+///Cells beyond that are left out, with a warning
     int Get(const LineCollide *target, std::vector<T> *retval[]) {
         unsigned int sizer = 1;
-        //int minx,miny,minz,maxx,maxy,maxz;
-        //hash_vec(Min,minx,miny,minz);
-        //hash_vec(Max,maxx,maxy,maxz);
-        double maxx = (ceil(target->Maxi.i / COLLIDETABLEACCURACY)) * COLLIDETABLEACCURACY;
-        double maxy = (ceil(target->Maxi.j / COLLIDETABLEACCURACY)) * COLLIDETABLEACCURACY;
-        double maxz = (ceil(target->Maxi.k / COLLIDETABLEACCURACY)) * COLLIDETABLEACCURACY;
-        int x, y, z;
-        if (target->Mini.i == maxx) {
-            maxx += COLLIDETABLEACCURACY / 2;
-        }
-        if (target->Mini.j == maxy) {
-            maxy += COLLIDETABLEACCURACY / 2;
-        }
-        if (target->Mini.k == maxz) {
-            maxz += COLLIDETABLEACCURACY / 2;
-        }
-        retval[0] = &hugeobjects;
+        retval[0] = &hugeobjects.objects;
         if (target->hhuge) {
             return sizer;      //we can't get _everything
         }
-        for (double i = target->Mini.i; i < maxx; i += COLLIDETABLEACCURACY) {
-            x = hash_int(i);
-            for (double j = target->Mini.j; j < maxy; j += COLLIDETABLEACCURACY) {
-                y = hash_int(j);
-                for (double k = target->Mini.k; k < maxz; k += COLLIDETABLEACCURACY) {
-                    z = hash_int(k);
-                    if (!table[x][y][z].empty()) {
-                        retval[sizer] = &table[x][y][z];
-                        sizer++;
-                        if (sizer >= HUGEOBJECT + 1) {
+        //From the level target would go into on up, it spans at most 2 cells per axis. On finer
+        //levels it may span far more cells than are occupied; those levels walk their cells instead
+        const int target_level = pick_level(target);
+        CellKey lo[LEVELS], hi[LEVELS];
+        bool walk[LEVELS];
+        bool walk_any = false;
+        for (int level = 0; level < LEVELS; ++level) {
+            walk[level] = false;
+            if (!level_count[level]) {
+                continue;
+            }
+            lo[level] = cell_key(target->Mini, level);
+            hi[level] = cell_key(target->Maxi, level);
+            if (target_level < 0 || level < target_level) {
+                const double span = ((double) (hi[level].i - lo[level].i) + 1)
+                        * ((double) (hi[level].j - lo[level].j) + 1)
+                        * ((double) (hi[level].k - lo[level].k) + 1);
+                if (span > cell_count[level]) {
+                    walk[level] = walk_any = true;
+                    continue;
+                }
+            }
+            CellKey key = lo[level];
+            for (key.i = lo[level].i; key.i <= hi[level].i; ++key.i) {
+                for (key.j = lo[level].j; key.j <= hi[level].j; ++key.j) {
+                    for (key.k = lo[level].k; key.k <= hi[level].k; ++key.k) {
+                        Cell *cell = find_cell(key);
+                        if (cell && !add_list(*cell, retval, sizer)) {
                             return sizer;
                         }
                     }
                 }
             }
         }
-        assert(sizer <= HUGEOBJECT + 1); //make sure we didn't overrun our array
+        if (walk_any) {
+            for (typename CellMap::iterator i = cells.begin(); i != cells.end(); ++i) {
+                const CellKey &key = i->first;
+                if (walk[key.level]
+                        && key.i >= lo[key.level].i && key.i <= hi[key.level].i
+                        && key.j >= lo[key.level].j && key.j <= hi[key.level].j
+                        && key.k >= lo[key.level].k && key.k <= hi[key.level].k
+                        && !add_list(i->second, retval, sizer)) {
+                    return sizer;
+                }
+            }
+        }
         return sizer;
     }
 
 ///Adds objectToPut into collide table with limits specified by target.
     void Put(LineCollide *target, const T objectToPut) {
-        int x, y, z;
-        double maxx = (ceil(target->Maxi.i / COLLIDETABLEACCURACY)) * COLLIDETABLEACCURACY;
-        double maxy = (ceil(target->Maxi.j / COLLIDETABLEACCURACY)) * COLLIDETABLEACCURACY;
-        double maxz = (ceil(target->Maxi.k / COLLIDETABLEACCURACY)) * COLLIDETABLEACCURACY;
-        //for huge calculation...not sure it's necessary
-        double minx = (floor(target->Mini.i / COLLIDETABLEACCURACY)) * COLLIDETABLEACCURACY;
-        double miny = (floor(target->Mini.j / COLLIDETABLEACCURACY)) * COLLIDETABLEACCURACY;
-        double minz = (floor(target->Mini.k / COLLIDETABLEACCURACY)) * COLLIDETABLEACCURACY;
-        if (target->Mini.i == maxx) {
-            maxx += COLLIDETABLEACCURACY / 2;
-        }
-        if (target->Mini.j == maxy) {
-            maxy += COLLIDETABLEACCURACY / 2;
-        }
-        if (target->Mini.k == maxz) {
-            maxz += COLLIDETABLEACCURACY / 2;
-        }
-        if (fabs((maxx
-                - minx)
-                * (maxy
-                        - miny)
-                * (maxz
-                        - minz)) > ((double) COLLIDETABLEACCURACY) * ((double) COLLIDETABLEACCURACY)
-                * ((double) COLLIDETABLEACCURACY)
-                * ((double) HUGEOBJECT)) {
-            target->hhuge = true;
-            hugeobjects.push_back(objectToPut);
+        typename RecordMap::iterator found = records.find(objectToPut);
+        if (found != records.end()) {
+            remove_record(found);
+        }
+        Record &record = records[objectToPut];
+        record.level = pick_level(target);
+        target->hhuge = record.level < 0;
+        if (target->hhuge) {
+            add_to_cell(hugeobjects, objectToPut, record);
             return;
-        } else {
-            target->hhuge = false;
-        }
-        for (double i = target->Mini.i; i < maxx; i += COLLIDETABLEACCURACY) {
-            x = hash_int(i);
-            for (double j = target->Mini.j; j < maxy; j += COLLIDETABLEACCURACY) {
-                y = hash_int(j);
-                for (double k = target->Mini.k; k < maxz; k += COLLIDETABLEACCURACY) {
-                    z = hash_int(k);
-                    table[x][y][z].push_back(objectToPut);
-                }
-            }
         }
-    }
-
-    static bool removeFromVector(std::vector<T> &myvector, T &objectToKill) {
-        bool ret = false;
-        typename std::vector<T>::iterator removal = myvector.begin();
-        while (removal != myvector.end()) {
-            removal = std::find(removal, myvector.end(), objectToKill);
-            if (removal != myvector.end()) {
-                ret = true;
-                int offset = removal - myvector.begin();
-                objectToKill = *removal;
-                myvector.erase(removal);
-                removal = myvector.begin() + offset;
+        ++level_count[record.level];
+        const CellKey lo = cell_key(target->Mini, record.level);
+        const CellKey hi = cell_key(target->Maxi, record.level);
+        CellKey key = lo;
+        for (key.i = lo.i; key.i <= hi.i; ++key.i) {
+            for (key.j = lo.j; key.j <= hi.j; ++key.j) {
+                for (key.k = lo.k; key.k <= hi.k; ++key.k) {
+                    Cell &cell = cells[key];
+                    if (cell.objects.empty()) {
+                        cell.key = key;
+                        ++cell_count[key.level];
+                    }
+                    add_to_cell(cell, objectToPut, record);
+                }
             }
         }
-        return ret;
     }
 
-    bool Eradicate(T objectToKill) {
-        bool ret = removeFromVector(hugeobjects, objectToKill);
-        for (unsigned int i = 0; i <= COLLIDETABLESIZE - 1; i++) {
-            for (unsigned int j = 0; j <= COLLIDETABLESIZE - 1; j++) {
-                for (unsigned int k = 0; k <= COLLIDETABLESIZE - 1; k++) {
-                    ret |= removeFromVector(table[i][j][k], objectToKill);
-                }
-            }
+///Removes objectToKill wherever it is, handing back the stored copy in objectToKill
+    bool Eradicate(T &objectToKill) {
+        typename RecordMap::iterator found = records.find(objectToKill);
+        if (found == records.end()) {
+            return false;
         }
-        return ret;
+        objectToKill = found->first;
+        remove_record(found);
+        return true;
     }
 
-///Removes objectToKill from collide table with span of Target
+///Removes objectToKill from collide table with span of Target, handing back the stored copy in objectToKill
     bool Remove(const LineCollide *target, T &objectToKill) {
-        //int minx,miny,minz,maxx,maxy,maxz;
-        //hash_vec(target->Mini,minx,miny,minz);
-        //hash_vec(target->Maxi,maxx,maxy,maxz);
-        bool ret = false;
-        int x, y, z;
-        double maxx = (ceil(target->Maxi.i / COLLIDETABLEACCURACY)) * COLLIDETABLEACCURACY;
-        double maxy = (ceil(target->Maxi.j / COLLIDETABLEACCURACY)) * COLLIDETABLEACCURACY;
-        double maxz = (ceil(target->Maxi.k / COLLIDETABLEACCURACY)) * COLLIDETABLEACCURACY;
-        if (target->Mini.i == maxx) {
-            maxx += COLLIDETABLEACCURACY / 2;
-        }
-        if (target->Mini.j == maxy) {
-            maxy += COLLIDETABLEACCURACY / 2;
-        }
-        if (target->Mini.k == maxz) {
-            maxz += COLLIDETABLEACCURACY / 2;
-        }
-        if (!target->hhuge) {
-            for (double i = target->Mini.i; i < maxx; i += COLLIDETABLEACCURACY) {
-                x = hash_int(i);
-                for (double j = target->Mini.j; j < maxy; j += COLLIDETABLEACCURACY) {
-                    y = hash_int(j);
-                    for (double k = target->Mini.k; k < maxz; k += COLLIDETABLEACCURACY) {
-                        z = hash_int(k);
-                        ret |= removeFromVector(table[x][y][z], objectToKill);
-                    }
-                }
-            }
-        }
+        const bool ret = Eradicate(objectToKill);
         if (!ret && !target->hhuge) {
             VS_LOG(error, "Nonfatal Collide Error");
         }
-        if (!ret || target->hhuge) {
-            ret |= removeFromVector(hugeobjects, objectToKill);
-        }
         return ret;
     }
 };
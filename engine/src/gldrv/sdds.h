@@ -27,13 +27,20 @@
  *       input is the compressed dxt file, already read in by vsimage.
  *       output is an empty pointer created in the calling function.
  *       format is the bit format of the compressed texture (rgba)
- *       height and width are self explanatory
+ *       height and width are those of the first mipmap in input
  *
- *       when function returns, output will contain the uncompressed first mipmap of the dxt image.
+ *       when function returns, output will contain the uncompressed mipmaps first_level
+ *       to first_level + levels - 1 of the dxt image, one after another, allocated with malloc.
  *       the calling function will have to replace the input pointer with the output pointer and set
  *       the texture format to rgba.
  */
 
-void ddsDecompress(unsigned char *&input, unsigned char *&output, TEXTUREFORMAT format, int height, int width);
+void ddsDecompress(unsigned char *&input,
+        unsigned char *&output,
+        TEXTUREFORMAT format,
+        int height,
+        int width,
+        int first_level = 0,
+        int levels = 1);
 
 #endif //VEGA_STRIKE_ENGINE_GLDRV_SDDS_H
@@ -0,0 +1,159 @@
+/*
+ * dxt_decoder_tests.cpp
+ *
+ * Copyright (C) 2023 Vega Strike contributors.
+ *
+ * https://github.com/vegastrike/Vega-Strike-Engine-Source
+ *
+ * This file is part of Vega Strike.
+ *
+ * Vega Strike is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Vega Strike is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Vega Strike. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "gldrv/dxt_decoder.h"
+
+namespace {
+
+// Red and blue endpoints, every pixel using palette entry index
+std::vector<unsigned char> Dxt1Block(unsigned short c0, unsigned short c1, unsigned int index) {
+    unsigned int indices = 0;
+    for (int pixel = 0; pixel < 16; ++pixel) {
+        indices |= index << (2 * pixel);
+    }
+    return {
+            static_cast<unsigned char>(c0 & 0xff), static_cast<unsigned char>(c0 >> 8),
+            static_cast<unsigned char>(c1 & 0xff), static_cast<unsigned char>(c1 >> 8),
+            static_cast<unsigned char>(indices & 0xff), static_cast<unsigned char>((indices >> 8) & 0xff),
+            static_cast<unsigned char>((indices >> 16) & 0xff), static_cast<unsigned char>(indices >> 24),
+    };
+}
+
+std::vector<unsigned char> Decode(const std::vector<unsigned char> &input,
+        DxtFormat format,
+        int width,
+        int height,
+        int first_level = 0,
+        int levels = 1,
+        const DxtParallelFor &parallel_for = DxtParallelFor()) {
+    std::vector<unsigned char> output(DxtDecodedBytes(width, height, first_level, levels));
+    DxtDecode(&input[0], format, width, height, first_level, levels, &output[0], parallel_for);
+    return output;
+}
+
+std::vector<unsigned char> RandomBlocks(size_t bytes, unsigned int seed) {
+    std::mt19937 random(seed);
+    std::vector<unsigned char> blocks(bytes);
+    for (unsigned char &byte : blocks) {
+        byte = static_cast<unsigned char>(random());
+    }
+    return blocks;
+}
+
+void ExpectPixel(const std::vector<unsigned char> &rgba, size_t pixel, int r, int g, int b, int a) {
+    EXPECT_EQ(r, rgba[pixel * 4]);
+    EXPECT_EQ(g, rgba[pixel * 4 + 1]);
+    EXPECT_EQ(b, rgba[pixel * 4 + 2]);
+    EXPECT_EQ(a, rgba[pixel * 4 + 3]);
+}
+
+} // namespace
+
+TEST(DxtDecoder, Dxt1Palette) {
+    ExpectPixel(Decode(Dxt1Block(0xf800, 0x001f, 0), DXT_FORMAT_DXT1, 4, 4), 5, 255, 0, 0, 255);
+    ExpectPixel(Decode(Dxt1Block(0xf800, 0x001f, 1), DXT_FORMAT_DXT1, 4, 4), 5, 0, 0, 255, 255);
+    ExpectPixel(Decode(Dxt1Block(0xf800, 0x001f, 2), DXT_FORMAT_DXT1, 4, 4), 5, 170, 0, 85, 255);
+    // c0 <= c1: three colours and transparent black
+    ExpectPixel(Decode(Dxt1Block(0x001f, 0xf800, 2), DXT_FORMAT_DXT1, 4, 4), 5, 128, 0, 128, 255);
+    ExpectPixel(Decode(Dxt1Block(0x001f, 0xf800, 3), DXT_FORMAT_DXT1, 4, 4), 5, 0, 0, 0, 0);
+}
+
+TEST(DxtDecoder, Dxt5Alpha) {
+    std::vector<unsigned char> block = {200, 100, 0, 0, 0, 0, 0, 0};
+    // Pixel 0 takes a0, pixel 1 a1, pixel 2 the first interpolated alpha
+    block[2] = 0 | (1 << 3) | ((2 & 3) << 6);
+    block[3] = 2 >> 2;
+    const std::vector<unsigned char> color = Dxt1Block(0xffff, 0x0000, 0);
+    block.insert(block.end(), color.begin(), color.end());
+    const std::vector<unsigned char> rgba = Decode(block, DXT_FORMAT_DXT5, 4, 4);
+    ExpectPixel(rgba, 0, 255, 255, 255, 200);
+    ExpectPixel(rgba, 1, 255, 255, 255, 100);
+    ExpectPixel(rgba, 2, 255, 255, 255, (6 * 200 + 1 * 100) / 7);
+}
+
+TEST(DxtDecoder, SurfacesSmallerThanABlock) {
+    // Height used to be clipped by the width, writing past short surfaces
+    const std::vector<unsigned char> block = Dxt1Block(0xf800, 0x001f, 0);
+    const std::vector<unsigned char> wide = Decode(block, DXT_FORMAT_DXT1, 4, 1);
+    ASSERT_EQ(16, wide.size());
+    ExpectPixel(wide, 3, 255, 0, 0, 255);
+    const std::vector<unsigned char> tall = Decode(block, DXT_FORMAT_DXT1, 1, 4);
+    ASSERT_EQ(16, tall.size());
+    ExpectPixel(tall, 3, 255, 0, 0, 255);
+}
+
+TEST(DxtDecoder, PartialBlocksAtTheEdges) {
+    std::vector<unsigned char> blocks;
+    for (int block = 0; block < 4; ++block) {
+        const std::vector<unsigned char> one = Dxt1Block(0xf800, 0x001f, block % 2);
+        blocks.insert(blocks.end(), one.begin(), one.end());
+    }
+    const std::vector<unsigned char> rgba = Decode(blocks, DXT_FORMAT_DXT1, 6, 6);
+    ASSERT_EQ(6 * 6 * 4, rgba.size());
+    ExpectPixel(rgba, 3, 255, 0, 0, 255);
+    ExpectPixel(rgba, 5, 0, 0, 255, 255);
+    ExpectPixel(rgba, 5 * 6, 255, 0, 0, 255);
+    ExpectPixel(rgba, 5 * 6 + 5, 0, 0, 255, 255);
+}
+
+TEST(DxtDecoder, DecodersAgree) {
+    const DxtFormat formats[] = {DXT_FORMAT_DXT1, DXT_FORMAT_DXT3, DXT_FORMAT_DXT5};
+    for (DxtFormat format : formats) {
+        const std::vector<unsigned char> blocks = RandomBlocks(DxtLevelBytes(format, 64, 64), format + 1);
+        const std::vector<unsigned char> fast = Decode(blocks, format, 64, 64);
+        DxtForceScalarDecoder(true);
+        const std::vector<unsigned char> scalar = Decode(blocks, format, 64, 64);
+        DxtForceScalarDecoder(false);
+        EXPECT_EQ(scalar, fast) << "format " << format << ", decoder " << DxtDecoderName();
+    }
+}
+
+TEST(DxtDecoder, DecodesRequestedLevelsOnly) {
+    size_t bytes = 0;
+    for (int size = 16; size >= 1; size /= 2) {
+        bytes += DxtLevelBytes(DXT_FORMAT_DXT5, size, size);
+    }
+    const std::vector<unsigned char> chain = RandomBlocks(bytes, 7);
+    const std::vector<unsigned char> all = Decode(chain, DXT_FORMAT_DXT5, 16, 16, 0, 5);
+    const std::vector<unsigned char> some = Decode(chain, DXT_FORMAT_DXT5, 16, 16, 2, 2);
+    ASSERT_EQ((4 * 4 + 2 * 2) * 4, some.size());
+    const size_t skipped = (16 * 16 + 8 * 8) * 4;
+    EXPECT_TRUE(std::equal(some.begin(), some.end(), all.begin() + skipped));
+}
+
+TEST(DxtDecoder, ParallelDecodeMatches) {
+    const std::vector<unsigned char> blocks = RandomBlocks(DxtLevelBytes(DXT_FORMAT_DXT3, 256, 128), 11);
+    const DxtParallelFor two_threads = [](size_t count, const std::function<void(size_t, size_t)> &body) {
+        std::thread other(body, count / 2, count);
+        body(0, count / 2);
+        other.join();
+    };
+    EXPECT_EQ(Decode(blocks, DXT_FORMAT_DXT3, 256, 128),
+            Decode(blocks, DXT_FORMAT_DXT3, 256, 128, 0, 1, two_threads));
+}
@@ -0,0 +1,174 @@
+/*
+ * hashtable_3d_tests.cpp
+ *
+ * Copyright (C) 2023 Vega Strike contributors.
+ *
+ * https://github.com/vegastrike/Vega-Strike-Engine-Source
+ *
+ * This file is part of Vega Strike.
+ *
+ * Vega Strike is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Vega Strike is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Vega Strike. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "gldrv/hashtable_3d.h"
+
+namespace {
+
+typedef Hashtable3d<int, 100, 27> Table;
+
+LineCollide Box(double x, double y, double z, double size) {
+    return LineCollide(nullptr, LineCollide::UNIT, QVector(x, y, z), QVector(x + size, y + size, z + size));
+}
+
+// Every object the lists returned by Get hold, without duplicates
+std::vector<int> Gather(std::vector<int> *lists[], int count) {
+    std::vector<int> found;
+    for (int i = 0; i < count; ++i) {
+        found.insert(found.end(), lists[i]->begin(), lists[i]->end());
+    }
+    std::sort(found.begin(), found.end());
+    found.erase(std::unique(found.begin(), found.end()), found.end());
+    return found;
+}
+
+std::vector<int> AtPoint(Table &table, const QVector &point) {
+    std::vector<int> *lists[Table::POINT_LISTS];
+    return Gather(lists, table.Get(point, lists));
+}
+
+std::vector<int> InBox(Table &table, const LineCollide &box) {
+    std::vector<int> *lists[27 + 1];
+    return Gather(lists, table.Get(&box, lists));
+}
+
+} // namespace
+
+TEST(Hashtable3d, FindsObjectsWhereTheyAre) {
+    Table table;
+    LineCollide near = Box(10, 10, 10, 5);
+    LineCollide far = Box(1e9, -1e9, 3e8, 5);
+    table.Put(&near, 1);
+    table.Put(&far, 2);
+    EXPECT_EQ(std::vector<int>{1}, AtPoint(table, QVector(12, 12, 12)));
+    EXPECT_EQ(std::vector<int>{2}, AtPoint(table, QVector(1e9 + 1, -1e9 + 1, 3e8 + 1)));
+    EXPECT_TRUE(AtPoint(table, QVector(5000, 0, 0)).empty());
+}
+
+TEST(Hashtable3d, DistantObjectsDoNotShareCells) {
+    // The fixed table used to wrap coordinates, so these shared a cell
+    Table table;
+    LineCollide here = Box(50, 50, 50, 1);
+    LineCollide there = Box(50 + 100 * 10, 50, 50, 1);
+    table.Put(&here, 1);
+    table.Put(&there, 2);
+    EXPECT_EQ(std::vector<int>{1}, InBox(table, here));
+    EXPECT_EQ(std::vector<int>{2}, InBox(table, there));
+}
+
+TEST(Hashtable3d, LargeObjectsUseCoarserCells) {
+    Table table;
+    LineCollide big = Box(0, 0, 0, 100 * 50);
+    table.Put(&big, 1);
+    EXPECT_FALSE(big.hhuge);
+    EXPECT_TRUE(table.GetHuge().empty());
+    EXPECT_EQ(std::vector<int>{1}, AtPoint(table, QVector(4000, 10, 2500)));
+    EXPECT_EQ(std::vector<int>{1}, InBox(table, Box(2000, 2000, 2000, 1)));
+    EXPECT_TRUE(AtPoint(table, QVector(-10000, 0, 0)).empty());
+
+    LineCollide galaxy = Box(-1e12, -1e12, -1e12, 2e12);
+    table.Put(&galaxy, 2);
+    EXPECT_TRUE(galaxy.hhuge);
+    EXPECT_EQ(std::vector<int>{2}, table.GetHuge());
+    EXPECT_EQ((std::vector<int>{1, 2}), AtPoint(table, QVector(10, 10, 10)));
+}
+
+TEST(Hashtable3d, RemoveLeavesOtherObjects) {
+    Table table;
+    std::vector<LineCollide> boxes;
+    for (int i = 0; i < 20; ++i) {
+        boxes.push_back(Box(i * 7, 0, 0, 150));
+    }
+    for (int i = 0; i < 20; ++i) {
+        table.Put(&boxes[i], i);
+    }
+    for (int i = 0; i < 20; i += 2) {
+        int object = i;
+        EXPECT_TRUE(table.Remove(&boxes[i], object));
+        EXPECT_FALSE(table.Contains(i));
+    }
+    int gone = 4;
+    EXPECT_FALSE(table.Eradicate(gone));
+    std::vector<int> odd;
+    for (int i = 1; i < 20; i += 2) {
+        odd.push_back(i);
+    }
+    EXPECT_EQ(odd, AtPoint(table, QVector(140, 10, 10)));
+    EXPECT_EQ(odd, InBox(table, boxes[0]));
+}
+
+TEST(Hashtable3d, PutTwiceMovesTheObject) {
+    Table table;
+    LineCollide first = Box(0, 0, 0, 1);
+    LineCollide second = Box(5000, 0, 0, 1);
+    table.Put(&first, 1);
+    table.Put(&second, 1);
+    EXPECT_TRUE(AtPoint(table, QVector(0.5, 0.5, 0.5)).empty());
+    EXPECT_EQ(std::vector<int>{1}, AtPoint(table, QVector(5000.5, 0.5, 0.5)));
+    int object = 1;
+    EXPECT_TRUE(table.Eradicate(object));
+    EXPECT_FALSE(table.Eradicate(object));
+}
+
+TEST(Hashtable3d, ClearEmptiesTheTable) {
+    Table table;
+    LineCollide box = Box(0, 0, 0, 1);
+    LineCollide galaxy = Box(-1e12, -1e12, -1e12, 2e12);
+    table.Put(&box, 1);
+    table.Put(&galaxy, 2);
+    table.Clear();
+    EXPECT_FALSE(table.Contains(1));
+    EXPECT_TRUE(table.GetHuge().empty());
+    EXPECT_TRUE(AtPoint(table, QVector(0.5, 0.5, 0.5)).empty());
+}
+
+TEST(Hashtable3d, WideBoxWalksOccupiedCells) {
+    // Spans about 10^12 of the finest cells, of which only two are occupied
+    Table table;
+    LineCollide inside = Box(1e5, -1e5, 3e5, 1);
+    LineCollide outside = Box(5e6, 0, 0, 1);
+    LineCollide wide = Box(-1e6, -1e6, -1e6, 2e6);
+    table.Put(&inside, 1);
+    table.Put(&outside, 2);
+    EXPECT_EQ(std::vector<int>{1}, InBox(table, wide));
+}
+
+TEST(Hashtable3d, GetStopsWhenTheListsAreFull) {
+    Table table;
+    std::vector<LineCollide> boxes;
+    for (int i = 0; i < 40; ++i) {
+        boxes.push_back(Box(i * 1000, 0, 0, 1));
+    }
+    for (int i = 0; i < 40; ++i) {
+        table.Put(&boxes[i], i);
+    }
+    // 40 occupied cells overlap it, but retval only has room for the huge list and 27 more
+    LineCollide all = Box(0, 0, 0, 40000);
+    std::vector<int> *lists[27 + 1];
+    EXPECT_EQ(27 + 1, table.Get(&all, lists));
+}
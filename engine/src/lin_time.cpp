@@ -21,13 +21,35 @@
  */
 
 
+#include <atomic>
+
 #include "vegastrike.h"
 #include "in_kb.h"
 #include "vs_random.h"
 #include "vs_logging.h"
 
 static double firsttime;
-VSRandom vsrandom(time(NULL));
+
+static std::atomic<unsigned int> &RandomMasterSeed() {
+    static std::atomic<unsigned int> seed(static_cast<unsigned int>(time(NULL)));
+    return seed;
+}
+
+void SetRandomMasterSeed(unsigned int seed) {
+    RandomMasterSeed() = seed;
+}
+
+unsigned int GetRandomMasterSeed() {
+    return RandomMasterSeed();
+}
+
+//Threads starting in the same second mustn't share a sequence
+static unsigned int ThreadRandomSeed() {
+    static std::atomic<unsigned int> threads(0);
+    return RandomMasterSeed() + 0x9e3779b9U * threads++;
+}
+
+thread_local VSRandom vsrandom(ThreadRandomSeed());
 
 #ifdef WIN32
 #ifndef NOMINMAX
@@ -51,6 +73,7 @@ static double lasttime;
 #endif
 static double elapsedtime = .1;
 static double timecompression = 1;
+static double fixed_time_step = 0;
 
 double getNewTime() {
 #ifdef _WIN32
@@ -243,6 +266,23 @@ double realTime() {
 
 void UpdateTime() {
     static bool first = true;
+    if (fixed_time_step > 0) {
+#ifdef WIN32
+        dblnewtime += fixed_time_step;
+        if (first) {
+            firsttime = dblnewtime;
+        }
+#else
+        lasttime = newtime;
+        newtime += fixed_time_step;
+        if (first) {
+            firsttime = newtime;
+        }
+#endif
+        elapsedtime = fixed_time_step * timecompression;
+        first = false;
+        return;
+    }
 #ifdef WIN32
     QueryPerformanceCounter( (LARGE_INTEGER*) &newtime );
     elapsedtime = ( (double) (newtime-ttime) )/freq;
@@ -285,6 +325,10 @@ void UpdateTime() {
     first = false;
 }
 
+void setFixedTimeStep(double step) {
+    fixed_time_step = step;
+}
+
 void setNewTime(double newnewtime) {
     firsttime -= newnewtime - queryTime();
     UpdateTime();
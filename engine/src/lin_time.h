@@ -33,6 +33,10 @@ void micro_sleep(unsigned int n);
 double getNewTime();
 void setNewTime(double newnewtime);
 
+//Makes UpdateTime() advance the game clock by exactly step seconds instead of
+//reading the wall clock; 0 goes back to the wall clock. For reproducible runs.
+void setFixedTimeStep(double step);
+
 //Essentially calling UpdateTime();getNewTime() without modifying any state.
 //Always use this except at the beginning of a frame.
 double queryTime();
@@ -27,6 +27,7 @@
 #include <boost/python.hpp>
 #include <Python.h>
 #include "audio/test.h"
+#include "simbench.h"
 #if defined (HAVE_SDL)
 #include <SDL2/SDL.h>
 #endif
@@ -79,6 +80,7 @@
 #endif
 
 #include "vs_logging.h"
+#include "vs_profiler.h"
 #include "options.h"
 #include "version.h"
 #include "vs_exit.h"
@@ -142,6 +144,7 @@ int readCommandLineOptions(int argc, char **argv);
 // FIXME: Code should throw exception instead of calling winsys_exit            // Should it really? - stephengtuggy 2020-10-25
 void VSExit(int code) {
     Music::CleanupMuzak();
+    VegaStrikeProfiler::Shutdown();
     VegaStrikeLogging::vega_logger()->FlushLogs();
     winsys_exit(code);
 }
@@ -151,6 +154,7 @@ void cleanup(void) {
     // stephengtuggy 2020-10-30: Output message both to the console and to the logs
     printf("Thank you for playing!\n");
     VS_LOG(info, "Thank you for playing!");
+    VegaStrikeProfiler::Shutdown();
     VegaStrikeLogging::vega_logger()->FlushLogs();
     if (_Universe != NULL) {
         _Universe->WriteSaveGame(true);
@@ -238,6 +242,8 @@ bool isVista = false;
 
 Unit *TheTopLevelUnit;
 
+#ifndef VEGA_STRIKE_ENGINE_TESTS
+//tests built against the whole client bring their own main()
 int main(int argc, char *argv[]) {
     // Change to program directory if not already
     // std::string program_as_called();
@@ -333,6 +339,18 @@ int main(int argc, char *argv[]) {
     }
 
     VegaStrikeLogging::vega_logger()->InitLoggingPart2(g_game.vsdebug, home_subdir_path);
+    if (configuration()->logging.async_logging) {
+        VegaStrikeLogging::vega_logger()->StartAsyncWriter();
+    }
+
+    if (configuration()->logging.profiler) {
+        std::string trace_file = configuration()->logging.profiler_trace_file;
+        if (!trace_file.empty()) {
+            trace_file = boost::filesystem::absolute(trace_file, home_subdir_path).string();
+        }
+        VegaStrikeProfiler::Configure(configuration()->logging.profiler_report_frames, trace_file);
+        VegaStrikeProfiler::Enable(true);
+    }
 
     // can use the vegastrike config variable to read in the default mission
     if (game_options()->force_client_connect) {
@@ -406,6 +424,7 @@ int main(int argc, char *argv[]) {
     VegaStrikeLogging::vega_logger()->FlushLogs();
     return 0;
 }
+#endif //VEGA_STRIKE_ENGINE_TESTS
 
 static Animation *SplashScreen = NULL;
 static bool BootstrapMyStarSystemLoading = true;
@@ -884,6 +903,10 @@ std::string ParseCommandLine(int argc, char **lpCmdLine) {
 #undef main
 
 int readCommandLineOptions(int argc, char **argv) {
+#ifdef VEGA_STRIKE_SIMBENCH
+    //vegastrike-simbench: the same engine, but never the game loop
+    return RunSimulationBenchmark(argc, argv, mission_name);
+#else
     for (int i = 1; i < argc; ++i) {
         if (argv[i][0] == '-') {
             if (strcmp("--test-audio", argv[i]) == 0) {
@@ -892,4 +915,5 @@ int readCommandLineOptions(int argc, char **argv) {
         }
     }
     return -1;
+#endif
 }
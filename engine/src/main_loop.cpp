@@ -85,6 +85,7 @@
 #ifndef NO_GFX
 #include "gldrv/gl_globals.h"
 #include "vs_exit.h"
+#include "vs_profiler.h"
 #endif
 
 #define KEYDOWN(name, key) (name[key]&0x80)
@@ -1061,4 +1062,5 @@ void main_loop() {
     if (g_game.sound_enabled) {
         Audio::SceneManager::getSingleton()->commit();
     }
+    VegaStrikeProfiler::EndFrame();
 }
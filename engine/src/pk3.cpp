@@ -214,6 +214,9 @@ bool CPK3::CheckPK3(FILE *f) {
     //Go to the beginning of the directory.
     fseek(f, dhOffset - dh.dirSize, SEEK_SET);
 
+    m_index.clear();
+    m_index.reserve(dh.nDirEntries);
+
     //Allocate the data buffer, and read the whole thing.
     m_pDirData = new char[dh.dirSize + dh.nDirEntries * sizeof(*m_papDir)];
     if (!m_pDirData) {
@@ -248,12 +251,15 @@ bool CPK3::CheckPK3(FILE *f) {
                     pfh[j] = '\\';
                 }
             }
+            //The first entry of a name wins, as it did for a linear search
+            m_index.emplace(NormalizeName(pfh, fh.fnameLen), i);
             //Skip name, extra and comment fields.
             pfh += fh.fnameLen + fh.xtraLen + fh.cmntLen;
         }
     }
     if (ret != true) {
         delete[] m_pDirData;
+        m_index.clear();
     } else {
         m_nEntries = dh.nDirEntries;
         this->f = f;
@@ -293,30 +299,28 @@ bool CPK3::ExtractFile(const char *lp_name, const char *new_filename) {
     return false;     //probably file not found
 }
 
-//Compares 2 c-strings but do not take into account '/' or '\'
-int vsstrcmp(const char *lp, const char *str) {
-    unsigned int i, ok = 1;
-    unsigned int len = strlen(lp);
-    for (i = 0; ok && i < len; i++) {
-        if (lp[i] != '/' && lp[i] != '\\' && lp[i] != str[i]) {
-            ok = 0;
+//Lower case with DOS backslashes, so that lookups ignore case and the kind of slash
+std::string CPK3::NormalizeName(const char *name, size_t length) {
+    std::string normalized(name, length);
+    for (char &c : normalized) {
+        if (c == '/') {
+            c = '\\';
+        } else if (c >= 'A' && c <= 'Z') {
+            c = c - 'A' + 'a';
         }
     }
-    return !ok;
+    return normalized;
+}
+
+int CPK3::FindFile(const char *lpname) const {
+    auto entry = m_index.find(NormalizeName(lpname, strlen(lpname)));
+    return entry == m_index.end() ? -1 : entry->second;
 }
 
 int CPK3::FileExists(const char *lpname) {
-    char str[PK3LENGTH];
-    int idx = -1;
-
-    memset(&str, 0, sizeof(str));
-    for (int i = 0; idx == -1 && i < m_nEntries; i++) {
-        GetFilename(i, str);
-        int result = vsstrcmp(lpname, str);
-        if (result == 0) {
-            VS_LOG(info, (boost::format("FOUND IN PK3 FILE : %1% with index=%2%") % lpname % i));
-            idx = i;
-        }
+    int idx = FindFile(lpname);
+    if (idx != -1) {
+        VS_LOG(info, (boost::format("FOUND IN PK3 FILE : %1% with index=%2%") % lpname % idx));
     }
     //if the file isn't in the archive idx=-1
     return idx;
@@ -343,18 +347,9 @@ char *CPK3::ExtractFile(int index, int *file_size) {
 }
 
 char *CPK3::ExtractFile(const char *lpname, int *file_size) {
-    char str[PK3LENGTH];
-    int index = -1;
+    int index = FindFile(lpname);
     char *buffer;
 
-    memset(&str, 0, sizeof(str));
-    for (int i = 0; index == -1 && i < m_nEntries; i++) {
-        GetFilename(i, str);
-        int result = vsstrcmp(lpname, str);
-        if (result == 0) {
-            index = i;
-        }
-    }
     //if the file isn't in the archive
     if (index == -1) {
         return (NULL);
@@ -377,10 +372,34 @@ char *CPK3::ExtractFile(const char *lpname, int *file_size) {
     return buffer;
 }
 
+const char *CPK3::MapFile(int index, int *file_size) {
+    TZipLocalHeader h;
+    const char *data = GetMappedData(index, h);
+    if (data == NULL || h.compression != TZipLocalHeader::COMP_STORE) {
+        return NULL;
+    }
+    *file_size = h.cSize;
+    return data;
+}
+
+const char *CPK3::MapFile(const char *lpname, int *file_size) {
+    int index = FindFile(lpname);
+    //if the file isn't in the archive
+    if (index == -1) {
+        return NULL;
+    }
+    return MapFile(index, file_size);
+}
+
 bool CPK3::Close() {
+    VSFileSystem::UnmapFile(m_pMapped, m_nMappedSize);
+    m_pMapped = NULL;
+    m_nMappedSize = 0;
+    m_bMapFailed = false;
     fclose(f);
     delete[] m_pDirData;
     m_nEntries = 0;
+    m_index.clear();
 
     return true;
 }
@@ -411,6 +430,39 @@ int CPK3::GetFileLen(int i) const {
     }
 }
 
+//Reads the local header of entry i from the mapped archive into h and returns its data, which lies entirely
+//inside the mapping, or NULL if the archive can't be mapped or the entry is damaged
+const char *CPK3::GetMappedData(int i, TZipLocalHeader &h) {
+    if (i < 0 || i >= m_nEntries) {
+        return NULL;
+    }
+    if (m_pMapped == NULL) {
+        if (m_bMapFailed) {
+            return NULL;
+        }
+        m_pMapped = VSFileSystem::MapFile(this->f, m_nMappedSize);
+        if (m_pMapped == NULL) {
+            m_bMapFailed = true;
+            return NULL;
+        }
+    }
+    size_t hdrOffset = m_papDir[i]->hdrOffset;
+    if (hdrOffset > m_nMappedSize || m_nMappedSize - hdrOffset < sizeof(h)) {
+        return NULL;
+    }
+    //The header may be unaligned in the mapping
+    memcpy(&h, m_pMapped + hdrOffset, sizeof(h));
+    h.correctByteOrder();
+    if (h.sig != TZipLocalHeader::SIGNATURE) {
+        return NULL;
+    }
+    size_t dataOffset = hdrOffset + sizeof(h) + h.fnameLen + h.xtraLen;
+    if (dataOffset > m_nMappedSize || m_nMappedSize - dataOffset < h.cSize) {
+        return NULL;
+    }
+    return m_pMapped + dataOffset;
+}
+
 bool CPK3::ReadFile(int i, void *pBuf) {
     if (pBuf == nullptr) {
         VS_LOG(error, "PK3ERROR :  pBuf is NULL !!!");
@@ -423,25 +475,34 @@ bool CPK3::ReadFile(int i, void *pBuf) {
         return false;
     }
 
-    //Quick'n dirty read, the whole file at once.
-    //Ungood if the ZIP has huge files inside
-
-    //Go to the actual file and read the local header.
-    fseek(this->f, m_papDir[i]->hdrOffset, SEEK_SET);
     TZipLocalHeader h;
-
-    memset(&h, 0, sizeof(h));
-    bogus_sizet = fread(&h, sizeof(h), 1, this->f);
-    h.correctByteOrder();
-    if (h.sig != TZipLocalHeader::SIGNATURE) {
-        VS_LOG(error, "PK3ERROR - BAD LOCAL HEADER SIGNATURE !!!");
-        return false;
+    //Inflate (or copy) straight from the mapped archive when possible
+    const char *pcSource = GetMappedData(i, h);
+    char *pcData = NULL;
+    if (pcSource == NULL) {
+        //Quick'n dirty read, the whole file at once.
+        //Ungood if the ZIP has huge files inside
+
+        //Go to the actual file and read the local header.
+        fseek(this->f, m_papDir[i]->hdrOffset, SEEK_SET);
+
+        memset(&h, 0, sizeof(h));
+        bogus_sizet = fread(&h, sizeof(h), 1, this->f);
+        h.correctByteOrder();
+        if (h.sig != TZipLocalHeader::SIGNATURE) {
+            VS_LOG(error, "PK3ERROR - BAD LOCAL HEADER SIGNATURE !!!");
+            return false;
+        }
+        //Skip extra fields
+        fseek(this->f, h.fnameLen + h.xtraLen, SEEK_CUR);
     }
-    //Skip extra fields
-    fseek(this->f, h.fnameLen + h.xtraLen, SEEK_CUR);
     if (h.compression == TZipLocalHeader::COMP_STORE) {
         //Simply read in raw stored data.
-        bogus_sizet = fread(pBuf, h.cSize, 1, this->f);
+        if (pcSource != NULL) {
+            memcpy(pBuf, pcSource, h.cSize);
+        } else {
+            bogus_sizet = fread(pBuf, h.cSize, 1, this->f);
+        }
         return true;
     } else if (h.compression != TZipLocalHeader::COMP_DEFLAT) {
         VS_LOG(error,
@@ -449,14 +510,17 @@ bool CPK3::ReadFile(int i, void *pBuf) {
                         % TZipLocalHeader::COMP_DEFLAT));
         return false;
     }
-    //Alloc compressed data buffer and read the whole stream
-    char *pcData = new char[h.cSize];
-    if (!pcData) {
-        VS_LOG(error, "PK3ERROR : Could not allocate memory buffer for decompression");
-        return false;
+    if (pcSource == NULL) {
+        //Alloc compressed data buffer and read the whole stream
+        pcData = new char[h.cSize];
+        if (!pcData) {
+            VS_LOG(error, "PK3ERROR : Could not allocate memory buffer for decompression");
+            return false;
+        }
+        memset(pcData, 0, h.cSize);
+        bogus_sizet = fread(pcData, h.cSize, 1, this->f);
+        pcSource = pcData;
     }
-    memset(pcData, 0, h.cSize);
-    bogus_sizet = fread(pcData, h.cSize, 1, this->f);
 
     bool ret = true;
 
@@ -464,7 +528,7 @@ bool CPK3::ReadFile(int i, void *pBuf) {
     z_stream stream;
     int err, err2;
 
-    stream.next_in = (Bytef *) pcData;
+    stream.next_in = (Bytef *) pcSource;
     stream.avail_in = (uInt) h.cSize;
     stream.next_out = (Bytef *) pBuf;
     stream.avail_out = h.ucSize;
@@ -486,9 +550,6 @@ bool CPK3::ReadFile(int i, void *pBuf) {
         err2 = inflateEnd(&stream);
         if (err2 == Z_STREAM_ERROR)
             VS_LOG(error, "PK3ERROR : Bad parameter, stream error");
-        err2 = inflateEnd(&stream);
-        if (err2 == Z_STREAM_ERROR)
-            VS_LOG(error, "PK3ERROR : Bad parameter, stream error");
     } else {
         if (err == Z_STREAM_ERROR)
             VS_LOG(error, "PK3ERROR : Bad parameter, stream error");
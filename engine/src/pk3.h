@@ -41,6 +41,8 @@
 #include <stdio.h>
 #include <string.h>
 #include <zlib.h>
+#include <string>
+#include <unordered_map>
 
 #define PK3LENGTH 512
 
@@ -57,8 +59,19 @@ private:
 
 //Pointers to the dir entries in pDirData.
     const TZipDirFileHeader **m_papDir;
+    //Normalized name (see NormalizeName) to index, built when the archive is opened
+    std::unordered_map<std::string, int> m_index;
+
+    //The whole archive mapped read only, mapped on first use
+    const char *m_pMapped{nullptr};
+    size_t m_nMappedSize{0};
+    bool m_bMapFailed{false};
+
+    static std::string NormalizeName(const char *name, size_t length);
+    int FindFile(const char *lpname) const;
     void GetFilename(int i, char *pszDest) const;
     int GetFileLen(int i) const;
+    const char *GetMappedData(int i, TZipLocalHeader &h);
     bool ReadFile(int i, void *pBuf);
 
 public:
@@ -77,6 +90,10 @@ public:
     bool ExtractFile(const char *lp_name, const char *new_filename);
     char *ExtractFile(int index, int *file_size);
     char *ExtractFile(const char *lpname, int *file_size);
+    //Returns the data of a file stored uncompressed, in place in the mapped archive, or NULL if it is compressed
+    //(and has to be extracted) or can't be found. It stays valid until the archive is closed
+    const char *MapFile(int index, int *file_size);
+    const char *MapFile(const char *lpname, int *file_size);
     int FileExists(const char *lpname);                                       //Checks if a file exists and returns index or -1 if not found
     bool Close(void);
 
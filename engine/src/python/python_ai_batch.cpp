@@ -0,0 +1,310 @@
+/*
+ * python_ai_batch.cpp
+ *
+ * Copyright (C) 2023 Vega Strike contributors.
+ *
+ * https://github.com/vegastrike/Vega-Strike-Engine-Source
+ *
+ * This file is part of Vega Strike.
+ *
+ * Vega Strike is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Vega Strike is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Vega Strike. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "python/python_ai_batch.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+
+#include "cmd/collide_map.h"
+#include "cmd/container.h"
+#include "cmd/unit_generic.h"
+#include "python/python_compile.h"
+#include "vs_logging.h"
+#include "vs_profiler.h"
+
+namespace PythonAIBatch {
+
+namespace {
+
+struct Entry {
+    PyObject *ai{nullptr};
+    //chosen by the last batch, until the AI takes it
+    UnitContainer target;
+    bool has_target{false};
+};
+
+//Star systems may run on several threads. Lock the GIL first when taking both.
+std::mutex registry_mutex;
+std::unordered_map<Unit *, Entry> registry;
+
+struct Row {
+    Unit *unit;
+    PyObject *ai;
+};
+
+//What the views show; kept from atom to atom so that they rarely allocate
+struct Buffers {
+    std::vector<Row> rows;
+    //The units that may be targeted, in the rows after those of the AIs
+    std::vector<Unit *> candidates;
+    std::vector<Unit *> found;
+    std::vector<double> positions;
+    std::vector<float> velocities;
+    std::vector<int32_t> factions;
+    std::vector<int32_t> targets;
+    std::vector<int32_t> order_targets;
+    std::unordered_map<const Unit *, int32_t> row_of;
+};
+
+void Gather(Unit *unit, std::vector<Row> &rows) {
+    std::unordered_map<Unit *, Entry>::const_iterator found = registry.find(unit);
+    if (found != registry.end()) {
+        rows.push_back(Row{unit, found->second.ai});
+    }
+    if (!unit->SubUnits.empty()) {
+        un_iter iter = unit->getSubUnits();
+        Unit *subunit;
+        while ((subunit = *iter)) {
+            Gather(subunit, rows);
+            ++iter;
+        }
+    }
+}
+
+//A memoryview of rows x columns items of the given format, or NULL with a Python error set
+PyObject *View(void *data, size_t item_size, const char *format, Py_ssize_t rows, Py_ssize_t columns, int flags) {
+    PyObject *bytes = PyMemoryView_FromMemory(static_cast<char *>(data), item_size * rows * columns, flags);
+    if (bytes == nullptr) {
+        return nullptr;
+    }
+    PyObject *view = columns > 1
+            ? PyObject_CallMethod(bytes, "cast", "s(nn)", format, rows, columns)
+            : PyObject_CallMethod(bytes, "cast", "s", format);
+    Py_DECREF(bytes);
+    return view;
+}
+
+bool AddView(PyObject *dict, const char *name, PyObject *view) {
+    if (view == nullptr) {
+        return false;
+    }
+    PyDict_SetItemString(dict, name, view);
+    Py_DECREF(view);
+    return true;
+}
+
+//Keeps the buffers from being read after the call, and complains if they still can be
+void ReleaseViews(PyObject *dict) {
+    PyObject *name;
+    PyObject *view;
+    Py_ssize_t position = 0;
+    while (PyDict_Next(dict, &position, &name, &view)) {
+        PyObject *result = PyObject_CallMethod(view, "release", nullptr);
+        if (result == nullptr) {
+            VS_LOG(error, (boost::format("PythonAIBatch: ExecuteBatch kept a buffer of %1% past the call")
+                    % PyUnicode_AsUTF8(name)));
+            PyErr_Clear();
+        } else {
+            Py_DECREF(result);
+        }
+    }
+}
+
+void PrintPythonError(const char *what) {
+    VS_LOG_AND_FLUSH(error, (boost::format("PythonAIBatch: Python error in %1%") % what));
+    PyErr_Print();
+    PyErr_Clear();
+    VegaStrikeLogging::vega_logger()->FlushLogs();
+}
+
+} //namespace
+
+bool Register(Unit *unit, PyObject *ai) {
+    PythonGILLock python_lock;
+    if (!PyObject_HasAttrString(reinterpret_cast<PyObject *>(Py_TYPE(ai)), "ExecuteBatch")) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    Entry &entry = registry[unit];
+    entry.ai = ai;
+    entry.target.SetUnit(nullptr);
+    entry.has_target = false;
+    return true;
+}
+
+void Unregister(Unit *unit, PyObject *ai) {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    std::unordered_map<Unit *, Entry>::iterator found = registry.find(unit);
+    if (found != registry.end() && found->second.ai == ai) {
+        registry.erase(found);
+    }
+}
+
+void ApplyOrders(Unit *unit) {
+    Unit *target = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        std::unordered_map<Unit *, Entry>::iterator found = registry.find(unit);
+        if (found == registry.end() || !found->second.has_target) {
+            return;
+        }
+        found->second.has_target = false;
+        target = found->second.target.GetUnit();
+    }
+    if (target) {
+        unit->Target(target);
+    }
+}
+
+void Run(const std::vector<Unit *> &units, const CollideArray &unit_map) {
+    static thread_local Buffers buffers;
+    std::vector<Row> &rows = buffers.rows;
+    std::vector<Unit *> &candidates = buffers.candidates;
+    rows.clear();
+    candidates.clear();
+    {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        if (registry.empty()) {
+            return;
+        }
+        for (Unit *unit : units) {
+            if (!unit->Killed()) {
+                Gather(unit, rows);
+            }
+        }
+    }
+    if (rows.empty()) {
+        return;
+    }
+    VS_PROFILE_ZONE("PythonAIBatch");
+    //What is within radar range of the AIs, and what they target already, before the GIL is taken
+    for (const Row &row : rows) {
+        buffers.found.clear();
+        unit_map.QueryUnits(row.unit->Position(), row.unit->GetComputerData().radar.maxrange, buffers.found);
+        candidates.insert(candidates.end(), buffers.found.begin(), buffers.found.end());
+        Unit *target = row.unit->Target();
+        if (target) {
+            candidates.push_back(target);
+        }
+    }
+    PythonGILLock python_lock;
+    PyObject *ais;
+    {
+        //Drops the AIs that went away before the GIL was ours; the tuple keeps the others
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        rows.erase(std::remove_if(rows.begin(), rows.end(), [](const Row &row) {
+            std::unordered_map<Unit *, Entry>::const_iterator found = registry.find(row.unit);
+            return found == registry.end() || found->second.ai != row.ai;
+        }), rows.end());
+        //The rows of a class next to each other, so that each class is called once
+        std::stable_sort(rows.begin(), rows.end(), [](const Row &a, const Row &b) {
+            return std::less<PyTypeObject *>()(Py_TYPE(a.ai), Py_TYPE(b.ai));
+        });
+        ais = PyTuple_New(rows.size());
+        for (size_t i = 0; i < rows.size(); ++i) {
+            Py_INCREF(rows[i].ai);
+            PyTuple_SET_ITEM(ais, i, rows[i].ai);
+        }
+    }
+    const Py_ssize_t count = rows.size();
+    if (count == 0) {
+        Py_DECREF(ais);
+        return;
+    }
+
+    buffers.row_of.clear();
+    for (Py_ssize_t i = 0; i < count; ++i) {
+        buffers.row_of[rows[i].unit] = i;
+    }
+    //Each candidate once, and none that is an AI row already
+    candidates.erase(std::remove_if(candidates.begin(), candidates.end(), [&buffers](Unit *candidate) {
+        return candidate->Killed()
+                || !buffers.row_of.emplace(candidate, buffers.row_of.size()).second;
+    }), candidates.end());
+    const Py_ssize_t total = count + candidates.size();
+
+    buffers.positions.resize(3 * total);
+    buffers.velocities.resize(3 * total);
+    buffers.factions.resize(total);
+    buffers.targets.resize(total);
+    buffers.order_targets.assign(count, -1);
+    for (Py_ssize_t i = 0; i < total; ++i) {
+        const Unit *unit = i < count ? rows[i].unit : candidates[i - count];
+        const QVector position = unit->Position();
+        const Vector &velocity = unit->GetVelocity();
+        buffers.positions[3 * i] = position.i;
+        buffers.positions[3 * i + 1] = position.j;
+        buffers.positions[3 * i + 2] = position.k;
+        buffers.velocities[3 * i] = velocity.i;
+        buffers.velocities[3 * i + 1] = velocity.j;
+        buffers.velocities[3 * i + 2] = velocity.k;
+        buffers.factions[i] = unit->faction;
+        std::unordered_map<const Unit *, int32_t>::const_iterator target = buffers.row_of.find(unit->Target());
+        buffers.targets[i] = target == buffers.row_of.end() ? -1 : target->second;
+    }
+
+    PyObject *state = PyDict_New();
+    PyObject *orders = PyDict_New();
+    const bool viewed =
+            AddView(state, "positions", View(&buffers.positions[0], sizeof(double), "d", total, 3, PyBUF_READ))
+            && AddView(state, "velocities", View(&buffers.velocities[0], sizeof(float), "f", total, 3, PyBUF_READ))
+            && AddView(state, "factions", View(&buffers.factions[0], sizeof(int32_t), "i", total, 1, PyBUF_READ))
+            && AddView(state, "targets", View(&buffers.targets[0], sizeof(int32_t), "i", total, 1, PyBUF_READ))
+            && AddView(orders, "targets",
+                    View(&buffers.order_targets[0], sizeof(int32_t), "i", count, 1, PyBUF_WRITE));
+    if (!viewed) {
+        PrintPythonError("the unit state views");
+    } else {
+        Py_ssize_t first = 0;
+        while (first < count) {
+            PyTypeObject *type = Py_TYPE(rows[first].ai);
+            Py_ssize_t end = first + 1;
+            while (end < count && Py_TYPE(rows[end].ai) == type) {
+                ++end;
+            }
+            PyObject *result = PyObject_CallMethod(reinterpret_cast<PyObject *>(type), "ExecuteBatch", "OOOnn",
+                    ais, state, orders, first, end - first);
+            if (result == nullptr) {
+                PrintPythonError(type->tp_name);
+            } else {
+                Py_DECREF(result);
+            }
+            first = end;
+        }
+    }
+    ReleaseViews(state);
+    ReleaseViews(orders);
+    Py_DECREF(state);
+    Py_DECREF(orders);
+    Py_DECREF(ais);
+
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    for (Py_ssize_t i = 0; i < count; ++i) {
+        const int32_t target = buffers.order_targets[i];
+        if (target < 0 || target >= total) {
+            continue;
+        }
+        Unit *unit = target < count ? rows[target].unit : candidates[target - count];
+        std::unordered_map<Unit *, Entry>::iterator found = registry.find(rows[i].unit);
+        if (found != registry.end() && found->second.ai == rows[i].ai && !unit->Killed()) {
+            found->second.target.SetUnit(unit);
+            found->second.has_target = true;
+        }
+    }
+}
+
+} //namespace PythonAIBatch
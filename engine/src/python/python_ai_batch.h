@@ -0,0 +1,84 @@
+/*
+ * python_ai_batch.h
+ *
+ * Copyright (C) 2023 Vega Strike contributors.
+ *
+ * https://github.com/vegastrike/Vega-Strike-Engine-Source
+ *
+ * This file is part of Vega Strike.
+ *
+ * Vega Strike is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Vega Strike is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Vega Strike. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef VEGA_STRIKE_ENGINE_PYTHON_PYTHON_AI_BATCH_H
+#define VEGA_STRIKE_ENGINE_PYTHON_PYTHON_AI_BATCH_H
+
+//Python.h sets and uses it
+#ifdef _POSIX_C_SOURCE
+#undef _POSIX_C_SOURCE
+#endif //_POSIX_C_SOURCE
+
+#include <Python.h>
+#include <vector>
+
+class CollideArray;
+class Unit;
+
+/**
+ * Runs the Python AI of many units with one call into Python per atom.
+ *
+ * A Python AI class opts in by defining a static or class method
+ *
+ *     ExecuteBatch(ais, state, orders, first, count)
+ *
+ * Its instances then no longer get Execute() called for each unit. Instead,
+ * once per atom and star system, ExecuteBatch() is called once for each such
+ * class. It gets:
+ * - ais: the AI objects of the system, one per row, first;
+ * - state: a dict of memoryviews with a row for each AI, then one for each
+ *   unit it may target: those within its radar range, and its current target.
+ *   "positions" (rows x 3 doubles), "velocities" (rows x 3 floats),
+ *   "factions" (ints) and "targets" (the row of the current target, or -1);
+ * - orders: a dict with the writable memoryview "targets", with a row for
+ *   each AI, filled with -1. Set to a row of state to target that unit;
+ *   -1 leaves the target alone;
+ * - first, count: the rows that are AIs of the class.
+ * The views are copies made for the atom, which numpy.frombuffer() and the
+ * like can read without copying again. Writing to state changes nothing.
+ * They are released when the call returns, so they mustn't be kept. The
+ * unit then flies as FireAt would, at its target.
+ */
+namespace PythonAIBatch {
+
+/**
+ * Called when a Python AI gets its unit.
+ * @return whether the class of ai runs in batches
+ */
+bool Register(Unit *unit, PyObject *ai);
+
+/// Called when a Python AI goes away
+void Unregister(Unit *unit, PyObject *ai);
+
+/// Gives the unit what the last batch ordered for it, once
+void ApplyOrders(Unit *unit);
+
+/**
+ * Runs the batched AI of the units, and of their subunits, once for each class.
+ * @param unit_map the collide map of their star system holding units, in
+ * which the units each AI may target are looked up
+ */
+void Run(const std::vector<Unit *> &units, const CollideArray &unit_map);
+
+} //namespace PythonAIBatch
+
+#endif //VEGA_STRIKE_ENGINE_PYTHON_PYTHON_AI_BATCH_H
@@ -62,16 +62,18 @@
 #endif //PY_VERSION_HEX < 0x030B0000
 
 #include "python/python_compile.h"
+#include "python/python_ai_batch.h"
 #include "cmd/ai/fire.h"
 #include <memory>
 #include "init.h"
 #include "vs_logging.h"
 #include "vega_py_run.h"
 
+//The temporary lock lives until the end of the full expression
 #define PYTHONCALLBACK(rtype, ptr, str) \
-  boost::python::call_method<rtype>(ptr, str)
+  (PythonGILLock(), boost::python::call_method<rtype>(ptr, str))
 #define PYTHONCALLBACK2(rtype, ptr, str, str2) \
-  boost::python::call_method<rtype>(ptr, str, str2)
+  (PythonGILLock(), boost::python::call_method<rtype>(ptr, str, str2))
 
 /*
 These following #defines will create a module for python
@@ -179,6 +181,7 @@ protected:
     PyObject *self;
 
     virtual void Destructor() {
+        PythonGILLock python_lock;
         Py_XDECREF(self);
     }
 
@@ -202,11 +205,13 @@ public:
     }
 
     static PythonClass *Factory(const std::string &file) {
+        PythonGILLock python_lock;
         CompileRunPython(file);
         return LastPythonClass();
     }
 
     static PythonClass *FactoryString(char *code) {
+        PythonGILLock python_lock;
         Python::reseterrors();
         VegaPyRunString(code);
         Python::reseterrors();
@@ -220,11 +225,27 @@ public:
 
 template<class SuperClass>
 class PythonAI : public PythonClass<SuperClass> {
+protected:
+    //The class has ExecuteBatch, see python_ai_batch.h
+    bool batched{false};
+
+    virtual void Destructor() {
+        if (batched) {
+            PythonAIBatch::Unregister(this->parent, this->self);
+        }
+        PythonClass<SuperClass>::Destructor();
+    }
+
 public:
     PythonAI(PyObject *self_) : PythonClass<SuperClass>(self_) {
     }
 
     virtual void Execute() {
+        if (batched) {
+            PythonAIBatch::ApplyOrders(this->parent);
+            SuperClass::Execute();
+            return;
+        }
         PYTHONCALLBACK(void, this->self, "Execute");
     }
 
@@ -233,8 +254,12 @@ public:
     }
 
     virtual void SetParent(Unit *parent) {
+        if (batched) {
+            PythonAIBatch::Unregister(this->parent, this->self);
+        }
         SuperClass::SetParent(parent);
         PYTHONCALLBACK2(void, this->self, "init", parent);
+        batched = PythonAIBatch::Register(parent, this->self);
     }
 
     static void default_Execute(SuperClass &self_) {
@@ -102,6 +102,7 @@ PyObject *CompilePython(const std::string &name) {
 extern PyObject *PyInit_VS;
 
 void CompileRunPython(const std::string &filename) {
+    PythonGILLock python_lock;
 #if (PY_VERSION_HEX >= 0x030B0000)
     Python::reseterrors();
     InterpretPython(filename);
@@ -36,9 +36,55 @@
 #include "hashtable.h"
 #include <string>
 #include <compile.h>
+#include "vs_profiler.h"
 
 extern Hashtable<std::string, PyObject, 1023> compiled_python;
 
+/**
+ * Holds the GIL for its lifetime. Needed wherever the engine calls into
+ * Python, since unit AI may run on simulation worker threads while the
+ * main thread has released the interpreter. Nests safely.
+ */
+class PythonGILLock {
+public:
+    PythonGILLock() : zone("Python"), state(PyGILState_Ensure()) {
+    }
+
+    ~PythonGILLock() {
+        PyGILState_Release(state);
+    }
+
+    PythonGILLock(const PythonGILLock &) = delete;
+    PythonGILLock &operator=(const PythonGILLock &) = delete;
+
+private:
+    //Counts time waiting for the GIL too
+    VegaStrikeProfiler::Zone zone;
+    PyGILState_STATE state;
+};
+
+/**
+ * Lets other threads take the GIL while the main thread waits on them.
+ * Must be created on a thread that holds the GIL.
+ */
+class PythonGILRelease {
+public:
+    PythonGILRelease() : state(Py_IsInitialized() ? PyEval_SaveThread() : nullptr) {
+    }
+
+    ~PythonGILRelease() {
+        if (state) {
+            PyEval_RestoreThread(state);
+        }
+    }
+
+    PythonGILRelease(const PythonGILRelease &) = delete;
+    PythonGILRelease &operator=(const PythonGILRelease &) = delete;
+
+private:
+    PyThreadState *state;
+};
+
 class PythonBasicType {
 public:
     std::string objects;
@@ -0,0 +1,150 @@
+/*
+ * python_ai_batch_tests.cpp
+ *
+ * Copyright (C) 2023 Vega Strike contributors.
+ *
+ * https://github.com/vegastrike/Vega-Strike-Engine-Source
+ *
+ * This file is part of Vega Strike.
+ *
+ * Vega Strike is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Vega Strike is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Vega Strike. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// A Python AI class with ExecuteBatch runs against real units, without a star system
+
+#include "python/python_ai_batch.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "cmd/collide_map.h"
+#include "cmd/unit_generic.h"
+#include "python/config/python_utils.h"
+#include "universe.h"
+#include "vs_globals.h"
+#include "vsfilesystem.h"
+
+namespace {
+
+// Targets the nearest row of another faction, and counts what it was given
+const char *const kNearestEnemy =
+        "class NearestEnemy(object):\n"
+        "    calls = 0\n"
+        "    rows = 0\n"
+        "    @staticmethod\n"
+        "    def ExecuteBatch(ais, state, orders, first, count):\n"
+        "        NearestEnemy.calls += 1\n"
+        "        positions = state['positions']\n"
+        "        factions = state['factions']\n"
+        "        NearestEnemy.rows = len(factions)\n"
+        "        for row in range(first, first + count):\n"
+        "            best = -1\n"
+        "            best_distance = 0.0\n"
+        "            for other in range(len(factions)):\n"
+        "                if factions[other] == factions[row]:\n"
+        "                    continue\n"
+        "                distance = sum((positions[other, axis] - positions[row, axis]) ** 2 for axis in range(3))\n"
+        "                if best < 0 or distance < best_distance:\n"
+        "                    best, best_distance = other, distance\n"
+        "            orders['targets'][row] = best\n";
+
+class PythonAIBatchTest : public ::testing::Test {
+protected:
+    static void SetUpTestCase() {
+        // Pilots read it, and targeting asks the universe for the active star system
+        if (vs_config == nullptr) {
+            vs_config = createVegaConfig("test_assets/vegastrike.config");
+        }
+        if (_Universe == nullptr) {
+            _Universe = new Universe();
+        }
+        if (!Py_IsInitialized()) {
+            const std::string path = GetPythonPath();
+            Py_SetPath(std::wstring(path.begin(), path.end()).c_str());
+            Py_Initialize();
+        }
+        globals = PyDict_New();
+        PyDict_SetItemString(globals, "__builtins__", PyEval_GetBuiltins());
+        PyObject *result = PyRun_String(kNearestEnemy, Py_file_input, globals, globals);
+        ASSERT_NE(result, nullptr);
+        Py_DECREF(result);
+    }
+
+    static void TearDownTestCase() {
+        Py_CLEAR(globals);
+    }
+
+    Unit *MakeUnit(int faction, double x, double radius) {
+        Unit *unit = new Unit(0);
+        unit->faction = faction;
+        unit->SetPosition(QVector(x, 0, 0));
+        unit->GetComputerData().radar.maxrange = 1000;
+        Collidable collidable;
+        collidable.SetPosition(unit->Position());
+        collidable.radius = radius;
+        collidable.ref.unit = unit;
+        unit_map.insert(collidable);
+        return unit;
+    }
+
+    long ClassAttribute(const char *name) {
+        PyObject *value = PyObject_GetAttrString(PyDict_GetItemString(globals, "NearestEnemy"), name);
+        const long result = PyLong_AsLong(value);
+        Py_DECREF(value);
+        return result;
+    }
+
+    static PyObject *globals;
+    CollideArray unit_map{Unit::UNIT_ONLY};
+};
+
+PyObject *PythonAIBatchTest::globals = nullptr;
+
+} // namespace
+
+TEST_F(PythonAIBatchTest, TargetsTheNearestCandidate) {
+    Unit *hunter = MakeUnit(1, 0, 10);
+    MakeUnit(1, 50, 10);
+    Unit *near_enemy = MakeUnit(2, 300, 10);
+    MakeUnit(2, -600, 10);
+    // Its centre is out of radar range, but not its surface
+    MakeUnit(2, 1100, 200);
+    // Out of radar range
+    MakeUnit(2, 5000, 10);
+
+    PyObject *ai = PyObject_CallObject(PyDict_GetItemString(globals, "NearestEnemy"), nullptr);
+    ASSERT_NE(ai, nullptr);
+    ASSERT_TRUE(PythonAIBatch::Register(hunter, ai));
+
+    PythonAIBatch::Run(std::vector<Unit *>{hunter}, unit_map);
+    EXPECT_EQ(ClassAttribute("calls"), 1);
+    // The hunter first, then everything its radar reaches
+    EXPECT_EQ(ClassAttribute("rows"), 5);
+
+    PythonAIBatch::ApplyOrders(hunter);
+    EXPECT_EQ(hunter->Target(), near_enemy);
+
+    // Orders are given once: another enemy closing in is left alone until the next batch
+    Unit *closer_enemy = MakeUnit(2, 100, 10);
+    PythonAIBatch::ApplyOrders(hunter);
+    EXPECT_EQ(hunter->Target(), near_enemy);
+    PythonAIBatch::Run(std::vector<Unit *>{hunter}, unit_map);
+    PythonAIBatch::ApplyOrders(hunter);
+    EXPECT_EQ(hunter->Target(), closer_enemy);
+
+    PythonAIBatch::Unregister(hunter, ai);
+    Py_DECREF(ai);
+}
@@ -70,12 +70,13 @@ Manifest::Manifest() {
     _items = std::vector<Cargo>();
 }
 
-Manifest::Manifest(std::string category) {
-    Manifest& mpl = Manifest::MPL();
+Manifest::Manifest(const std::string& category) {
+    const Manifest& mpl = Manifest::MPL();
 
-    auto predicate = [&category](Cargo c) {return c.GetCategory() == category;};
-    std::copy_if(mpl._items.begin(), mpl._items.end(), 
-             std::back_inserter(_items), predicate);
+    for(size_t index : mpl.GetCategoryIndices(category)) {
+        _items.push_back(mpl._items[index]);
+    }
+    _index();
 }
 
 // Called by MPL if it is empty
@@ -119,6 +120,22 @@ Manifest::Manifest(int dummy) {
             _items.push_back(cargo);
         }
     }
+    _index();
+}
+
+void Manifest::_index() {
+    _items_by_name.clear();
+    _items_by_category.clear();
+    _mission_items.clear();
+
+    for(size_t index = 0; index < _items.size(); index++) {
+        const Cargo& cargo = _items[index];
+        _items_by_name.emplace(cargo.name, index);
+        _items_by_category[cargo.GetCategory()].push_back(index);
+        if(cargo.name.find("mission") != std::string::npos) {
+            _mission_items.push_back(index);
+        }
+    }
 }
 
 Manifest& Manifest::MPL() {
@@ -127,28 +144,34 @@ Manifest& Manifest::MPL() {
     return mpl;
 }
 
-Cargo Manifest::GetCargoByName(const std::string name) {
+const Cargo* Manifest::_find(const std::string& name) const {
+    auto found = _items_by_name.find(name);
+    if(found == _items_by_name.end()) {
+        return nullptr;
+    }
+
+    return &_items[found->second];
+}
+
+Cargo Manifest::GetCargoByName(const std::string& name) const {
     const std::string upgrades_suffix = "__upgrades";
-    std::string filename;
+    const Cargo* cargo;
 
     // Check if we need to remove __upgrades suffix
     if(ends_with(name, upgrades_suffix)) {
-        filename = name.substr(0, name.length() - upgrades_suffix.length());
+        cargo = _find(name.substr(0, name.length() - upgrades_suffix.length()));
     } else {
-        filename = name;
+        cargo = _find(name);
     }
 
-
-    for(const Cargo& c : getItems()) {
-        if(c.name == filename) {
-            return c;
-        }
+    if(cargo) {
+        return *cargo;
     }
 
     return Cargo();
 }
 
-Cargo Manifest::GetRandomCargo(int quantity) {
+Cargo Manifest::GetRandomCargo(int quantity) const {
     // TODO: Need to figure a better solution here
     if(_items.empty()) {
         return Cargo();
@@ -160,50 +183,65 @@ Cargo Manifest::GetRandomCargo(int quantity) {
     return c;
 }
 
+Cargo Manifest::_getRandomCargo(const std::vector<size_t>& indices, int quantity) const {
+    int index = randomInt(indices.size()-1);
+    Cargo c = _items[indices[index]];
+    c.SetQuantity(quantity);
+    return c;
+}
 
-
-Cargo Manifest::GetRandomCargoFromCategory(std::string category, int quantity) {
-    Manifest manifest = GetCategoryManifest(category);
+Cargo Manifest::GetRandomCargoFromCategory(const std::string& category, int quantity) const {
+    const std::vector<size_t>& indices = GetCategoryIndices(category);
 
     // If category is empty, return randomly from MPL itself.
-    if(manifest._items.empty()) {
-        manifest = GetMissionManifest();
-        if(manifest._items.empty()) {
+    if(indices.empty()) {
+        if(_mission_items.empty()) {
             return GetRandomCargo(quantity);
         }
+        return _getRandomCargo(_mission_items, quantity);
+    }
+
+    return _getRandomCargo(indices, quantity);
+}
+
+const std::vector<size_t>& Manifest::GetCategoryIndices(const std::string& category) const {
+    static const std::vector<size_t> no_items;
+
+    auto found = _items_by_category.find(category);
+    if(found == _items_by_category.end()) {
+        return no_items;
     }
 
-    return manifest.GetRandomCargo(quantity);
+    return found->second;
 }
 
-Manifest Manifest::GetCategoryManifest(std::string category) {
+Manifest Manifest::GetCategoryManifest(const std::string& category) const {
     Manifest manifest;
 
-    std::copy_if(_items.begin(), _items.end(), back_inserter(manifest._items), 
-            [category](Cargo c) {
-        return c.GetCategory() == category;
-    });
+    for(size_t index : GetCategoryIndices(category)) {
+        manifest._items.push_back(_items[index]);
+    }
+    manifest._index();
 
     return manifest;
 }
 
-Manifest Manifest::GetMissionManifest() {
+Manifest Manifest::GetMissionManifest() const {
     Manifest manifest;
 
-    std::copy_if(_items.begin(), _items.end(), back_inserter(manifest._items), 
-            [](Cargo c) {
-        return c.name.find("mission") != std::string::npos;
-    });
+    for(size_t index : _mission_items) {
+        manifest._items.push_back(_items[index]);
+    }
+    manifest._index();
 
     return manifest;
 }
 
-const std::string Manifest::GetShipDescription(const std::string unit_key) {
-    for(const Cargo& cargo : _items) {
-        if(cargo.name == unit_key) {
-            return cargo.description;
-        }
+const std::string Manifest::GetShipDescription(const std::string& unit_key) const {
+    const Cargo* cargo = _find(unit_key);
+    if(cargo) {
+        return cargo->description;
     }
 
     return "";
-}
\ No newline at end of file
+}
@@ -27,6 +27,7 @@
 
 #include <vector>
 #include <string>
+#include <unordered_map>
 
 #include "cargo.h"
 
@@ -34,27 +35,40 @@
  * A manifest is a list of items in a cargo hold.
  * The master part list is a special, singleton instance holding all items
  * in the game. It is read only (const). Its short is MPL.
+ * Items are indexed by name and category when the manifest is built, so
+ * lookups don't walk or copy the list.
  **/
 class Manifest {
     std::vector<Cargo> _items; 
 
+    // Indices into _items. A name maps to its first item.
+    std::unordered_map<std::string, size_t> _items_by_name;
+    std::unordered_map<std::string, std::vector<size_t>> _items_by_category;
+    std::vector<size_t> _mission_items;
+
     Manifest(int dummy); // Create the MPL singleton.
+    void _index();
+    const Cargo* _find(const std::string& name) const;
+    Cargo _getRandomCargo(const std::vector<size_t>& indices, int quantity) const;
 public:
     Manifest();
-    Manifest(std::string category); // Create a subset of the MPL for a category
+    Manifest(const std::string& category); // Create a subset of the MPL for a category
 
     static Manifest& MPL(); // Get the master part list singleton
-    Cargo GetCargoByName(const std::string name);
-    Cargo GetRandomCargo(int quantity = 0);
-    Cargo GetRandomCargoFromCategory(std::string category, int quantity = 0);
-    Manifest GetCategoryManifest(std::string category);
-    Manifest GetMissionManifest();
+    Cargo GetCargoByName(const std::string& name) const;
+    Cargo GetRandomCargo(int quantity = 0) const;
+    Cargo GetRandomCargoFromCategory(const std::string& category, int quantity = 0) const;
+    Manifest GetCategoryManifest(const std::string& category) const;
+    Manifest GetMissionManifest() const;
+
+    // Positions in getItems() of the items of a category, in list order
+    const std::vector<size_t>& GetCategoryIndices(const std::string& category) const;
 
-    std::vector<Cargo> getItems() { return _items; }
-    bool empty() { return _items.empty(); }
-    int size() { return _items.size(); }
+    const std::vector<Cargo>& getItems() const { return _items; }
+    bool empty() const { return _items.empty(); }
+    int size() const { return _items.size(); }
 
-    const std::string GetShipDescription(const std::string unit_key);
+    const std::string GetShipDescription(const std::string& unit_key) const;
 };
 
 
@@ -24,20 +24,23 @@
 
 #include <random>
 
+// Seeding a Mersenne twister costs far more than drawing from it, so each
+// thread seeds one once
+static std::mt19937 &randomEngine() {
+    static thread_local std::mt19937 rng(std::random_device{}());
+    return rng;
+}
+
 int randomInt(int max, int min = 0 ) {
-    std::random_device dev;
-    std::mt19937 rng(dev());
     std::uniform_int_distribution<std::mt19937::result_type> int_dist(min,max);
 
-    return int_dist(rng); // TODO: test this gets all items
+    return int_dist(randomEngine()); // TODO: test this gets all items
 }
 
 
 double randomDouble() {
     const int precision = 10000;
-    std::random_device dev;
-    std::mt19937 rng(dev());
     std::uniform_int_distribution<std::mt19937::result_type> int_dist(0,precision);
-    int random_int = int_dist(rng);
+    int random_int = int_dist(randomEngine());
     return (double)random_int/precision;
-}
\ No newline at end of file
+}
@@ -0,0 +1,424 @@
+/*
+ * simbench.cpp
+ *
+ * Copyright (C) 2023 Vega Strike contributors.
+ *
+ * https://github.com/vegastrike/Vega-Strike-Engine-Source
+ *
+ * This file is part of Vega Strike.
+ *
+ * Vega Strike is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Vega Strike is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Vega Strike. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "simbench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "cmd/collide_broadphase.h"
+#include "cmd/collide_map.h"
+#include "cmd/script/mission.h"
+#include "cmd/unit_generic.h"
+#include "configxml.h"
+#include "gfx/cockpit_generic.h"
+#include "lin_time.h"
+#include "manifest.h"
+#include "options.h"
+#include "python/init.h"
+#include "star_system.h"
+#include "system_factory.h"
+#include "universe.h"
+#include "universe_util.h"
+#include "vega_py_run.h"
+#include "vs_globals.h"
+#include "vs_logging.h"
+#include "vs_profiler.h"
+#include "vs_random.h"
+
+extern void InitUnitTables();
+extern bool TimeUnitTableLoads(unsigned int repeats, std::string &table, double &parse_seconds, double &load_seconds);
+extern Unit *TheTopLevelUnit;
+
+namespace {
+
+struct Fleet {
+    std::string faction;
+    std::string ship;
+    int count{0};
+    std::string ai;
+};
+
+struct Options {
+    std::string system;
+    unsigned int atoms{1000};
+    unsigned int warmup{100};
+    unsigned int seed{1};
+    //distance of the fleets from the mission origin, in meters
+    double spread{2000};
+    std::vector<Fleet> fleets;
+    std::string trace_file;
+    //run the mission's XML scripts, and the AI modules of the fleets
+    bool scripts{false};
+    //walk the script expressions instead of running them compiled
+    bool interpreted{false};
+    //times loading the unit tables this many times each way, 0 not at all
+    unsigned int unit_tables{0};
+    //times the broadphase indices on queries this far around every unit, 0 not at all
+    double broadphase{0};
+};
+
+const char usage[] =
+        "Options for vegastrike-simbench\n"
+        "\n"
+        " --system=sector/name \t Star system to simulate (default: the mission's)\n"
+        " --atoms=N \t Sim atoms to time (default 1000)\n"
+        " --warmup=N \t Sim atoms to run before timing (default 100)\n"
+        " --seed=S \t Seed of every random number generator (default 1)\n"
+        " --spread=M \t Distance of the fleets from the mission origin (default 2000)\n"
+        " --fleet=faction:ship:count[:ai] \t Fleet to launch; repeat for more\n"
+        " --trace=file.json \t Write a Chrome trace of the timed atoms\n"
+        " --scripts \t Run the mission's XML scripts; an ai of _module runs that module\n"
+        " --interpreted \t With --scripts, interpret the scripts instead of compiling them\n"
+        " --unit-tables=N \t Time parsing the unit table against loading its compiled copy, best of N\n"
+        " --broadphase=M \t Time each broadphase index on queries of M meters around every unit at the end\n"
+        "\n";
+
+//The rest of arg if it starts with name, otherwise nullptr
+const char *OptionValue(const char *arg, const char *name) {
+    const size_t length = strlen(name);
+    return strncmp(arg, name, length) == 0 ? arg + length : nullptr;
+}
+
+bool ParseFleet(const std::string &spec, Fleet &fleet) {
+    std::vector<std::string> fields;
+    std::string::size_type start = 0, colon;
+    while ((colon = spec.find(':', start)) != std::string::npos) {
+        fields.push_back(spec.substr(start, colon - start));
+        start = colon + 1;
+    }
+    fields.push_back(spec.substr(start));
+    if (fields.size() < 3 || fields.size() > 4) {
+        return false;
+    }
+    fleet.faction = fields[0];
+    fleet.ship = fields[1];
+    fleet.count = atoi(fields[2].c_str());
+    fleet.ai = fields.size() > 3 ? fields[3] : "default";
+    return !fleet.faction.empty() && !fleet.ship.empty() && fleet.count > 0;
+}
+
+bool ParseOptions(int argc, char **argv, Options &options) {
+    for (int i = 1; i < argc; ++i) {
+        const char *value;
+        if ((value = OptionValue(argv[i], "--system="))) {
+            options.system = value;
+        } else if ((value = OptionValue(argv[i], "--atoms="))) {
+            options.atoms = strtoul(value, nullptr, 10);
+        } else if ((value = OptionValue(argv[i], "--warmup="))) {
+            options.warmup = strtoul(value, nullptr, 10);
+        } else if ((value = OptionValue(argv[i], "--seed="))) {
+            options.seed = strtoul(value, nullptr, 10);
+        } else if ((value = OptionValue(argv[i], "--spread="))) {
+            options.spread = atof(value);
+        } else if ((value = OptionValue(argv[i], "--unit-tables="))) {
+            options.unit_tables = strtoul(value, nullptr, 10);
+        } else if ((value = OptionValue(argv[i], "--broadphase="))) {
+            options.broadphase = atof(value);
+        } else if ((value = OptionValue(argv[i], "--trace="))) {
+            options.trace_file = value;
+        } else if ((value = OptionValue(argv[i], "--fleet="))) {
+            Fleet fleet;
+            if (!ParseFleet(value, fleet)) {
+                fprintf(stderr, "Bad fleet %s, expected faction:ship:count[:ai]\n", value);
+                return false;
+            }
+            options.fleets.push_back(fleet);
+        } else if (strcmp(argv[i], "--scripts") == 0) {
+            options.scripts = true;
+        } else if (strcmp(argv[i], "--interpreted") == 0) {
+            options.interpreted = true;
+        } else if (strcmp(argv[i], "--help") == 0) {
+            //ParseCommandLine() already printed the engine's own options
+            fputs(usage, stdout);
+            return false;
+        }
+        //anything else is an engine option, e.g. the data directory
+    }
+    if (options.atoms == 0) {
+        fprintf(stderr, "Nothing to do with --atoms=0\n");
+        return false;
+    }
+    for (const Fleet &fleet : options.fleets) {
+        if (!options.scripts && fleet.ai[0] == '_') {
+            fprintf(stderr, "The ai %s is a mission script module, which needs --scripts\n", fleet.ai.c_str());
+            return false;
+        }
+    }
+    if (options.fleets.empty()) {
+        Fleet fleet;
+        fleet.count = 8;
+        fleet.ai = "default";
+        fleet.faction = "confed";
+        fleet.ship = "Robin";
+        options.fleets.push_back(fleet);
+        fleet.faction = "aera";
+        fleet.ship = "Kahan";
+        options.fleets.push_back(fleet);
+    }
+    return true;
+}
+
+//The loaders already know how to do without textures, animations and sounds.
+//Nothing creates a window or GL context: the GL extension entry points stay
+//null, which the driver checks for, and core GL calls without a current
+//context do nothing. AUDInit() is never called.
+void DisableGraphicsAndSound() {
+    g_game.use_textures = 0;
+    g_game.use_animations = 0;
+    g_game.use_videos = 0;
+    g_game.use_sprites = 0;
+    g_game.use_logos = 0;
+    g_game.use_ship_textures = 0;
+    g_game.use_planet_textures = 0;
+    g_game.sound_enabled = 0;
+    game_options()->Sound = false;
+    game_options()->Music = false;
+}
+
+void SeedRandomNumbers(unsigned int seed) {
+    srand(seed);
+    SetRandomMasterSeed(seed);
+    //the unit stages draw from their star system's generator, the rest from the main thread's
+    vsrandom.init_genrand(seed);
+#ifdef HAVE_PYTHON
+    VegaPyRunString("import random\nrandom.seed(" + std::to_string(seed) + ")\n");
+#endif
+}
+
+//Spaces the fleets evenly on a circle around the origin, jittered by the seed
+void LaunchFleets(const Options &options, StarSystem *system, const QVector &origin) {
+    VSRandom random(options.seed);
+    _Universe->pushActiveStarSystem(system);
+    for (size_t i = 0; i < options.fleets.size(); ++i) {
+        const Fleet &fleet = options.fleets[i];
+        const double angle = 2 * M_PI * i / options.fleets.size();
+        QVector position = origin + QVector(cos(angle), 0, sin(angle)) * options.spread
+                + QVector(random.uniformInc(-1, 1), random.uniformInc(-1, 1), random.uniformInc(-1, 1))
+                        * (options.spread / 10);
+        position = UniverseUtil::SafeStarSystemEntrancePoint(system, position);
+        UniverseUtil::launch(fleet.faction + std::to_string(i), fleet.ship, fleet.faction, "unit", fleet.ai,
+                fleet.count, 1, position, "");
+        VS_LOG(info, (boost::format("simbench: launched %1% %2% of %3% at %4% %5% %6%")
+                % fleet.count % fleet.ship % fleet.faction % position.i % position.j % position.k));
+    }
+    _Universe->popActiveStarSystem();
+}
+
+//FNV-1a over the bytes of every value added, so only bit-identical states hash alike
+class StateHash {
+public:
+    template<typename T>
+    void Add(const T &value) {
+        const unsigned char *bytes = reinterpret_cast<const unsigned char *>(&value);
+        for (size_t i = 0; i < sizeof(T); ++i) {
+            hash = (hash ^ bytes[i]) * 1099511628211ULL;
+        }
+    }
+
+    uint64_t Value() const {
+        return hash;
+    }
+
+private:
+    uint64_t hash{14695981039346656037ULL};
+};
+
+uint64_t HashUnits(StarSystem *system, unsigned int &units) {
+    StateHash hash;
+    units = 0;
+    for (un_iter iter = system->getUnitList().createIterator(); !iter.isDone(); ++iter) {
+        const Unit *unit = *iter;
+        const QVector position = unit->Position();
+        const Vector &velocity = unit->GetVelocity();
+        hash.Add(unit->faction);
+        hash.Add(position.i);
+        hash.Add(position.j);
+        hash.Add(position.k);
+        hash.Add(velocity.i);
+        hash.Add(velocity.j);
+        hash.Add(velocity.k);
+        hash.Add(unit->GetHull());
+        ++units;
+    }
+    hash.Add(units);
+    return hash.Value();
+}
+
+//Microseconds per query of distance around each unit of the map, with the given broadphase index
+double MicrosecondsPerQuery(const char *kind, const CollideArray &units, double distance) {
+    std::unique_ptr<CollideBroadphase> broadphase = CollideBroadphase::Create(kind);
+    const std::vector<Collidable> &collidables = units.sorted;
+    broadphase->Build(collidables.data(), collidables.data() + collidables.size());
+    std::vector<size_t> found;
+    const auto start = std::chrono::steady_clock::now();
+    for (const Collidable &around : collidables) {
+        found.clear();
+        broadphase->Query(around.GetPosition(), distance, found);
+    }
+    const std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+    return collidables.empty() ? 0 : elapsed.count() / collidables.size();
+}
+
+void PrintStages(unsigned int atoms) {
+    printf("%-28s %8s %10s %10s %9s %9s %9s\n",
+            "stage", "calls", "total ms", "ms/atom", "p50 ms", "p99 ms", "max ms");
+    for (const VegaStrikeProfiler::StageStats &stage : VegaStrikeProfiler::GetStageStats()) {
+        printf("%-28s %8llu %10.3f %10.4f %9.4f %9.4f %9.4f\n",
+                stage.name.c_str(), (unsigned long long) stage.count, stage.total_ns / 1e6,
+                stage.total_ns / 1e6 / atoms, stage.p50_ns / 1e6, stage.p99_ns / 1e6, stage.max_ns / 1e6);
+    }
+}
+
+} //namespace
+
+int RunSimulationBenchmark(int argc, char **argv, const char *mission_file) {
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        return 1;
+    }
+    DisableGraphicsAndSound();
+
+    InitUnitTables();
+    std::string unit_table;
+    double unit_table_parse_seconds = 0;
+    double unit_table_load_seconds = 0;
+    if (options.unit_tables > 0
+            && !TimeUnitTableLoads(options.unit_tables, unit_table, unit_table_parse_seconds, unit_table_load_seconds)) {
+        fprintf(stderr, "Could not time loading the unit tables\n");
+        return 1;
+    }
+    Manifest::MPL();
+#ifdef HAVE_PYTHON
+    Python::init();
+#endif
+    SeedRandomNumbers(options.seed);
+
+    _Universe = new Universe();
+    _Universe->InitGalaxy(game_options()->galaxy.c_str());
+    TheTopLevelUnit = new Unit(0);
+    //Without scripts the fleets are ours, but the launch code and the AI look things up in the mission
+    active_missions.push_back(mission = new Mission(mission_file, options.scripts));
+    double script_parse_seconds = 0;
+    if (options.scripts) {
+        vs_config->setVariable("interpreter", "compile", options.interpreted ? "false" : "true");
+        //the director loads them with its own imports
+        for (const Fleet &fleet : options.fleets) {
+            if (fleet.ai[0] == '_') {
+                mission->addModule(fleet.ai.substr(1));
+            }
+        }
+        const auto parse_start = std::chrono::steady_clock::now();
+        mission->initMission(true);
+        script_parse_seconds =
+                std::chrono::duration<double>(std::chrono::steady_clock::now() - parse_start).count();
+    } else {
+        mission->initMission(false);
+    }
+    if (options.system.empty()) {
+        options.system = mission->getVariable("system", "Sol/Sol");
+    }
+    QVector origin(0, 0, 0);
+    std::string planet;
+    mission->GetOrigin(origin, planet);
+    //a viewless cockpit, for the code that asks for the player's ship
+    _Universe->createCockpit("simbench");
+
+    const double step = simulation_atom_var;
+    setFixedTimeStep(step);
+    InitTime();
+    UpdateTime();
+    SystemFactory::recordLoadTimes(true);
+    const auto load_start = std::chrono::steady_clock::now();
+    StarSystem *system = _Universe->GenerateStarSystem((options.system + ".system").c_str(), "", Vector(0, 0, 0));
+    LaunchFleets(options, system, origin);
+    if (options.scripts) {
+        mission->DirectorInitgame();
+    }
+    const double load_seconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - load_start).count();
+
+    //Load times depend on the disk cache; only the stepping is reproducible
+    SeedRandomNumbers(options.seed);
+    system->SeedRandom(options.seed);
+    for (unsigned int atom = 0; atom < options.warmup; ++atom) {
+        UpdateTime();
+        system->UpdateAtom(false);
+    }
+
+    VegaStrikeProfiler::Configure(0, options.trace_file);
+    VegaStrikeProfiler::Reset();
+    VegaStrikeProfiler::Enable(true);
+    const auto start = std::chrono::steady_clock::now();
+    for (unsigned int atom = 0; atom < options.atoms; ++atom) {
+        UpdateTime();
+        system->UpdateAtom(false);
+        //folds the zones before the ring buffers wrap, and times the atom as a frame
+        VegaStrikeProfiler::EndFrame();
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    unsigned int units;
+    const uint64_t state_hash = HashUnits(system, units);
+    printf("system %s, seed %u, %u fleet(s), %u units after %u warm-up and %u timed atoms of %g s\n",
+            options.system.c_str(), options.seed, (unsigned int) options.fleets.size(), units,
+            options.warmup, options.atoms, step);
+    printf("loaded in %.3f s; simulated in %.3f s: %.1f atoms/s, %.2fx real time\n",
+            load_seconds, seconds, options.atoms / seconds, options.atoms * step / seconds);
+    if (options.scripts) {
+        printf("mission scripts %s, parsed in %.3f s\n",
+                options.interpreted ? "interpreted" : "compiled", script_parse_seconds);
+    }
+    if (options.unit_tables > 0) {
+        printf("unit table %s: parsed in %.4f s, compiled copy loaded in %.4f s (best of %u)\n",
+                unit_table.c_str(), unit_table_parse_seconds, unit_table_load_seconds, options.unit_tables);
+    }
+    for (const SystemFactory::LoadTime &load_time : SystemFactory::loadTimes()) {
+        printf("system file %s: %u objects, parsed in %.4f s%s, built in %.4f s\n",
+                load_time.file.c_str(), (unsigned int) load_time.objects, load_time.parse_seconds,
+                load_time.prefetched ? " ahead" : "", load_time.build_seconds);
+    }
+    if (options.broadphase > 0) {
+        const CollideArray &units = *system->collide_map[Unit::UNIT_ONLY];
+        printf("broadphase, %u collidables, queries of %g m: sorted_axis %.2f us/query, loose_octree %.2f us/query\n",
+                (unsigned int) units.sorted.size(), options.broadphase,
+                MicrosecondsPerQuery("sorted_axis", units, options.broadphase),
+                MicrosecondsPerQuery("loose_octree", units, options.broadphase));
+    }
+    PrintStages(options.atoms);
+    const TimingWheel<Unit *>::LoadStats load = system->getPhysicsLoad();
+    printf("physics schedule: %u units over %u atoms, %u to %u per atom\n",
+            (unsigned int) load.items, SIM_QUEUE_SIZE, (unsigned int) load.quietest, (unsigned int) load.busiest);
+    printf("state hash %016llx\n", (unsigned long long) state_hash);
+    VegaStrikeProfiler::Shutdown();
+    VegaStrikeLogging::vega_logger()->FlushLogs();
+    return 0;
+}
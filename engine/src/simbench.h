@@ -0,0 +1,44 @@
+/*
+ * simbench.h
+ *
+ * Copyright (C) 2023 Vega Strike contributors.
+ *
+ * https://github.com/vegastrike/Vega-Strike-Engine-Source
+ *
+ * This file is part of Vega Strike.
+ *
+ * Vega Strike is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Vega Strike is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Vega Strike. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef VEGA_STRIKE_ENGINE_SIMBENCH_H
+#define VEGA_STRIKE_ENGINE_SIMBENCH_H
+
+/**
+ * Headless simulation benchmark, the main of vegastrike-simbench.
+ *
+ * Loads the unit tables, galaxy, factions and one star system without
+ * opening a window or an audio device, launches fleets at the mission's
+ * origin and steps the simulation a fixed number of sim atoms on a fixed
+ * clock and seed. Prints atoms per second, the profiler's per-stage timings
+ * and a hash of every unit's state, which is the same from run to run as
+ * long as the simulation is deterministic.
+ *
+ *     vegastrike-simbench --system=Sol/Sol --atoms=2000 --seed=7
+ *             --fleet=confed:Robin:12 --fleet=aera:Kahan:12
+ *
+ * Expects the paths, configuration and logging set up, as main() does
+ * before it looks at the command line.
+ */
+int RunSimulationBenchmark(int argc, char **argv, const char *mission_file);
+
+#endif //VEGA_STRIKE_ENGINE_SIMBENCH_H
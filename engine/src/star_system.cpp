@@ -26,6 +26,8 @@
 #define PY_SSIZE_T_CLEAN
 #include <boost/python.hpp>
 #include <assert.h>
+#include <atomic>
+#include <unordered_set>
 #include "star_system.h"
 
 #include "damageable.h"
@@ -68,6 +70,7 @@
 #include "cmd/nebula.h"
 #include "cmd/unit_util.h"
 #include "cmd/missile.h"
+#include "cmd/ai/target_acquisition.h"
 
 #include "gfx/boltdrawmanager.h"
 #include "gfx/sphere.h"
@@ -86,6 +89,11 @@
 #include "gfx/cockpit_generic.h"
 
 #include <boost/python/errors.hpp>
+#include "python/python_ai_batch.h"
+#include "python/python_compile.h"
+#include "star_system_loader.h"
+#include "worker_pool.h"
+#include "vs_profiler.h"
 
 using std::endl;
 
@@ -112,6 +120,7 @@ StarSystem::StarSystem(const string filename, const Vector &centr, const float t
     if (name.empty()) {
         name = filename;
     }
+    SeedRandom(GetRandomMasterSeed());
     AddStarsystemToUniverse(filename);
     UpdateTime();
 
@@ -155,6 +164,13 @@ StarSystem::~StarSystem() {
         delete collide_table;
         collide_table = nullptr;
     }
+    //bolts take themselves out of this system's collide map
+    delete bolt_draw_manager;
+    bolt_draw_manager = nullptr;
+    delete target_acquisition;
+    target_acquisition = nullptr;
+    delete random;
+    random = nullptr;
     _Universe->popActiveStarSystem();
     vector<StarSystem *> activ;
     while (_Universe->getNumActiveStarSystem()) {
@@ -173,6 +189,12 @@ StarSystem::~StarSystem() {
         _Universe->activeStarSystem()->SwapIn();
     }
     RemoveStarsystemFromUniverse();
+    for (unsigned int bucket = 0; bucket < physics_schedule.Turn(); ++bucket) {
+        for (Unit *unit : physics_schedule.Bucket(bucket)) {
+            unit->UnRef();
+        }
+    }
+    physics_schedule.Clear();
     delete collide_map[Unit::UNIT_ONLY];
     delete collide_map[Unit::UNIT_BOLT];
 
@@ -475,7 +497,11 @@ void UpdateTerrain() {
 }
 
 void UpdateCameraSnds() {
-    _Universe->AccessCockpit(0)->AccessCamera()->UpdateCameraSounds();
+    //cockpits without a view, e.g. in headless runs, have no camera
+    Camera *camera = _Universe->AccessCockpit(0)->AccessCamera();
+    if (camera) {
+        camera->UpdateCameraSounds();
+    }
 }
 
 void NebulaUpdate(StarSystem *ss) {
@@ -643,10 +669,9 @@ void StarSystem::AddUnit(Unit *unit) {
     draw_list.prepend(unit);
     unit->activeStarSystem = this;     //otherwise set at next physics frame...
     unsigned int priority = UnitUtil::getPhysicsPriority(unit);
-    //Do we need the +1 here or not - need to look at when current_sim_location is changed relative to this function
-    //and relative to this function, when the bucket is processed...
-    unsigned int tmp = 1 + ((unsigned int) vsrandom.genrand_int32()) % priority;
-    this->physics_buffer[(this->current_sim_location + tmp) % SIM_QUEUE_SIZE].prepend(unit);
+    if (physics_schedule.Schedule(unit, physics_schedule.SpreadDelay(priority, vsrandom.genrand_int32()))) {
+        unit->Ref();
+    }
     stats.AddUnit(unit);
 }
 
@@ -660,10 +685,8 @@ bool StarSystem::RemoveUnit(Unit *un) {
 
     if (draw_list.remove(un)) {
         // regardless of being drawn, it should be in physics list
-        for (unsigned int i = 0; i <= SIM_QUEUE_SIZE; ++i) {
-            if (physics_buffer[i].remove(un)) {
-                i = SIM_QUEUE_SIZE + 1;
-            }
+        if (physics_schedule.Remove(un)) {
+            un->UnRef();
         }
         stats.RemoveUnit(un);
         return (true);
@@ -680,6 +703,7 @@ void StarSystem::ExecuteUnitAI() {
         }
     }
     catch (const boost::python::error_already_set &) {
+        PythonGILLock python_lock;
         if (PyErr_Occurred()) {
             VS_LOG_AND_FLUSH(fatal, "void StarSystem::ExecuteUnitAI(): Python error occurred");
             PyErr_Print();
@@ -872,27 +896,32 @@ void Statistics::RemoveUnit(Unit *un) {
 }
 
 //Variables for debugging purposes only - eliminate later
-unsigned int physicsframecounter = 1;
-unsigned int theunitcounter = 0;
-unsigned int totalprocessed = 0;
+//Kept per thread, since star systems may be simulated in parallel
+thread_local unsigned int physicsframecounter = 1;
+thread_local unsigned int theunitcounter = 0;
+thread_local unsigned int totalprocessed = 0;
 unsigned int movingavgarray[128] = {0};
 unsigned int movingtotal = 0;
-double aggfire = 0;
-int numprocessed = 0;
-double targetpick = 0;
+thread_local double aggfire = 0;
+thread_local int numprocessed = 0;
+thread_local double targetpick = 0;
 
-void StarSystem::RequestPhysics(Unit *un, unsigned int queue) {
-    Unit *unit = nullptr;
-    un_iter iter = this->physics_buffer[queue].createIterator();
-    while ((unit = *iter) && *iter != un) {
-        ++iter;
-    }
-    if (unit == un) {
+struct StarSystem::PendingUnitPhysics {
+    Unit *unit;
+    float simulation_atom;
+    bool lastframe;
+    Transformation old_physical_state;
+    Movable::MotionStep step;
+};
+
+//Reused between batches; each simulation thread updates one system at a time
+static thread_local vector<StarSystem::PendingUnitPhysics> pending_unit_physics;
+static thread_local vector<Unit *> due_units;
+
+void StarSystem::RequestPhysics(Unit *un) {
+    if (physics_schedule.Contains(un)) {
         un->predicted_priority = 0;
-        unsigned int newloc = (current_sim_location + 1) % SIM_QUEUE_SIZE;
-        if (newloc != queue) {
-            iter.moveBefore(this->physics_buffer[newloc]);
-        }
+        physics_schedule.Schedule(un, 1);
     }
 }
 
@@ -906,23 +935,39 @@ void StarSystem::RequestPhysics(Unit *un, unsigned int queue) {
 //will wreak havoc with subunit interpolation. Luckily again, we only need
 //randomization on priority changes, so we're fine.
 void StarSystem::UpdateUnitsPhysics(bool firstframe) {
-    static int batchcount = SIM_QUEUE_SIZE - 1;
-//    double collidetime = 0.0;
-//    double bolttime = 0.0;
+    //Only the very first call catches up on the whole queue
+    static std::atomic<int> batchcount(SIM_QUEUE_SIZE - 1);
+    VS_PROFILE_ZONE("UpdateUnitsPhysics");
     targetpick = 0.0;
     aggfire = 0.0;
     numprocessed = 0;
     stats.CheckVitals(this);
 
-    for (++batchcount; batchcount > 0; --batchcount) {
+    for (int batches = batchcount.exchange(0) + 1; batches > 0; --batches) {
+        //Units may be added, removed or requeued while the batch runs, so work on a copy
+        vector<Unit *> &due = due_units;
+        due = physics_schedule.Due();
+        //Keeps the batch alive until the end of the atom
+        for (Unit *unit : due) {
+            unit->Ref();
+        }
         try {
-            UnitCollection col = physics_buffer[current_sim_location];
-            un_iter iter = physics_buffer[current_sim_location].createIterator();
-            Unit *unit = nullptr;
-            for (; (unit = *iter); ++iter) {
-                UpdateUnitPhysics(firstframe, unit);
+            //One call into Python for the batched Python AI of the whole batch, before any of it runs
+            PythonAIBatch::Run(due, *collide_map[Unit::UNIT_ONLY]);
+            vector<PendingUnitPhysics> &batch = pending_unit_physics;
+            batch.clear();
+            for (Unit *unit : due) {
+                if (!unit->Killed()) {
+                    batch.emplace_back();
+                    PrepareUnitPhysics(firstframe, unit, batch.back());
+                }
+            }
+            IntegrateUnitsMotion(batch);
+            for (PendingUnitPhysics &pending : batch) {
+                CommitUnitPhysics(pending);
             }
         } catch (const boost::python::error_already_set &) {
+            PythonGILLock python_lock;
             if (PyErr_Occurred()) {
                 VS_LOG_AND_FLUSH(fatal,
                         "void StarSystem::UpdateUnitPhysics( bool firstframe ): Msg D: Python error occurred");
@@ -930,44 +975,54 @@ void StarSystem::UpdateUnitsPhysics(bool firstframe) {
                 PyErr_Clear();
                 VegaStrikeLogging::vega_logger()->FlushLogs();
             }
+            for (Unit *unit : due) {
+                unit->UnRef();
+            }
             throw;
         }
-//        double c0 = queryTime();
         Bolt::UpdatePhysics(this);
-//        double cc = queryTime();
         last_collisions.clear();
         collide_map[Unit::UNIT_BOLT]->flatten();
         if (Unit::NUM_COLLIDE_MAPS > 1) {
             collide_map[Unit::UNIT_ONLY]->flatten(*collide_map[Unit::UNIT_BOLT]);
         }
-        Unit *unit;
-        for (un_iter iter = physics_buffer[current_sim_location].createIterator(); (unit = *iter);) {
-            unsigned int priority = unit->sim_atom_multiplier;
-            float backup = simulation_atom_var;
-            //VS_LOG(trace, (boost::format("void StarSystem::UpdateUnitPhysics( bool firstframe ): Msg E: simulation_atom_var as backed up:  %1%") % simulation_atom_var));
-            simulation_atom_var *= priority;
-            //VS_LOG(trace, (boost::format("void StarSystem::UpdateUnitPhysics( bool firstframe ): Msg F: simulation_atom_var as multiplied: %1%") % simulation_atom_var));
-            unsigned int newloc = (current_sim_location + priority) % SIM_QUEUE_SIZE;
-            unit->CollideAll();
-            simulation_atom_var = backup;
-            //VS_LOG(trace, (boost::format("void StarSystem::UpdateUnitPhysics( bool firstframe ): Msg G: simulation_atom_var as restored:   %1%") % simulation_atom_var));
-            if (newloc == current_sim_location) {
-                ++iter;
-            } else {
-                iter.moveBefore(physics_buffer[newloc]);
+        //Serve the target searches asked for by the AI of this batch
+        if (target_acquisition) {
+            target_acquisition->Run(*collide_map[Unit::UNIT_ONLY]);
+        }
+        VS_PROFILE_ZONE("CollideAll");
+        for (Unit *unit : due) {
+            if (!unit->Killed()) {
+                unsigned int priority = unit->sim_atom_multiplier;
+                float backup = simulation_atom_var;
+                //VS_LOG(trace, (boost::format("void StarSystem::UpdateUnitPhysics( bool firstframe ): Msg E: simulation_atom_var as backed up:  %1%") % simulation_atom_var));
+                simulation_atom_var *= priority;
+                //VS_LOG(trace, (boost::format("void StarSystem::UpdateUnitPhysics( bool firstframe ): Msg F: simulation_atom_var as multiplied: %1%") % simulation_atom_var));
+                unit->CollideAll();
+                simulation_atom_var = backup;
+                //VS_LOG(trace, (boost::format("void StarSystem::UpdateUnitPhysics( bool firstframe ): Msg G: simulation_atom_var as restored:   %1%") % simulation_atom_var));
             }
+            //Left alone if it was removed or requested physics meanwhile
+            if (physics_schedule.DelayOf(unit) == 0) {
+                if (unit->Killed()) {
+                    physics_schedule.Remove(unit);
+                    unit->UnRef();
+                } else {
+                    physics_schedule.Schedule(unit, unit->sim_atom_multiplier);
+                }
+            }
+        }
+        for (Unit *unit : due) {
+            unit->UnRef();
         }
-//        double dd = queryTime();
-//        collidetime += dd - cc;
-//        bolttime += cc - c0;
-        current_sim_location = (current_sim_location + 1) % SIM_QUEUE_SIZE;
+        physics_schedule.Advance();
         ++physicsframecounter;
         totalprocessed += theunitcounter;
         theunitcounter = 0;
     }
 }
 
-void StarSystem::UpdateUnitPhysics(bool firstframe, Unit *unit) {
+void StarSystem::PrepareUnitPhysics(bool firstframe, Unit *unit, PendingUnitPhysics &pending) {
     int priority = UnitUtil::getPhysicsPriority(unit);
     //Doing spreading here and only on priority changes, so as to make AI easier
     int predprior = unit->predicted_priority;
@@ -979,31 +1034,29 @@ void StarSystem::UpdateUnitPhysics(bool firstframe, Unit *unit) {
         }
         //Save priority value as prediction for next scheduling, but don't overwrite yet.
         predprior = priority;
-        //Scatter, so as to achieve uniform distribution
-#if defined(RANDOMIZE_SIM_ATOMS)
-        VS_LOG(trace, "void StarSystem::UpdateUnitPhysics( bool firstframe ): Randomizing unit priority");
-        priority  = 1+( ( (unsigned int) vsrandom.genrand_int32() )%priority );
-#endif
+        //Scatter to the quieter sim atoms, so that units whose priority changed together do not step together
+        priority = physics_schedule.SpreadDelay(priority, vsrandom.genrand_int32());
     }
     float backup = simulation_atom_var;
     //VS_LOG(trace, (boost::format("void StarSystem::UpdateUnitPhysics( bool firstframe ): Msg A: simulation_atom_var as backed up:  %1%") % simulation_atom_var));
+    pending.unit = unit;
+    //FIXME "firstframe"-- assume no more than 2 physics updates per frame.
+    pending.lastframe = priority == 1 ? firstframe : true;
     try {
         theunitcounter = theunitcounter + 1;
         simulation_atom_var *= priority;
+        pending.simulation_atom = simulation_atom_var;
         //VS_LOG(trace, (boost::format("void StarSystem::UpdateUnitPhysics( bool firstframe ): Msg B: simulation_atom_var as multiplied: %1%") % simulation_atom_var));
         unit->sim_atom_multiplier = priority;
         unit->ExecuteAI();
         unit->ResetThreatLevel();
-        //FIXME "firstframe"-- assume no more than 2 physics updates per frame.
-        unit->UpdatePhysics(identity_transformation,
+        pending.old_physical_state = unit->PrepareUpdatePhysics(identity_transformation,
                 identity_matrix,
-                Vector(0,
-                        0,
-                        0),
-                priority
-                        == 1 ? firstframe : true,
+                pending.lastframe,
                 &this->gravitationalUnits(),
                 unit);
+        //Walks the unit lists of the system, which the concurrent integration mustn't
+        unit->FindNearestWarpMultiplier(pending.step);
         simulation_atom_var = backup;
     } catch (...) {
         simulation_atom_var = backup;
@@ -1013,6 +1066,46 @@ void StarSystem::UpdateUnitPhysics(bool firstframe, Unit *unit) {
     unit->predicted_priority = predprior;
 }
 
+void StarSystem::IntegrateUnitsMotion(vector<PendingUnitPhysics> &batch) {
+    //Units per task; integrating a single unit is too cheap to be worth a task
+    static const size_t min_units_per_task = 32;
+    auto integrate = [this, &batch](size_t begin, size_t end) {
+        VS_PROFILE_ZONE("IntegrateUnitsMotion");
+        WorkerStarSystemScope scope(this);
+        for (size_t i = begin; i < end; ++i) {
+            PendingUnitPhysics &pending = batch[i];
+            pending.unit->ComputeMotion(identity_transformation,
+                    identity_matrix,
+                    Vector(0, 0, 0),
+                    pending.simulation_atom,
+                    pending.step);
+        }
+    };
+    if (configuration()->physics_config.parallel_unit_physics) {
+        GetWorkerPool().ParallelFor(batch.size(), min_units_per_task, integrate);
+    } else {
+        integrate(0, batch.size());
+    }
+}
+
+void StarSystem::CommitUnitPhysics(PendingUnitPhysics &pending) {
+    float backup = simulation_atom_var;
+    simulation_atom_var = pending.simulation_atom;
+    try {
+        pending.unit->FinishUpdatePhysics(identity_transformation,
+                identity_matrix,
+                Vector(0, 0, 0),
+                pending.lastframe,
+                &this->gravitationalUnits(),
+                pending.old_physical_state,
+                pending.step);
+        simulation_atom_var = backup;
+    } catch (...) {
+        simulation_atom_var = backup;
+        throw;
+    }
+}
+
 extern void TerrainCollide();
 extern void UpdateAnimatedTexture();
 extern void UpdateCameraSnds();
@@ -1021,6 +1114,7 @@ extern float getTimeCompression();
 
 //server
 void ExecuteDirector() {
+    VS_PROFILE_ZONE("ExecuteDirector");
     unsigned int curcockpit = _Universe->CurrentCockpit();
     {
         for (unsigned int i = 0; i < active_missions.size(); ++i) {
@@ -1091,6 +1185,7 @@ void StarSystem::Update(float priority) {
             }
             UpdateMissiles();                    //do explosions
             UpdateUnitsPhysics(firstframe);
+            RunMainThreadQueue();
 
             firstframe = false;
             time -= SIMULATION_ATOM;
@@ -1102,118 +1197,169 @@ void StarSystem::Update(float priority) {
 
 //client
 void StarSystem::Update(float priority, bool executeDirector) {
-    bool firstframe = true;
+    VS_PROFILE_ZONE("StarSystem::Update");
+    BeginUpdate(priority);
+    ///just be sure to restore this at the end
+    float normal_simulation_atom = simulation_atom_var;
+    //VS_LOG(trace, (boost::format("void StarSystem::Update( float priority, bool executeDirector ): Msg A: simulation_atom_var as backed up  = %1%") % simulation_atom_var));
+    simulation_atom_var = update_simulation_atom;
+    //VS_LOG(trace, (boost::format("void StarSystem::Update( float priority, bool executeDirector ): Msg B: simulation_atom_var as multiplied = %1%") % simulation_atom_var));
+    _Universe->pushActiveStarSystem(this);
+    //Chew up all sim_atoms that have elapsed since last update
+    // ** stephengtuggy 2020-07-23: We definitely need this block of code! **
+    while (AtomDue()) {
+        //VS_LOG(trace, "void StarSystem::Update( float priority, bool executeDirector ): Chewing up a sim atom");
+        if (current_stage == MISSION_SIMULATION) {
+            ExecuteMissionStage(executeDirector);
+        } else if (current_stage == PROCESS_UNIT) {
+            ExecuteUnitStage();
+            FinishUnitStage();
+        }
+    }
+    EndUpdate();
+    //WARNING cockpit does not get here...
+    simulation_atom_var = normal_simulation_atom;
+    //VS_LOG(trace, (boost::format("void StarSystem::Update( float priority, bool executeDirector ): Msg D: simulation_atom_var as restored   = %1%") % simulation_atom_var));
+    _Universe->popActiveStarSystem();
+}
+
+void StarSystem::UpdateAtom(bool executeDirector) {
+    VS_PROFILE_ZONE("StarSystem::Update");
+    update_simulation_atom = simulation_atom_var;
+    update_first_atom = true;
+    update_ran_atoms = true;
+    _Universe->pushActiveStarSystem(this);
+    if (current_stage == MISSION_SIMULATION) {
+        ExecuteMissionStage(executeDirector);
+    }
+    ExecuteUnitStage();
+    FinishUnitStage();
+    //the stages count down time that was never added
+    time = 0;
+    EndUpdate();
+    _Universe->popActiveStarSystem();
+}
+
+void StarSystem::BeginUpdate(float priority) {
     ///this makes it so systems without players may be simulated less accurately
     for (unsigned int k = 0; k < _Universe->numPlayers(); ++k) {
         if (_Universe->AccessCockpit(k)->activeStarSystem == this) {
             priority = 1;
         }
     }
-    float normal_simulation_atom = simulation_atom_var;
-    //VS_LOG(trace, (boost::format("void StarSystem::Update( float priority, bool executeDirector ): Msg A: simulation_atom_var as backed up  = %1%") % simulation_atom_var));
-    simulation_atom_var /= (priority / getTimeCompression());
-    //VS_LOG(trace, (boost::format("void StarSystem::Update( float priority, bool executeDirector ): Msg B: simulation_atom_var as multiplied = %1%") % simulation_atom_var));
-    ///just be sure to restore this at the end
+    update_simulation_atom = simulation_atom_var / (priority / getTimeCompression());
+    update_first_atom = true;
     time += GetElapsedTime();
-    _Universe->pushActiveStarSystem(this);
-//    double bolttime = 0;
-    if (time > simulation_atom_var) {
-        if (time > simulation_atom_var * 2) {
-            VS_LOG(trace,
-                    (boost::format(
-                            "%1% %2%: time, %3$.6f, is more than twice simulation_atom_var, %4$.6f")
-                            % __FILE__ % __LINE__ % time % simulation_atom_var));
+    update_ran_atoms = AtomDue();
+    if (time > update_simulation_atom * 2) {
+        VS_LOG(trace,
+                (boost::format(
+                        "%1% %2%: time, %3$.6f, is more than twice simulation_atom_var, %4$.6f")
+                        % __FILE__ % __LINE__ % time % update_simulation_atom));
+    }
+}
+
+void StarSystem::ExecuteMissionStage(bool executeDirector) {
+    TerrainCollide();
+    UpdateAnimatedTexture();
+    Unit::ProcessDeleteQueue();
+    //Units are only added and removed between here and the next frame, so
+    //take the chance to pack the lists while nothing is iterating over them
+    draw_list.compact();
+    gravitational_units.compact();
+    if ((run_only_player_starsystem
+            && _Universe->getActiveStarSystem(0) == this) || !run_only_player_starsystem) {
+        if (executeDirector) {
+            ExecuteDirector();
+        }
+    }
+    static int dothis = 0;
+    if (this == _Universe->getActiveStarSystem(0)) {
+        if ((++dothis) % 2 == 0) {
+            AUDRefreshSounds();
         }
+    }
+    for (unsigned int i = 0; i < active_missions.size(); ++i) {
+        //waste of frakkin time
+        active_missions[i]->BriefingUpdate();
+    }
+    current_stage = PROCESS_UNIT;
+    time -= update_simulation_atom;
+}
 
-//        double missionSimulationTimeSubtotal = 0.0;
-//        double processUnitTimeSubtotal = 0.0;
-//
-//        double updateUnitsPhysicsTimeSubtotal = 0.0;
-//        double updateMissilesTimeSubtotal = 0.0;
-//        double collideTableUpdateTimeSubtotal = 0.0;
-//        double updateCameraSoundsTimeSubtotal = 0.0;
+namespace {
+//Swaps the generator of a star system in as vsrandom, and back out
+class ScopedStarSystemRandom {
+public:
+    explicit ScopedStarSystemRandom(VSRandom &random) : random(random) {
+        std::swap(vsrandom, random);
+    }
 
-        //Chew up all sim_atoms that have elapsed since last update
-        // ** stephengtuggy 2020-07-23: We definitely need this block of code! **
-        while (time > simulation_atom_var) {
-            //VS_LOG(trace, "void StarSystem::Update( float priority, bool executeDirector ): Chewing up a sim atom");
-            if (current_stage == MISSION_SIMULATION) {
-//                double missionSimulationStageStartTime = realTime();
-                TerrainCollide();
-                UpdateAnimatedTexture();
-                Unit::ProcessDeleteQueue();
-                if ((run_only_player_starsystem
-                        && _Universe->getActiveStarSystem(0) == this) || !run_only_player_starsystem) {
-                    if (executeDirector) {
-                        ExecuteDirector();
-                    }
-                }
-                static int dothis = 0;
-                if (this == _Universe->getActiveStarSystem(0)) {
-                    if ((++dothis) % 2 == 0) {
-                        AUDRefreshSounds();
-                    }
-                }
-                for (unsigned int i = 0; i < active_missions.size(); ++i) {
-                    //waste of frakkin time
-                    active_missions[i]->BriefingUpdate();
-                }
-//                double missionSimulationStageEndTime = realTime();
-//                missionSimulationTimeSubtotal += (missionSimulationStageEndTime - missionSimulationStageStartTime);
-//                VS_LOG(trace, (boost::format("void StarSystem::Update( float priority, bool executeDirector ): Time taken by MISSION_SIMULATION stage: %1%") % (missionSimulationStageEndTime - missionSimulationStageStartTime)));
-                current_stage = PROCESS_UNIT;
-            } else if (current_stage == PROCESS_UNIT) {
-//                double processUnitStageStartTime = realTime();
-                UpdateUnitsPhysics(firstframe);
-//                double updateUnitsPhysicsDoneTime = realTime();
-//                updateUnitsPhysicsTimeSubtotal += (updateUnitsPhysicsDoneTime - processUnitStageStartTime);
-                UpdateMissiles(); //do explosions
-//                double updateMissilesDoneTime = realTime();
-//                updateMissilesTimeSubtotal += (updateMissilesDoneTime - updateUnitsPhysicsDoneTime);
-                collide_table->Update();
-//                double collideTableUpdateDoneTime = realTime();
-//                collideTableUpdateTimeSubtotal += (collideTableUpdateDoneTime - updateMissilesDoneTime);
-                if (this == _Universe->getActiveStarSystem(0)) {
-                    UpdateCameraSnds();
-                }
-//                bolttime = queryTime();
-//                bolttime = queryTime() - bolttime;
-//                double processUnitStageEndTime = realTime();
-//                processUnitTimeSubtotal += (processUnitStageEndTime - processUnitStageStartTime);
-//                updateCameraSoundsTimeSubtotal += (processUnitStageEndTime - collideTableUpdateDoneTime);
-//                VS_LOG(trace, (boost::format("void StarSystem::Update( float priority, bool executeDirector ): Time taken by PROCESS_UNIT stage: %1%") % (processUnitStageEndTime - processUnitStageStartTime)));
-                current_stage = MISSION_SIMULATION;
-                firstframe = false;
-            }
-            time -= simulation_atom_var;
-        }
+    ~ScopedStarSystemRandom() {
+        std::swap(vsrandom, random);
+    }
+
+private:
+    VSRandom &random;
+};
+} //namespace
+
+void StarSystem::SeedRandom(unsigned int master_seed) {
+    const unsigned int seed = master_seed ^ static_cast<unsigned int>(std::hash<std::string>()(filename));
+    if (random) {
+        random->init_genrand(seed);
+    } else {
+        random = new VSRandom(seed);
+    }
+}
+
+void StarSystem::ExecuteUnitStage() {
+    ScopedStarSystemRandom scoped_random(*random);
+    UpdateUnitsPhysics(update_first_atom);
+    UpdateMissiles(); //do explosions
+    collide_table->Update();
+}
+
+void StarSystem::QueueForMainThread(std::function<void()> work) {
+    std::lock_guard<std::mutex> lock(main_thread_queue_mutex);
+    main_thread_queue.push_back(std::move(work));
+}
+
+void StarSystem::RunMainThreadQueue() {
+    vector<std::function<void()>> work;
+    {
+        std::lock_guard<std::mutex> lock(main_thread_queue_mutex);
+        work.swap(main_thread_queue);
+    }
+    for (const std::function<void()> &item : work) {
+        item();
+    }
+}
 
-//        VS_LOG(trace, (boost::format("%1% %2%: Subtotal of time taken by MISSION_SIMULATION: %3%") % __FILE__ % __LINE__ % missionSimulationTimeSubtotal));
-//        VS_LOG(trace, (boost::format("%1% %2%: Subtotal of time taken by PROCESS_UNIT: %3%") % __FILE__ % __LINE__ % processUnitTimeSubtotal));
-//
-//        VS_LOG(trace, (boost::format("%1% %2%: Subtotal of time taken by updating units' physics: %3%") % __FILE__ % __LINE__ % updateUnitsPhysicsTimeSubtotal));
-//        VS_LOG(trace, (boost::format("%1% %2%: Subtotal of time taken by updating missiles: %3%") % __FILE__ % __LINE__ % updateMissilesTimeSubtotal));
-//        VS_LOG(trace, (boost::format("%1% %2%: Subtotal of time taken by updating collide tables: %3%") % __FILE__ % __LINE__ % collideTableUpdateTimeSubtotal));
-//        VS_LOG(trace, (boost::format("%1% %2%: Subtotal of time taken by updating camera sounds: %3%") % __FILE__ % __LINE__ % updateCameraSoundsTimeSubtotal));
+void StarSystem::FinishUnitStage() {
+    RunMainThreadQueue();
+    if (this == _Universe->getActiveStarSystem(0)) {
+        UpdateCameraSnds();
+    }
+    current_stage = MISSION_SIMULATION;
+    update_first_atom = false;
+    time -= update_simulation_atom;
+}
 
-//        double cycleThroughPlayersStartTime = realTime();
+void StarSystem::EndUpdate() {
+    if (update_ran_atoms) {
         unsigned int i = _Universe->CurrentCockpit();
         for (unsigned int j = 0; j < _Universe->numPlayers(); ++j) {
             if (_Universe->AccessCockpit(j)->activeStarSystem == this) {
                 _Universe->SetActiveCockpit(j);
                 _Universe->AccessCockpit(j)->updateAttackers();
                 if (_Universe->AccessCockpit(j)->Update()) {
-                    simulation_atom_var = normal_simulation_atom;
-                    //VS_LOG(trace, (boost::format("void StarSystem::Update( float priority, bool executeDirector ): Msg C: simulation_atom_var as restored   = %1%") % simulation_atom_var));
                     _Universe->SetActiveCockpit(i);
-                    _Universe->popActiveStarSystem();
                     return;
                 }
             }
         }
         _Universe->SetActiveCockpit(i);
-//        double cycleThroughPlayersEndTime = realTime();
-//        VS_LOG(trace, (boost::format("%1% %2%: Time taken by cycling through active players / cockpits: %3%") % __FILE__ % __LINE__ % (cycleThroughPlayersEndTime - cycleThroughPlayersStartTime)));
     }
     if (sigIter.isDone()) {
         sigIter = draw_list.createIterator();
@@ -1224,11 +1370,20 @@ void StarSystem::Update(float priority, bool executeDirector) {
         ++sigIter;
     }
     //If it is done, leave it nullptr for this frame then.
-    //WARNING cockpit does not get here...
-    simulation_atom_var = normal_simulation_atom;
-    //VS_LOG(trace, (boost::format("void StarSystem::Update( float priority, bool executeDirector ): Msg D: simulation_atom_var as restored   = %1%") % simulation_atom_var));
-    //WARNING cockpit does not get here...
-    _Universe->popActiveStarSystem();
+}
+
+BoltDrawManager &StarSystem::GetBoltDrawManager() {
+    if (!bolt_draw_manager) {
+        bolt_draw_manager = new BoltDrawManager();
+    }
+    return *bolt_draw_manager;
+}
+
+TargetAcquisition &StarSystem::GetTargetAcquisition() {
+    if (!target_acquisition) {
+        target_acquisition = new TargetAcquisition();
+    }
+    return *target_acquisition;
 }
 
 /*
@@ -1413,6 +1568,10 @@ bool StarSystem::JumpTo(Unit *un, Unit *jumppoint, const std::string &system, bo
         justloaded = true;
         ss = _Universe->GenerateStarSystem(ssys.c_str(), filename.c_str(), Vector(0, 0, 0));
     }
+    if (ss && _Universe->isPlayerStarship(un)) {
+        //Whichever way the player goes on from there
+        GetStarSystemLoader().PrefetchAdjacent(ss->getFileName());
+    }
     if (ss && !isJumping(pendingjump, un)) {
 #ifdef JUMP_DEBUG
         VS_LOG(debug, "Pushing back to pending queue!");
@@ -1461,32 +1620,56 @@ unsigned int StarSystem::numContTerrain() {
 }
 
 void StarSystem::UpdateMissiles() {
+    VS_PROFILE_ZONE("UpdateMissiles");
     //if false, missiles collide with rocks as units, but not harm them with explosions
     //FIXME that's how it's used now, but not really correct, as there could be separate AsteroidWeaponDamage for this
     static bool collideroids =
             XMLSupport::parse_bool(vs_config->getVariable("physics", "AsteroidWeaponCollision", "false"));
 
-    //WARNING: This is a big performance problem...
-    //...responsible for many hiccups.
-    //TODO: Make it use the collide_map to only iterate through potential hits...
-    //PROBLEM: The current collide_map does not allow this efficiently (no way of
-    //taking the other unit's rSize() into account).
-    if (!discharged_missiles.empty()) {
-        if (discharged_missiles.back()->GetRadius()
-                > 0) {           //we can avoid this iterated check for kinetic projectiles even if they "discharge" on hit
-            Unit *un;
-            for (un_iter ui = getUnitList().createIterator();
-                    NULL != (un = (*ui));
-                    ++ui) {
-                enum Vega_UnitType type = un->isUnit();
-                if (collideroids || type
-                        != Vega_UnitType::asteroid) {           // could check for more, unless someone wants planet-killer missiles, but what it would change?
-                    discharged_missiles.back()->ApplyDamage(un);
-                }
+    if (discharged_missiles.empty()) {
+        return;
+    }
+    //Explosions set off by these ones go off next atom
+    vector<MissileEffect *> explosions;
+    explosions.swap(discharged_missiles);
+
+    //Only units that one of the blasts may reach, each once, in the order found
+    vector<Unit *> candidates;
+    if (configuration()->physics_config.no_unit_collisions) {
+        //Units don't keep their place in the collide map then, so try them all
+        Unit *un;
+        for (un_iter ui = getUnitList().createIterator(); NULL != (un = (*ui)); ++ui) {
+            candidates.push_back(un);
+        }
+    } else {
+        for (MissileEffect *explosion : explosions) {
+            //we can avoid this check for kinetic projectiles even if they "discharge" on hit
+            if (explosion->GetRadius() > 0) {
+                collide_map[Unit::UNIT_ONLY]->QueryUnits(explosion->GetCenter(), explosion->GetRadius(), candidates);
+            }
+        }
+    }
+    std::unordered_set<Unit *> seen;
+    for (Unit *un : candidates) {
+        if (!seen.insert(un).second) {
+            continue;
+        }
+        // could check for more, unless someone wants planet-killer missiles, but what it would change?
+        if (!collideroids && un->isUnit() == Vega_UnitType::asteroid) {
+            continue;
+        }
+        //Overlapping blasts all hit the unit, unless an earlier one finished it off
+        for (MissileEffect *explosion : explosions) {
+            if (un->Killed()) {
+                break;
+            }
+            if (explosion->GetRadius() > 0) {
+                explosion->ApplyDamage(un);
             }
         }
-        delete discharged_missiles.back();
-        discharged_missiles.pop_back();
+    }
+    for (MissileEffect *explosion : explosions) {
+        delete explosion;
     }
 }
 
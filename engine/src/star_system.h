@@ -30,7 +30,10 @@
 #include "gfxlib_struct.h"
 
 #include "star_xml.h"
+#include "timing_wheel.h"
 
+#include <functional>
+#include <mutex>
 #include <string>
 #include <vector>
 #include <map>
@@ -108,12 +111,29 @@ protected:
 
     ///to track the next given physics frame
     double time = 0;
+    ///the simulation atom scaled by this system's priority for the current Update
+    float update_simulation_atom = 0;
+    ///whether the current Update has yet to run its first unit stage
+    bool update_first_atom = true;
+    ///whether the current Update chewed up any sim atom at all
+    bool update_ran_atoms = false;
+
+    ///Bolts fired in this system; created on first use
+    class BoltDrawManager *bolt_draw_manager = nullptr;
+    ///Target searches of the ships in this system; created on first use
+    class TargetAcquisition *target_acquisition = nullptr;
+    ///What vsrandom is during the unit stage, so that its draws don't depend on
+    ///which thread runs the stage, nor on the order systems happen to run in
+    class VSRandom *random = nullptr;
+    ///Work the unit stage queued for the main thread, such as spawning units
+    std::mutex main_thread_queue_mutex;
+    vector<std::function<void()>> main_thread_queue;
 
     /// Everything to be drawn. Folded missiles in here oneday
     UnitCollection draw_list;
     UnitCollection gravitational_units;
-    UnitCollection physics_buffer[SIM_QUEUE_SIZE + 1];
-    unsigned int current_sim_location = 0;
+    ///The units, by the sim atom of their next physics step; each holds a reference
+    TimingWheel<Unit *> physics_schedule{SIM_QUEUE_SIZE};
 
     ///The moving, fading stars
     Stars *stars = nullptr;
@@ -157,19 +177,71 @@ public:
     virtual void AddMissileToQueue(class MissileEffect *);
     virtual void UpdateMissiles();
     void UpdateUnitsPhysics(bool firstframe);
-    void UpdateUnitPhysics(bool firstframe, Unit *unit);
+    ///A unit of the current physics batch, between its AI and its motion commit
+    struct PendingUnitPhysics;
+
+protected:
+    ///Runs the AI and systems of a unit; its motion is integrated later, with the rest of the batch
+    void PrepareUnitPhysics(bool firstframe, Unit *unit, PendingUnitPhysics &pending);
+    ///Integrates the motion of the whole batch from the state left by PrepareUnitPhysics
+    void IntegrateUnitsMotion(vector<PendingUnitPhysics> &batch);
+    ///Stores the integrated motion of a unit; done in queue order
+    void CommitUnitPhysics(PendingUnitPhysics &pending);
+
+public:
 
     ///Requeues the unit so that it is simulated ASAP.
-    void RequestPhysics(Unit *un, unsigned int queue);
+    void RequestPhysics(Unit *un);
 
     /// update a simulation atom ExecuteDirector must be false if star system is just loaded before mission is loaded
     void Update(float priority, bool executeDirector);
     //This one is temporarly used on server side
     void Update(float priority);
+    ///Runs exactly one sim atom, whatever the elapsed time; for headless runs that step the simulation themselves
+    void UpdateAtom(bool executeDirector);
+
+    class BoltDrawManager &GetBoltDrawManager();
+    class TargetAcquisition &GetTargetAcquisition();
+
+protected:
+    // The steps of Update(priority, executeDirector). Universe drives them
+    // directly when star systems are simulated in parallel: only
+    // ExecuteUnitStage() may run off the main thread, and all of them expect
+    // this system to be active and simulation_atom_var to be
+    // update_simulation_atom.
+    void BeginUpdate(float priority);
+
+    bool AtomDue() const {
+        return time > update_simulation_atom;
+    }
+
+    bool UnitStageDue() const {
+        return AtomDue() && current_stage == PROCESS_UNIT;
+    }
+
+    void ExecuteMissionStage(bool executeDirector);
+    void ExecuteUnitStage();
+    void FinishUnitStage();
+    void EndUpdate();
+
+public:
+    ///Has work the unit stage can't do off the main thread run there, once the
+    ///stage is over. Meant for creating units, which isn't thread safe.
+    void QueueForMainThread(std::function<void()> work);
+    ///Runs what was queued so far; called from the main thread
+    void RunMainThreadQueue();
+
+    ///Seeds the generator of the unit stage from the master seed and the file name
+    void SeedRandom(unsigned int master_seed);
 
     ///Gets the current simulation frame
     unsigned int getCurrentSimFrame() const {
-        return current_sim_location;
+        return physics_schedule.Now();
+    }
+
+    ///How evenly the units are spread over the sim atoms of a turn
+    TimingWheel<Unit *>::LoadStats getPhysicsLoad() const {
+        return physics_schedule.Stats();
     }
 
     void ExecuteUnitAI();
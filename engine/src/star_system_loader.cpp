@@ -0,0 +1,376 @@
+/*
+ * star_system_loader.cpp
+ *
+ * Copyright (C) 2023 Vega Strike contributors.
+ *
+ * https://github.com/vegastrike/Vega-Strike-Engine-Source
+ *
+ * This file is part of Vega Strike.
+ *
+ * Vega Strike is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Vega Strike is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Vega Strike. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "star_system_loader.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <exception>
+#include <set>
+#include <utility>
+
+#include "cmd/unit_csv_factory.h"
+#include "configuration/configuration.h"
+#include "faction_generic.h"
+#include "gfx/aux_texture.h"
+#include "universe.h"
+#include "vs_globals.h"
+#include "vs_logging.h"
+#include "vs_profiler.h"
+#include "xml_support.h"
+
+extern StarSystem *GetLoadedStarSystem(const char *file);
+
+std::map<std::string, std::unique_ptr<StarSystemLoader::Asset>> StarSystemLoader::staged;
+
+StarSystemLoader::Asset::Asset() {
+    decoded.palette = nullptr;
+}
+
+StarSystemLoader::Asset::~Asset() {
+    if (data != nullptr) {
+        free(data);
+    }
+    if (decoded.palette != nullptr) {
+        free(decoded.palette);
+    }
+}
+
+StarSystemLoader::StarSystemLoader(size_t capacity, size_t image_bytes) : capacity(capacity), image_bytes(image_bytes) {
+    if (capacity > 0) {
+        thread = std::thread(&StarSystemLoader::Run, this);
+    }
+}
+
+StarSystemLoader::~StarSystemLoader() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        shutting_down = true;
+    }
+    queued.notify_all();
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+void StarSystemLoader::Prefetch(const std::string &system) {
+    if (capacity == 0 || system.empty()) {
+        return;
+    }
+    std::string file = system;
+    if (file.find(".system") == std::string::npos) {
+        file += ".system";
+    }
+    if (GetLoadedStarSystem(file.c_str())) {
+        return;
+    }
+    // Looking the file up isn't safe off the main thread, but is cheap next to parsing it
+    if (VSFileSystem::LookForFile(file, VSFileSystem::SystemFile) > VSFileSystem::Ok) {
+        // Universe::Generate1() has yet to make it up
+        return;
+    }
+    VSFileSystem::VSFile lookup;
+    const std::string system_file = lookup.GetSystemDirectoryPath(file);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (entries.count(system_file)) {
+        return;
+    }
+    MakeRoom();
+    entries[system_file];
+    order.push_back(system_file);
+    queue.push_back(system_file);
+    queued.notify_one();
+    VS_LOG(debug, (boost::format("Prefetching star system %1%") % system_file));
+}
+
+void StarSystemLoader::PrefetchAdjacent(const std::string &system) {
+    if (capacity == 0) {
+        return;
+    }
+    // Copied, as reading the galaxy may reuse the list
+    const std::vector<std::string> adjacent = _Universe->getAdjacentStarSystems(system);
+    for (const std::string &next : adjacent) {
+        Prefetch(next);
+    }
+}
+
+StarSystemLoader::Parsed StarSystemLoader::Take(const std::string &system_file) {
+    Unstage();
+    std::unique_lock<std::mutex> lock(mutex);
+    std::map<std::string, Entry>::iterator found = entries.find(system_file);
+    if (found == entries.end()) {
+        return nullptr;
+    }
+    // Not started yet, so the caller may as well parse it itself; otherwise the
+    // parse or the asset being read is finished first
+    parsed.wait(lock, [this, &system_file] { return working != system_file; });
+    Parsed result = found->second.parsed;
+    // The assets still to read are loaded on the main loop as they always were
+    for (std::unique_ptr<Asset> &asset : found->second.assets) {
+        if (asset->done) {
+            decoded_bytes -= asset->bytes;
+            asset->bytes = 0;
+            staged[asset->file->GetFullPath()] = std::move(asset);
+        }
+    }
+    Forget(found);
+    return result;
+}
+
+void StarSystemLoader::FindAssets() {
+    if (capacity == 0) {
+        return;
+    }
+    std::vector<std::pair<std::string, Parsed>> found;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (std::pair<const std::string, Entry> &entry : entries) {
+            if (entry.second.done && entry.second.parsed && !entry.second.found_assets) {
+                entry.second.found_assets = true;
+                found.emplace_back(entry.first, entry.second.parsed);
+            }
+        }
+    }
+    for (const std::pair<std::string, Parsed> &system : found) {
+        std::vector<std::unique_ptr<Asset>> assets = OpenAssets(*system.second);
+        std::lock_guard<std::mutex> lock(mutex);
+        std::map<std::string, Entry>::iterator entry = entries.find(system.first);
+        if (entry != entries.end() && !assets.empty()) {
+            unread_assets += assets.size();
+            entry->second.assets = std::move(assets);
+            queued.notify_one();
+        }
+    }
+}
+
+std::vector<std::unique_ptr<StarSystemLoader::Asset>> StarSystemLoader::OpenAssets(
+        const SystemFactory::Document &document) {
+    std::vector<string> textures;
+    std::vector<std::pair<string, string>> units;
+    SystemFactory::findAssets(document.root(), textures, units);
+
+    std::vector<std::unique_ptr<Asset>> assets;
+    std::set<std::string> opened;
+    // Only files on disk; those in volumes share the reader of the volume
+    auto open = [&assets, &opened](const std::string &name, VSFileSystem::VSFileType type) -> Asset * {
+        std::unique_ptr<Asset> asset(new Asset);
+        asset->file.reset(new VSFileSystem::VSFile);
+        if (asset->file->OpenReadOnly(name, type) > VSFileSystem::Ok || asset->file->GetFP() == nullptr
+                || !opened.insert(asset->file->GetFullPath()).second) {
+            return nullptr;
+        }
+        assets.push_back(std::move(asset));
+        return assets.back().get();
+    };
+
+    // As Texture::Load() looks for them, with the alpha map next to the image
+    static const bool use_alphamap = XMLSupport::parse_bool(vs_config->getVariable("graphics", "bitmap_alphamap", "true"));
+    for (const string &texture : textures) {
+        if (Texture::Exists(texture)) {
+            continue;
+        }
+        Asset *asset = open(texture, VSFileSystem::TextureFile);
+        if (asset == nullptr) {
+            continue;
+        }
+        asset->image = true;
+        if (use_alphamap && texture.length() > 3) {
+            const string alpha = texture.substr(0, texture.length() - 3) + "alp";
+            asset->alpha.reset(new VSFileSystem::VSFile);
+            if (asset->alpha->OpenReadOnly(alpha, VSFileSystem::TextureFile) > VSFileSystem::Ok
+                    || asset->alpha->GetFP() == nullptr) {
+                asset->alpha.reset();
+            }
+        }
+    }
+
+    // As Unit::Init() looks for them, from the directory of the unit
+    for (const std::pair<string, string> &unit : units) {
+        const string faction_name = FactionUtil::GetFactionName(
+                unit.second.empty() ? 0 : FactionUtil::GetFactionIndex(unit.second));
+        const string unit_key = GetUnitKeyFromNameAndFaction(unit.first, faction_name);
+        if (unit_key.empty()) {
+            continue;
+        }
+        const string meshes = UnitCSVFactory::GetVariable(unit_key, "Mesh", string());
+        VSFileSystem::current_path.push_back(UnitCSVFactory::GetVariable(unit_key, "root", string()));
+        VSFileSystem::current_subdirectory.push_back("/" + UnitCSVFactory::GetVariable(unit_key, "Directory", string()));
+        VSFileSystem::current_type.push_back(VSFileSystem::UnitFile);
+        // As AddMeshes() splits them: {file;startframe;starttime}
+        string::size_type start = 0;
+        while ((start = meshes.find('{', start)) != string::npos) {
+            ++start;
+            const string::size_type end = meshes.find_first_of(";}", start);
+            open(meshes.substr(start, end == string::npos ? string::npos : end - start), VSFileSystem::MeshFile);
+        }
+        VSFileSystem::current_type.pop_back();
+        VSFileSystem::current_subdirectory.pop_back();
+        VSFileSystem::current_path.pop_back();
+    }
+    return assets;
+}
+
+unsigned char *StarSystemLoader::TakeImage(const std::string &path, const std::string &alpha_path, VSImage &image) {
+    std::map<std::string, std::unique_ptr<Asset>>::iterator found = staged.find(path);
+    if (found == staged.end() || !found->second->image
+            || (found->second->alpha ? found->second->alpha->GetFullPath() : std::string()) != alpha_path) {
+        return nullptr;
+    }
+    Asset &asset = *found->second;
+    image = asset.decoded;
+    // Its files go with the asset
+    image.ForgetFiles();
+    unsigned char *data = asset.data;
+    asset.data = nullptr;
+    asset.decoded.palette = nullptr;
+    staged.erase(found);
+    return data;
+}
+
+std::unique_ptr<VSFileSystem::VSFile> StarSystemLoader::TakeMesh(const std::string &path) {
+    std::map<std::string, std::unique_ptr<Asset>>::iterator found = staged.find(path);
+    if (found == staged.end() || found->second->image) {
+        return nullptr;
+    }
+    std::unique_ptr<VSFileSystem::VSFile> file = std::move(found->second->file);
+    staged.erase(found);
+    return file;
+}
+
+void StarSystemLoader::Unstage() {
+    staged.clear();
+}
+
+void StarSystemLoader::Forget(std::map<std::string, Entry>::iterator entry) {
+    std::deque<std::string>::iterator waiting = std::find(queue.begin(), queue.end(), entry->first);
+    if (waiting != queue.end()) {
+        queue.erase(waiting);
+    }
+    unread_assets -= entry->second.assets.size() - entry->second.next_asset;
+    for (const std::unique_ptr<Asset> &asset : entry->second.assets) {
+        if (asset) {
+            decoded_bytes -= asset->bytes;
+        }
+    }
+    order.erase(std::find(order.begin(), order.end(), entry->first));
+    entries.erase(entry);
+}
+
+void StarSystemLoader::MakeRoom() {
+    std::deque<std::string>::iterator oldest = order.begin();
+    while (entries.size() >= capacity && oldest != order.end()) {
+        if (*oldest == working) {
+            ++oldest;
+            continue;
+        }
+        const size_t index = oldest - order.begin();
+        Forget(entries.find(*oldest));
+        oldest = order.begin() + index;
+    }
+}
+
+void StarSystemLoader::Read(Asset &asset) {
+    if (asset.image) {
+        asset.data = asset.decoded.ReadImage(asset.file.get(), nullptr, true, asset.alpha.get());
+        asset.done = asset.data != nullptr;
+        // What it takes uncompressed, which is more than it takes otherwise
+        asset.bytes = asset.done ? asset.decoded.sizeX * asset.decoded.sizeY * 4 : 0;
+    } else {
+        // Mapped, then read through so that the pages are in memory when the mesh is built
+        size_t length = 0;
+        const char *contents = asset.file->MapFull(length);
+        char sum = 0;
+        for (size_t offset = 0; contents != nullptr && offset < length; offset += 4096) {
+            sum ^= contents[offset];
+        }
+        volatile char touched = sum;
+        (void) touched;
+        asset.done = contents != nullptr;
+    }
+}
+
+void StarSystemLoader::Run() {
+    // The main loop folds the zones while this thread reads files
+    VegaStrikeProfiler::IgnoreThisThread();
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        queued.wait(lock, [this] { return shutting_down || !queue.empty() || unread_assets > 0; });
+        if (shutting_down) {
+            return;
+        }
+        // Parsing comes first, as the files of a system are only known once it is parsed
+        if (!queue.empty()) {
+            const std::string system_file = queue.front();
+            queue.pop_front();
+            working = system_file;
+            lock.unlock();
+
+            Parsed result;
+            try {
+                result = SystemFactory::parseFile(system_file);
+            } catch (const std::exception &e) {
+                // Parsed again on the main loop, which reports it as it always did
+                VS_LOG(warning, (boost::format("Could not prefetch star system %1%: %2%") % system_file % e.what()));
+            }
+
+            lock.lock();
+            std::map<std::string, Entry>::iterator found = entries.find(system_file);
+            if (found != entries.end()) {
+                found->second.parsed = result;
+                found->second.done = true;
+            }
+        } else {
+            // The oldest entry first, as it was likely prefetched for the jump under way
+            std::map<std::string, Entry>::iterator found = entries.end();
+            for (const std::string &system_file : order) {
+                std::map<std::string, Entry>::iterator entry = entries.find(system_file);
+                if (entry->second.next_asset < entry->second.assets.size()) {
+                    found = entry;
+                    break;
+                }
+            }
+            assert(found != entries.end());
+            Asset &asset = *found->second.assets[found->second.next_asset++];
+            --unread_assets;
+            // Past the budget the images are left to the main loop
+            if (!asset.image || decoded_bytes < image_bytes) {
+                working = found->first;
+                lock.unlock();
+                Read(asset);
+                lock.lock();
+                decoded_bytes += asset.bytes;
+            }
+        }
+        working.clear();
+        parsed.notify_all();
+    }
+}
+
+StarSystemLoader &GetStarSystemLoader() {
+    static StarSystemLoader loader(configuration()->general_config.prefetched_star_systems,
+            static_cast<size_t>(configuration()->general_config.prefetched_image_megabytes) << 20);
+    return loader;
+}
@@ -0,0 +1,157 @@
+/*
+ * star_system_loader.h
+ *
+ * Copyright (C) 2023 Vega Strike contributors.
+ *
+ * https://github.com/vegastrike/Vega-Strike-Engine-Source
+ *
+ * This file is part of Vega Strike.
+ *
+ * Vega Strike is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Vega Strike is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Vega Strike. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef VEGA_STRIKE_ENGINE_STAR_SYSTEM_LOADER_H
+#define VEGA_STRIKE_ENGINE_STAR_SYSTEM_LOADER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gfx/vsimage.h"
+#include "system_factory.h"
+#include "vsfilesystem.h"
+
+/**
+ * @brief Parses the files of star systems the player may jump to next, and
+ * reads their meshes and textures, on a background thread.
+ *
+ * It is told about the destinations of the targeted jump point when the
+ * jump drive is engaged, and about the systems next to the one the player
+ * jumps to. Once a file is parsed, FindAssets() looks up on the main loop
+ * the files of the planet and ring textures and of the unit meshes it
+ * names, as VSFileSystem lookups and the unit tables are not thread safe.
+ * The thread then decodes the textures and reads the meshes into memory.
+ *
+ * When one of the systems gets loaded, SystemFactory takes the parsed file
+ * instead of reading it on the main loop, and Texture and Mesh take what
+ * was read for them while the system is built. Only building the units
+ * and uploading to the graphics card are left to the main loop.
+ */
+class StarSystemLoader {
+public:
+    typedef std::shared_ptr<SystemFactory::Document> Parsed;
+
+    // Keeps at most capacity parsed files around, 0 turning prefetching
+    // off, and decodes images until they take image_bytes
+    StarSystemLoader(size_t capacity, size_t image_bytes);
+    ~StarSystemLoader();
+
+    StarSystemLoader(const StarSystemLoader &) = delete;
+    StarSystemLoader &operator=(const StarSystemLoader &) = delete;
+
+    // Starts parsing the file of a system such as "Sol/Sol", unless the
+    // system is loaded already or its file has yet to be generated
+    void Prefetch(const std::string &system);
+    // Prefetches every system next to the given one in the galaxy
+    void PrefetchAdjacent(const std::string &system);
+
+    // The prefetched parse of a system file, given by its full path, which
+    // the loader then forgets. Waits for it if it is being parsed right now.
+    // nullptr if it wasn't prefetched or failed to parse. What was read for
+    // its meshes and textures is held for TakeImage() and TakeMesh() until
+    // Unstage() is called.
+    Parsed Take(const std::string &system_file);
+
+    // Looks up the files of the systems parsed since the last call, and
+    // queues them for reading. Called once a frame by the main loop.
+    void FindAssets();
+
+    // The image decoded from the texture file at path, whose alpha map is
+    // at alpha_path ("" for none), with its size and mode set on image.
+    // nullptr unless the system being loaded was prefetched with it.
+    static unsigned char *TakeImage(const std::string &path, const std::string &alpha_path, VSImage &image);
+    // The mesh file at path, read into memory already, or nullptr
+    static std::unique_ptr<VSFileSystem::VSFile> TakeMesh(const std::string &path);
+    // Drops what was read for the system just built that it didn't use
+    static void Unstage();
+
+private:
+    // A texture or mesh file opened on the main loop, for the thread to read
+    struct Asset {
+        Asset();
+        ~Asset();
+
+        std::unique_ptr<VSFileSystem::VSFile> file;
+        // The alpha map of a texture, if it has one
+        std::unique_ptr<VSFileSystem::VSFile> alpha;
+        bool image{false};
+        bool done{false};
+        // What was decoded from an image, for Texture::Bind()
+        VSImage decoded;
+        unsigned char *data{nullptr};
+        size_t bytes{0};
+    };
+
+    struct Entry {
+        Parsed parsed;
+        bool done{false};
+        bool found_assets{false};
+        std::vector<std::unique_ptr<Asset>> assets;
+        // The first asset still to read
+        size_t next_asset{0};
+    };
+
+    void Run();
+    void Read(Asset &asset);
+    // Opens the files of the textures and unit meshes a parsed system names
+    std::vector<std::unique_ptr<Asset>> OpenAssets(const SystemFactory::Document &document);
+    // Forgets an entry the thread isn't working on. Must be called with the lock held.
+    void Forget(std::map<std::string, Entry>::iterator entry);
+    // Forgets the oldest entries the thread isn't working on, down to capacity - 1.
+    // Must be called with the lock held.
+    void MakeRoom();
+
+    const size_t capacity;
+    const size_t image_bytes;
+    std::mutex mutex;
+    std::condition_variable queued;
+    std::condition_variable parsed;
+    // Files still to parse
+    std::deque<std::string> queue;
+    // Assets of the entries still to read
+    size_t unread_assets{0};
+    // Taken by the decoded images of the entries
+    size_t decoded_bytes{0};
+    std::map<std::string, Entry> entries;
+    // The keys of entries, oldest first
+    std::deque<std::string> order;
+    // The entry the thread is parsing or reading an asset of
+    std::string working;
+    bool shutting_down{false};
+    std::thread thread;
+
+    // What was read for the system being loaded, by full path. Only touched by the main loop.
+    static std::map<std::string, std::unique_ptr<Asset>> staged;
+};
+
+// Sized from general.prefetched_star_systems and general.prefetched_image_megabytes
+// the first time it is requested
+StarSystemLoader &GetStarSystemLoader();
+
+#endif //VEGA_STRIKE_ENGINE_STAR_SYSTEM_LOADER_H
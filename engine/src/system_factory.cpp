@@ -37,23 +37,28 @@
 #include "building.h"
 #include "asteroid.h"
 #include "atmospheric_fog_mesh.h"
+#include "star_system_loader.h"
 
 
 // TODO: For comparison only - remove
 #include "terrain.h"
 #include "cont_terrain.h"
 
-#include <boost/property_tree/ptree.hpp>
-#include <boost/property_tree/xml_parser.hpp>
 #include <boost/algorithm/string.hpp>
 #include <boost/foreach.hpp>
+#include <expat.h>
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
 #include <string>
 #include <map>
 #include <vector>
 #include <iostream>
 #include <sstream>
 
-namespace pt = boost::property_tree;
 namespace alg = boost::algorithm;
 
 using std::string;
@@ -99,6 +104,9 @@ static bool ConfigAllows(string var, float val) {
     return invert ? -x >= val : x >= val;
 }
 
+static bool record_load_times = false;
+static vector<SystemFactory::LoadTime> load_times;
+
 // turn a relative path filename to <sector>/<system>
 string truncateFilename(string filename) {
     string::size_type tmp;
@@ -109,45 +117,138 @@ string truncateFilename(string filename) {
 }
 
 SystemFactory::SystemFactory(string const &relative_filename, string &system_file, Star_XML *xml) {
-    root = Object();
-    root.type = ("root");
-
     this->fullname = truncateFilename(relative_filename);
 
-    pt::ptree tree;
-    pt::read_xml(system_file, tree);
-    recursiveParse(tree, root);
-    recursiveProcess(xml, root, nullptr);
+    // Jump destinations have usually been parsed in the background already
+    document = GetStarSystemLoader().Take(system_file);
+    const bool prefetched = document != nullptr;
+    if (!prefetched) {
+        document = parseFile(system_file);
+    }
+
+    const auto build_start = std::chrono::steady_clock::now();
+    recursiveProcess(xml, document->root(), nullptr);
+    StarSystemLoader::Unstage();
+    if (record_load_times) {
+        const double build_seconds =
+                std::chrono::duration<double>(std::chrono::steady_clock::now() - build_start).count();
+        load_times.push_back(LoadTime{system_file, document->numObjects(), prefetched,
+                document->parse_seconds, build_seconds});
+    }
 }
 
-void SystemFactory::recursiveParse(pt::ptree tree, Object &object) {
-    for (const auto &iterator : tree) {
-        Object inner_object = Object();
-        inner_object.type = iterator.first;
-
-        // Process attributes
-        if (inner_object.type == "<xmlattr>") {
-            for (const auto &attributes_iterator : iterator.second) {
-                string key = attributes_iterator.first.data();
-                string value = attributes_iterator.second.data();
-                alg::to_lower(key); // to avoid various bugs, we turn all keys to lowercase
-                object.attributes[key] = value;
-            }
+void SystemFactory::recordLoadTimes(bool record) {
+    record_load_times = record;
+}
 
-            // We've already processed the children
-            continue;
-        }
+const vector<SystemFactory::LoadTime> &SystemFactory::loadTimes() {
+    return load_times;
+}
 
-        // Process children
-        if (!iterator.second.empty()) {
-            recursiveParse(iterator.second, inner_object);
-        }
+SystemFactory::Document::Document() {
+    objects.emplace_back();
+    objects.front().type = ("root");
+}
+
+SystemFactory::Object *SystemFactory::Document::newObject() {
+    objects.emplace_back();
+    return &objects.back();
+}
+
+const string *SystemFactory::Document::intern(const string &name) {
+    return &*names.insert(name).first;
+}
 
-        object.objects.push_back(inner_object);
+namespace {
+// Where the expat callbacks build the document
+struct SystemFileReader {
+    SystemFactory::Document *document;
+    vector<SystemFactory::Object *> open_objects;
+    string key;
+};
+
+void beginSystemElement(void *userdata, const XML_Char *name, const XML_Char **atts) {
+    SystemFileReader *reader = static_cast<SystemFileReader *>(userdata);
+    SystemFactory::Object *object = reader->document->newObject();
+    object->type = name;
+    for (const XML_Char **att = atts; *att != nullptr; att += 2) {
+        reader->key = att[0];
+        alg::to_lower(reader->key); // to avoid various bugs, we turn all keys to lowercase
+        object->attributes.push_back(SystemFactory::Attribute{reader->document->intern(reader->key), att[1]});
+    }
+    reader->open_objects.back()->objects.push_back(object);
+    reader->open_objects.push_back(object);
+}
+
+void endSystemElement(void *userdata, const XML_Char *) {
+    static_cast<SystemFileReader *>(userdata)->open_objects.pop_back();
+}
+} // namespace
+
+std::shared_ptr<SystemFactory::Document> SystemFactory::parseFile(const string &system_file) {
+    const auto parse_start = std::chrono::steady_clock::now();
+    std::shared_ptr<Document> document = std::make_shared<Document>();
+    SystemFileReader reader{document.get(), {&document->root()}, string()};
+
+    FILE *file = fopen(system_file.c_str(), "rb");
+    if (file == nullptr) {
+        throw std::runtime_error("Could not open star system file " + system_file);
+    }
+    XML_Parser parser = XML_ParserCreate(nullptr);
+    XML_SetUserData(parser, &reader);
+    XML_SetElementHandler(parser, &beginSystemElement, &endSystemElement);
+
+    // Streamed through expat's buffer, so the file is never held in memory whole
+    static const int block_size = 65536;
+    bool parsed = true;
+    bool done = false;
+    while (parsed && !done) {
+        void *block = XML_GetBuffer(parser, block_size);
+        const size_t read = block ? fread(block, 1, block_size, file) : 0;
+        done = read < static_cast<size_t>(block_size);
+        parsed = block != nullptr && XML_ParseBuffer(parser, static_cast<int>(read), done) != XML_STATUS_ERROR;
+    }
+    fclose(file);
+    if (!parsed) {
+        std::ostringstream message;
+        message << system_file << "(" << XML_GetCurrentLineNumber(parser) << "): "
+                << XML_ErrorString(XML_GetErrorCode(parser));
+        XML_ParserFree(parser);
+        throw std::runtime_error(message.str());
+    }
+    XML_ParserFree(parser);
+
+    document->parse_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - parse_start).count();
+    return document;
+}
+
+void SystemFactory::findAssets(const Object &object, vector<string> &textures, vector<std::pair<string, string>> &units) {
+    const string *file = findAttribute(object, "file");
+    if (boost::iequals(object.type, "planet") || boost::iequals(object.type, "jump")) {
+        // As SphereMesh splits them; animated ones are left alone
+        string::size_type start = 0;
+        while (file && start < file->length()) {
+            const string::size_type end = std::min(file->find('|', start), file->length());
+            const string texture = file->substr(start, end - start);
+            if (!texture.empty() && texture.find(".ani") == string::npos) {
+                textures.push_back(texture);
+            }
+            start = end + 1;
+        }
+    } else if (boost::iequals(object.type, "ring")) {
+        textures.push_back(file ? *file : "planets/ring.png");
+    } else if (file && (boost::iequals(object.type, "unit") || boost::iequals(object.type, "asteroid") ||
+            boost::iequals(object.type, "enhancement") || boost::iequals(object.type, "vehicle") ||
+            boost::iequals(object.type, "building"))) {
+        const string *faction = findAttribute(object, "faction");
+        units.emplace_back(*file, faction ? *faction : string());
+    }
+    for (const Object *child_object : object.objects) {
+        findAssets(*child_object, textures, units);
     }
 }
 
-void SystemFactory::recursiveProcess(Star_XML *xml, Object &object, Planet *owner, int level) {
+void SystemFactory::recursiveProcess(Star_XML *xml, const Object &object, Planet *owner, int level) {
     xml->unitlevel = level;
 
     if (boost::iequals(object.type, "light")) {
@@ -170,23 +271,23 @@ void SystemFactory::recursiveProcess(Star_XML *xml, Object &object, Planet *owne
     }
 
     // Now we process children
-    for (auto &child_object : object.objects) {
-        recursiveProcess(xml, child_object, owner, level + 1);
+    for (const Object *child_object : object.objects) {
+        recursiveProcess(xml, *child_object, owner, level + 1);
     }
 }
 
-void SystemFactory::processLight(Object &object) {
+void SystemFactory::processLight(const Object &object) {
     Light light;
-    for (const auto &child_object : object.objects) {
-        GFXColor color = initializeColor(child_object);
+    for (const Object *child_object : object.objects) {
+        GFXColor color = initializeColor(*child_object);
 
-        if (child_object.type == "diffuse") {
+        if (child_object->type == "diffuse") {
             light.diffuse = color;
         }
-        if (child_object.type == "specular") {
+        if (child_object->type == "specular") {
             light.specular = color;
         }
-        if (child_object.type == "ambient") {
+        if (child_object->type == "ambient") {
             light.ambient = color;
         }
     }
@@ -194,7 +295,7 @@ void SystemFactory::processLight(Object &object) {
     lights.push_back(light);
 }
 
-void SystemFactory::processSystem(Star_XML *xml, Object &object) {
+void SystemFactory::processSystem(Star_XML *xml, const Object &object) {
     xml->name = getStringAttribute(object, "name");
     xml->backgroundname = getStringAttribute(object, "background");
     xml->scale *= getFloatAttribute(object, "ScaleSystem"); // Size multiplier of planets, rings and some other units
@@ -208,7 +309,7 @@ void SystemFactory::processSystem(Star_XML *xml, Object &object) {
 //    xml->backgroundColor.a = std::stof(backgroundColor["a"]);
 }
 
-void SystemFactory::processRing(Star_XML *xml, Object &object, Planet *owner) {
+void SystemFactory::processRing(Star_XML *xml, const Object &object, Planet *owner) {
     BLENDFUNC blend_source = SRCALPHA;
     BLENDFUNC blend_destination = INVSRCALPHA;
     initializeAlpha(object, blend_source, blend_destination);
@@ -245,7 +346,7 @@ void SystemFactory::processRing(Star_XML *xml, Object &object, Planet *owner) {
     }
 }
 
-Planet *SystemFactory::processPlanet(Star_XML *xml, Object &object, Planet *owner) {
+Planet *SystemFactory::processPlanet(Star_XML *xml, const Object &object, Planet *owner) {
     QVector S(0, 1, 0);
     QVector R(0, 0, 1);
 
@@ -301,7 +402,7 @@ Planet *SystemFactory::processPlanet(Star_XML *xml, Object &object, Planet *owne
     // End planet not glow code
 
     // "Invisible" object
-    if (object.attributes.count("reflectnolight")) {
+    if (findAttribute(object, "reflectnolight")) {
         ourmat.sr = ourmat.sg = ourmat.sb = ourmat.dr = ourmat.dg =
                 ourmat.db = ourmat.ar = ourmat.ag = ourmat.ab = 0;
     }
@@ -309,8 +410,8 @@ Planet *SystemFactory::processPlanet(Star_XML *xml, Object &object, Planet *owne
     bootstrap_draw("Loading " + fullname);
 
     // Parse destinations (jump only?)
-    if (object.attributes.count("destination")) {
-        destination = ParseDestinations(object.attributes["destination"]);
+    if (const string *value = findAttribute(object, "destination")) {
+        destination = ParseDestinations(*value);
         isDestination = true;
     }
 
@@ -318,10 +419,10 @@ Planet *SystemFactory::processPlanet(Star_XML *xml, Object &object, Planet *owne
     // Discussion - the original code supported multiple lights
     // This is why we have curlights as a vector
     // If you disable this, the ship in dock will be dark. Weird.
-    if (object.attributes.count("light")) {
+    if (const string *value = findAttribute(object, "light")) {
         unsigned long index = 0;
         char local = 0;
-        std::istringstream stream(object.attributes["light"]);
+        std::istringstream stream(*value);
         stream >> index >> local;
 
         Light light = lights[index];
@@ -337,10 +438,10 @@ Planet *SystemFactory::processPlanet(Star_XML *xml, Object &object, Planet *owne
     }
 
     // Parse faction
-    if (object.attributes.count("faction")) {
+    if (const string *value = findAttribute(object, "faction")) {
         int originalowner =
                 FactionUtil::GetFactionIndex(UniverseUtil::GetGalaxyProperty(this->fullname, "faction"));
-        faction = FactionUtil::GetFactionIndex(object.attributes["faction"]);
+        faction = FactionUtil::GetFactionIndex(*value);
         if (faction == originalowner) {
             int ownerfaction = FactionUtil::GetFactionIndex(UniverseUtil::GetGalaxyFaction(this->fullname));
             faction = ownerfaction;
@@ -366,8 +467,8 @@ Planet *SystemFactory::processPlanet(Star_XML *xml, Object &object, Planet *owne
     xml->cursun.j = getFloatAttribute(object, "y", xml->cursun.j, float_scales_product);
     xml->cursun.k = getFloatAttribute(object, "z", xml->cursun.k, float_scales_product);
 
-    if (object.attributes.count("override")) {
-        string value = object.attributes["override"];
+    if (const string *override = findAttribute(object, "override")) {
+        const string &value = *override;
         string::size_type eqpos = value.find_first_of('=');
         if (eqpos != string::npos) {
             string name = value.substr(0, eqpos);
@@ -424,7 +525,7 @@ Planet *SystemFactory::processPlanet(Star_XML *xml, Object &object, Planet *owne
     return planet;
 }
 
-void SystemFactory::processSpaceElevator(Object &object, Planet *owner) {
+void SystemFactory::processSpaceElevator(const Object &object, Planet *owner) {
     string myfile = getStringAttribute(object, "file", "elevator");
     string varname = getStringAttribute(object, "varname");
     float varvalue = getFloatAttribute(object, "varvalue", 0.0f);
@@ -442,8 +543,8 @@ void SystemFactory::processSpaceElevator(Object &object, Planet *owner) {
 
     // Faction
     string faction(UniverseUtil::GetGalaxyFaction(fullname));
-    if (object.attributes.count("faction")) {
-        faction = object.attributes["faction"];
+    if (const string *value = findAttribute(object, "faction")) {
+        faction = *value;
         if (faction == UniverseUtil::GetGalaxyProperty(fullname, "faction")) {
             string ownerfaction = UniverseUtil::GetGalaxyFaction(fullname);
             faction = ownerfaction;
@@ -455,7 +556,7 @@ void SystemFactory::processSpaceElevator(Object &object, Planet *owner) {
     }
 }
 
-void SystemFactory::processFog(Star_XML *xml, Object &object, Planet *owner) {
+void SystemFactory::processFog(Star_XML *xml, const Object &object, Planet *owner) {
     if (!game_options()->usePlanetFog) {
         return;
     }
@@ -464,12 +565,12 @@ void SystemFactory::processFog(Star_XML *xml, Object &object, Planet *owner) {
     xml->fogopticalillusion = getBoolAttribute(object, "fog", true);
     xml->fog.clear();
 
-    for (const auto &child_object : object.objects) {
+    for (const Object *child_object : object.objects) {
         AtmosphericFogMesh fogMesh = AtmosphericFogMesh();
         fogMesh.meshname = getStringAttribute(object, "file");
         fogMesh.scale = 1.1 - .075 + .075 * (xml->fog.size() + 1);
 
-        initializeColor(child_object);
+        initializeColor(*child_object);
 
         fogMesh.er = getFloatAttribute(object, "red", fogMesh.er);
         fogMesh.eg = getFloatAttribute(object, "green", fogMesh.eg);
@@ -499,7 +600,7 @@ void SystemFactory::processFog(Star_XML *xml, Object &object, Planet *owner) {
     }
 }
 
-void SystemFactory::processEnhancement(string element, Star_XML *xml, Object &object, Planet *owner) {
+void SystemFactory::processEnhancement(const string &element, Star_XML *xml, const Object &object, Planet *owner) {
     QVector S(0, 1, 0);
     QVector R(0, 0, 1);
 
@@ -528,17 +629,17 @@ void SystemFactory::processEnhancement(string element, Star_XML *xml, Object &ob
     double position = getDoubleAttribute(object, "position", 0.0);
 
     // Parse destinations (jump only?)
-    if (object.attributes.count("destination")) {
-        destinations = ParseDestinations(object.attributes["destination"]);
+    if (const string *value = findAttribute(object, "destination")) {
+        destinations = ParseDestinations(*value);
     }
 
     // Parse faction
     // This code is nonsensical to some degree.
     // Why do we need ownerfaction and not just assign to faction?
-    if (object.attributes.count("faction")) {
+    if (const string *value = findAttribute(object, "faction")) {
         int originalowner = FactionUtil::GetFactionIndex(
                 UniverseUtil::GetGalaxyProperty(this->fullname, "faction"));
-        faction = FactionUtil::GetFactionIndex(object.attributes["faction"]);
+        faction = FactionUtil::GetFactionIndex(*value);
         if (faction == originalowner) {
             int ownerfaction = FactionUtil::GetFactionIndex(UniverseUtil::GetGalaxyFaction(this->fullname));
             faction = ownerfaction;
@@ -652,76 +753,88 @@ void SystemFactory::processEnhancement(string element, Star_XML *xml, Object &ob
 // However, we would still need to specialize the string conversion (e.g. std:stof)
 // More important, this is dangerous. Changing T would change the function called and
 // this would not be obvious to somewhat not familiar with the code.
-string SystemFactory::getStringAttribute(Object object, string key, string default_value) {
-    alg::to_lower(key);
-    if (object.attributes.count(key)) {
-        return object.attributes[key];
+const string *SystemFactory::findAttribute(const Object &object, const char *key) {
+    for (const Attribute &attribute : object.attributes) {
+        const string &attribute_key = *attribute.key;
+        size_t i = 0;
+        while (i < attribute_key.size() && key[i] != 0
+                && attribute_key[i] == std::tolower(static_cast<unsigned char>(key[i]))) {
+            ++i;
+        }
+        if (i == attribute_key.size() && key[i] == 0) {
+            return &attribute.value;
+        }
+    }
+    return nullptr;
+}
+
+string SystemFactory::getStringAttribute(const Object &object, const char *key, const string &default_value) {
+    if (const string *value = findAttribute(object, key)) {
+        return *value;
     }
     return default_value;
 }
 
-bool SystemFactory::getBoolAttribute(Object object, string key, bool default_value) {
-    alg::to_lower(key);
-    if (object.attributes.count(key)) {
-        return object.attributes[key] == "true";
+bool SystemFactory::getBoolAttribute(const Object &object, const char *key, bool default_value) {
+    if (const string *value = findAttribute(object, key)) {
+        return *value == "true";
     }
     return default_value;
 }
 
-char SystemFactory::getCharAttribute(Object object, string key, char default_value) {
-    alg::to_lower(key);
-    if (object.attributes.count(key) && object.attributes[key].size() > 0) {
-        return object.attributes[key][0];
+char SystemFactory::getCharAttribute(const Object &object, const char *key, char default_value) {
+    const string *value = findAttribute(object, key);
+    if (value && value->size() > 0) {
+        return (*value)[0];
     }
     return default_value;
 }
 
-int SystemFactory::getIntAttribute(Object object, string key, int default_value,
+// The number conversions don't allocate; as before, values that don't start with a number get the default
+int SystemFactory::getIntAttribute(const Object &object, const char *key, int default_value,
         int multiplier, int default_multiplier) {
-    alg::to_lower(key);
-    if (object.attributes.count(key)) {
-        try {
-            return std::stoi(object.attributes[key]) * multiplier;
-        } catch (std::invalid_argument&) {
-            return default_value * default_multiplier;
+    if (const string *value = findAttribute(object, key)) {
+        char *end;
+        const long number = std::strtol(value->c_str(), &end, 10);
+        if (end != value->c_str()) {
+            return static_cast<int>(number) * multiplier;
         }
     }
     return default_value * default_multiplier;
 }
 
-float SystemFactory::getFloatAttribute(Object object, string key, float default_value,
+float SystemFactory::getFloatAttribute(const Object &object, const char *key, float default_value,
         float multiplier, float default_multiplier) {
-    alg::to_lower(key);
-    if (object.attributes.count(key)) {
-        try {
-            return std::stof(object.attributes[key]) * multiplier;
-        } catch (std::invalid_argument&) {
-            return default_value * default_multiplier;
+    if (const string *value = findAttribute(object, key)) {
+        char *end;
+        const float number = std::strtof(value->c_str(), &end);
+        if (end != value->c_str()) {
+            return number * multiplier;
         }
     }
     return default_value * default_multiplier;
 }
 
-double SystemFactory::getDoubleAttribute(Object object, string key, double default_value,
+double SystemFactory::getDoubleAttribute(const Object &object, const char *key, double default_value,
         double multiplier, double default_multiplier) {
-    alg::to_lower(key);
-    if (object.attributes.count(key)) {
-        try {
-            return std::stod(object.attributes[key]) * multiplier;
-        } catch (std::invalid_argument&) {
-            return default_value * default_multiplier;
+    if (const string *value = findAttribute(object, key)) {
+        char *end;
+        const double number = std::strtod(value->c_str(), &end);
+        if (end != value->c_str()) {
+            return number * multiplier;
         }
     }
     return default_value * default_multiplier;
 }
 
-void SystemFactory::initializeQVector(Object object, string key_prefix, QVector &vector, double multiplier) {
-    vector.i = getDoubleAttribute(object, key_prefix + "i", vector.i, multiplier);
-    vector.j = getDoubleAttribute(object, key_prefix + "j", vector.j, multiplier);
-    vector.k = getDoubleAttribute(object, key_prefix + "k", vector.k, multiplier);
+void SystemFactory::initializeQVector(const Object &object, const string &key_prefix, QVector &vector,
+        double multiplier) {
+    vector.i = getDoubleAttribute(object, (key_prefix + "i").c_str(), vector.i, multiplier);
+    vector.j = getDoubleAttribute(object, (key_prefix + "j").c_str(), vector.j, multiplier);
+    vector.k = getDoubleAttribute(object, (key_prefix + "k").c_str(), vector.k, multiplier);
 }
 
-void SystemFactory::initializeMaterial(Object object, GFXMaterial &material) {
+void SystemFactory::initializeMaterial(const Object &object, GFXMaterial &material) {
     material.er = getFloatAttribute(object, "Red", material.er);
     material.eg = getFloatAttribute(object, "Green", material.eg);
     material.eb = getFloatAttribute(object, "Blue", material.eb);
@@ -743,15 +856,16 @@ void SystemFactory::initializeMaterial(Object object, GFXMaterial &material) {
 // If we do but it's invalid, we use ONE/ZERO
 // Otherwise we actually parse it
 // This doesn't seem right
-void SystemFactory::initializeAlpha(Object object, BLENDFUNC blend_source, BLENDFUNC blend_destination) {
-    if (!object.attributes.count("alpha")) {
+void SystemFactory::initializeAlpha(const Object &object, BLENDFUNC blend_source, BLENDFUNC blend_destination) {
+    const string *value = findAttribute(object, "alpha");
+    if (!value) {
         return;
     }
 
     blend_source = ONE;
     blend_destination = ZERO;
 
-    const char *alpha = object.attributes["alpha"].c_str();
+    const char *alpha = value->c_str();
     if (alpha == nullptr || alpha[0] == 0) {
         return;
     } // This is really only a check for an empty string. Refactor?
@@ -773,7 +887,7 @@ void SystemFactory::initializeAlpha(Object object, BLENDFUNC blend_source, BLEND
     free(d);
 }
 
-GFXColor SystemFactory::initializeColor(Object object) {
+GFXColor SystemFactory::initializeColor(const Object &object) {
     return GFXColor(getFloatAttribute(object, "red", 0),
             getFloatAttribute(object, "green", 0),
             getFloatAttribute(object, "blue", 0),
@@ -25,10 +25,13 @@
 #include "gfx/vec.h"
 #include "gfxlib_struct.h"
 
+#include <deque>
 #include <string>
 #include <vector>
 #include <map>
-#include <boost/property_tree/ptree.hpp>
+#include <memory>
+#include <unordered_set>
+#include <utility>
 
 using std::string;
 using std::map;
@@ -39,13 +42,59 @@ struct Star_XML;
 class Planet;
 
 class SystemFactory {
+public:
+    struct Attribute {
+        const string *key; // lower case, interned by the document
+        string value;
+    };
+
     struct Object {
         string type;
-        map<string, string> attributes;
-        vector<Object> objects;
+        vector<Attribute> attributes;
+        vector<Object *> objects;
+    };
+
+    // A parsed system file. Its objects and attribute keys live as long as it does.
+    class Document {
+    public:
+        Document();
+        Document(const Document &) = delete;
+        Document &operator=(const Document &) = delete;
+
+        Object &root() {
+            return objects.front();
+        }
+        const Object &root() const {
+            return objects.front();
+        }
+        Object *newObject();
+        const string *intern(const string &name);
+        size_t numObjects() const {
+            return objects.size() - 1;
+        }
+
+        double parse_seconds{0.0};
+
+    private:
+        std::deque<Object> objects;
+        std::unordered_set<string> names;
+    };
+
+    // How long loading a system file took, for benchmarks
+    struct LoadTime {
+        string file;
+        size_t objects;
+        bool prefetched;
+        double parse_seconds;
+        double build_seconds;
     };
 
-    Object root;
+    // Off unless a benchmark turns it on, as they are kept for as long as the game runs
+    static void recordLoadTimes(bool record);
+    static const vector<LoadTime> &loadTimes();
+
+private:
+    std::shared_ptr<Document> document;
 
     struct Color {
         double red;
@@ -75,34 +124,39 @@ public:
     // Constructor
     SystemFactory(string const &relative_filename, string &system_file, Star_XML *xml);
 
-    void recursiveParse(boost::property_tree::ptree tree, Object &object);
-    void recursiveProcess(Star_XML *xml, Object &object, Planet *owner, int level = 0);
-
-    void processLight(Object &object);
-    void processSystem(Star_XML *xml, Object &object);
-    void processRing(Star_XML *xml, Object &object, Planet *owner);
-    Planet *processPlanet(Star_XML *xml, Object &object, Planet *owner);
-    void processSpaceElevator(Object &object, Planet *owner);
-    void processFog(Star_XML *xml, Object &object, Planet *owner);
-    void processEnhancement(string element, Star_XML *xml, Object &object, Planet *owner);
-    void processAsteroid(Star_XML *xml, Object &object, Planet *owner);
-
-    string getStringAttribute(Object object, string key, string default_value = "");
-    bool getBoolAttribute(Object object, string key, bool default_value = true);
-    char getCharAttribute(Object object, string key, char default_value);
-    int getIntAttribute(Object object, string key, int default_value = 1,
+    // Reads the file into a document in one pass. Touches nothing but the file, so any thread may call it
+    static std::shared_ptr<Document> parseFile(const string &system_file);
+    // The textures of the planets and rings of object and its children, and their units as file and faction
+    static void findAssets(const Object &object, vector<string> &textures, vector<std::pair<string, string>> &units);
+    void recursiveProcess(Star_XML *xml, const Object &object, Planet *owner, int level = 0);
+
+    void processLight(const Object &object);
+    void processSystem(Star_XML *xml, const Object &object);
+    void processRing(Star_XML *xml, const Object &object, Planet *owner);
+    Planet *processPlanet(Star_XML *xml, const Object &object, Planet *owner);
+    void processSpaceElevator(const Object &object, Planet *owner);
+    void processFog(Star_XML *xml, const Object &object, Planet *owner);
+    void processEnhancement(const string &element, Star_XML *xml, const Object &object, Planet *owner);
+    void processAsteroid(Star_XML *xml, const Object &object, Planet *owner);
+
+    // The value of the attribute, whose key is matched regardless of case, or nullptr
+    static const string *findAttribute(const Object &object, const char *key);
+    string getStringAttribute(const Object &object, const char *key, const string &default_value = "");
+    bool getBoolAttribute(const Object &object, const char *key, bool default_value = true);
+    char getCharAttribute(const Object &object, const char *key, char default_value);
+    int getIntAttribute(const Object &object, const char *key, int default_value = 1,
             int multiplier = 1, int default_multiplier = 1);
-    float getFloatAttribute(Object object, string key, float default_value = 1.0f,
+    float getFloatAttribute(const Object &object, const char *key, float default_value = 1.0f,
             float multiplier = 1.0f, float default_multiplier = 1.0f);
-    double getDoubleAttribute(Object object, string key, double default_value = 1.0,
+    double getDoubleAttribute(const Object &object, const char *key, double default_value = 1.0,
             double multiplier = 1.0, double default_multiplier = 1.0);
 
-    void initializeQVector(Object object, string key_prefix, QVector &vector,
+    void initializeQVector(const Object &object, const string &key_prefix, QVector &vector,
             double multiplier = 1.0);
-    void initializeMaterial(Object object, GFXMaterial &material);
-    void initializeAlpha(Object object, BLENDFUNC blend_source,
+    void initializeMaterial(const Object &object, GFXMaterial &material);
+    void initializeAlpha(const Object &object, BLENDFUNC blend_source,
             BLENDFUNC blend_destination);
-    GFXColor initializeColor(Object object);
+    GFXColor initializeColor(const Object &object);
 };
 
 #endif //VEGA_STRIKE_ENGINE_SYSTEM_FACTORY_H
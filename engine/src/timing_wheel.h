@@ -0,0 +1,192 @@
+/*
+ * timing_wheel.h
+ *
+ * Copyright (C) 2023 Vega Strike contributors.
+ *
+ * https://github.com/vegastrike/Vega-Strike-Engine-Source
+ *
+ * This file is part of Vega Strike.
+ *
+ * Vega Strike is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Vega Strike is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Vega Strike. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef VEGA_STRIKE_ENGINE_TIMING_WHEEL_H
+#define VEGA_STRIKE_ENGINE_TIMING_WHEEL_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Schedule of items that fall due every so many atoms, e.g. the units of a
+ * star system waiting for their next physics step.
+ *
+ * The wheel has one bucket per atom of a full turn. Each item is in at most
+ * one bucket, and the wheel remembers which one and where, so scheduling,
+ * moving and removing an item are O(1) whatever the number of items. An item
+ * can be scheduled at most one turn ahead.
+ */
+template<typename Item>
+class TimingWheel {
+public:
+    /// Load of the buckets of a whole turn
+    struct LoadStats {
+        size_t items{0};
+        size_t quietest{0};
+        size_t busiest{0};
+        /// How many atoms from now the busiest bucket falls due
+        unsigned int busiest_delay{0};
+    };
+
+    explicit TimingWheel(unsigned int turn) : buckets(std::max(turn, 1u)) {
+    }
+
+    /// Atoms in a full turn of the wheel
+    unsigned int Turn() const {
+        return static_cast<unsigned int>(buckets.size());
+    }
+
+    /// The bucket falling due now
+    unsigned int Now() const {
+        return now;
+    }
+
+    size_t Size() const {
+        return positions.size();
+    }
+
+    bool Contains(const Item &item) const {
+        return positions.find(item) != positions.end();
+    }
+
+    /// Atoms until the item falls due: 0 if it is due now, Turn() if it is not scheduled
+    unsigned int DelayOf(const Item &item) const {
+        typename std::unordered_map<Item, Position>::const_iterator found = positions.find(item);
+        if (found == positions.end()) {
+            return Turn();
+        }
+        return (found->second.bucket + Turn() - now) % Turn();
+    }
+
+    /**
+     * Makes the item fall due the given number of atoms from now, clamped to
+     * 1 through a full turn, whether or not it was scheduled already.
+     * @return whether the item is new to the wheel
+     */
+    bool Schedule(const Item &item, unsigned int delay) {
+        delay = std::min(std::max(delay, 1u), Turn());
+        const unsigned int bucket = (now + delay) % Turn();
+        std::pair<typename std::unordered_map<Item, Position>::iterator, bool> inserted =
+                positions.insert(std::make_pair(item, Position()));
+        Position &position = inserted.first->second;
+        if (!inserted.second) {
+            if (position.bucket == bucket) {
+                return false;
+            }
+            Unlink(position);
+        }
+        position.bucket = bucket;
+        position.index = buckets[bucket].size();
+        buckets[bucket].push_back(item);
+        return inserted.second;
+    }
+
+    /// @return whether the item was scheduled
+    bool Remove(const Item &item) {
+        typename std::unordered_map<Item, Position>::iterator found = positions.find(item);
+        if (found == positions.end()) {
+            return false;
+        }
+        Unlink(found->second);
+        positions.erase(found);
+        return true;
+    }
+
+    /// The items due now, in no particular order
+    const std::vector<Item> &Due() const {
+        return buckets[now];
+    }
+
+    /// The items of a bucket, in no particular order
+    const std::vector<Item> &Bucket(unsigned int bucket) const {
+        return buckets[bucket % Turn()];
+    }
+
+    /// Moves on to the next bucket. Items still due now fall due again a full turn later.
+    void Advance() {
+        now = (now + 1) % Turn();
+    }
+
+    /// Items falling due the given number of atoms from now
+    size_t Load(unsigned int delay) const {
+        return buckets[(now + delay) % Turn()].size();
+    }
+
+    LoadStats Stats() const {
+        LoadStats stats;
+        stats.items = positions.size();
+        stats.quietest = buckets[0].size();
+        for (unsigned int delay = 0; delay < Turn(); ++delay) {
+            const size_t load = Load(delay);
+            stats.quietest = std::min(stats.quietest, load);
+            if (load > stats.busiest) {
+                stats.busiest = load;
+                stats.busiest_delay = delay;
+            }
+        }
+        return stats;
+    }
+
+    /**
+     * A delay of 1 through max_delay atoms that keeps the buckets even: the
+     * quieter of two drawn from the random number. Drawing two and keeping
+     * the better spreads items about as well as looking at every bucket.
+     */
+    unsigned int SpreadDelay(unsigned int max_delay, uint32_t random) const {
+        max_delay = std::min(std::max(max_delay, 1u), Turn());
+        const unsigned int first = 1 + (random & 0xffff) % max_delay;
+        const unsigned int second = 1 + (random >> 16) % max_delay;
+        return Load(second) < Load(first) ? second : first;
+    }
+
+    void Clear() {
+        for (std::vector<Item> &bucket : buckets) {
+            bucket.clear();
+        }
+        positions.clear();
+    }
+
+private:
+    struct Position {
+        unsigned int bucket{0};
+        size_t index{0};
+    };
+
+    // Takes the item out of its bucket by moving the last item of the bucket into its place
+    void Unlink(const Position &position) {
+        std::vector<Item> &bucket = buckets[position.bucket];
+        if (position.index + 1 != bucket.size()) {
+            bucket[position.index] = bucket.back();
+            positions[bucket[position.index]].index = position.index;
+        }
+        bucket.pop_back();
+    }
+
+    std::vector<std::vector<Item>> buckets;
+    std::unordered_map<Item, Position> positions;
+    unsigned int now{0};
+};
+
+#endif //VEGA_STRIKE_ENGINE_TIMING_WHEEL_H
@@ -0,0 +1,98 @@
+/*
+ * timing_wheel_tests.cpp
+ *
+ * Copyright (C) 2023 Vega Strike contributors.
+ *
+ * https://github.com/vegastrike/Vega-Strike-Engine-Source
+ *
+ * This file is part of Vega Strike.
+ *
+ * Vega Strike is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Vega Strike is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Vega Strike. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+#include "timing_wheel.h"
+
+TEST(TimingWheel, ItemsFallDueAfterTheirDelay) {
+    TimingWheel<int> wheel(8);
+    EXPECT_TRUE(wheel.Schedule(1, 1));
+    EXPECT_TRUE(wheel.Schedule(2, 3));
+    EXPECT_FALSE(wheel.Schedule(2, 3));
+    EXPECT_EQ(3u, wheel.DelayOf(2));
+    EXPECT_EQ(8u, wheel.DelayOf(3));
+    EXPECT_TRUE(wheel.Due().empty());
+    wheel.Advance();
+    ASSERT_EQ(1u, wheel.Due().size());
+    EXPECT_EQ(1, wheel.Due()[0]);
+    EXPECT_EQ(0u, wheel.DelayOf(1));
+    wheel.Advance();
+    wheel.Advance();
+    ASSERT_EQ(1u, wheel.Due().size());
+    EXPECT_EQ(2, wheel.Due()[0]);
+}
+
+TEST(TimingWheel, DelaysAreClampedToATurn) {
+    TimingWheel<int> wheel(8);
+    wheel.Schedule(1, 0);
+    EXPECT_EQ(1u, wheel.DelayOf(1));
+    //A full turn puts it back in the bucket due now, to be done again next time round
+    wheel.Schedule(1, 100);
+    EXPECT_EQ(0u, wheel.DelayOf(1));
+    EXPECT_EQ(1u, wheel.Load(8));
+}
+
+TEST(TimingWheel, MovesAndRemovesKeepTheOtherItems) {
+    TimingWheel<int> wheel(8);
+    for (int item = 0; item < 5; ++item) {
+        wheel.Schedule(item, 4);
+    }
+    //Promote one from the middle, demote another, remove a third
+    wheel.Schedule(1, 1);
+    wheel.Schedule(3, 6);
+    EXPECT_TRUE(wheel.Remove(0));
+    EXPECT_FALSE(wheel.Remove(0));
+    EXPECT_EQ(4u, wheel.Size());
+    EXPECT_EQ(1u, wheel.Load(1));
+    EXPECT_EQ(2u, wheel.Load(4));
+    EXPECT_EQ(1u, wheel.Load(6));
+    EXPECT_EQ(4u, wheel.DelayOf(2));
+    EXPECT_EQ(4u, wheel.DelayOf(4));
+    //The positions of the moved items still match their buckets
+    EXPECT_TRUE(wheel.Remove(4));
+    EXPECT_TRUE(wheel.Remove(2));
+    EXPECT_EQ(0u, wheel.Load(4));
+    EXPECT_EQ(1u, wheel.DelayOf(1));
+    EXPECT_EQ(6u, wheel.DelayOf(3));
+}
+
+TEST(TimingWheel, SpreadDelayKeepsTheBucketsEven) {
+    const unsigned int turn = 128;
+    const unsigned int items = 128 * 20;
+    TimingWheel<unsigned int> wheel(turn);
+    std::mt19937 random(7);
+    for (unsigned int item = 0; item < items; ++item) {
+        const unsigned int delay = wheel.SpreadDelay(turn, random());
+        EXPECT_GE(delay, 1u);
+        EXPECT_LE(delay, turn);
+        wheel.Schedule(item, delay);
+    }
+    const TimingWheel<unsigned int>::LoadStats stats = wheel.Stats();
+    EXPECT_EQ(items, stats.items);
+    //Uniformly random delays would leave some buckets about half again as full as the mean
+    EXPECT_LE(stats.busiest, items / turn + 3);
+    EXPECT_GE(stats.quietest, items / turn - 3);
+}
@@ -23,6 +23,7 @@
 
 #include <stdio.h>
 #include <fcntl.h>
+#include <sys/stat.h>
 #include "gfxlib.h"
 #include "universe.h"
 #include "lin_time.h"
@@ -57,12 +58,20 @@
 #include "unit_csv_factory.h"
 #include "unit_json_factory.h"
 #include "unit_optimize_factory.h"
+#include "star_system_loader.h"
+#include "unit_database.h"
+#include "unit_util.h"
 
 #include <algorithm>
+#include <chrono>
+#include <functional>
+#include <limits>
 #include <string>
 #include <vector>
 
 #include "options.h"
+#include "worker_pool.h"
+#include "python/python_compile.h"
 
 // Using
 using namespace VSFileSystem;
@@ -271,6 +280,39 @@ static void AppendUnitTables(const string &csvfiles) {
     }
 }
 
+// Fills UnitCSVFactory from a unit table, going through its compiled copy
+// in the home directory unless the table has changed since it was compiled
+static void LoadUnitTable(VSFileSystem::VSFile &file, const std::function<void(const std::string &)> &parse) {
+    if (!configuration()->data_config.unit_database_cache) {
+        parse(file.ReadFull());
+        return;
+    }
+
+    // Keyed by where the table lives too, since its root is part of every unit
+    const std::string cache_path = (boost::format("%1%/cache/%2%.%3$016x.db") % VSFileSystem::homedir
+            % file.GetFilename() % UnitDatabase::Hash(file.GetFullPath())).str();
+    UnitDatabase::SourceStamp source;
+    source.size = file.Size();
+    struct stat st{};
+    if (!file.UseVolume() && file.GetFP() != nullptr && fstat(fileno(file.GetFP()), &st) == 0) {
+        source.modified = st.st_mtime;
+    }
+    if (UnitDatabase::Load(cache_path, source)) {
+        return;
+    }
+
+    const std::string data = file.ReadFull();
+    source.hash = UnitDatabase::Hash(data);
+    if (UnitDatabase::Load(cache_path, source)) {
+        // Touched but not changed: remember the new timestamp
+        UnitDatabase::Save(cache_path, source);
+        return;
+    }
+    VS_LOG(info, (boost::format("Compiling %1% into %2%") % file.GetFilename() % cache_path));
+    parse(data);
+    UnitDatabase::Save(cache_path, source);
+}
+
 void InitUnitTables() {
     // Old Init
     AppendUnitTables(game_options()->modUnitCSV);
@@ -280,15 +322,17 @@ void InitUnitTables() {
     VSFileSystem::VSFile jsonFile;
     VSFileSystem::VSError err = jsonFile.OpenReadOnly("units.json", VSFileSystem::UnitFile);
     if (err <= VSFileSystem::Ok) {
-        UnitJSONFactory::ParseJSON(jsonFile);
-
+        LoadUnitTable(jsonFile, [&jsonFile](const std::string &data) {
+            UnitJSONFactory::ParseJSON(data, jsonFile.GetRoot());
+        });
     } else {
         // Try units.csv
         VSFileSystem::VSFile csvFile;
         VSFileSystem::VSError err = csvFile.OpenReadOnly("units.csv", VSFileSystem::UnitFile);
         if (err <= VSFileSystem::Ok) {
-            std::string data = csvFile.ReadFull();
-            UnitCSVFactory::ParseCSV(data, csvFile.GetRoot(), true);
+            LoadUnitTable(csvFile, [&csvFile](const std::string &data) {
+                UnitCSVFactory::ParseCSV(data, csvFile.GetRoot(), true);
+            });
         } else {
             std::cerr << "Unable to open units file. Aborting.\n";
             abort();
@@ -315,6 +359,52 @@ void InitUnitTables() {
     newJsonFile.Close();
 }
 
+// Times filling UnitCSVFactory from units.json, or units.csv, both ways
+// LoadUnitTable() can: parsing the table and loading a compiled copy of it.
+// Each is the best of repeats runs. For vegastrike-simbench.
+bool TimeUnitTableLoads(unsigned int repeats, std::string &table, double &parse_seconds, double &load_seconds) {
+    VSFileSystem::VSFile file;
+    std::function<void(const std::string &)> parse;
+    if (file.OpenReadOnly("units.json", VSFileSystem::UnitFile) <= VSFileSystem::Ok) {
+        parse = [&file](const std::string &data) {
+            UnitJSONFactory::ParseJSON(data, file.GetRoot());
+        };
+    } else if (file.OpenReadOnly("units.csv", VSFileSystem::UnitFile) <= VSFileSystem::Ok) {
+        parse = [&file](const std::string &data) {
+            UnitCSVFactory::ParseCSV(data, file.GetRoot(), true);
+        };
+    } else {
+        return false;
+    }
+    table = file.GetFilename();
+    const std::string data = file.ReadFull();
+
+    parse_seconds = load_seconds = std::numeric_limits<double>::max();
+    for (unsigned int run = 0; run < repeats; ++run) {
+        const auto start = std::chrono::steady_clock::now();
+        parse(data);
+        parse_seconds = std::min(parse_seconds,
+                std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+
+    // Apart from the one startup uses, so as to leave it alone
+    const std::string cache_path = (boost::format("%1%/cache/simbench.%2%.db") % VSFileSystem::homedir
+            % table).str();
+    UnitDatabase::SourceStamp source;
+    source.size = data.size();
+    source.hash = UnitDatabase::Hash(data);
+    bool loaded = UnitDatabase::Save(cache_path, source);
+    for (unsigned int run = 0; loaded && run < repeats; ++run) {
+        const auto start = std::chrono::steady_clock::now();
+        loaded = UnitDatabase::Load(cache_path, source);
+        load_seconds = std::min(load_seconds,
+                std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    remove(cache_path.c_str());
+    file.Close();
+    return loaded;
+}
+
 void CleanupUnitTables() {
     for (std::vector<CSVTable *>::iterator it = unitTables.begin(); it != unitTables.end(); ++it) {
         delete *it;
@@ -343,6 +433,13 @@ Universe::Universe(int argc, char **argv, const char *galaxy_str) {
     //Hasten splash screen loading, to cover up lengthy universe initialization
     bootstrap_first_loop();
 
+    InitGalaxy(galaxy_str);
+    _script_system = NULL;
+    _current_cockpit = 0;
+    _script_system = nullptr;
+}
+
+void Universe::InitGalaxy(const char *galaxy_str) {
     ROLES::getAllRolePriorities();
     //LoadWeapons( VSFileSystem::weapon_list.c_str() );
     WeaponFactory wf = WeaponFactory(VSFileSystem::weapon_list);
@@ -353,9 +450,6 @@ Universe::Universe(int argc, char **argv, const char *galaxy_str) {
         LoadFactionXML("factions.xml");
         firsttime = true;
     }
-    _script_system = NULL;
-    _current_cockpit = 0;
-    _script_system = nullptr;
 }
 
 Universe::Universe() {
@@ -442,10 +536,17 @@ void Universe::StartDraw() {
     UpdateTime();
     UpdateTimeCompressionSounds();
     _Universe->SetActiveCockpit(((int) (rand01() * _cockpits.size())) % _cockpits.size());
-    for (i = 0; i < star_system.size() && i < game_options()->NumRunningSystems; ++i) {
-        star_system[i]->Update((i == 0) ? 1 : game_options()->InactiveSystemTime / i, true);
+    size_t num_running_systems = std::min<size_t>(star_system.size(), game_options()->NumRunningSystems);
+    if (configuration()->physics_config.parallel_star_systems && num_running_systems > 1) {
+        UpdateStarSystemsInParallel(num_running_systems);
+    } else {
+        for (i = 0; i < num_running_systems; ++i) {
+            star_system[i]->Update((i == 0) ? 1 : game_options()->InactiveSystemTime / i, true);
+        }
     }
     StarSystem::ProcessPendingJumps();
+    //Hands the background loader the files of the systems it parsed
+    GetStarSystemLoader().FindAssets();
     for (i = 0; i < _cockpits.size(); ++i) {
         SetActiveCockpit(i);
         pushActiveStarSystem(AccessCockpit(i)->activeStarSystem);
@@ -482,6 +583,74 @@ void Universe::StartDraw() {
     }
 }
 
+void Universe::UpdateStarSystemsInParallel(size_t num_systems) {
+    vector<StarSystem *> systems(star_system.begin(), star_system.begin() + num_systems);
+    float normal_simulation_atom = simulation_atom_var;
+    for (size_t i = 0; i < systems.size(); ++i) {
+        systems[i]->BeginUpdate((i == 0) ? 1 : game_options()->InactiveSystemTime / i);
+    }
+
+    // Everything but the unit stage runs here, between the batches, in the
+    // same order the serial update would use
+    vector<StarSystem *> unit_stages;
+    vector<WorkerPool::Task> tasks;
+    while (true) {
+        bool any_atom_due = false;
+        unit_stages.clear();
+        for (StarSystem *system : systems) {
+            if (!system->AtomDue()) {
+                continue;
+            }
+            any_atom_due = true;
+            if (system->UnitStageDue()) {
+                unit_stages.push_back(system);
+                continue;
+            }
+            simulation_atom_var = system->update_simulation_atom;
+            pushActiveStarSystem(system);
+            system->ExecuteMissionStage(true);
+            popActiveStarSystem();
+        }
+        if (!any_atom_due) {
+            break;
+        }
+
+        tasks.clear();
+        for (StarSystem *system : unit_stages) {
+            tasks.push_back([system]() {
+                WorkerStarSystemScope scope(system);
+                simulation_atom_var = system->update_simulation_atom;
+                system->ExecuteUnitStage();
+            });
+        }
+        //The unit stages only read the relations between factions from here on
+        UnitUtil::FreezeRelationCache();
+        try {
+            PythonGILRelease python_release;
+            GetWorkerPool().Run(tasks);
+        } catch (...) {
+            UnitUtil::ThawRelationCache();
+            throw;
+        }
+        UnitUtil::ThawRelationCache();
+
+        for (StarSystem *system : unit_stages) {
+            simulation_atom_var = system->update_simulation_atom;
+            pushActiveStarSystem(system);
+            system->FinishUnitStage();
+            popActiveStarSystem();
+        }
+    }
+
+    for (StarSystem *system : systems) {
+        simulation_atom_var = system->update_simulation_atom;
+        pushActiveStarSystem(system);
+        system->EndUpdate();
+        popActiveStarSystem();
+    }
+    simulation_atom_var = normal_simulation_atom;
+}
+
 void Universe::StartGFX() {
     GFXBeginScene();
     GFXMaterial mat;
@@ -634,27 +803,46 @@ bool Universe::setScriptSystem(string name) {
 }
 
 // Star System
+//Set while a simulation worker thread updates a star system
+static thread_local vector<StarSystem *> *worker_active_star_systems = nullptr;
+
+static vector<StarSystem *> &ActiveStarSystemStack() {
+    return worker_active_star_systems ? *worker_active_star_systems : _active_star_systems;
+}
+
+WorkerStarSystemScope::WorkerStarSystemScope(StarSystem *star_system)
+        : active_star_systems(1, star_system), previous_active_star_systems(worker_active_star_systems) {
+    worker_active_star_systems = &active_star_systems;
+}
+
+WorkerStarSystemScope::~WorkerStarSystemScope() {
+    worker_active_star_systems = previous_active_star_systems;
+}
+
 StarSystem *Universe::activeStarSystem() {
-    return _active_star_systems.empty() ? NULL
-            : _active_star_systems.back();
+    vector<StarSystem *> &active_star_systems = ActiveStarSystemStack();
+    return active_star_systems.empty() ? NULL
+            : active_star_systems.back();
 }
 
 // Missing bool StillExists( StarSystem *ss );
 void Universe::setActiveStarSystem(StarSystem *ss) {
-    if (_active_star_systems.empty()) {
+    vector<StarSystem *> &active_star_systems = ActiveStarSystemStack();
+    if (active_star_systems.empty()) {
         pushActiveStarSystem(ss);
     } else {
-        _active_star_systems.back() = ss;
+        active_star_systems.back() = ss;
     }
 }
 
 void Universe::pushActiveStarSystem(StarSystem *ss) {
-    _active_star_systems.push_back(ss);
+    ActiveStarSystemStack().push_back(ss);
 }
 
 void Universe::popActiveStarSystem() {
-    if (!_active_star_systems.empty()) {
-        _active_star_systems.pop_back();
+    vector<StarSystem *> &active_star_systems = ActiveStarSystemStack();
+    if (!active_star_systems.empty()) {
+        active_star_systems.pop_back();
     }
 }
 
@@ -703,6 +891,7 @@ void Universe::Generate2(StarSystem *ss) {
     for (unsigned int tume = 0; tume <= game_options()->num_times_to_simulate_new_star_system * SIM_QUEUE_SIZE + 1;
             ++tume) {
         ss->UpdateUnitsPhysics(true);
+        ss->RunMainThreadQueue();
     }
     //notify the director that a new system is loaded (gotta have at least one active star system)
     StarSystem *old_script_system = _script_system;
@@ -727,6 +916,8 @@ void Universe::Generate2(StarSystem *ss) {
     }
     if (firsttime) {
         firsttime = false;
+        //Later ones are prefetched when the player jumps
+        GetStarSystemLoader().PrefetchAdjacent(ss->getFileName());
     } else {
     }
     ss_generating(false);
@@ -53,6 +53,8 @@ public:
     Universe(int argc, char **argv, const char *galaxy);
     Universe();
     void Init(int argc, char **argv, const char *galaxy);
+    // Loads roles, weapons, the galaxy and factions; the part of the full constructor that needs no graphics
+    void InitGalaxy(const char *galaxy);
     ~Universe();
     class StarSystem *Init(string systemfile,
             const Vector &centroid = Vector(0, 0, 0),
@@ -76,6 +78,13 @@ public:
     //Update starsystems (for server side)
     void Update();
 
+protected:
+    // Updates the first num_systems star systems, running their unit stages
+    // concurrently on the simulation worker pool
+    void UpdateStarSystemsInParallel(size_t num_systems);
+
+public:
+
 // Camera
     Camera *AccessCamera(int num);
     Camera *AccessCamera();
@@ -127,6 +136,7 @@ public:
     void Generate1(const char *file, const char *jumpback);
     void Generate2(StarSystem *ss);
     void clearAllSystems();
+    // Reads the main thread's stack even on a simulation worker thread
     StarSystem *getActiveStarSystem(unsigned int size);
     unsigned int getNumActiveStarSystem();
     StarSystem *getStarSystem(string name);
@@ -138,4 +148,23 @@ public:
     unsigned int numPlayers();
 };
 
+/**
+ * Gives the current thread its own active star system stack for the
+ * lifetime of the scope, with star_system on top. Simulation worker
+ * threads use it so that activeStarSystem() and friends refer to the
+ * system they are updating instead of racing on the main thread's stack.
+ */
+class WorkerStarSystemScope {
+public:
+    explicit WorkerStarSystemScope(StarSystem *star_system);
+    ~WorkerStarSystemScope();
+
+    WorkerStarSystemScope(const WorkerStarSystemScope &) = delete;
+    WorkerStarSystemScope &operator=(const WorkerStarSystemScope &) = delete;
+
+private:
+    vector<StarSystem *> active_star_systems;
+    vector<StarSystem *> *previous_active_star_systems;
+};
+
 #endif //VEGA_STRIKE_ENGINE_UNIVERSE_H
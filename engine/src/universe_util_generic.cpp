@@ -399,6 +399,7 @@ namespace UniverseUtil {
         if (val > 1) {
             val = 1;
         }
+        ++FactionUtil::relations_version;
         return putSaveData(which_cp, saveVar, 0, val);
     }
 
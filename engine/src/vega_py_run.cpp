@@ -28,6 +28,7 @@
 #include <pyerrors.h>
 #include <pythonrun.h>
 #include "vega_py_run.h"
+#include "python/python_compile.h"
 #include "vega_string_utils.h"
 #include "vs_logging.h"
 
@@ -43,6 +44,7 @@ void VegaPyRunString(char *py_snippet) {
 //    VS_LOG(important_info, (boost::format("Debug mode on Windows; not running %1%") % py_snippet));
 //#else
     VS_LOG(important_info, (boost::format("running %1%") % py_snippet));
+    PythonGILLock python_lock;
     PyRun_SimpleString(py_snippet);
     //Python::reseterrors();
     if (PyErr_Occurred()) {
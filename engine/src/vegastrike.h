@@ -28,7 +28,8 @@
 #include <assert.h>
 #endif //__cplusplus
 
-extern float simulation_atom_var;
+// Each simulation thread scales the atom for the star system it is running
+extern thread_local float simulation_atom_var;
 extern float audio_atom_var;
 //#define SIMULATION_ATOM (simulation_atom_var)
 //#define AUDIO_ATOM (audio_atom_var)
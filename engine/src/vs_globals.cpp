@@ -35,7 +35,7 @@ bool run_only_player_starsystem = true;
 
 FILE *fpread = nullptr;
 
-float simulation_atom_var = (float) (1.0 / 10.0);
+thread_local float simulation_atom_var = (float) (1.0 / 10.0);
 float audio_atom_var = (float) (1.0 / 18.0);
 Mission *mission = nullptr;
 
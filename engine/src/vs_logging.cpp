@@ -25,6 +25,12 @@
 
 #include <string>
 #include <cstdint>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 #include <boost/smart_ptr/shared_ptr.hpp>
 #include <boost/smart_ptr/make_shared_object.hpp>
@@ -38,10 +44,222 @@
 #include <boost/log/utility/setup/console.hpp>
 #include <boost/log/utility/setup/file.hpp>
 #include <boost/log/utility/setup/common_attributes.hpp>
+#include <boost/log/attributes/mutable_constant.hpp>
+#include <boost/date_time/c_local_time_adjustor.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
 #include <boost/filesystem.hpp>
 
 namespace VegaStrikeLogging {
 
+// Everything until InitLoggingPart2 sets up the filter
+std::atomic<int> minimum_log_level(trace);
+
+namespace {
+
+// Records a thread can queue ahead of the writer; a power of two
+const uint64_t ring_size = 1 << 12;
+
+struct QueuedRecord {
+    uint64_t sequence;
+    vega_log_level level;
+    std::chrono::system_clock::time_point time;
+    std::string message;
+};
+
+// Single producer, the owning thread, and single consumer, whoever holds
+// the registry mutex. The strings in the slots keep their capacity, so
+// queueing a record does not allocate once a thread has logged for a while.
+struct LogRing {
+    std::vector<QueuedRecord> records;
+    std::atomic<uint64_t> tail{0};
+    char padding[64];
+    std::atomic<uint64_t> head{0};
+    // Set when the owning thread exits, so the ring can go once it is empty
+    std::atomic<bool> closed{false};
+
+    LogRing() : records(ring_size) {
+    }
+};
+
+struct RingRegistry {
+    // Taken to register a thread's ring and to drain the rings
+    std::mutex mutex;
+    std::vector<std::shared_ptr<LogRing>> rings;
+    // Orders the records of different threads
+    std::atomic<uint64_t> sequence{0};
+};
+
+// Never destroyed, since threads may still log while statics go away
+RingRegistry &ring_registry() {
+    static RingRegistry *instance = new RingRegistry;
+    return *instance;
+}
+
+struct RingOwner {
+    std::shared_ptr<LogRing> ring;
+
+    ~RingOwner() {
+        if (ring) {
+            ring->closed.store(true, std::memory_order_release);
+        }
+    }
+};
+
+LogRing &thread_ring() {
+    static thread_local RingOwner owner;
+    if (!owner.ring) {
+        owner.ring = std::make_shared<LogRing>();
+        RingRegistry &registry = ring_registry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.rings.push_back(owner.ring);
+    }
+    return *owner.ring;
+}
+
+} // namespace
+
+class AsyncLogWriter {
+public:
+    AsyncLogWriter();
+    ~AsyncLogWriter();
+
+    // False if the writer is stopping and the caller has to write the record itself
+    bool Enqueue(const vega_log_level level, const std::string &message);
+    // Writes every record queued so far, on the calling thread
+    void Drain();
+
+private:
+    void Run();
+    void Wake();
+    void Write(const QueuedRecord &record);
+
+    boost::log::sources::severity_logger<vega_log_level> slg_;
+    // Overrides the global TimeStamp with the time the record was queued
+    boost::log::attributes::mutable_constant<boost::posix_time::ptime> timestamp_;
+    // Records taken out of the rings; only used under the registry mutex
+    std::vector<QueuedRecord> batch_;
+    std::mutex wake_mutex_;
+    std::condition_variable wake_;
+    bool wake_requested_;
+    std::atomic<bool> running_;
+    std::thread thread_;
+};
+
+AsyncLogWriter::AsyncLogWriter()
+        : timestamp_(boost::posix_time::microsec_clock::local_time()),
+          wake_requested_(false),
+          running_(true) {
+    slg_.add_attribute("TimeStamp", timestamp_);
+    thread_ = std::thread(&AsyncLogWriter::Run, this);
+}
+
+AsyncLogWriter::~AsyncLogWriter() {
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        running_.store(false, std::memory_order_relaxed);
+    }
+    wake_.notify_one();
+    thread_.join();
+    Drain();
+}
+
+bool AsyncLogWriter::Enqueue(const vega_log_level level, const std::string &message) {
+    LogRing &ring = thread_ring();
+    const uint64_t tail = ring.tail.load(std::memory_order_relaxed);
+    while (tail - ring.head.load(std::memory_order_acquire) >= ring_size) {
+        if (!running_.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        Wake();
+        std::this_thread::yield();
+    }
+    QueuedRecord &record = ring.records[tail & (ring_size - 1)];
+    record.sequence = ring_registry().sequence.fetch_add(1, std::memory_order_relaxed);
+    record.level = level;
+    record.time = std::chrono::system_clock::now();
+    record.message.assign(message);
+    ring.tail.store(tail + 1, std::memory_order_release);
+    // Don't let a chatty thread wait for the writer's next round
+    if (((tail + 1) & (ring_size / 2 - 1)) == 0) {
+        Wake();
+    }
+    return true;
+}
+
+void AsyncLogWriter::Wake() {
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        wake_requested_ = true;
+    }
+    wake_.notify_one();
+}
+
+void AsyncLogWriter::Run() {
+    std::unique_lock<std::mutex> lock(wake_mutex_);
+    while (running_.load(std::memory_order_relaxed)) {
+        wake_.wait_for(lock, std::chrono::milliseconds(50), [this]() {
+            return wake_requested_ || !running_.load(std::memory_order_relaxed);
+        });
+        wake_requested_ = false;
+        lock.unlock();
+        Drain();
+        lock.lock();
+    }
+}
+
+void AsyncLogWriter::Drain() {
+    RingRegistry &registry = ring_registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    size_t batch_size = 0;
+    for (auto it = registry.rings.begin(); it != registry.rings.end();) {
+        LogRing &ring = **it;
+        // Read before tail: once closed, nothing more gets queued
+        const bool closed = ring.closed.load(std::memory_order_acquire);
+        const uint64_t tail = ring.tail.load(std::memory_order_acquire);
+        uint64_t head = ring.head.load(std::memory_order_relaxed);
+        for (; head < tail; ++head) {
+            QueuedRecord &record = ring.records[head & (ring_size - 1)];
+            if (batch_size == batch_.size()) {
+                batch_.emplace_back();
+            }
+            QueuedRecord &taken = batch_[batch_size++];
+            taken.sequence = record.sequence;
+            taken.level = record.level;
+            taken.time = record.time;
+            // Hands the slot a used buffer in return
+            taken.message.swap(record.message);
+        }
+        ring.head.store(head, std::memory_order_release);
+        if (closed) {
+            it = registry.rings.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    std::sort(batch_.begin(), batch_.begin() + batch_size, [](const QueuedRecord &a, const QueuedRecord &b) {
+        return a.sequence < b.sequence;
+    });
+    for (size_t i = 0; i < batch_size; ++i) {
+        Write(batch_[i]);
+    }
+}
+
+void AsyncLogWriter::Write(const QueuedRecord &record) {
+    const int64_t microseconds_since_epoch =
+            std::chrono::duration_cast<std::chrono::microseconds>(record.time.time_since_epoch()).count();
+    const boost::posix_time::ptime utc =
+            boost::posix_time::from_time_t(0) + boost::posix_time::microseconds(microseconds_since_epoch);
+    timestamp_.set(boost::date_time::c_local_adjustor<boost::posix_time::ptime>::utc_to_local(utc));
+    boost::log::record rec = slg_.open_record(boost::log::keywords::severity = record.level);
+    if (rec)
+    {
+        boost::log::record_ostream strm(rec);
+        strm << record.message;
+        strm.flush();
+        slg_.push_record(boost::move(rec));
+    }
+}
+
 // void exitProgram(int code)
 // {
 //     Music::CleanupMuzak();
@@ -57,20 +275,23 @@ void VegaStrikeLogger::InitLoggingPart2(const uint8_t debug_level,
     const std::string &logging_dir_name = logging_dir.string();
     VS_LOG(info, (boost::format("log directory : '%1%'") % logging_dir_name));
 
+    vega_log_level minimum_level;
     switch (debug_level) {
         case 1:
-            logging_core_->set_filter(severity >= info);
+            minimum_level = info;
             break;
         case 2:
-            logging_core_->set_filter(severity >= debug);
+            minimum_level = debug;
             break;
         case 3:
-            logging_core_->set_filter(severity >= trace);
+            minimum_level = trace;
             break;
         default:
-            logging_core_->set_filter(severity >= important_info);
+            minimum_level = important_info;
             break;
     }
+    logging_core_->set_filter(severity >= minimum_level);
+    minimum_log_level.store(minimum_level, std::memory_order_relaxed);
 
     file_log_sink_ = boost::log::add_file_log
             (
@@ -91,7 +312,18 @@ void VegaStrikeLogger::InitLoggingPart2(const uint8_t debug_level,
     console_log_sink_->set_filter(severity >= fatal);
 }
 
+void VegaStrikeLogger::StartAsyncWriter() {
+    if (!async_writer_) {
+        async_writer_.reset(new AsyncLogWriter());
+        active_async_writer_.store(async_writer_.get(), std::memory_order_release);
+    }
+}
+
 void VegaStrikeLogger::FlushLogs() {
+    AsyncLogWriter *writer = active_async_writer_.load(std::memory_order_acquire);
+    if (writer) {
+        writer->Drain();
+    }
     if (console_log_sink_) {
         console_log_sink_->flush();
     }
@@ -102,7 +334,7 @@ void VegaStrikeLogger::FlushLogs() {
     fflush(stderr);
 }
 
-VegaStrikeLogger::VegaStrikeLogger() {
+VegaStrikeLogger::VegaStrikeLogger() : active_async_writer_(nullptr) {
     logging_core_ = boost::log::core::get();
     boost::log::add_common_attributes();
     slg_ = boost::make_shared<boost::log::sources::severity_logger_mt<vega_log_level>>();
@@ -119,10 +351,28 @@ VegaStrikeLogger::VegaStrikeLogger() {
 }
 
 VegaStrikeLogger::~VegaStrikeLogger() {
+    active_async_writer_.store(nullptr, std::memory_order_release);
+    // Stops the writer thread after it wrote everything
+    async_writer_.reset();
     FlushLogs();
 }
 
-void VegaStrikeLogger::Log(const vega_log_level level, const std::string &message) {
+void VegaStrikeLogger::Dispatch(const vega_log_level level, const std::string &message) {
+    AsyncLogWriter *writer = active_async_writer_.load(std::memory_order_acquire);
+    if (writer) {
+        if (level < fatal && writer->Enqueue(level, message)) {
+            return;
+        }
+        // Whatever was queued comes first, and fatal records are flushed right away
+        writer->Drain();
+        Write(level, message);
+        FlushLogs();
+        return;
+    }
+    Write(level, message);
+}
+
+void VegaStrikeLogger::Write(const vega_log_level level, const std::string &message) {
     boost::log::record rec = slg_->open_record(boost::log::keywords::severity = level);
     if (rec)
     {
@@ -133,20 +383,17 @@ void VegaStrikeLogger::Log(const vega_log_level level, const std::string &messag
     }
 }
 
+void VegaStrikeLogger::Log(const vega_log_level level, const std::string &message) {
+    Dispatch(level, message);
+}
+
 void VegaStrikeLogger::LogAndFlush(const vega_log_level level, const std::string &message) {
     Log(level, message);
     FlushLogs();
 }
 
 void VegaStrikeLogger::Log(const vega_log_level level, const char *message) {
-    boost::log::record rec = slg_->open_record(boost::log::keywords::severity = level);
-    if (rec)
-    {
-        boost::log::record_ostream strm(rec);
-        strm << message;
-        strm.flush();
-        slg_->push_record(boost::move(rec));
-    }
+    Dispatch(level, std::string(message));
 }
 
 void VegaStrikeLogger::LogAndFlush(const vega_log_level level, const char *message) {
@@ -155,14 +402,7 @@ void VegaStrikeLogger::LogAndFlush(const vega_log_level level, const char *messa
 }
 
 void VegaStrikeLogger::Log(const vega_log_level level, const boost::basic_format<char> &message) {
-    boost::log::record rec = slg_->open_record(boost::log::keywords::severity = level);
-    if (rec)
-    {
-        boost::log::record_ostream strm(rec);
-        strm << message;
-        strm.flush();
-        slg_->push_record(boost::move(rec));
-    }
+    Dispatch(level, message.str());
 }
 
 void VegaStrikeLogger::LogAndFlush(const vega_log_level level, const boost::basic_format<char> &message) {
@@ -22,7 +22,10 @@
 #ifndef VEGA_STRIKE_ENGINE_VS_LOGGING_H
 #define VEGA_STRIKE_ENGINE_VS_LOGGING_H
 
+#include <atomic>
 #include <cstdint>
+#include <memory>
+#include <string>
 
 #include <boost/move/utility_core.hpp>
 #include <boost/smart_ptr/shared_ptr.hpp>
@@ -53,26 +56,49 @@ BOOST_LOG_ATTRIBUTE_KEYWORD(severity, "Severity", vega_log_level)
 typedef boost::log::sinks::synchronous_sink<boost::log::sinks::text_ostream_backend> ConsoleLogSink;
 typedef boost::log::sinks::synchronous_sink<boost::log::sinks::text_file_backend> FileLogSink;
 
+///Lowest level that is logged at all. Mirrors the logging core's filter so
+///that VS_LOG can skip formatting messages nobody will see.
+extern std::atomic<int> minimum_log_level;
+
+inline bool IsLogged(const vega_log_level level) {
+    return level >= minimum_log_level.load(std::memory_order_relaxed);
+}
+
 #define VS_LOG(log_level, log_message)                                                                              \
     do {                                                                                                            \
-        VegaStrikeLogging::vega_logger()->Log(VegaStrikeLogging::vega_log_level::log_level, (log_message));         \
+        if (VegaStrikeLogging::IsLogged(VegaStrikeLogging::vega_log_level::log_level)) {                            \
+            VegaStrikeLogging::vega_logger()->Log(VegaStrikeLogging::vega_log_level::log_level, (log_message));     \
+        }                                                                                                           \
     } while (false)
 #define VS_LOG_AND_FLUSH(log_level, log_message)                                                                    \
     do {                                                                                                            \
         VegaStrikeLogging::vega_logger()->LogAndFlush(VegaStrikeLogging::vega_log_level::log_level, (log_message)); \
     } while (false)
 
+class AsyncLogWriter;
+
 class VegaStrikeLogger {
 private:
     boost::log::core_ptr logging_core_;
     boost::shared_ptr<boost::log::sources::severity_logger_mt<vega_log_level>> slg_;
     boost::shared_ptr<ConsoleLogSink> console_log_sink_;
     boost::shared_ptr<FileLogSink> file_log_sink_;
+    std::unique_ptr<AsyncLogWriter> async_writer_;
+    std::atomic<AsyncLogWriter *> active_async_writer_;
+
+    void Dispatch(const vega_log_level level, const std::string &message);
+    void Write(const vega_log_level level, const std::string &message);
 
 public:
     VegaStrikeLogger();
     ~VegaStrikeLogger();
     void InitLoggingPart2(const uint8_t debug_level, const boost::filesystem::path &vega_strike_home_dir);
+    ///From now on, queue records in lock-free per-thread rings and have a
+    ///background thread write them. Fatal records and the *AndFlush calls
+    ///still write everything queued before returning. The writer runs until
+    ///the logger is destroyed; the config flag is general.async_logging.
+    void StartAsyncWriter();
+    ///Writes out queued records, then flushes the sinks
     void FlushLogs();
     void Log(const vega_log_level level, const std::string& message);
     void Log(const vega_log_level level, const char * message);
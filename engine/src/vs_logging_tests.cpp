@@ -0,0 +1,144 @@
+/*
+ * vs_logging_tests.cpp
+ *
+ * Copyright (C) 2023 Vega Strike contributors.
+ *
+ * https://github.com/vegastrike/Vega-Strike-Engine-Source
+ *
+ * This file is part of Vega Strike.
+ *
+ * Vega Strike is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Vega Strike is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Vega Strike. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/log/core.hpp>
+#include <boost/log/utility/setup/console.hpp>
+#include <boost/smart_ptr/make_shared_object.hpp>
+
+#include "vs_logging.h"
+
+namespace {
+
+struct CountedArgument {
+    int *formatted;
+};
+
+std::ostream &operator<<(std::ostream &out, const CountedArgument &argument) {
+    ++*argument.formatted;
+    return out << "counted";
+}
+
+// Collects the messages logged while it exists
+class CapturedLog {
+public:
+    CapturedLog() : stream(boost::make_shared<std::stringstream>()) {
+        sink = boost::log::add_console_log(*stream, boost::log::keywords::format = "%Message%");
+    }
+
+    ~CapturedLog() {
+        boost::log::core::get()->remove_sink(sink);
+    }
+
+    std::vector<std::string> Lines() {
+        std::vector<std::string> lines;
+        std::string line;
+        std::istringstream in(stream->str());
+        while (std::getline(in, line)) {
+            lines.push_back(line);
+        }
+        return lines;
+    }
+
+private:
+    boost::shared_ptr<std::stringstream> stream;
+    boost::shared_ptr<VegaStrikeLogging::ConsoleLogSink> sink;
+};
+
+// Keeps the default console sink quiet and the log file out of the way
+void InitLogging() {
+    static bool initialized = false;
+    if (!initialized) {
+        VegaStrikeLogging::vega_logger()->InitLoggingPart2(3,
+                boost::filesystem::temp_directory_path() / boost::filesystem::unique_path());
+        initialized = true;
+    }
+}
+
+} // namespace
+
+TEST(Logging, FilteredMessagesAreNotFormatted) {
+    InitLogging();
+    int formatted = 0;
+    VegaStrikeLogging::minimum_log_level.store(VegaStrikeLogging::warning);
+    VS_LOG(info, (boost::format("%1%") % CountedArgument{&formatted}));
+    EXPECT_EQ(0, formatted);
+    VS_LOG(warning, (boost::format("%1%") % CountedArgument{&formatted}));
+    EXPECT_EQ(1, formatted);
+    VegaStrikeLogging::minimum_log_level.store(VegaStrikeLogging::trace);
+}
+
+TEST(Logging, AsyncWriterKeepsEveryRecordInOrder) {
+    InitLogging();
+    CapturedLog log;
+    VegaStrikeLogging::vega_logger()->StartAsyncWriter();
+    const int threads = 4;
+    // More than a ring holds, so that threads wait for the writer
+    const int records = 10000;
+    std::vector<std::thread> loggers;
+    for (int t = 0; t < threads; ++t) {
+        loggers.push_back(std::thread([t, records]() {
+            for (int i = 0; i < records; ++i) {
+                VS_LOG(debug, (boost::format("async %1% %2%") % t % i));
+            }
+        }));
+    }
+    for (std::thread &logger : loggers) {
+        logger.join();
+    }
+    VegaStrikeLogging::vega_logger()->FlushLogs();
+
+    std::map<int, int> next;
+    for (const std::string &line : log.Lines()) {
+        std::istringstream in(line);
+        std::string word;
+        int t, i;
+        if (in >> word >> t >> i && word == "async") {
+            EXPECT_EQ(next[t], i);
+            next[t] = i + 1;
+        }
+    }
+    ASSERT_EQ(threads, static_cast<int>(next.size()));
+    for (const auto &counted : next) {
+        EXPECT_EQ(records, counted.second);
+    }
+}
+
+TEST(Logging, FatalRecordsAreWrittenBeforeReturning) {
+    InitLogging();
+    CapturedLog log;
+    VegaStrikeLogging::vega_logger()->StartAsyncWriter();
+    VS_LOG(info, "before fatal");
+    VS_LOG(fatal, "fatal");
+    const std::vector<std::string> lines = log.Lines();
+    ASSERT_EQ(2u, lines.size());
+    EXPECT_EQ("before fatal", lines[0]);
+    EXPECT_EQ("fatal", lines[1]);
+}
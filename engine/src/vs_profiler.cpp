@@ -0,0 +1,362 @@
+/*
+ * vs_profiler.cpp
+ *
+ * Copyright (C) 2023 Vega Strike contributors.
+ *
+ * https://github.com/vegastrike/Vega-Strike-Engine-Source
+ *
+ * This file is part of Vega Strike.
+ *
+ * Vega Strike is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Vega Strike is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Vega Strike. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "vs_profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "vs_logging.h"
+
+namespace VegaStrikeProfiler {
+
+#ifndef VS_DISABLE_PROFILER
+
+std::atomic<bool> profiler_enabled(false);
+
+namespace {
+
+struct Event {
+    const char *name;
+    uint64_t start_ns;
+    uint64_t end_ns;
+};
+
+// Zones kept per thread; a power of two. Older zones are overwritten.
+const uint64_t ring_size = 1 << 15;
+// Power-of-two buckets of nanoseconds, 0 through 2^63
+const int histogram_buckets = 65;
+
+struct ThreadBuffer {
+    std::vector<Event> events;
+    // Zones ever recorded; only the owning thread writes it
+    std::atomic<uint64_t> written;
+    // Zones already added to the histograms
+    uint64_t folded;
+    unsigned int thread_id;
+
+    explicit ThreadBuffer(unsigned int id) : events(ring_size), written(0), folded(0), thread_id(id) {
+    }
+};
+
+struct Stage {
+    uint64_t count{0};
+    uint64_t total_ns{0};
+    uint64_t max_ns{0};
+    uint64_t buckets[histogram_buckets] = {};
+};
+
+struct Registry {
+    std::mutex mutex;
+    // Shared so that buffers of finished threads can still be exported
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    std::map<std::string, Stage> stages;
+    std::unordered_map<const char *, Stage *> stages_by_literal;
+    unsigned int report_frames{600};
+    unsigned int frames_since_report{0};
+    uint64_t dropped_zones{0};
+    uint64_t last_frame_ns{0};
+    std::string trace_file;
+};
+
+// Never destroyed, since threads may still record while statics go away
+Registry &registry() {
+    static Registry *instance = new Registry;
+    return *instance;
+}
+
+// Set by IgnoreThisThread()
+thread_local bool thread_ignored = false;
+
+ThreadBuffer &thread_buffer() {
+    static thread_local std::shared_ptr<ThreadBuffer> buffer;
+    if (!buffer) {
+        Registry &reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        buffer = std::make_shared<ThreadBuffer>(static_cast<unsigned int>(reg.buffers.size() + 1));
+        reg.buffers.push_back(buffer);
+    }
+    return *buffer;
+}
+
+int bucket_of(uint64_t ns) {
+    int bucket = 0;
+    while (ns) {
+        ++bucket;
+        ns >>= 1;
+    }
+    return bucket;
+}
+
+uint64_t bucket_limit(int bucket) {
+    return bucket ? (bucket >= 64 ? UINT64_MAX : (uint64_t(1) << bucket)) : 0;
+}
+
+uint64_t percentile(const Stage &stage, double fraction) {
+    const uint64_t wanted = std::max<uint64_t>(1, static_cast<uint64_t>(stage.count * fraction + 0.5));
+    uint64_t seen = 0;
+    for (int bucket = 0; bucket < histogram_buckets; ++bucket) {
+        seen += stage.buckets[bucket];
+        if (seen >= wanted) {
+            return std::min(bucket_limit(bucket), stage.max_ns);
+        }
+    }
+    return stage.max_ns;
+}
+
+// Must be called with the registry locked
+void fold_zones(Registry &reg) {
+    for (const std::shared_ptr<ThreadBuffer> &buffer : reg.buffers) {
+        const uint64_t written = buffer->written.load(std::memory_order_acquire);
+        if (written - buffer->folded > ring_size) {
+            reg.dropped_zones += written - buffer->folded - ring_size;
+            buffer->folded = written - ring_size;
+        }
+        for (; buffer->folded < written; ++buffer->folded) {
+            const Event &event = buffer->events[buffer->folded & (ring_size - 1)];
+            Stage *&stage = reg.stages_by_literal[event.name];
+            if (!stage) {
+                stage = &reg.stages[event.name];
+            }
+            const uint64_t duration = event.end_ns - event.start_ns;
+            ++stage->count;
+            stage->total_ns += duration;
+            stage->max_ns = std::max(stage->max_ns, duration);
+            ++stage->buckets[bucket_of(duration)];
+        }
+    }
+}
+
+// Must be called with the registry locked
+std::vector<StageStats> stage_stats(const Registry &reg) {
+    std::vector<StageStats> stats;
+    for (const auto &named : reg.stages) {
+        StageStats stage;
+        stage.name = named.first;
+        stage.count = named.second.count;
+        stage.total_ns = named.second.total_ns;
+        stage.max_ns = named.second.max_ns;
+        stage.p50_ns = percentile(named.second, 0.5);
+        stage.p99_ns = percentile(named.second, 0.99);
+        stats.push_back(stage);
+    }
+    std::sort(stats.begin(), stats.end(), [](const StageStats &a, const StageStats &b) {
+        return a.total_ns > b.total_ns;
+    });
+    return stats;
+}
+
+// Must be called with the registry locked
+void report_stages(Registry &reg) {
+    VS_LOG(info, (boost::format("Profile of the last %1% frames (ms; %2% zones dropped):")
+            % reg.frames_since_report % reg.dropped_zones));
+    for (const StageStats &stage : stage_stats(reg)) {
+        VS_LOG(info, (boost::format("  %1$-24s %2$8d calls %3$10.3f total %4$8.3f mean %5$8.3f p50 %6$8.3f p99 %7$8.3f max")
+                % stage.name % stage.count % (stage.total_ns / 1e6) % (stage.total_ns / 1e6 / stage.count)
+                % (stage.p50_ns / 1e6) % (stage.p99_ns / 1e6) % (stage.max_ns / 1e6)));
+    }
+    reg.stages.clear();
+    reg.stages_by_literal.clear();
+    reg.frames_since_report = 0;
+    reg.dropped_zones = 0;
+}
+
+void write_json_string(std::ostream &out, const char *text) {
+    out << '"';
+    for (; *text; ++text) {
+        if (*text == '"' || *text == '\\') {
+            out << '\\';
+        }
+        out << *text;
+    }
+    out << '"';
+}
+
+} //namespace
+
+uint64_t NowNanoseconds() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void RecordZone(const char *name, uint64_t start_ns, uint64_t end_ns) {
+    if (thread_ignored) {
+        return;
+    }
+    ThreadBuffer &buffer = thread_buffer();
+    const uint64_t index = buffer.written.load(std::memory_order_relaxed);
+    Event &event = buffer.events[index & (ring_size - 1)];
+    event.name = name;
+    event.start_ns = start_ns;
+    event.end_ns = end_ns;
+    buffer.written.store(index + 1, std::memory_order_release);
+}
+
+void Enable(bool enable) {
+    Registry &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    reg.last_frame_ns = 0;
+    profiler_enabled.store(enable, std::memory_order_relaxed);
+}
+
+void Configure(unsigned int report_frames, const std::string &trace_file) {
+    Registry &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    reg.report_frames = report_frames;
+    reg.trace_file = trace_file;
+}
+
+void EndFrame() {
+    if (!IsEnabled()) {
+        return;
+    }
+    Registry &reg = registry();
+    const uint64_t now = NowNanoseconds();
+    uint64_t last_frame;
+    {
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        last_frame = reg.last_frame_ns;
+        reg.last_frame_ns = now;
+    }
+    if (last_frame) {
+        RecordZone("Frame", last_frame, now);
+    }
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    fold_zones(reg);
+    if (reg.report_frames && ++reg.frames_since_report >= reg.report_frames) {
+        report_stages(reg);
+    }
+}
+
+std::vector<StageStats> GetStageStats() {
+    Registry &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    fold_zones(reg);
+    return stage_stats(reg);
+}
+
+void Reset() {
+    Registry &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    fold_zones(reg);
+    reg.stages.clear();
+    reg.stages_by_literal.clear();
+    reg.frames_since_report = 0;
+    reg.dropped_zones = 0;
+    reg.last_frame_ns = 0;
+}
+
+void WriteChromeTrace(std::ostream &out) {
+    Registry &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    const char *separator = "\n";
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    for (const std::shared_ptr<ThreadBuffer> &buffer : reg.buffers) {
+        out << separator << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->thread_id
+                << ",\"args\":{\"name\":\"" << (buffer->thread_id == 1 ? "Main" : "Thread ")
+                << (buffer->thread_id == 1 ? "" : std::to_string(buffer->thread_id)) << "\"}}";
+        separator = ",\n";
+        const uint64_t written = buffer->written.load(std::memory_order_acquire);
+        for (uint64_t i = written > ring_size ? written - ring_size : 0; i < written; ++i) {
+            const Event &event = buffer->events[i & (ring_size - 1)];
+            out << separator << "{\"name\":";
+            write_json_string(out, event.name);
+            out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->thread_id
+                    << ",\"ts\":" << event.start_ns / 1000 << '.' << event.start_ns % 1000 / 100
+                    << ",\"dur\":" << (event.end_ns - event.start_ns) / 1000 << '.'
+                    << (event.end_ns - event.start_ns) % 1000 / 100 << '}';
+        }
+    }
+    out << "\n]}\n";
+}
+
+bool WriteChromeTrace(const std::string &path) {
+    std::ofstream out(path.c_str());
+    if (!out) {
+        VS_LOG(error, (boost::format("Could not write profiler trace %1%") % path));
+        return false;
+    }
+    WriteChromeTrace(out);
+    return out.good();
+}
+
+void Shutdown() {
+    std::string trace_file;
+    {
+        Registry &reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        trace_file = reg.trace_file;
+    }
+    if (IsEnabled() && !trace_file.empty() && WriteChromeTrace(trace_file)) {
+        VS_LOG(info, (boost::format("Wrote profiler trace %1%") % trace_file));
+    }
+    Enable(false);
+}
+
+void IgnoreThisThread() {
+    thread_ignored = true;
+}
+
+#else //VS_DISABLE_PROFILER
+
+void Enable(bool) {
+}
+
+void Configure(unsigned int, const std::string &) {
+}
+
+void EndFrame() {
+}
+
+std::vector<StageStats> GetStageStats() {
+    return std::vector<StageStats>();
+}
+
+void Reset() {
+}
+
+void WriteChromeTrace(std::ostream &out) {
+    out << "{\"traceEvents\":[]}\n";
+}
+
+bool WriteChromeTrace(const std::string &path) {
+    std::ofstream out(path.c_str());
+    WriteChromeTrace(out);
+    return out.good();
+}
+
+void Shutdown() {
+}
+
+void IgnoreThisThread() {
+}
+
+#endif //VS_DISABLE_PROFILER
+
+} //namespace VegaStrikeProfiler
@@ -0,0 +1,139 @@
+/*
+ * vs_profiler.h
+ *
+ * Copyright (C) 2023 Vega Strike contributors.
+ *
+ * https://github.com/vegastrike/Vega-Strike-Engine-Source
+ *
+ * This file is part of Vega Strike.
+ *
+ * Vega Strike is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Vega Strike is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Vega Strike. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef VEGA_STRIKE_ENGINE_VS_PROFILER_H
+#define VEGA_STRIKE_ENGINE_VS_PROFILER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * Scoped-zone profiler for the simulation and render loop.
+ *
+ * VS_PROFILE_ZONE("Name") times the rest of the enclosing scope. Zones are
+ * appended to a ring buffer owned by the calling thread, so recording takes
+ * no lock. EndFrame() folds them into per-stage histograms that are logged
+ * every few hundred frames, and WriteChromeTrace() dumps whatever the ring
+ * buffers still hold as Chrome trace-event JSON (chrome://tracing, Perfetto).
+ *
+ * Zones cost one relaxed atomic load while the profiler is disabled, and
+ * nothing at all when built with VS_DISABLE_PROFILER.
+ */
+
+#define VS_PROFILE_CONCAT_IMPL(a, b) a##b
+#define VS_PROFILE_CONCAT(a, b) VS_PROFILE_CONCAT_IMPL(a, b)
+///name must be a string literal; it is kept by pointer
+#define VS_PROFILE_ZONE(name) VegaStrikeProfiler::Zone VS_PROFILE_CONCAT(vs_profile_zone_, __LINE__)(name)
+
+namespace VegaStrikeProfiler {
+
+///Timing of one stage over the frames since the last report
+struct StageStats {
+    std::string name;
+    uint64_t count{0};
+    uint64_t total_ns{0};
+    uint64_t max_ns{0};
+    //percentiles are the upper bounds of power-of-two histogram buckets
+    uint64_t p50_ns{0};
+    uint64_t p99_ns{0};
+};
+
+#ifndef VS_DISABLE_PROFILER
+
+extern std::atomic<bool> profiler_enabled;
+
+inline bool IsEnabled() {
+    return profiler_enabled.load(std::memory_order_relaxed);
+}
+
+uint64_t NowNanoseconds();
+void RecordZone(const char *name, uint64_t start_ns, uint64_t end_ns);
+
+class Zone {
+public:
+    explicit Zone(const char *name) : name(name), start_ns(IsEnabled() ? NowNanoseconds() : 0) {
+    }
+
+    ~Zone() {
+        if (start_ns) {
+            RecordZone(name, start_ns, NowNanoseconds());
+        }
+    }
+
+    Zone(const Zone &) = delete;
+    Zone &operator=(const Zone &) = delete;
+
+private:
+    const char *name;
+    uint64_t start_ns;
+};
+
+#else //VS_DISABLE_PROFILER
+
+inline bool IsEnabled() {
+    return false;
+}
+
+class Zone {
+public:
+    explicit Zone(const char *) {
+    }
+};
+
+#endif //VS_DISABLE_PROFILER
+
+///Turns recording on or off; the config flag is general.profiler
+void Enable(bool enable);
+
+///Logs the stage histograms every report_frames frames (0 never does) and
+///writes the Chrome trace to trace_file on Shutdown() if it is not empty
+void Configure(unsigned int report_frames, const std::string &trace_file);
+
+///Marks the end of a frame. Call from the main thread while no worker
+///threads are recording, e.g. between worker pool batches.
+void EndFrame();
+
+///Stages folded in since the last report, slowest total first
+std::vector<StageStats> GetStageStats();
+
+///Drops the stages gathered so far, e.g. those of a warm-up
+void Reset();
+
+///Writes every zone still held in the ring buffers as trace-event JSON.
+///Same threading rules as EndFrame().
+void WriteChromeTrace(std::ostream &out);
+bool WriteChromeTrace(const std::string &path);
+
+///Writes the configured trace file, if any, and stops recording
+void Shutdown();
+
+///Drops the zones of the calling thread from now on. For threads that keep
+///running while the main thread calls EndFrame()
+void IgnoreThisThread();
+
+} //namespace VegaStrikeProfiler
+
+#endif //VEGA_STRIKE_ENGINE_VS_PROFILER_H
@@ -0,0 +1,107 @@
+/*
+ * vs_profiler_tests.cpp
+ *
+ * Copyright (C) 2023 Vega Strike contributors.
+ *
+ * https://github.com/vegastrike/Vega-Strike-Engine-Source
+ *
+ * This file is part of Vega Strike.
+ *
+ * Vega Strike is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Vega Strike is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Vega Strike. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <sstream>
+#include <thread>
+
+#include "vs_profiler.h"
+
+#ifndef VS_DISABLE_PROFILER
+
+namespace {
+
+const VegaStrikeProfiler::StageStats *FindStage(const std::vector<VegaStrikeProfiler::StageStats> &stats,
+        const std::string &name) {
+    for (const VegaStrikeProfiler::StageStats &stage : stats) {
+        if (stage.name == name) {
+            return &stage;
+        }
+    }
+    return nullptr;
+}
+
+void SleepyZone() {
+    VS_PROFILE_ZONE("SleepyZone");
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+}
+
+} // namespace
+
+TEST(Profiler, RecordsNothingWhileDisabled) {
+    VegaStrikeProfiler::Enable(false);
+    {
+        VS_PROFILE_ZONE("DisabledZone");
+    }
+    EXPECT_EQ(nullptr, FindStage(VegaStrikeProfiler::GetStageStats(), "DisabledZone"));
+}
+
+TEST(Profiler, FoldsZonesIntoStages) {
+    VegaStrikeProfiler::Configure(0, "");
+    VegaStrikeProfiler::Enable(true);
+    for (int i = 0; i < 3; ++i) {
+        SleepyZone();
+        VegaStrikeProfiler::EndFrame();
+    }
+    VegaStrikeProfiler::Enable(false);
+    const std::vector<VegaStrikeProfiler::StageStats> stats = VegaStrikeProfiler::GetStageStats();
+    const VegaStrikeProfiler::StageStats *sleepy = FindStage(stats, "SleepyZone");
+    ASSERT_NE(nullptr, sleepy);
+    EXPECT_EQ(3, sleepy->count);
+    EXPECT_GE(sleepy->max_ns, 2000000u);
+    EXPECT_GE(sleepy->p99_ns, sleepy->p50_ns);
+    EXPECT_LE(sleepy->p99_ns, sleepy->max_ns);
+    const VegaStrikeProfiler::StageStats *frame = FindStage(stats, "Frame");
+    ASSERT_NE(nullptr, frame);
+    EXPECT_EQ(2, frame->count);
+}
+
+TEST(Profiler, ResetDropsStages) {
+    VegaStrikeProfiler::Enable(true);
+    SleepyZone();
+    VegaStrikeProfiler::Enable(false);
+    VegaStrikeProfiler::Reset();
+    EXPECT_EQ(nullptr, FindStage(VegaStrikeProfiler::GetStageStats(), "SleepyZone"));
+}
+
+TEST(Profiler, ChromeTraceHasEveryThread) {
+    VegaStrikeProfiler::Enable(true);
+    SleepyZone();
+    std::thread other([]() {
+        VS_PROFILE_ZONE("OtherThreadZone");
+    });
+    other.join();
+    VegaStrikeProfiler::Enable(false);
+    std::ostringstream trace;
+    VegaStrikeProfiler::WriteChromeTrace(trace);
+    const std::string json = trace.str();
+    EXPECT_EQ(0, json.find("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["));
+    EXPECT_NE(std::string::npos, json.find("{\"name\":\"SleepyZone\",\"ph\":\"X\""));
+    EXPECT_NE(std::string::npos, json.find("{\"name\":\"OtherThreadZone\",\"ph\":\"X\""));
+    EXPECT_NE(std::string::npos, json.find("\"thread_name\""));
+    EXPECT_EQ("\n]}\n", json.substr(json.size() - 4));
+}
+
+#endif //VS_DISABLE_PROFILER
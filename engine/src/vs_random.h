@@ -204,5 +204,9 @@ public:
     }
 /* These real versions are due to Isaku Wada, 2002/01/09 added */
 };
-extern VSRandom vsrandom;
+extern thread_local VSRandom vsrandom;
+///What the generators of threads and star systems are seeded from; the time at startup by default.
+///Threads that already drew keep their state, see StarSystem::SeedRandom() for the systems.
+void SetRandomMasterSeed(unsigned int seed);
+unsigned int GetRandomMasterSeed();
 
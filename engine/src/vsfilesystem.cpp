@@ -35,6 +35,7 @@
 #define NOMINMAX
 #endif //tells VCC not to generate min/max macros
 #include <windows.h>
+#include <io.h>
 #include <cstdlib>
 struct dirent
 {
@@ -45,6 +46,7 @@ struct dirent
 #include <pwd.h>
 #include <sys/types.h>
 #include <dirent.h>
+#include <sys/mman.h>
 #endif
 #include <sys/stat.h>
 #include "configxml.h"
@@ -64,8 +66,10 @@ struct dirent
 
 #include "configuration/game_config.h"
 #include "vs_exit.h"
+#include "vs_profiler.h"
 
 #include <string>
+#include <unordered_set>
 #include <utility>
 
 // from main.cpp
@@ -274,6 +278,12 @@ std::string failed;
 //Map of the currently opened PK3 volume/resource files
 // FIXME: Clang-Tidy: Initialization of 'pk3_opened_files' with static storage duration may throw an exception that cannot be caught
 vsUMap<std::string, CPK3 *> pk3_opened_files;
+//Volume files that could not be opened, so they are only tried once
+static std::unordered_set<std::string> missing_volumes;
+//Lookups in volumes that found nothing, by root, type and file name. Forgotten
+//when the volumes are set up again, and when it grows past max_volume_misses
+static std::unordered_set<std::string> volume_misses;
+static const size_t max_volume_misses = 65536;
 
 /*
  ***********************************************************************************************
@@ -970,6 +980,8 @@ void InitPaths(string conf, string subdir) {
     //Also : Have to try with systems, not sure it would work well
     //Setup the use of volumes for certain VSFileType
     volume_format = game_options()->volume_format;
+    missing_volumes.clear();
+    volume_misses.clear();
     if (volume_format == "vsr") {
         q_volume_format = vfmtVSR;
     } else if (volume_format == "pk3") {
@@ -1088,11 +1100,36 @@ bool DirectoryExists(const string &filename) {
     return DirectoryExists(filename.c_str());
 }
 
+//Returns the already opened volume at fullpath, opens it, or returns NULL if it can't be opened
+static CPK3 *OpenVolume(const string &fullpath) {
+    failed += "Looking for file in VOLUME : " + fullpath + "... ";
+    vsUMap<string, CPK3 *>::iterator it = pk3_opened_files.find(fullpath);
+    if (it != pk3_opened_files.end()) {
+        failed += " VOLUME FOUND\n";
+        return it->second;
+    }
+    if (missing_volumes.count(fullpath)) {
+        failed += " COULD NOT OPEN VOLUME\n";
+        return NULL;
+    }
+    //File is not opened so we open it and add it in the pk3 file map
+    CPK3 *vol = new CPK3;
+    if (!vol->Open(fullpath.c_str())) {
+        failed += " COULD NOT OPEN VOLUME\n";
+        delete vol;
+        missing_volumes.insert(fullpath);
+        return NULL;
+    }
+    failed += " VOLUME OPENED\n";
+    //We add the resource file to the map only if we could have opened it
+    pk3_opened_files.insert(std::make_pair(fullpath, vol));
+    return vol;
+}
+
 //root is the path to the type directory or the type volume
 //filename is the subdirectory+"/"+filename
 int FileExists(const string &root, const char *filename, VSFileType type, bool lookinvolume) {
     int found = -1;
-    bool volok = false;
     string fullpath;
     const char *file;
     if (filename[0] == '/') {
@@ -1121,70 +1158,42 @@ int FileExists(const string &root, const char *filename, VSFileType type, bool l
     } else {
         if (q_volume_format == vfmtVSR) {
         } else if (q_volume_format == vfmtPK3) {
-            CPK3 *vol;
-            string filestr;
-
-            //TRY TO OPEN A DATA.VOLFORMAT FILE IN THE ROOT DIRECTORY PASSED AS AN ARG
-            filestr = Directories[type] + "/" + file;
-            fullpath = root + rootsep + "data." + volume_format;
-            vsUMap<string, CPK3 *>::iterator it;
-            it = pk3_opened_files.find(fullpath);
-            failed += "Looking for file in VOLUME : " + fullpath + "... ";
-            if (it == pk3_opened_files.end()) {
-                //File is not opened so we open it and add it in the pk3 file map
-                vol = new CPK3;
-                if ((volok = vol->Open(fullpath.c_str()))) {
-                    failed += " VOLUME OPENED\n";
-                    //We add the resource file to the map only if we could have opened it
-                    std::pair<std::string, CPK3 *> pk3_pair(fullpath, vol);
-                    pk3_opened_files.insert(pk3_pair);
-                } else {
-                    failed += " COULD NOT OPEN VOLUME\n";
-                }
-            } else {
-                failed += " VOLUME FOUND\n";
-                vol = it->second;
-                volok = true;
-            }
-            //Try to get the file index in the archive
-            if (volok) {
-                found = vol->FileExists(filestr.c_str());
-                if (found >= 0) {
-                    isin_bigvolumes = VSFSBig;
-                }
-            } else {
-                found = -1;
-            }
-            if (found < 0) {
-                //AND THEN A VOLUME FILE BASED ON DIRECTORIES[TYPE]
-                filestr = string(file);
+            //The archives do not change while the game runs, so a miss stays a miss
+            string miss_key = root + '\n' + std::to_string(type) + '\n' + file;
+            if (volume_misses.count(miss_key)) {
+                //Falls through to the same bookkeeping as a lookup, with the last volume it would try
+                failed += "Already looked for " + string(file) + " in the volumes of " + root + "... NOT FOUND\n";
                 fullpath = root + rootsep + Directories[type] + "." + volume_format;
-                it = pk3_opened_files.find(fullpath);
-                failed += "Looking for file in VOLUME : " + fullpath + "... ";
-                if (it == pk3_opened_files.end()) {
-                    //File is not opened so we open it and add it in the pk3 file map
-                    vol = new CPK3;
-                    if ((volok = vol->Open(fullpath.c_str()))) {
-                        failed += " VOLUME OPENED\n";
-                        //We add the resource file to the map only if we could have opened it
-                        std::pair<std::string, CPK3 *> pk3_pair(fullpath, vol);
-                        pk3_opened_files.insert(pk3_pair);
-                    } else {
-                        failed += " COULD NOT OPEN VOLUME\n";
-                    }
-                } else {
-                    failed += " VOLUME FOUND\n";
-                    vol = it->second;
-                    volok = true;
-                }
+            } else {
+                //TRY TO OPEN A DATA.VOLFORMAT FILE IN THE ROOT DIRECTORY PASSED AS AN ARG
+                string filestr = Directories[type] + "/" + file;
+                fullpath = root + rootsep + "data." + volume_format;
+                CPK3 *vol = OpenVolume(fullpath);
                 //Try to get the file index in the archive
-                if (volok) {
+                if (vol) {
                     found = vol->FileExists(filestr.c_str());
                     if (found >= 0) {
-                        isin_bigvolumes = VSFSSplit;
+                        isin_bigvolumes = VSFSBig;
+                    }
+                }
+                if (found < 0) {
+                    //AND THEN A VOLUME FILE BASED ON DIRECTORIES[TYPE]
+                    filestr = string(file);
+                    fullpath = root + rootsep + Directories[type] + "." + volume_format;
+                    vol = OpenVolume(fullpath);
+                    //Try to get the file index in the archive
+                    if (vol) {
+                        found = vol->FileExists(filestr.c_str());
+                        if (found >= 0) {
+                            isin_bigvolumes = VSFSSplit;
+                        }
                     }
-                } else {
-                    found = -1;
+                }
+                if (found < 0) {
+                    if (volume_misses.size() >= max_volume_misses) {
+                        volume_misses.clear();
+                    }
+                    volume_misses.insert(miss_key);
                 }
             }
         }
@@ -1427,11 +1436,52 @@ const boost::filesystem::path GetSavePath() {
 //SHOULD BE HANDLED IN VOLUMES MIGHT BE FOUND IN THE CURRENT DIRECTORY OF A TYPE THAT IS NOT HANDLED IN
 //VOLUMES -> SO WE HAVE TO USE THE ALT_TYPE IN MOST OF THE TEST TO USE THE CORRECT FILE OPERATIONS
 
+const char *MapFile(FILE *fp, size_t &length) {
+    length = 0;
+    struct stat st{};
+    if (fp == nullptr || fstat(fileno(fp), &st) != 0 || st.st_size <= 0) {
+        return nullptr;
+    }
+#if defined (_WIN32) && !defined (__CYGWIN__)
+    HANDLE mapping = CreateFileMapping((HANDLE) _get_osfhandle(_fileno(fp)), NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping == NULL) {
+        return nullptr;
+    }
+    //The view keeps the mapping alive
+    const char *data = (const char *) MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (data == NULL) {
+        return nullptr;
+    }
+#else
+    void *view = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fileno(fp), 0);
+    if (view == MAP_FAILED) {
+        return nullptr;
+    }
+    const char *data = (const char *) view;
+#endif
+    length = st.st_size;
+    return data;
+}
+
+void UnmapFile(const char *data, size_t length) {
+    if (data == nullptr) {
+        return;
+    }
+#if defined (_WIN32) && !defined (__CYGWIN__)
+    UnmapViewOfFile(data);
+#else
+    munmap((void *) data, length);
+#endif
+}
+
 void VSFile::private_init() {
     fp = nullptr;
     size = 0;
     pk3_file = nullptr;
     pk3_extracted_file = nullptr;
+    mapped_file = nullptr;
+    mapped_length = 0;
     offset = 0;
     valid = false;
     file_type = alt_type = UnknownFile;
@@ -1467,6 +1517,7 @@ VSFile::VSFile(const char *filename, VSFileType type, VSFileMode mode) {
 }
 
 VSFile::~VSFile() {
+    UnmapFile(mapped_file, mapped_length);
     if (fp != nullptr) {
         fclose(fp);
         this->fp = nullptr;
@@ -1477,31 +1528,36 @@ VSFile::~VSFile() {
     }
 }
 
+//Sets pk3_file to the volume holding the file, opening it if needed
+void VSFile::findVolume() {
+    string full_vol_path;
+    if (this->volume_type == VSFSBig) {
+        full_vol_path = this->rootname + "/data." + volume_format;
+    } else {
+        full_vol_path = this->rootname + "/" + Directories[this->alt_type] + "." + volume_format;
+    }
+    vsUMap<string, CPK3 *>::iterator it;
+    it = pk3_opened_files.find(full_vol_path);
+    if (it == pk3_opened_files.end()) {
+        //File is not opened so we open it and add it in the pk3 file map
+        CPK3 *pk3newfile = new CPK3;
+        if (!pk3newfile->Open(full_vol_path.c_str())) {
+            VS_LOG_AND_FLUSH(fatal, (boost::format("!!! ERROR : opening volume : %1%") % full_vol_path));
+            VSExit(1);
+        }
+        std::pair<std::string, CPK3 *> pk3_pair(full_vol_path, pk3newfile);
+        pk3_opened_files.insert(pk3_pair);
+
+        this->pk3_file = pk3newfile;
+    } else {
+        this->pk3_file = it->second;
+    }
+}
+
 void VSFile::checkExtracted() {
     if (q_volume_format == vfmtPK3) {
         if (!pk3_extracted_file) {
-            string full_vol_path;
-            if (this->volume_type == VSFSBig) {
-                full_vol_path = this->rootname + "/data." + volume_format;
-            } else {
-                full_vol_path = this->rootname + "/" + Directories[this->alt_type] + "." + volume_format;
-            }
-            vsUMap<string, CPK3 *>::iterator it;
-            it = pk3_opened_files.find(full_vol_path);
-            if (it == pk3_opened_files.end()) {
-                //File is not opened so we open it and add it in the pk3 file map
-                CPK3 *pk3newfile = new CPK3;
-                if (!pk3newfile->Open(full_vol_path.c_str())) {
-                    VS_LOG_AND_FLUSH(fatal, (boost::format("!!! ERROR : opening volume : %1%") % full_vol_path));
-                    VSExit(1);
-                }
-                std::pair<std::string, CPK3 *> pk3_pair(full_vol_path, pk3newfile);
-                pk3_opened_files.insert(pk3_pair);
-
-                this->pk3_file = pk3newfile;
-            } else {
-                this->pk3_file = it->second;
-            }
+            findVolume();
             int pk3size = 0;
             if (this->file_index != -1) {
                 pk3_extracted_file = (char *) pk3_file->ExtractFile(this->file_index, &pk3size);
@@ -1533,6 +1589,7 @@ const string VSFile::GetSystemDirectoryPath(string &file) {
 
 //Open a read only file
 VSError VSFile::OpenReadOnly(const char *file, VSFileType type) {
+    VS_PROFILE_ZONE("VSFile::OpenReadOnly");
     string filestr;
     int found = -1;
     this->file_type = this->alt_type = type;
@@ -1729,6 +1786,7 @@ VSError VSFile::OpenCreateWrite(const char *filenam, VSFileType type) {
 }
 
 size_t VSFile::Read(void *ptr, size_t length) {
+    VS_PROFILE_ZONE("VSFile::Read");
     size_t nbread = 0;
     if (!UseVolumes[this->alt_type] || this->volume_type == VSFSNone) {
         assert(fp != NULL);
@@ -1798,6 +1856,7 @@ VSError VSFile::ReadLine(void *ptr, size_t length) {
 }
 
 std::string VSFile::ReadFull() {
+    VS_PROFILE_ZONE("VSFile::ReadFull");
     if (this->Size() < 0) {
         VS_LOG(error,
                 (boost::format("Attempt to call ReadFull on a bad file %1% %2% %3%") % this->filename % this->Size()
@@ -1809,6 +1868,14 @@ std::string VSFile::ReadFull() {
         if (sz <= 0) {
             return string();
         }
+        //Copy straight from a mapping of the file, reading from the current position like fread would
+        size_t length = 0;
+        const char *view = this->MapFull(length);
+        long position = ftell(this->fp);
+        if (view != nullptr && position >= 0 && (size_t) position <= length) {
+            fseek(this->fp, 0, SEEK_END);
+            return string(view + position, length - position);
+        }
 
         char *content = new char[this->Size() + 1];
         content[this->Size()] = 0;
@@ -1838,6 +1905,44 @@ std::string VSFile::ReadFull() {
     return string("");
 }
 
+const char *VSFile::MapFull(size_t &length) {
+    length = 0;
+    if (this->pk3_extracted_file != nullptr) {
+        //Buffers and files already extracted from a volume
+        length = this->size;
+        return this->pk3_extracted_file;
+    }
+    if (!UseVolumes[alt_type] || this->volume_type == VSFSNone) {
+        if (this->mapped_file == nullptr) {
+            this->mapped_file = MapFile(this->fp, this->mapped_length);
+        }
+        length = this->mapped_length;
+        return this->mapped_file;
+    } else {
+        if (q_volume_format == vfmtVSR) {
+        } else if (q_volume_format == vfmtPK3) {
+            findVolume();
+            int pk3size = 0;
+            const char *data;
+            if (this->file_index != -1) {
+                data = pk3_file->MapFile(this->file_index, &pk3size);
+            } else {
+                data = pk3_file->MapFile((this->subdirectoryname + "/" + this->filename).c_str(), &pk3size);
+            }
+            if (data == nullptr) {
+                //Compressed, so it has to be extracted after all
+                checkExtracted();
+                length = this->size;
+                return length ? this->pk3_extracted_file : nullptr;
+            }
+            this->size = pk3size;
+            length = pk3size;
+            return data;
+        }
+    }
+    return nullptr;
+}
+
 size_t VSFile::Write(const void *ptr, size_t length) {
     if (!UseVolumes[this->alt_type] || this->volume_type == VSFSNone) {
         size_t nbwritten = fwrite(ptr, 1, length, this->fp);
@@ -2039,6 +2144,9 @@ void VSFile::Close() {
             cerr << endl << endl;
         }
     }
+    UnmapFile(this->mapped_file, this->mapped_length);
+    this->mapped_file = nullptr;
+    this->mapped_length = 0;
     if (!UseVolumes[file_type] || this->volume_type == VSFSNone || file_mode != ReadOnly) {
         fclose(this->fp);
         this->fp = nullptr;
@@ -281,6 +281,11 @@ void CreateDirectoryHome(const std::string &filename);
 void CreateDirectoryData(const char *filename);
 void CreateDirectoryData(const std::string &filename);
 
+//Map the whole of an open file read only, returns NULL (and a length of 0) if it is empty or can't be mapped
+//The mapping outlives fp and must be released with UnmapFile
+const char *MapFile(FILE *fp, size_t &length);
+void UnmapFile(const char *data, size_t length);
+
 /********** DO NO USE FileExists functions directly : USE LookForFile instead **********/
 //Test if a directory exists (absolute path)
 bool DirectoryExists(const char *filename);
@@ -325,6 +330,11 @@ private:
     unsigned int offset{};
 
     void checkExtracted();
+    void findVolume();
+
+//Mapped file stuff (see MapFull)
+    const char *mapped_file{};
+    size_t mapped_length{};
 
 //VSFile internals
     VSFileType file_type{};
@@ -390,6 +400,10 @@ public:
             size_t length);                                            //Read length in ptr (store read bytes number in length)
     VSError ReadLine(void *ptr, size_t length);                               //Read a line of maximum length
     std::string ReadFull();                                                                                          //Read the entire file and returns the content in a string
+//Returns the whole content of the file without reading it into a buffer and sets length to its size, or NULL if
+//it is empty or bad. Files on disk are memory mapped, files stored uncompressed in a volume point into the mapped
+//volume and compressed ones are extracted. The content is read only, not null terminated and valid until Close()
+    const char *MapFull(size_t &length);
     size_t Write(const void *ptr,
             size_t length);                             //Write length from ptr (store written bytes number in length)
     size_t Write(const std::string &content);                                              //Write a string
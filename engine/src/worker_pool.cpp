@@ -0,0 +1,165 @@
+/*
+ * worker_pool.cpp
+ *
+ * Copyright (C) 2023 Vega Strike contributors.
+ *
+ * https://github.com/vegastrike/Vega-Strike-Engine-Source
+ *
+ * This file is part of Vega Strike.
+ *
+ * Vega Strike is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Vega Strike is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Vega Strike. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "worker_pool.h"
+
+#include <algorithm>
+
+#include "configuration/configuration.h"
+#include "vs_logging.h"
+
+// Whether this thread is currently running a task of some batch
+static thread_local bool running_task = false;
+
+WorkerPool::WorkerPool(size_t num_threads) {
+    threads.reserve(num_threads);
+    for (size_t i = 0; i < num_threads; ++i) {
+        threads.emplace_back(&WorkerPool::WorkerLoop, this);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        shutting_down = true;
+    }
+    batch_started.notify_all();
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+}
+
+size_t WorkerPool::NumThreads() const {
+    return threads.size();
+}
+
+void WorkerPool::Run(const std::vector<Task> &tasks) {
+    if (tasks.empty()) {
+        return;
+    }
+    if (threads.empty() || tasks.size() == 1 || running_task) {
+        for (const Task &task : tasks) {
+            task();
+        }
+        return;
+    }
+
+    // batch, next_task and unfinished_tasks describe a single batch
+    std::lock_guard<std::mutex> run_lock(run_mutex);
+    std::unique_lock<std::mutex> lock(mutex);
+    batch = &tasks;
+    next_task = 0;
+    unfinished_tasks = tasks.size();
+    first_error = nullptr;
+    ++batch_number;
+    batch_started.notify_all();
+
+    // The caller is a worker too, rather than sleeping through the batch
+    ExecuteTasks(lock);
+    batch_finished.wait(lock, [this] { return unfinished_tasks == 0; });
+    batch = nullptr;
+
+    std::exception_ptr error = first_error;
+    first_error = nullptr;
+    lock.unlock();
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+void WorkerPool::ParallelFor(size_t count, size_t min_chunk, const std::function<void(size_t, size_t)> &body) {
+    if (count == 0) {
+        return;
+    }
+    size_t num_chunks = std::min(threads.size() + 1, (count + min_chunk - 1) / std::max<size_t>(min_chunk, 1));
+    if (num_chunks <= 1 || running_task) {
+        body(0, count);
+        return;
+    }
+    size_t chunk_size = (count + num_chunks - 1) / num_chunks;
+    std::vector<Task> tasks;
+    tasks.reserve(num_chunks);
+    for (size_t begin = 0; begin < count; begin += chunk_size) {
+        size_t end = std::min(count, begin + chunk_size);
+        tasks.push_back([&body, begin, end]() {
+            body(begin, end);
+        });
+    }
+    Run(tasks);
+}
+
+bool WorkerPool::InTask() {
+    return running_task;
+}
+
+void WorkerPool::WorkerLoop() {
+    size_t last_batch = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        batch_started.wait(lock, [this, last_batch] { return shutting_down || batch_number != last_batch; });
+        if (shutting_down) {
+            return;
+        }
+        last_batch = batch_number;
+        ExecuteTasks(lock);
+    }
+}
+
+void WorkerPool::ExecuteTasks(std::unique_lock<std::mutex> &lock) {
+    while (batch && next_task < batch->size()) {
+        const Task &task = (*batch)[next_task++];
+        lock.unlock();
+        std::exception_ptr error;
+        running_task = true;
+        try {
+            task();
+        } catch (...) {
+            error = std::current_exception();
+        }
+        running_task = false;
+        lock.lock();
+        if (error && !first_error) {
+            first_error = error;
+        }
+        if (--unfinished_tasks == 0) {
+            batch_finished.notify_all();
+        }
+    }
+}
+
+WorkerPool &GetWorkerPool() {
+    static WorkerPool pool([]() -> size_t {
+        size_t num_threads = configuration()->physics_config.simulation_worker_threads;
+        if (num_threads == 0) {
+            num_threads = std::thread::hardware_concurrency();
+        }
+        // The thread calling Run() executes tasks as well
+        if (num_threads > 0) {
+            --num_threads;
+        }
+        VS_LOG(info, (boost::format("Starting simulation worker pool with %1% threads") % num_threads));
+        return num_threads;
+    }());
+    return pool;
+}
@@ -0,0 +1,94 @@
+/*
+ * worker_pool.h
+ *
+ * Copyright (C) 2023 Vega Strike contributors.
+ *
+ * https://github.com/vegastrike/Vega-Strike-Engine-Source
+ *
+ * This file is part of Vega Strike.
+ *
+ * Vega Strike is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Vega Strike is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Vega Strike. If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef VEGA_STRIKE_ENGINE_WORKER_POOL_H
+#define VEGA_STRIKE_ENGINE_WORKER_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief A fixed set of threads that run batches of simulation tasks.
+ *
+ * Run() is a barrier: it hands out the tasks, helps execute them on the
+ * calling thread and only returns once every task of the batch has finished.
+ * Nothing is queued between batches, so the pool is idle (and holds no
+ * engine state) whenever the main loop is not inside Run().
+ */
+class WorkerPool {
+public:
+    typedef std::function<void()> Task;
+
+    // A pool of 0 threads runs every batch serially on the calling thread
+    explicit WorkerPool(size_t num_threads);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool &operator=(const WorkerPool &) = delete;
+
+    size_t NumThreads() const;
+
+    // Runs all tasks and waits for them. If any task throws, the first
+    // exception is rethrown here once the whole batch is done. Called from
+    // inside a task, the batch runs serially on that thread instead. Callers
+    // on other threads take turns: one batch is in flight at a time.
+    void Run(const std::vector<Task> &tasks);
+
+    // Calls body(begin, end) over [0, count) in chunks of at least
+    // min_chunk items, spread over the pool
+    void ParallelFor(size_t count, size_t min_chunk, const std::function<void(size_t, size_t)> &body);
+
+    // Whether the calling thread is running a task of some batch. Work that
+    // is only safe on the main thread checks it to defer itself.
+    static bool InTask();
+
+private:
+    void WorkerLoop();
+    // Takes tasks from the current batch until it is exhausted.
+    // Must be called with the lock held; returns with the lock held.
+    void ExecuteTasks(std::unique_lock<std::mutex> &lock);
+
+    std::vector<std::thread> threads;
+    // Held by the thread that owns the current batch, for the whole of Run()
+    std::mutex run_mutex;
+    std::mutex mutex;
+    std::condition_variable batch_started;
+    std::condition_variable batch_finished;
+
+    const std::vector<Task> *batch{nullptr};
+    size_t next_task{0};
+    size_t unfinished_tasks{0};
+    size_t batch_number{0};
+    std::exception_ptr first_error;
+    bool shutting_down{false};
+};
+
+// The pool used by the simulation. Sized from physics.simulation_worker_threads
+// the first time it is requested; 0 means one thread per hardware core.
+WorkerPool &GetWorkerPool();
+
+#endif //VEGA_STRIKE_ENGINE_WORKER_POOL_H